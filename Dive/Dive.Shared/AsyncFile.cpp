@@ -0,0 +1,31 @@
+#include "pch.h"
+#include "AsyncFile.h"
+
+#include <fstream>
+
+using namespace Dive;
+
+std::vector<uint8> Dive::ReadFileBytes(std::string const& filename)
+{
+	std::vector<uint8>	data;
+	std::ifstream		file(filename, std::ios::binary | std::ios::ate);
+	if (!file)
+		return data;
+
+	std::streamoff const	size = file.tellg();
+	data.resize(static_cast<size_t>(size));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(data.data()), size))
+		data.clear();
+	return data;
+}
+
+#if defined(DIVE_COROUTINES)
+
+Task<std::vector<uint8>> Dive::ReadFileAsync(std::string filename)
+{
+	co_await ResumeOnWorker();
+	co_return ReadFileBytes(filename);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Task.h"
+
+#include <string>
+#include <vector>
+
+namespace Dive
+{
+	// Reads a whole file on the calling thread. Relative names start from the working directory, the
+	// package folder on Windows. Empty when the file cannot be read.
+	std::vector<uint8>	ReadFileBytes(std::string const& filename);
+
+#if defined(DIVE_COROUTINES)
+	// ReadFileBytes on a worker.
+	Task<std::vector<uint8>>	ReadFileAsync(std::string filename);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,443 @@
+#include "pch.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	uint32 const	BIN_COUNT = 16;
+	uint32 const	MAX_LEAF_PRIMITIVES = 8;
+	// Below this a subtree is cheaper to build on the calling thread than through a job.
+	uint32 const	PARALLEL_BUILD_PRIMITIVES = 4096;
+	// Deeper ranges become leaves, so the traversal stacks never overflow.
+	uint32 const	MAX_TREE_DEPTH = 48;
+	uint32 const	STACK_SIZE = 64;
+	uint32 const	ALL_PLANES = (1 << FrustumCuller::PlaneCount) - 1;
+
+	float Component(XMFLOAT3 const& vector, int axis)
+	{
+		return (&vector.x)[axis];
+	}
+
+	void Grow(XMFLOAT3& minimum, XMFLOAT3& maximum, XMFLOAT3 const& otherMinimum, XMFLOAT3 const& otherMaximum)
+	{
+		minimum.x = otherMinimum.x < minimum.x ? otherMinimum.x : minimum.x;
+		minimum.y = otherMinimum.y < minimum.y ? otherMinimum.y : minimum.y;
+		minimum.z = otherMinimum.z < minimum.z ? otherMinimum.z : minimum.z;
+		maximum.x = otherMaximum.x > maximum.x ? otherMaximum.x : maximum.x;
+		maximum.y = otherMaximum.y > maximum.y ? otherMaximum.y : maximum.y;
+		maximum.z = otherMaximum.z > maximum.z ? otherMaximum.z : maximum.z;
+	}
+
+	void ResetBounds(XMFLOAT3& minimum, XMFLOAT3& maximum)
+	{
+		minimum = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		maximum = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+
+	// Half the surface area, the heuristic only compares ratios.
+	float SurfaceArea(XMFLOAT3 const& minimum, XMFLOAT3 const& maximum)
+	{
+		float const	x = maximum.x - minimum.x;
+		float const	y = maximum.y - minimum.y;
+		float const	z = maximum.z - minimum.z;
+		return x * y + y * z + z * x;
+	}
+
+	// False when the box is outside one of the planes. Planes it is entirely in front of are cleared from activePlanes.
+	bool ClassifyBox(XMFLOAT4 const planes[FrustumCuller::PlaneCount], uint32& activePlanes, XMFLOAT3 const& minimum, XMFLOAT3 const& maximum)
+	{
+		float const	centerX = (minimum.x + maximum.x) * 0.5f;
+		float const	centerY = (minimum.y + maximum.y) * 0.5f;
+		float const	centerZ = (minimum.z + maximum.z) * 0.5f;
+		float const	extentX = (maximum.x - minimum.x) * 0.5f;
+		float const	extentY = (maximum.y - minimum.y) * 0.5f;
+		float const	extentZ = (maximum.z - minimum.z) * 0.5f;
+
+		for (auto i = 0; i < FrustumCuller::PlaneCount; ++i)
+		{
+			if (!(activePlanes & (1 << i)))
+				continue;
+
+			XMFLOAT4 const&	plane = planes[i];
+			float const		distance = plane.x * centerX + plane.y * centerY + plane.z * centerZ + plane.w;
+			float const		radius = fabsf(plane.x) * extentX + fabsf(plane.y) * extentY + fabsf(plane.z) * extentZ;
+			if (distance + radius < 0.0f)
+				return false;
+			if (distance - radius >= 0.0f)
+				activePlanes &= ~(1 << i);
+		}
+		return true;
+	}
+
+	// Slab test, the entry distance when the ray enters the box before limit, FLT_MAX otherwise.
+	float IntersectRay(XMFLOAT3 const& origin, XMFLOAT3 const& inverseDirection, float limit, XMFLOAT3 const& minimum, XMFLOAT3 const& maximum)
+	{
+		float	entryDistance = 0.0f;
+		float	exitDistance = limit;
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			float	slabNear = (Component(minimum, axis) - Component(origin, axis)) * Component(inverseDirection, axis);
+			float	slabFar = (Component(maximum, axis) - Component(origin, axis)) * Component(inverseDirection, axis);
+			if (slabNear > slabFar)
+				std::swap(slabNear, slabFar);
+			entryDistance = slabNear > entryDistance ? slabNear : entryDistance;
+			exitDistance = slabFar < exitDistance ? slabFar : exitDistance;
+			if (entryDistance > exitDistance)
+				return FLT_MAX;
+		}
+		return entryDistance;
+	}
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() :
+m_nodeCount(0)
+{
+}
+
+void BoundingVolumeHierarchy::Build(BoundingBox const* bounds, uint32 count, bool parallel)
+{
+	Clear();
+	if (!count)
+		return;
+
+	m_minimum.resize(count);
+	m_maximum.resize(count);
+	m_centroid.resize(count);
+	m_order.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		BoundingBox const&	box = bounds[i];
+		m_minimum[i] = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+		m_maximum[i] = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+		m_centroid[i] = box.Center;
+		m_order[i] = i;
+	}
+
+	// A binary tree over n leaves never needs more than 2n - 1 nodes.
+	m_nodes.resize(2 * count - 1);
+	m_nodeCount = 1;
+	BuildNode(0, 0, count, 0, parallel);
+	m_nodes.resize(m_nodeCount);
+}
+
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_order.clear();
+	m_minimum.clear();
+	m_maximum.clear();
+	m_centroid.clear();
+	m_nodeCount = 0;
+}
+
+void BoundingVolumeHierarchy::UpdateBounds(uint32 primitive, BoundingBox const& box)
+{
+	m_minimum[primitive] = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+	m_maximum[primitive] = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+	m_centroid[primitive] = box.Center;
+}
+
+// Children are always allocated after their parent, so one backward pass sees every child before its parent.
+void BoundingVolumeHierarchy::Refit()
+{
+	for (auto index = m_nodes.size(); index-- > 0;)
+	{
+		Node&	node = m_nodes[index];
+		ResetBounds(node.Minimum, node.Maximum);
+		if (node.Count)
+		{
+			for (auto i = node.Offset; i < node.Offset + node.Count; ++i)
+				Grow(node.Minimum, node.Maximum, m_minimum[m_order[i]], m_maximum[m_order[i]]);
+		}
+		else
+		{
+			Grow(node.Minimum, node.Maximum, m_nodes[node.Offset].Minimum, m_nodes[node.Offset].Maximum);
+			Grow(node.Minimum, node.Maximum, m_nodes[node.Offset + 1].Minimum, m_nodes[node.Offset + 1].Maximum);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::Cull(CXMMATRIX viewProjection, std::vector<uint32>& visible) const
+{
+	if (m_nodes.empty())
+		return;
+
+	XMFLOAT4	planes[FrustumCuller::PlaneCount];
+	FrustumCuller::ExtractPlanes(viewProjection, planes);
+
+	// A subtree only gets tested against the planes its parent straddles.
+	struct Entry
+	{
+		uint32	Node;
+		uint32	Planes;
+	};
+
+	Entry	stack[STACK_SIZE];
+	uint32	stackSize = 0;
+	stack[stackSize].Node = 0;
+	stack[stackSize++].Planes = ALL_PLANES;
+
+	while (stackSize)
+	{
+		Entry	entry = stack[--stackSize];
+		Node const&	node = m_nodes[entry.Node];
+		if (!ClassifyBox(planes, entry.Planes, node.Minimum, node.Maximum))
+			continue;
+
+		if (!entry.Planes)
+			AppendSubtree(entry.Node, visible);
+		else if (node.Count)
+		{
+			for (auto i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				uint32	primitivePlanes = entry.Planes;
+				if (ClassifyBox(planes, primitivePlanes, m_minimum[m_order[i]], m_maximum[m_order[i]]))
+					visible.push_back(m_order[i]);
+			}
+		}
+		else
+		{
+			stack[stackSize].Node = node.Offset + 1;
+			stack[stackSize++].Planes = entry.Planes;
+			stack[stackSize].Node = node.Offset;
+			stack[stackSize++].Planes = entry.Planes;
+		}
+	}
+}
+
+uint32 BoundingVolumeHierarchy::RayCast(FXMVECTOR origin, FXMVECTOR direction, float& distance) const
+{
+	distance = FLT_MAX;
+	if (m_nodes.empty())
+		return InvalidPrimitive;
+
+	XMFLOAT3	rayOrigin;
+	XMFLOAT3	inverseDirection;
+	XMStoreFloat3(&rayOrigin, origin);
+	XMStoreFloat3(&inverseDirection, XMVectorReciprocal(direction));
+
+	struct Entry
+	{
+		uint32	Node;
+		float	Distance;
+	};
+
+	Entry	stack[STACK_SIZE];
+	uint32	stackSize = 0;
+	uint32	nearest = InvalidPrimitive;
+
+	float const	rootDistance = IntersectRay(rayOrigin, inverseDirection, distance, m_nodes[0].Minimum, m_nodes[0].Maximum);
+	if (rootDistance != FLT_MAX)
+	{
+		stack[stackSize].Node = 0;
+		stack[stackSize++].Distance = rootDistance;
+	}
+
+	while (stackSize)
+	{
+		Entry const	entry = stack[--stackSize];
+		if (entry.Distance >= distance)
+			continue;
+
+		Node const&	node = m_nodes[entry.Node];
+		if (node.Count)
+		{
+			for (auto i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				uint32 const	primitive = m_order[i];
+				float const		hit = IntersectRay(rayOrigin, inverseDirection, distance, m_minimum[primitive], m_maximum[primitive]);
+				if (hit < distance)
+				{
+					distance = hit;
+					nearest = primitive;
+				}
+			}
+			continue;
+		}
+
+		// The nearer child goes on top so it is visited first and tightens the limit for the other one.
+		uint32	nearChild = node.Offset;
+		uint32	farChild = node.Offset + 1;
+		float	nearDistance = IntersectRay(rayOrigin, inverseDirection, distance, m_nodes[nearChild].Minimum, m_nodes[nearChild].Maximum);
+		float	farDistance = IntersectRay(rayOrigin, inverseDirection, distance, m_nodes[farChild].Minimum, m_nodes[farChild].Maximum);
+		if (farDistance < nearDistance)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+
+		if (farDistance != FLT_MAX)
+		{
+			stack[stackSize].Node = farChild;
+			stack[stackSize++].Distance = farDistance;
+		}
+		if (nearDistance != FLT_MAX)
+		{
+			stack[stackSize].Node = nearChild;
+			stack[stackSize++].Distance = nearDistance;
+		}
+	}
+
+	return nearest;
+}
+
+uint32 BoundingVolumeHierarchy::GetPrimitiveCount() const
+{
+	return static_cast<uint32>(m_order.size());
+}
+
+uint32 BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return static_cast<uint32>(m_nodes.size());
+}
+
+void BoundingVolumeHierarchy::BuildNode(uint32 nodeIndex, uint32 begin, uint32 end, uint32 depth, bool parallel)
+{
+	Node&			node = m_nodes[nodeIndex];
+	uint32 const	count = end - begin;
+
+	XMFLOAT3	centroidMinimum;
+	XMFLOAT3	centroidMaximum;
+	ResetBounds(node.Minimum, node.Maximum);
+	ResetBounds(centroidMinimum, centroidMaximum);
+	for (auto i = begin; i < end; ++i)
+	{
+		uint32 const	primitive = m_order[i];
+		Grow(node.Minimum, node.Maximum, m_minimum[primitive], m_maximum[primitive]);
+		Grow(centroidMinimum, centroidMaximum, m_centroid[primitive], m_centroid[primitive]);
+	}
+
+	if (count <= 2 || depth >= MAX_TREE_DEPTH)
+	{
+		node.Offset = begin;
+		node.Count = count;
+		return;
+	}
+
+	int		axis = 0;
+	float	extent = centroidMaximum.x - centroidMinimum.x;
+	for (auto i = 1; i < 3; ++i)
+	{
+		float const	axisExtent = Component(centroidMaximum, i) - Component(centroidMinimum, i);
+		if (axisExtent > extent)
+		{
+			axis = i;
+			extent = axisExtent;
+		}
+	}
+
+	uint32	middle = begin + count / 2;
+	if (extent > 0.0f)
+	{
+		struct Bin
+		{
+			XMFLOAT3	Minimum;
+			XMFLOAT3	Maximum;
+			uint32		Count;
+		};
+
+		float const	origin = Component(centroidMinimum, axis);
+		float const	scale = BIN_COUNT / extent;
+		auto const	binIndex = [&](uint32 primitive)
+		{
+			uint32 const	bin = static_cast<uint32>((Component(m_centroid[primitive], axis) - origin) * scale);
+			return bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+		};
+
+		Bin	bins[BIN_COUNT];
+		for (auto& bin : bins)
+		{
+			ResetBounds(bin.Minimum, bin.Maximum);
+			bin.Count = 0;
+		}
+		for (auto i = begin; i < end; ++i)
+		{
+			uint32 const	primitive = m_order[i];
+			Bin&			bin = bins[binIndex(primitive)];
+			Grow(bin.Minimum, bin.Maximum, m_minimum[primitive], m_maximum[primitive]);
+			++bin.Count;
+		}
+
+		// Cost of everything right of each split plane, then a left sweep to pick the cheapest plane.
+		float		rightCosts[BIN_COUNT - 1];
+		XMFLOAT3	sweepMinimum;
+		XMFLOAT3	sweepMaximum;
+		uint32		sweepCount = 0;
+		ResetBounds(sweepMinimum, sweepMaximum);
+		for (auto bin = BIN_COUNT - 1; bin > 0; --bin)
+		{
+			Grow(sweepMinimum, sweepMaximum, bins[bin].Minimum, bins[bin].Maximum);
+			sweepCount += bins[bin].Count;
+			rightCosts[bin - 1] = sweepCount ? SurfaceArea(sweepMinimum, sweepMaximum) * sweepCount : 0.0f;
+		}
+
+		float	bestCost = FLT_MAX;
+		uint32	bestSplit = 0;
+		sweepCount = 0;
+		ResetBounds(sweepMinimum, sweepMaximum);
+		for (uint32 bin = 0; bin < BIN_COUNT - 1; ++bin)
+		{
+			Grow(sweepMinimum, sweepMaximum, bins[bin].Minimum, bins[bin].Maximum);
+			sweepCount += bins[bin].Count;
+			float const	cost = (sweepCount ? SurfaceArea(sweepMinimum, sweepMaximum) * sweepCount : 0.0f) + rightCosts[bin];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+
+		// Splitting also costs a traversal step, small ranges that would not gain from it stay leaves.
+		float const	leafCost = SurfaceArea(node.Minimum, node.Maximum) * (count - 1);
+		if (count <= MAX_LEAF_PRIMITIVES && bestCost >= leafCost)
+		{
+			node.Offset = begin;
+			node.Count = count;
+			return;
+		}
+
+		uint32* const	first = m_order.data();
+		middle = static_cast<uint32>(std::partition(first + begin, first + end, [&](uint32 primitive) { return binIndex(primitive) <= bestSplit; }) - first);
+		if (middle == begin || middle == end)
+			middle = begin + count / 2;
+	}
+
+	uint32 const	left = m_nodeCount.fetch_add(2);
+	node.Offset = left;
+	node.Count = 0;
+
+	if (parallel && count >= PARALLEL_BUILD_PRIMITIVES)
+	{
+		JobSystem&	jobSystem = JobSystem::Get();
+		JobCounter	counter;
+		jobSystem.Run([this, left, begin, middle, depth]() { BuildNode(left, begin, middle, depth + 1, true); }, &counter);
+		BuildNode(left + 1, middle, end, depth + 1, true);
+		jobSystem.Wait(counter);
+	}
+	else
+	{
+		BuildNode(left, begin, middle, depth + 1, parallel);
+		BuildNode(left + 1, middle, end, depth + 1, parallel);
+	}
+}
+
+// The primitives of a subtree are contiguous in m_order, between its leftmost and rightmost leaves.
+void BoundingVolumeHierarchy::AppendSubtree(uint32 nodeIndex, std::vector<uint32>& primitives) const
+{
+	uint32	first = nodeIndex;
+	while (!m_nodes[first].Count)
+		first = m_nodes[first].Offset;
+
+	uint32	last = nodeIndex;
+	while (!m_nodes[last].Count)
+		last = m_nodes[last].Offset + 1;
+
+	primitives.insert(primitives.end(), m_order.begin() + m_nodes[first].Offset, m_order.begin() + m_nodes[last].Offset + m_nodes[last].Count);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace Dive
+{
+	// Binary tree of axis-aligned boxes over a set of primitives, split with a binned surface area
+	// heuristic. Subtrees are built concurrently once they are large enough to pay for a task.
+	// Moving primitives only need UpdateBounds and Refit, which keep the topology; rebuild once
+	// they have moved far enough for the tree quality to suffer.
+	class BoundingVolumeHierarchy
+	{
+	public:
+		static uint32 const	InvalidPrimitive = uint32(-1);
+
+		BoundingVolumeHierarchy();
+
+		// Primitive i is bounds[i], every query reports primitives by that index.
+		void	Build(DirectX::BoundingBox const* bounds, uint32 count, bool parallel);
+		void	Clear();
+		void	UpdateBounds(uint32 primitive, DirectX::BoundingBox const& box);
+		void	Refit();
+
+		// Appends every primitive whose box touches the frustum. viewProjection is not transposed.
+		void	Cull(DirectX::CXMMATRIX viewProjection, std::vector<uint32>& visible) const;
+		// Nearest primitive whose box the ray enters, distance is in units of direction.
+		uint32	RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& distance) const;
+
+		uint32	GetPrimitiveCount() const;
+		uint32	GetNodeCount() const;
+
+	private:
+		struct Node
+		{
+			DirectX::XMFLOAT3	Minimum;
+			// Primitives in a leaf, 0 for an inner node.
+			uint32				Count;
+			DirectX::XMFLOAT3	Maximum;
+			// First entry of m_order for a leaf, left child for an inner node. The right child follows it.
+			uint32				Offset;
+		};
+
+		void	BuildNode(uint32 nodeIndex, uint32 begin, uint32 end, uint32 depth, bool parallel);
+		void	AppendSubtree(uint32 nodeIndex, std::vector<uint32>& primitives) const;
+
+		std::vector<Node>				m_nodes;
+		std::vector<uint32>				m_order;
+		std::vector<DirectX::XMFLOAT3>	m_minimum;
+		std::vector<DirectX::XMFLOAT3>	m_maximum;
+		std::vector<DirectX::XMFLOAT3>	m_centroid;
+		std::atomic<uint32>				m_nodeCount;
+	};
+}
\ No newline at end of file
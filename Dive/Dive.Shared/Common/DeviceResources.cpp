@@ -57,6 +57,7 @@ m_logicalSize(),
 m_nativeOrientation(DisplayOrientations::None),
 m_currentOrientation(DisplayOrientations::None),
 m_dpi(-1.0f),
+m_renderScale(1.0f),
 m_deviceNotify(nullptr)
 {
 	CreateDeviceIndependentResources();
@@ -202,6 +203,10 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 	m_d3dRenderTargetSize.Width = swapDimension ? m_outputSize.Height : m_outputSize.Width;
 	m_d3dRenderTargetSize.Height = swapDimension ? m_outputSize.Width : m_outputSize.Height;
 
+	// The swap chain stretches the smaller buffers over the window.
+	m_d3dRenderTargetSize.Width = max(floorf(m_d3dRenderTargetSize.Width * m_renderScale + 0.5f), 1);
+	m_d3dRenderTargetSize.Height = max(floorf(m_d3dRenderTargetSize.Height * m_renderScale + 0.5f), 1);
+
 	if (m_swapChain != nullptr)
 	{
 		HRESULT	hr = m_swapChain->ResizeBuffers(
@@ -234,7 +239,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		swapChainDesc.BufferCount = 2;
 		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
 		swapChainDesc.Flags = 0;
-		swapChainDesc.Scaling = DXGI_SCALING_NONE;
+		swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
 		swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
 
 		ComPtr<IDXGIDevice3>	dxgiDevice;
@@ -353,8 +358,8 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		D2D1::BitmapProperties1(
 			D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
 			D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
-			m_dpi,
-			m_dpi
+			m_dpi * m_renderScale,
+			m_dpi * m_renderScale
 		);
 
 	ComPtr<IDXGISurface2>	dxgiBackBuffer;
@@ -371,6 +376,8 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		);
 
 	m_d2dContext->SetTarget(m_d2dTargetBitmap.Get());
+	// Keeps the overlay laid out in DIPs of the window.
+	m_d2dContext->SetDpi(m_dpi * m_renderScale, m_dpi * m_renderScale);
 
 	m_d2dContext->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
 }
@@ -449,6 +456,16 @@ void DX::DeviceResources::SetDpi(float dpi)
 	}
 }
 
+void DX::DeviceResources::SetRenderScale(float renderScale)
+{
+	if (renderScale != m_renderScale)
+	{
+		m_renderScale = renderScale;
+
+		CreateWindowSizeDependentResources();
+	}
+}
+
 void DX::DeviceResources::ValidateDevice()
 {
 	ComPtr<IDXGIDevice3> dxgiDevice;
@@ -542,6 +559,11 @@ Windows::Foundation::Size DX::DeviceResources::GetLogicalSize() const
 	return m_logicalSize;
 }
 
+float DX::DeviceResources::GetRenderScale() const
+{
+	return m_renderScale;
+}
+
 ID3D11Device2* DX::DeviceResources::GetD3DDevice() const
 {
 	return m_d3dDevice.Get();
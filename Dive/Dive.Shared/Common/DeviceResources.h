@@ -17,6 +17,7 @@ namespace DX
 		void	SetLogicalSize(Windows::Foundation::Size logicalSize);
 		void	SetCurrentOrientation(Windows::Graphics::Display::DisplayOrientations currentOrientation);
 		void	SetDpi(float dpi);
+		void	SetRenderScale(float renderScale);
 		void	ValidateDevice();
 		void	HandleDeviceLost();
 		void	RegisterDeviceNotify(IDeviceNotify* deviceNotify);
@@ -26,6 +27,7 @@ namespace DX
 		// Device Accessors
 		Windows::Foundation::Size	GetOutputSize() const;
 		Windows::Foundation::Size	GetLogicalSize() const;
+		float						GetRenderScale() const;
 
 		// D3D Accessors
 		ID3D11Device2*			GetD3DDevice() const;
@@ -83,6 +85,7 @@ namespace DX
 		Windows::Graphics::Display::DisplayOrientations	m_nativeOrientation;
 		Windows::Graphics::Display::DisplayOrientations	m_currentOrientation;
 		float											m_dpi;
+		float											m_renderScale;
 
 		// Transforms used for display orientation
 		D2D1::Matrix3x2F	m_orientationTransform2D;
@@ -1,30 +1,103 @@
 #pragma once
 
+#if defined(_WIN32)
 #include <wrl.h>
+#elif defined(__linux__)
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
+#include <cstdlib>
 
 namespace DX
 {
+	// Monotonic counter the timer reads, in counts of GetFrequency per second.
+	class StepClock
+	{
+	public:
+		virtual ~StepClock() { }
+
+		virtual uint64	GetCounter() const = 0;
+		virtual uint64	GetFrequency() const = 0;
+	};
+
+	// QueryPerformanceCounter on Windows, the raw monotonic clock on Linux, which NTP does not slew.
+	class SystemStepClock : public StepClock
+	{
+	public:
+		static SystemStepClock const&	Get()
+		{
+			static SystemStepClock	s_clock;
+			return s_clock;
+		}
+
+		virtual uint64	GetCounter() const override
+		{
+#if defined(_WIN32)
+			LARGE_INTEGER	counter;
+			QueryPerformanceCounter(&counter);
+			return counter.QuadPart;
+#elif defined(__linux__)
+			timespec	time;
+			clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+			return static_cast<uint64>(time.tv_sec) * 1000000000ull + time.tv_nsec;
+#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		virtual uint64	GetFrequency() const override
+		{
+#if defined(_WIN32)
+			LARGE_INTEGER	frequency;
+			QueryPerformanceFrequency(&frequency);
+			return frequency.QuadPart;
+#else
+			return 1000000000ull;
+#endif
+		}
+	};
+
+	// Only moves when told to, so that timing code behaves the same on every run.
+	class ManualStepClock : public StepClock
+	{
+	public:
+		explicit ManualStepClock(uint64 frequency = 10000000) : m_counter(0), m_frequency(frequency) { }
+
+		void	Advance(uint64 counts)			{ m_counter += counts; }
+		void	AdvanceSeconds(double seconds)	{ m_counter += static_cast<uint64>(seconds * m_frequency + 0.5); }
+
+		virtual uint64	GetCounter() const override		{ return m_counter; }
+		virtual uint64	GetFrequency() const override	{ return m_frequency; }
+
+	private:
+		uint64	m_counter;
+		uint64	m_frequency;
+	};
+
 	class StepTimer
 	{
 	public:
-		StepTimer() :
+		// clock has to outlive the timer and its copies.
+		explicit StepTimer(StepClock const& clock = SystemStepClock::Get()) :
+			m_clock(&clock),
 			m_elapsedTicks(0),
 			m_totalTicks(0),
 			m_leftOverTicks(0),
 			m_frameCount(0),
 			m_framesPerSecond(0),
 			m_framesThisSecond(0),
-			m_qpcSecondCounter(0),
+			m_secondCounter(0),
 			m_isFixedTimeStep(false),
-			m_targetElapsedTicks(TicksPerSecond / 60)
+			m_targetElapsedTicks(TicksPerSecond / 60),
+			m_maxStepsPerTick(0),
+			m_droppedTicks(0),
+			m_interpolationAlpha(1.0)
 		{
-			if (!QueryPerformanceFrequency(&m_qpcFrenquency))
-				throw ref new Platform::FailureException();
-
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-				throw ref new Platform::FailureException();
-
-			m_qpcMaxDelta = m_qpcFrenquency.QuadPart / 10;
+			m_counterFrequency = m_clock->GetFrequency();
+			m_lastCounter = m_clock->GetCounter();
+			m_maxDelta = m_counterFrequency / 10;
 		}
 
 		uint64	GetElapsedTicks() const							{ return m_elapsedTicks; }
@@ -42,6 +115,17 @@ namespace DX
 		void	SetTargetElapsedTicks(uint64 targetElapsed)		{ m_targetElapsedTicks = targetElapsed; }
 		void	SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+		// Fixed steps a single Tick may run to catch up, 0 for no limit. The time past the limit is dropped
+		// rather than simulated, so a slow frame cannot make the next one slower still. The dropped time
+		// also counts whatever a Tick clamps off a delta longer than a tenth of a second.
+		void	SetMaxStepsPerTick(uint32 maxSteps)				{ m_maxStepsPerTick = maxSteps; }
+		uint64	GetDroppedTicks() const							{ return m_droppedTicks; }
+		double	GetDroppedSeconds() const						{ return TicksToSeconds(m_droppedTicks); }
+
+		// How far the last Tick got between the last fixed step and the next one, to blend the two latest
+		// simulation states. Always 1 with a variable step.
+		double	GetInterpolationAlpha() const					{ return m_interpolationAlpha; }
+
 		static const uint64	TicksPerSecond = 10000000;
 
 		static double	TicksToSeconds(uint64 ticks)			{ return static_cast<double>(ticks) / TicksPerSecond; }
@@ -49,45 +133,56 @@ namespace DX
 
 		void	ResetElapsedTime()
 		{
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-				throw ref new Platform::FailureException();
+			m_lastCounter = m_clock->GetCounter();
 
 			m_leftOverTicks = 0;
 			m_framesPerSecond = 0;
 			m_framesThisSecond = 0;
-			m_qpcSecondCounter = 0;
+			m_secondCounter = 0;
 		}
 
 		template<typename TUpdate>
 		void	Tick(TUpdate const& update)
 		{
-			LARGE_INTEGER	currentTime;
+			uint64 const	currentCounter = m_clock->GetCounter();
 
-			if (!QueryPerformanceCounter(&currentTime))
-				throw ref new Platform::FailureException();
+			uint64	timeDelta = currentCounter - m_lastCounter;
 
-			uint64	timeDelta = currentTime.QuadPart - m_qpcLastTime.QuadPart;
+			m_lastCounter = currentCounter;
+			m_secondCounter += timeDelta;
 
-			m_qpcLastTime = currentTime;
-			m_qpcSecondCounter += timeDelta;
-
-			if (timeDelta > m_qpcMaxDelta)
-				timeDelta = m_qpcMaxDelta;
+			if (timeDelta > m_maxDelta)
+			{
+				// In whole seconds first, a long pause would overflow the product.
+				uint64 const	excess = timeDelta - m_maxDelta;
+				m_droppedTicks += excess / m_counterFrequency * TicksPerSecond + excess % m_counterFrequency * TicksPerSecond / m_counterFrequency;
+				timeDelta = m_maxDelta;
+			}
 
 			timeDelta *= TicksPerSecond;
-			timeDelta /= m_qpcFrenquency.QuadPart;
+			timeDelta /= m_counterFrequency;
 
 			uint32	lastFrameCount = m_frameCount;
 
 			if (m_isFixedTimeStep)
 			{
-				if (abs(static_cast<int64>(timeDelta - m_targetElapsedTicks)) < TicksPerSecond / 4000)
+				if (std::llabs(static_cast<long long>(timeDelta - m_targetElapsedTicks)) < static_cast<long long>(TicksPerSecond / 4000))
 					timeDelta = m_targetElapsedTicks;
 
 				m_leftOverTicks += timeDelta;
 
+				uint32	steps = 0;
 				while (m_leftOverTicks >= m_targetElapsedTicks)
 				{
+					if (m_maxStepsPerTick && steps == m_maxStepsPerTick)
+					{
+						uint64 const	dropped = m_leftOverTicks - m_leftOverTicks % m_targetElapsedTicks;
+						m_droppedTicks += dropped;
+						m_leftOverTicks -= dropped;
+						break;
+					}
+					steps++;
+
 					m_elapsedTicks = m_targetElapsedTicks;
 					m_totalTicks += m_targetElapsedTicks;
 					m_leftOverTicks -= m_targetElapsedTicks;
@@ -95,6 +190,8 @@ namespace DX
 
 					update();
 				}
+
+				m_interpolationAlpha = static_cast<double>(m_leftOverTicks) / m_targetElapsedTicks;
 			}
 			else
 			{
@@ -104,23 +201,26 @@ namespace DX
 				m_frameCount++;
 
 				update();
+
+				m_interpolationAlpha = 1.0;
 			}
 
 			if (m_frameCount != lastFrameCount)
 				m_framesThisSecond++;
 
-			if (m_qpcSecondCounter >= static_cast<uint64>(m_qpcFrenquency.QuadPart))
+			if (m_secondCounter >= m_counterFrequency)
 			{
 				m_framesPerSecond = m_framesThisSecond;
 				m_framesThisSecond = 0;
-				m_qpcSecondCounter %= m_qpcFrenquency.QuadPart;
+				m_secondCounter %= m_counterFrequency;
 			}
 		}
 
 	private:
-		LARGE_INTEGER	m_qpcFrenquency;
-		LARGE_INTEGER	m_qpcLastTime;
-		uint64			m_qpcMaxDelta;
+		StepClock const*	m_clock;
+		uint64				m_counterFrequency;
+		uint64				m_lastCounter;
+		uint64				m_maxDelta;
 
 		uint64	m_elapsedTicks;
 		uint64	m_totalTicks;
@@ -129,9 +229,12 @@ namespace DX
 		uint32	m_frameCount;
 		uint32	m_framesPerSecond;
 		uint32	m_framesThisSecond;
-		uint64	m_qpcSecondCounter;
+		uint64	m_secondCounter;
 
 		bool	m_isFixedTimeStep;
 		uint64	m_targetElapsedTicks;
+		uint32	m_maxStepsPerTick;
+		uint64	m_droppedTicks;
+		double	m_interpolationAlpha;
 	};
 }
\ No newline at end of file
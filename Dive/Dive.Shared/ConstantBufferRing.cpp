@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "ConstantBufferRing.h"
+
+using namespace Dive;
+
+ConstantBufferRing::ConstantBufferRing(std::shared_ptr<RenderDevice> const& renderDevice, uint32 frameSize) :
+m_renderDevice(renderDevice),
+m_frame(0),
+m_frameSize((frameSize + Alignment - 1) & ~(Alignment - 1)),
+m_head(0),
+m_mapped(nullptr),
+m_mappedHead(0),
+m_stalls(0),
+m_available(false)
+{
+}
+
+ConstantBufferRing::~ConstantBufferRing()
+{
+	Unmap();
+}
+
+void ConstantBufferRing::CreateDeviceDependentResources()
+{
+	m_available = m_renderDevice->SupportsConstantBufferOffsets();
+	if (!m_available)
+		return;
+
+	for (auto& frame : m_frames)
+	{
+		frame.Buffer = m_renderDevice->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_DYNAMIC, m_frameSize, nullptr);
+		frame.Size = m_frameSize;
+		frame.Fence = 0;
+		frame.Fresh = true;
+	}
+}
+
+void ConstantBufferRing::ReleaseDeviceDependentResources()
+{
+	Unmap();
+	m_available = false;
+	for (auto& frame : m_frames)
+	{
+		frame.Buffer.reset();
+		frame.Size = 0;
+		frame.Fence = 0;
+	}
+}
+
+bool ConstantBufferRing::IsAvailable() const
+{
+	return m_available;
+}
+
+void ConstantBufferRing::BeginFrame()
+{
+	if (!m_available)
+		return;
+
+	m_frame = (m_frame + 1) % FrameCount;
+	m_head = 0;
+
+	FrameBuffer&	frame = m_frames[m_frame];
+	if (frame.Fence && !m_renderDevice->IsFenceComplete(frame.Fence))
+	{
+		m_renderDevice->WaitForFence(frame.Fence);
+		++m_stalls;
+	}
+
+	if (frame.Size < m_frameSize)
+	{
+		frame.Buffer = m_renderDevice->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_DYNAMIC, m_frameSize, nullptr);
+		frame.Size = m_frameSize;
+		frame.Fresh = true;
+	}
+}
+
+void* ConstantBufferRing::Allocate(uint32 size, uint32& offset)
+{
+	FrameBuffer&	frame = m_frames[m_frame];
+	uint32 const	alignedSize = (size + Alignment - 1) & ~(Alignment - 1);
+	if (!m_available || m_head + alignedSize > frame.Size)
+	{
+		if (m_available)
+		{
+			while (m_frameSize < m_head + alignedSize)
+				m_frameSize *= 2;
+		}
+		return nullptr;
+	}
+
+	if (!m_mapped)
+	{
+		m_mapped = static_cast<uint8*>(m_renderDevice->MapBuffer(frame.Buffer.get(), frame.Fresh ? MAP_WRITE_DISCARD : MAP_WRITE_NO_OVERWRITE));
+		frame.Fresh = false;
+		m_mappedHead = m_head;
+	}
+
+	offset = m_head;
+	m_head += alignedSize;
+	return m_mapped + offset;
+}
+
+void ConstantBufferRing::Unmap()
+{
+	if (!m_mapped)
+		return;
+
+	m_renderDevice->UnmapBuffer(m_frames[m_frame].Buffer.get(), m_mappedHead, m_head - m_mappedHead);
+	m_mapped = nullptr;
+}
+
+void ConstantBufferRing::EndFrame()
+{
+	if (!m_available)
+		return;
+
+	Unmap();
+	m_frames[m_frame].Fence = m_renderDevice->InsertFence();
+}
+
+RenderBuffer* ConstantBufferRing::GetBuffer() const
+{
+	return m_frames[m_frame].Buffer.get();
+}
+
+uint32 ConstantBufferRing::GetUsedBytes() const
+{
+	return m_head;
+}
+
+uint32 ConstantBufferRing::GetStallCount() const
+{
+	return m_stalls;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+namespace Dive
+{
+	// Per-frame constant memory for draws. Each frame in flight owns one dynamic constant buffer,
+	// mapped no-overwrite and handed out in 256-byte steps, the granularity of constant buffer
+	// offsets. The fence inserted at the end of a frame keeps its buffer from being rewritten until
+	// the GPU has consumed it. A frame that runs out of space falls back to the caller's own
+	// constant buffer and the next frames get a buffer twice as large.
+	class ConstantBufferRing
+	{
+	public:
+		static uint32 const	Alignment = 256;
+		static uint32 const	FrameCount = 3;
+
+		ConstantBufferRing(std::shared_ptr<RenderDevice> const& renderDevice, uint32 frameSize);
+		~ConstantBufferRing();
+
+		void	CreateDeviceDependentResources();
+		void	ReleaseDeviceDependentResources();
+
+		// False when the device cannot bind constant buffer ranges, callers update a buffer per draw instead.
+		bool	IsAvailable() const;
+		void	BeginFrame();
+		// Space for size bytes in the current frame's buffer, nullptr when the frame is full.
+		void*	Allocate(uint32 size, uint32& offset);
+		// The buffer has to be unmapped before any draw reads from it, later allocations map it again.
+		void	Unmap();
+		void	EndFrame();
+
+		RenderBuffer*	GetBuffer() const;
+		uint32			GetUsedBytes() const;
+		uint32			GetStallCount() const;
+
+	private:
+		struct FrameBuffer
+		{
+			FrameBuffer() : Size(0), Fence(0), Fresh(true) { }
+
+			std::unique_ptr<RenderBuffer>	Buffer;
+			uint32							Size;
+			uint64							Fence;
+			// Never mapped yet, the first map discards.
+			bool							Fresh;
+		};
+
+		std::shared_ptr<RenderDevice>	m_renderDevice;
+
+		FrameBuffer	m_frames[FrameCount];
+		uint32		m_frame;
+		uint32		m_frameSize;
+		uint32		m_head;
+		uint8*		m_mapped;
+		// m_head when the buffer was mapped, the start of the range written since.
+		uint32		m_mappedHead;
+		uint32		m_stalls;
+		bool		m_available;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,551 @@
+#include "pch.h"
+#include "D3D11RenderDevice.h"
+#include "MemoryTracker.h"
+#include "Common/directxhelper.h"
+
+#include <vector>
+
+using namespace DirectX;
+using namespace Dive;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	class D3D11Buffer : public RenderBuffer
+	{
+	public:
+		explicit D3D11Buffer(uint32 byteWidth) : Memory(MemoryTracker::GetScopeCategory(), MEMORY_GPU, byteWidth) { }
+
+		ComPtr<ID3D11Buffer>	Buffer;
+		MemoryAllocation		Memory;
+	};
+
+	class D3D11InputLayout : public RenderInputLayout
+	{
+	public:
+		ComPtr<ID3D11InputLayout>	InputLayout;
+	};
+
+	class D3D11VertexShader : public RenderVertexShader
+	{
+	public:
+		ComPtr<ID3D11VertexShader>	VertexShader;
+	};
+
+	class D3D11PixelShader : public RenderPixelShader
+	{
+	public:
+		ComPtr<ID3D11PixelShader>	PixelShader;
+	};
+
+	class D3D11TextureView : public RenderTextureView
+	{
+	public:
+		explicit D3D11TextureView(uint64 byteSize) : Memory(MEMORY_TEXTURE, MEMORY_GPU, byteSize) { }
+
+		ComPtr<ID3D11ShaderResourceView>	View;
+		MemoryAllocation					Memory;
+	};
+
+	class D3D11TextFormat : public RenderTextFormat
+	{
+	public:
+		ComPtr<IDWriteTextFormat>	TextFormat;
+	};
+
+	class D3D11TextLayout : public RenderTextLayout
+	{
+	public:
+		ComPtr<IDWriteTextLayout>	TextLayout;
+	};
+
+	class D3D11Query : public RenderQuery
+	{
+	public:
+		ComPtr<ID3D11Query>	Query;
+	};
+
+	ID3D11Buffer* GetBuffer(RenderBuffer* buffer)
+	{
+		return buffer ? static_cast<D3D11Buffer*>(buffer)->Buffer.Get() : nullptr;
+	}
+
+	ID3D11Query* GetQuery(RenderQuery* query)
+	{
+		return static_cast<D3D11Query*>(query)->Query.Get();
+	}
+}
+
+D3D11RenderDevice::D3D11RenderDevice(std::shared_ptr<DX::DeviceResources> const& deviceResources) :
+m_deviceResources(deviceResources),
+m_lastFence(0),
+m_completedFence(0)
+{
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD2DFactory()->CreateDrawingStateBlock(&m_stateBlock)
+		);
+}
+
+std::unique_ptr<RenderBuffer> D3D11RenderDevice::CreateBuffer(BufferBinding binding, BufferUsage usage, uint32 byteWidth, void const* initialData)
+{
+	static UINT const			bindFlags[] = { D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER, D3D11_BIND_CONSTANT_BUFFER };
+	static D3D11_USAGE const	usages[] = { D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DEFAULT, D3D11_USAGE_DYNAMIC };
+
+	CD3D11_BUFFER_DESC	bufferDesc(byteWidth, bindFlags[binding], usages[usage], usage == USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0);
+
+	D3D11_SUBRESOURCE_DATA	bufferData = { 0 };
+	bufferData.pSysMem = initialData;
+	bufferData.SysMemPitch = 0;
+	bufferData.SysMemSlicePitch = 0;
+
+	std::unique_ptr<D3D11Buffer>	buffer(new D3D11Buffer(byteWidth));
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+		&bufferDesc,
+		initialData ? &bufferData : nullptr,
+		&buffer->Buffer
+		)
+		);
+	return std::move(buffer);
+}
+
+std::unique_ptr<RenderVertexShader> D3D11RenderDevice::CreateVertexShader(void const* bytecode, size_t bytecodeLength)
+{
+	std::unique_ptr<D3D11VertexShader>	vertexShader(new D3D11VertexShader());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateVertexShader(
+		bytecode,
+		bytecodeLength,
+		nullptr,
+		&vertexShader->VertexShader
+		)
+		);
+	return std::move(vertexShader);
+}
+
+std::unique_ptr<RenderPixelShader> D3D11RenderDevice::CreatePixelShader(void const* bytecode, size_t bytecodeLength)
+{
+	std::unique_ptr<D3D11PixelShader>	pixelShader(new D3D11PixelShader());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreatePixelShader(
+		bytecode,
+		bytecodeLength,
+		nullptr,
+		&pixelShader->PixelShader
+		)
+		);
+	return std::move(pixelShader);
+}
+
+std::unique_ptr<RenderInputLayout> D3D11RenderDevice::CreateInputLayout(InputElement const* elements, uint32 elementCount, void const* vertexShaderBytecode, size_t bytecodeLength)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC>	elementDescs(elementCount);
+	for (uint32 i = 0; i < elementCount; ++i)
+	{
+		elementDescs[i].SemanticName = elements[i].SemanticName;
+		elementDescs[i].SemanticIndex = elements[i].SemanticIndex;
+		elementDescs[i].Format = elements[i].Format;
+		elementDescs[i].InputSlot = elements[i].InputSlot;
+		elementDescs[i].AlignedByteOffset = elements[i].AlignedByteOffset;
+		elementDescs[i].InputSlotClass = elements[i].InstanceStepRate ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		elementDescs[i].InstanceDataStepRate = elements[i].InstanceStepRate;
+	}
+
+	std::unique_ptr<D3D11InputLayout>	inputLayout(new D3D11InputLayout());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateInputLayout(
+		elementDescs.data(),
+		elementCount,
+		vertexShaderBytecode,
+		bytecodeLength,
+		&inputLayout->InputLayout
+		)
+		);
+	return std::move(inputLayout);
+}
+
+std::unique_ptr<RenderTextureView> D3D11RenderDevice::CreateTextureView(ScratchImage const& image)
+{
+	std::unique_ptr<D3D11TextureView>	textureView(new D3D11TextureView(image.GetPixelsSize()));
+	DX::ThrowIfFailed(
+		DirectX::CreateShaderResourceView(
+		m_deviceResources->GetD3DDevice(),
+		image.GetImages(),
+		image.GetImageCount(),
+		image.GetMetadata(),
+		&textureView->View
+		)
+		);
+	return std::move(textureView);
+}
+
+std::unique_ptr<RenderTextFormat> D3D11RenderDevice::CreateTextFormat(wchar_t const* fontFamily, float fontSize, TextAlignment alignment)
+{
+	std::unique_ptr<D3D11TextFormat>	textFormat(new D3D11TextFormat());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetDWriteFactory()->CreateTextFormat(
+		fontFamily,
+		nullptr,
+		DWRITE_FONT_WEIGHT_LIGHT,
+		DWRITE_FONT_STYLE_NORMAL,
+		DWRITE_FONT_STRETCH_NORMAL,
+		fontSize,
+		L"en-US",
+		&textFormat->TextFormat
+		)
+		);
+
+	DX::ThrowIfFailed(
+		textFormat->TextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR)
+		);
+
+	DX::ThrowIfFailed(
+		textFormat->TextFormat->SetTextAlignment(alignment == TEXT_ALIGNMENT_TRAILING ? DWRITE_TEXT_ALIGNMENT_TRAILING : DWRITE_TEXT_ALIGNMENT_LEADING)
+		);
+
+	return std::move(textFormat);
+}
+
+std::unique_ptr<RenderTextLayout> D3D11RenderDevice::CreateTextLayout(std::wstring const& text, RenderTextFormat* format, float maxWidth, float maxHeight, TextMetrics& metrics)
+{
+	std::unique_ptr<D3D11TextLayout>	textLayout(new D3D11TextLayout());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetDWriteFactory()->CreateTextLayout(
+		text.c_str(),
+		static_cast<uint32>(text.length()),
+		static_cast<D3D11TextFormat*>(format)->TextFormat.Get(),
+		maxWidth,
+		maxHeight,
+		&textLayout->TextLayout
+		)
+		);
+
+	DWRITE_TEXT_METRICS	textMetrics;
+	DX::ThrowIfFailed(
+		textLayout->TextLayout->GetMetrics(&textMetrics)
+		);
+	metrics.Width = textMetrics.width;
+	metrics.Height = textMetrics.height;
+	metrics.LayoutWidth = textMetrics.layoutWidth;
+	metrics.LayoutHeight = textMetrics.layoutHeight;
+
+	return std::move(textLayout);
+}
+
+std::unique_ptr<RenderQuery> D3D11RenderDevice::CreateQuery(QueryType type)
+{
+	CD3D11_QUERY_DESC	queryDesc(type == QUERY_TIMESTAMP ? D3D11_QUERY_TIMESTAMP : D3D11_QUERY_TIMESTAMP_DISJOINT);
+
+	std::unique_ptr<D3D11Query>	query(new D3D11Query());
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateQuery(&queryDesc, &query->Query)
+		);
+	return std::move(query);
+}
+
+void D3D11RenderDevice::ReleaseDeviceDependentResources()
+{
+	m_whiteBrush.Reset();
+	m_fillBrush.Reset();
+	m_depthState.Reset();
+
+	// The queries die with the device, and so does any work they were waiting for.
+	m_pendingFences.clear();
+	m_freeQueries.clear();
+	m_completedFence = m_lastFence;
+}
+
+void D3D11RenderDevice::BeginFrame(float const clearColor[4])
+{
+	auto	context = m_deviceResources->GetD3DDeviceContext();
+
+	auto	viewport = m_deviceResources->GetScreenViewport();
+	context->RSSetViewports(1, &viewport);
+
+	ID3D11RenderTargetView* const	targets[1] = { m_deviceResources->GetBackBufferRenderTargetView() };
+	context->OMSetRenderTargets(1, targets, m_deviceResources->GetDepthStencilView());
+
+	context->ClearRenderTargetView(m_deviceResources->GetBackBufferRenderTargetView(), clearColor);
+	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+
+	if (!m_depthState)
+	{
+		CD3D11_DEPTH_STENCIL_DESC	depthDesc(D3D11_DEFAULT);
+		depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+		DX::ThrowIfFailed(
+			m_deviceResources->GetD3DDevice()->CreateDepthStencilState(&depthDesc, &m_depthState)
+			);
+	}
+	context->OMSetDepthStencilState(m_depthState.Get(), 0);
+
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D11RenderDevice::Present()
+{
+	m_deviceResources->Present();
+}
+
+void D3D11RenderDevice::SetInputLayout(RenderInputLayout* inputLayout)
+{
+	m_deviceResources->GetD3DDeviceContext()->IASetInputLayout(inputLayout ? static_cast<D3D11InputLayout*>(inputLayout)->InputLayout.Get() : nullptr);
+}
+
+void D3D11RenderDevice::SetVertexShader(RenderVertexShader* vertexShader)
+{
+	m_deviceResources->GetD3DDeviceContext()->VSSetShader(vertexShader ? static_cast<D3D11VertexShader*>(vertexShader)->VertexShader.Get() : nullptr, nullptr, 0);
+}
+
+void D3D11RenderDevice::SetPixelShader(RenderPixelShader* pixelShader)
+{
+	m_deviceResources->GetD3DDeviceContext()->PSSetShader(pixelShader ? static_cast<D3D11PixelShader*>(pixelShader)->PixelShader.Get() : nullptr, nullptr, 0);
+}
+
+void D3D11RenderDevice::SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride)
+{
+	ID3D11Buffer* const	buffer = GetBuffer(vertexBuffer);
+	UINT const			offset = 0;
+	m_deviceResources->GetD3DDeviceContext()->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+}
+
+void D3D11RenderDevice::SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 stride)
+{
+	ID3D11Buffer* const	buffer = GetBuffer(instanceBuffer);
+	UINT const			offset = 0;
+	m_deviceResources->GetD3DDeviceContext()->IASetVertexBuffers(1, 1, &buffer, &stride, &offset);
+}
+
+void D3D11RenderDevice::SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format)
+{
+	m_deviceResources->GetD3DDeviceContext()->IASetIndexBuffer(GetBuffer(indexBuffer), format, 0);
+}
+
+void D3D11RenderDevice::SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer)
+{
+	ID3D11Buffer* const	buffer = GetBuffer(constantBuffer);
+	m_deviceResources->GetD3DDeviceContext()->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void D3D11RenderDevice::SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size)
+{
+	// Offsets and sizes are counted in 16-byte constants.
+	ID3D11Buffer* const	buffer = GetBuffer(constantBuffer);
+	UINT const			firstConstant = offset / 16;
+	UINT const			constantCount = size / 16;
+	m_deviceResources->GetD3DDeviceContext()->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+}
+
+void D3D11RenderDevice::SetPixelTexture(uint32 slot, RenderTextureView* textureView)
+{
+	ID3D11ShaderResourceView* const	view = textureView ? static_cast<D3D11TextureView*>(textureView)->View.Get() : nullptr;
+	m_deviceResources->GetD3DDeviceContext()->PSSetShaderResources(slot, 1, &view);
+}
+
+void D3D11RenderDevice::UpdateBuffer(RenderBuffer* buffer, void const* data)
+{
+	m_deviceResources->GetD3DDeviceContext()->UpdateSubresource(GetBuffer(buffer), 0, nullptr, data, 0, 0);
+}
+
+void* D3D11RenderDevice::MapBuffer(RenderBuffer* buffer, MapMode mode)
+{
+	D3D11_MAPPED_SUBRESOURCE	mappedResource;
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDeviceContext()->Map(
+		GetBuffer(buffer),
+		0,
+		mode == MAP_WRITE_DISCARD ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE,
+		0,
+		&mappedResource
+		)
+		);
+	return mappedResource.pData;
+}
+
+// Direct3D 11 has no partial unmap, the driver tracks what was written.
+void D3D11RenderDevice::UnmapBuffer(RenderBuffer* buffer, uint32 /*writtenOffset*/, uint32 /*writtenSize*/)
+{
+	m_deviceResources->GetD3DDeviceContext()->Unmap(GetBuffer(buffer), 0);
+}
+
+void D3D11RenderDevice::DrawIndexed(uint32 indexCount, uint32 startIndex)
+{
+	m_deviceResources->GetD3DDeviceContext()->DrawIndexed(indexCount, startIndex, 0);
+}
+
+void D3D11RenderDevice::DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance)
+{
+	m_deviceResources->GetD3DDeviceContext()->DrawIndexedInstanced(indexCount, instanceCount, startIndex, 0, startInstance);
+}
+
+uint64 D3D11RenderDevice::InsertFence()
+{
+	PendingFence	pendingFence;
+	pendingFence.Fence = ++m_lastFence;
+	if (m_freeQueries.empty())
+	{
+		CD3D11_QUERY_DESC	queryDesc(D3D11_QUERY_EVENT);
+		DX::ThrowIfFailed(
+			m_deviceResources->GetD3DDevice()->CreateQuery(&queryDesc, &pendingFence.Query)
+			);
+	}
+	else
+	{
+		pendingFence.Query = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+
+	m_deviceResources->GetD3DDeviceContext()->End(pendingFence.Query.Get());
+	m_pendingFences.push_back(pendingFence);
+	return pendingFence.Fence;
+}
+
+bool D3D11RenderDevice::IsFenceComplete(uint64 fence)
+{
+	ID3D11DeviceContext2* const	context = m_deviceResources->GetD3DDeviceContext();
+	while (fence > m_completedFence && !m_pendingFences.empty())
+	{
+		PendingFence&	pendingFence = m_pendingFences.front();
+		if (context->GetData(pendingFence.Query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+
+		m_completedFence = pendingFence.Fence;
+		m_freeQueries.push_back(pendingFence.Query);
+		m_pendingFences.pop_front();
+	}
+	return fence <= m_completedFence;
+}
+
+void D3D11RenderDevice::WaitForFence(uint64 fence)
+{
+	ID3D11DeviceContext2* const	context = m_deviceResources->GetD3DDeviceContext();
+	while (!IsFenceComplete(fence) && !m_pendingFences.empty())
+	{
+		// Without a flush the query might never be submitted.
+		context->GetData(m_pendingFences.front().Query.Get(), nullptr, 0, 0);
+	}
+}
+
+void D3D11RenderDevice::BeginQuery(RenderQuery* query)
+{
+	m_deviceResources->GetD3DDeviceContext()->Begin(GetQuery(query));
+}
+
+void D3D11RenderDevice::EndQuery(RenderQuery* query)
+{
+	m_deviceResources->GetD3DDeviceContext()->End(GetQuery(query));
+}
+
+// Present flushes every frame, the queries get submitted without asking for it here.
+bool D3D11RenderDevice::GetTimestamp(RenderQuery* query, uint64& timestamp)
+{
+	UINT64	data = 0;
+	if (m_deviceResources->GetD3DDeviceContext()->GetData(GetQuery(query), &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	timestamp = data;
+	return true;
+}
+
+bool D3D11RenderDevice::GetTimestampFrequency(RenderQuery* query, uint64& frequency, bool& disjoint)
+{
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT	data;
+	if (m_deviceResources->GetD3DDeviceContext()->GetData(GetQuery(query), &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	frequency = data.Frequency;
+	disjoint = data.Disjoint != FALSE;
+	return true;
+}
+
+void D3D11RenderDevice::BeginOverlay()
+{
+	ID2D1DeviceContext*	context = m_deviceResources->GetD2DDeviceContext();
+
+	if (!m_whiteBrush)
+	{
+		DX::ThrowIfFailed(
+			context->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_whiteBrush)
+			);
+		DX::ThrowIfFailed(
+			context->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_fillBrush)
+			);
+	}
+
+	context->SaveDrawingState(m_stateBlock.Get());
+	context->BeginDraw();
+}
+
+void D3D11RenderDevice::DrawTextLayout(RenderTextLayout* layout, float x, float y)
+{
+	ID2D1DeviceContext*	context = m_deviceResources->GetD2DDeviceContext();
+
+	context->SetTransform(D2D1::Matrix3x2F::Translation(x, y) * m_deviceResources->GetOrientationTransform2D());
+
+	context->DrawTextLayout(
+		D2D1::Point2F(0.0f, 0.0f),
+		static_cast<D3D11TextLayout*>(layout)->TextLayout.Get(),
+		m_whiteBrush.Get()
+		);
+}
+
+void D3D11RenderDevice::FillRectangle(float x, float y, float width, float height, float const color[4])
+{
+	ID2D1DeviceContext*	context = m_deviceResources->GetD2DDeviceContext();
+
+	context->SetTransform(m_deviceResources->GetOrientationTransform2D());
+
+	m_fillBrush->SetColor(D2D1::ColorF(color[0], color[1], color[2], color[3]));
+	context->FillRectangle(D2D1::RectF(x, y, x + width, y + height), m_fillBrush.Get());
+}
+
+void D3D11RenderDevice::EndOverlay()
+{
+	ID2D1DeviceContext*	context = m_deviceResources->GetD2DDeviceContext();
+
+	HRESULT	hr = context->EndDraw();
+	if (hr != D2DERR_RECREATE_TARGET)
+		DX::ThrowIfFailed(hr);
+
+	context->RestoreDrawingState(m_stateBlock.Get());
+}
+
+void D3D11RenderDevice::SetRenderScale(float scale)
+{
+	m_deviceResources->SetRenderScale(scale);
+}
+
+float D3D11RenderDevice::GetRenderScale() const
+{
+	return m_deviceResources->GetRenderScale();
+}
+
+XMFLOAT2 D3D11RenderDevice::GetOutputSize() const
+{
+	Windows::Foundation::Size const	size = m_deviceResources->GetOutputSize();
+	return XMFLOAT2(size.Width, size.Height);
+}
+
+XMFLOAT2 D3D11RenderDevice::GetLogicalSize() const
+{
+	Windows::Foundation::Size const	size = m_deviceResources->GetLogicalSize();
+	return XMFLOAT2(size.Width, size.Height);
+}
+
+XMFLOAT4X4 D3D11RenderDevice::GetOrientationTransform3D() const
+{
+	return m_deviceResources->GetOrientationTransform3D();
+}
+
+bool D3D11RenderDevice::SupportsConstantBufferOffsets() const
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS	options = { 0 };
+	if (FAILED(m_deviceResources->GetD3DDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		return false;
+	return options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+}
+
+bool D3D11RenderDevice::SupportsShaderModel4() const
+{
+	return m_deviceResources->GetDeviceFeatureLevel() >= D3D_FEATURE_LEVEL_10_0;
+}
\ No newline at end of file
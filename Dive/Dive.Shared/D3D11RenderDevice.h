@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Common/DeviceResources.h"
+#include "RenderDevice.h"
+
+#include <deque>
+#include <vector>
+
+namespace Dive
+{
+	class D3D11RenderDevice : public RenderDevice
+	{
+	public:
+		D3D11RenderDevice(std::shared_ptr<DX::DeviceResources> const& deviceResources);
+
+		virtual std::unique_ptr<RenderBuffer>		CreateBuffer(BufferBinding binding, BufferUsage usage, uint32 byteWidth, void const* initialData) override;
+		virtual std::unique_ptr<RenderVertexShader>	CreateVertexShader(void const* bytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderPixelShader>	CreatePixelShader(void const* bytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderInputLayout>	CreateInputLayout(InputElement const* elements, uint32 elementCount, void const* vertexShaderBytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderTextureView>	CreateTextureView(DirectX::ScratchImage const& image) override;
+		virtual std::unique_ptr<RenderTextFormat>	CreateTextFormat(wchar_t const* fontFamily, float fontSize, TextAlignment alignment) override;
+		virtual std::unique_ptr<RenderTextLayout>	CreateTextLayout(std::wstring const& text, RenderTextFormat* format, float maxWidth, float maxHeight, TextMetrics& metrics) override;
+		virtual std::unique_ptr<RenderQuery>		CreateQuery(QueryType type) override;
+		virtual void								ReleaseDeviceDependentResources() override;
+
+		virtual void	BeginFrame(float const clearColor[4]) override;
+		virtual void	Present() override;
+
+		virtual void	SetInputLayout(RenderInputLayout* inputLayout) override;
+		virtual void	SetVertexShader(RenderVertexShader* vertexShader) override;
+		virtual void	SetPixelShader(RenderPixelShader* pixelShader) override;
+		virtual void	SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride) override;
+		virtual void	SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 stride) override;
+		virtual void	SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format) override;
+		virtual void	SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer) override;
+		virtual void	SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size) override;
+		virtual void	SetPixelTexture(uint32 slot, RenderTextureView* textureView) override;
+		virtual void	UpdateBuffer(RenderBuffer* buffer, void const* data) override;
+		virtual void*	MapBuffer(RenderBuffer* buffer, MapMode mode) override;
+		virtual void	UnmapBuffer(RenderBuffer* buffer, uint32 writtenOffset, uint32 writtenSize) override;
+		virtual void	DrawIndexed(uint32 indexCount, uint32 startIndex) override;
+		virtual void	DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance) override;
+
+		virtual uint64	InsertFence() override;
+		virtual bool	IsFenceComplete(uint64 fence) override;
+		virtual void	WaitForFence(uint64 fence) override;
+
+		virtual void	BeginQuery(RenderQuery* query) override;
+		virtual void	EndQuery(RenderQuery* query) override;
+		virtual bool	GetTimestamp(RenderQuery* query, uint64& timestamp) override;
+		virtual bool	GetTimestampFrequency(RenderQuery* query, uint64& frequency, bool& disjoint) override;
+
+		virtual void	BeginOverlay() override;
+		virtual void	DrawTextLayout(RenderTextLayout* layout, float x, float y) override;
+		virtual void	FillRectangle(float x, float y, float width, float height, float const color[4]) override;
+		virtual void	EndOverlay() override;
+
+		virtual void				SetRenderScale(float scale) override;
+		virtual float				GetRenderScale() const override;
+		virtual DirectX::XMFLOAT2	GetOutputSize() const override;
+		virtual DirectX::XMFLOAT2	GetLogicalSize() const override;
+		virtual DirectX::XMFLOAT4X4	GetOrientationTransform3D() const override;
+		virtual bool				SupportsConstantBufferOffsets() const override;
+		virtual bool				SupportsShaderModel4() const override;
+
+	private:
+		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
+
+		Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>	m_whiteBrush;
+		Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>	m_fillBrush;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState>	m_depthState;
+		Microsoft::WRL::ComPtr<ID2D1DrawingStateBlock>	m_stateBlock;
+
+		// Event queries stand in for fences, pending ones in submission order.
+		struct PendingFence
+		{
+			uint64								Fence;
+			Microsoft::WRL::ComPtr<ID3D11Query>	Query;
+		};
+
+		std::deque<PendingFence>							m_pendingFences;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Query>>	m_freeQueries;
+		uint64												m_lastFence;
+		uint64												m_completedFence;
+	};
+}
\ No newline at end of file
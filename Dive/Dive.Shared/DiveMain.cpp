@@ -1,75 +1,298 @@
 #include "pch.h"
 #include "DiveMain.h"
-#include "Common/DirectXHelper.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
 
 using namespace Dive;
 
-using namespace Windows::Foundation;
-using namespace Windows::System::Threading;
-using namespace Concurrency;
+namespace
+{
+	uint32 const	DEFAULT_PIPELINE_DEPTH = 2;
+	uint32 const	MAX_PIPELINE_DEPTH = 3;
+	// The scene is simulated at a fixed rate and drawn blended between steps.
+	double const	SIMULATION_STEP_SECONDS = 1.0 / 60.0;
+	uint32 const	MAX_SIMULATION_STEPS = 4;
 
-DiveMain::DiveMain(std::shared_ptr<DX::DeviceResources> const& deviceResources) :
-m_deviceResources(deviceResources)
+	double GetMilliseconds()
+	{
+		DX::SystemStepClock const&	clock = DX::SystemStepClock::Get();
+		return static_cast<double>(clock.GetCounter()) * 1000.0 / static_cast<double>(clock.GetFrequency());
+	}
+}
+
+DiveMain::DiveMain(std::shared_ptr<RenderDevice> const& renderDevice) :
+m_renderDevice(renderDevice)
 {
-	deviceResources->RegisterDeviceNotify(this);
+	// Makes this thread the main thread of the job system.
+	JobSystem::Get();
+	DIVE_PROFILE_THREAD("Main");
+
+	m_pipelineDepth = DEFAULT_PIPELINE_DEPTH;
+	m_frame = 0;
+	m_pipelineFilled = false;
+	m_timingFrames = 0;
+	m_lastFrameTime = 0.0;
+	m_reportedDroppedTicks = 0;
 
-	m_sampleRenderer = std::unique_ptr<Sample3DRenderer>(new Sample3DRenderer(m_deviceResources));
+	m_timer.SetFixedTimeStep(true);
+	m_timer.SetTargetElapsedSeconds(SIMULATION_STEP_SECONDS);
+	m_timer.SetMaxStepsPerTick(MAX_SIMULATION_STEPS);
 
-	m_fpsTextRenderer = std::unique_ptr<SampleFPSTextRenderer>(new SampleFPSTextRenderer(m_deviceResources));
+	m_sampleRenderer = std::unique_ptr<Sample3DRenderer>(new Sample3DRenderer(m_renderDevice));
+
+	m_performanceHud = std::unique_ptr<PerformanceHud>(new PerformanceHud(m_renderDevice));
+
+	m_gpuProfiler = std::unique_ptr<GpuProfiler>(new GpuProfiler(m_renderDevice));
 
 	CreateWindowSizeDependentResources();
 }
 
 DiveMain::~DiveMain()
 {
-	m_deviceResources->RegisterDeviceNotify(nullptr);
+	FlushPipeline();
 }
 
 void DiveMain::CreateWindowSizeDependentResources()
 {
+	FlushPipeline();
 	m_sampleRenderer->CreateWindowSizeDependantResources();
+	m_framePacer.Settle();
+}
+
+void DiveMain::SetPipelineDepth(uint32 depth)
+{
+	FlushPipeline();
+	m_pipelineDepth = depth < 1 ? 1 : depth > MAX_PIPELINE_DEPTH ? MAX_PIPELINE_DEPTH : depth;
+}
+
+void DiveMain::SetDepthPrepass(bool enabled)
+{
+	FlushPipeline();
+	m_sampleRenderer->SetDepthPrepass(enabled);
+}
+
+void DiveMain::SetFrontToBack(bool enabled)
+{
+	FlushPipeline();
+	m_sampleRenderer->SetFrontToBack(enabled);
 }
 
 void DiveMain::Update()
 {
-	m_timer.Tick([&]()
+	DIVE_PROFILE_SCOPE("Update");
+	JobSystem&	jobSystem = JobSystem::Get();
+	jobSystem.RunMainThreadJobs();
+
+	double const	now = GetMilliseconds();
+	m_timings.Frame = m_lastFrameTime > 0.0 ? now - m_lastFrameTime : 0.0;
+	m_lastFrameTime = now;
+
+	// The stages started by the last Update produced what this frame submits.
 	{
-		m_sampleRenderer->Update(m_timer);
-		m_fpsTextRenderer->Update(m_timer);
-	});
+		DIVE_PROFILE_SCOPE("Wait for pipeline");
+		jobSystem.Wait(m_pipelineJobs);
+	}
+	m_completedTimings = m_timings;
+	PaceFrame();
+
+	uint64 const	frame = m_frame;
+	if (!m_pipelineFilled)
+	{
+		if (m_pipelineDepth > 1)
+		{
+			Simulate(frame);
+			Prepare(frame);
+		}
+		if (m_pipelineDepth > 2)
+			Simulate(frame + 1);
+		m_pipelineFilled = true;
+	}
+
+	switch (m_pipelineDepth)
+	{
+	case 1:
+		Simulate(frame);
+		Prepare(frame);
+		break;
+	case 2:
+		jobSystem.Run([this, frame]()
+		{
+			Simulate(frame + 1);
+			Prepare(frame + 1);
+		}, &m_pipelineJobs);
+		break;
+	default:
+		jobSystem.Run([this, frame]() { Prepare(frame + 1); }, &m_pipelineJobs);
+		jobSystem.Run([this, frame]() { Simulate(frame + 2); }, &m_pipelineJobs);
+		break;
+	}
 }
 
 bool DiveMain::Render()
 {
-	if (m_timer.GetFrameCount() == 0)
+	uint32 const			slot = static_cast<uint32>(m_frame++ % Sample3DRenderer::FrameSlots);
+	DX::StepTimer const&	timer = m_preparedTimers[slot];
+	if (timer.GetFrameCount() == 0)
 		return false;
 
-	auto	context = m_deviceResources->GetD3DDeviceContext();
-
-	auto	viewport = m_deviceResources->GetScreenViewport();
-	context->RSSetViewports(1, &viewport);
+	DIVE_PROFILE_SCOPE("Submit");
+	double const	start = GetMilliseconds();
 
-	ID3D11RenderTargetView* const	targets[1] = { m_deviceResources->GetBackBufferRenderTargetView() };
-	context->OMSetRenderTargets(1, targets, m_deviceResources->GetDepthStencilView());
-
-	context->ClearRenderTargetView(m_deviceResources->GetBackBufferRenderTargetView(), DirectX::Colors::CornflowerBlue);
-	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	m_gpuProfiler->BeginFrame();
+	{
+		GpuProfileScope	gpuScope(*m_gpuProfiler, "Clear");
+		m_renderDevice->BeginFrame(DirectX::Colors::CornflowerBlue);
+	}
+	{
+		GpuProfileScope	gpuScope(*m_gpuProfiler, "Scene");
+		m_sampleRenderer->Render(slot);
+	}
+	UpdateHud();
+	{
+		GpuProfileScope	gpuScope(*m_gpuProfiler, "HUD");
+		m_performanceHud->Render();
+	}
+	m_gpuProfiler->EndFrame();
 
-	m_sampleRenderer->Render();
-	m_fpsTextRenderer->Render();
+	m_timings.Submit = GetMilliseconds() - start;
+	ReportTimings(timer);
 
 	return true;
 }
 
+void DiveMain::Present()
+{
+	DIVE_PROFILE_SCOPE("Present");
+	m_renderDevice->Present();
+}
+
 void DiveMain::OnDeviceLost()
 {
+	FlushPipeline();
 	m_sampleRenderer->ReleaseDeviceDependantResources();
-	m_fpsTextRenderer->ReleaseDeviceDependentResources();
+	m_performanceHud->ReleaseDeviceDependentResources();
+	m_gpuProfiler->ReleaseDeviceDependentResources();
+	m_renderDevice->ReleaseDeviceDependentResources();
 }
 
 void DiveMain::OnDeviceRestored()
 {
 	m_sampleRenderer->CreateDeviceDependantResources();
-	m_fpsTextRenderer->CreateDeviceDependentResources();
+	m_performanceHud->CreateDeviceDependentResources();
+	m_gpuProfiler->CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
+}
+
+void DiveMain::Simulate(uint64 frame)
+{
+	DIVE_PROFILE_SCOPE("Simulate");
+	uint32 const	slot = static_cast<uint32>(frame % Sample3DRenderer::FrameSlots);
+	double const	start = GetMilliseconds();
+
+	m_timer.Tick([&]()
+	{
+		m_sampleRenderer->Step(m_timer);
+	});
+	m_sampleRenderer->Update(m_timer);
+	m_sampleRenderer->Capture(slot);
+	m_simulatedTimers[slot] = m_timer;
+
+	m_timings.Simulate = GetMilliseconds() - start;
+}
+
+void DiveMain::Prepare(uint64 frame)
+{
+	DIVE_PROFILE_SCOPE("Prepare");
+	uint32 const	slot = static_cast<uint32>(frame % Sample3DRenderer::FrameSlots);
+	double const	start = GetMilliseconds();
+
+	m_preparedTimers[slot] = m_simulatedTimers[slot];
+	m_sampleRenderer->Prepare(slot);
+
+	m_timings.Prepare = GetMilliseconds() - start;
+}
+
+void DiveMain::FlushPipeline()
+{
+	JobSystem::Get().Wait(m_pipelineJobs);
+	m_pipelineFilled = false;
+}
+
+double DiveMain::GetCpuFrameTime() const
+{
+	FrameTimings const&	timings = m_completedTimings;
+	double const		simulatePrepare = timings.Simulate + timings.Prepare;
+	switch (m_pipelineDepth)
+	{
+	case 1:
+		return simulatePrepare + timings.Submit;
+	case 2:
+		return simulatePrepare > timings.Submit ? simulatePrepare : timings.Submit;
+	default:
+		double const	longest = timings.Simulate > timings.Prepare ? timings.Simulate : timings.Prepare;
+		return longest > timings.Submit ? longest : timings.Submit;
+	}
+}
+
+void DiveMain::PaceFrame()
+{
+	if (m_completedTimings.Frame <= 0.0)
+		return;
+
+	// The GPU time is a few frames old, less than the pacer lets settle after a change.
+	if (!m_framePacer.AddFrame(m_completedTimings.Frame, GetCpuFrameTime(), m_gpuProfiler->GetFrameTime()))
+		return;
+
+	// The viewport and the overlay follow the new back buffer size, the projection keeps its aspect ratio.
+	m_renderDevice->SetRenderScale(m_framePacer.GetRenderScale());
+	_RPT2(0, "Render scale %.2f after a %.2f ms frame\n", m_framePacer.GetRenderScale(), m_completedTimings.Frame);
+}
+
+void DiveMain::UpdateHud()
+{
+	if (m_completedTimings.Frame > 0.0)
+		m_performanceHud->AddFrame(m_completedTimings.Frame);
+	m_performanceHud->SetTargetFrameTime(m_framePacer.GetSettings().TargetFrameMs);
+	m_performanceHud->SetStageTimes(m_completedTimings.Simulate, m_completedTimings.Prepare, m_completedTimings.Submit);
+	m_performanceHud->SetRenderStats(m_sampleRenderer->GetRenderStats());
+	m_performanceHud->SetCullingStats(m_sampleRenderer->GetClusterStats(), m_sampleRenderer->GetOcclusionStats());
+	m_performanceHud->SetRenderScale(m_renderDevice->GetRenderScale());
+	m_performanceHud->SetGpuTimes(*m_gpuProfiler);
+
+	MemoryTracker const&	memoryTracker = MemoryTracker::Get();
+	for (uint32 category = 0; category < MEMORY_CATEGORY_COUNT; ++category)
+	{
+		MemoryCategory const	memoryCategory = static_cast<MemoryCategory>(category);
+		bool const				overBudget = memoryTracker.IsOverBudget(memoryCategory, MEMORY_CPU) || memoryTracker.IsOverBudget(memoryCategory, MEMORY_GPU);
+		m_performanceHud->SetMemory(MemoryTracker::GetName(memoryCategory),
+			memoryTracker.GetBytes(memoryCategory, MEMORY_CPU), memoryTracker.GetBytes(memoryCategory, MEMORY_GPU), overBudget);
+	}
+	m_performanceHud->Update();
+}
+
+void DiveMain::ReportTimings(DX::StepTimer const& timer)
+{
+	m_timingSums.Simulate += m_completedTimings.Simulate;
+	m_timingSums.Prepare += m_completedTimings.Prepare;
+	m_timingSums.Submit += m_completedTimings.Submit;
+	m_timingSums.Frame += m_completedTimings.Frame;
+	++m_timingFrames;
+
+	// Averages over about a second. With the stages overlapping the frame approaches the longest of them.
+	if (m_timingSums.Frame < 1000.0)
+		return;
+
+	double const	frames = static_cast<double>(m_timingFrames);
+	_RPT4(0, "Frame %.2f ms: simulate %.2f, prepare %.2f, submit %.2f\n",
+		m_timingSums.Frame / frames, m_timingSums.Simulate / frames, m_timingSums.Prepare / frames, m_timingSums.Submit / frames);
+	m_timingSums = FrameTimings();
+	m_timingFrames = 0;
+
+	uint64 const	droppedTicks = timer.GetDroppedTicks();
+	if (droppedTicks != m_reportedDroppedTicks)
+	{
+		_RPT1(0, "Dropped %.1f ms of simulation to catch up\n", DX::StepTimer::TicksToSeconds(droppedTicks - m_reportedDroppedTicks) * 1000.0);
+		m_reportedDroppedTicks = droppedTicks;
+	}
 }
\ No newline at end of file
@@ -1,31 +1,93 @@
 #pragma once
 
 #include "Common/StepTimer.h"
-#include "Common/DeviceResources.h"
+#include "FramePacer.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+#include "PerformanceHud.h"
+#include "RenderDevice.h"
 #include "Sample3DRenderer.h"
-#include "SampleFPSTextRenderer.h"
 
 namespace Dive
 {
-	class DiveMain : public DX::IDeviceNotify
+	// Milliseconds spent by the last frame in each stage, and between the last two frames.
+	struct FrameTimings
+	{
+		FrameTimings() : Simulate(0.0), Prepare(0.0), Submit(0.0), Frame(0.0) { }
+
+		double	Simulate;
+		double	Prepare;
+		double	Submit;
+		double	Frame;
+	};
+
+	// Runs the loop on any device, the D3D11 one in the app or a RecordingRenderDevice when there is no GPU.
+	class DiveMain
 	{
 	public:
-		DiveMain(std::shared_ptr<DX::DeviceResources> const& deviceResources);
+		explicit DiveMain(std::shared_ptr<RenderDevice> const& renderDevice);
 		~DiveMain();
 
 		void	CreateWindowSizeDependentResources();
 		void	Update();
 		bool	Render();
+		void	Present();
+
+		// Frames go through simulate, prepare and submit. Depth 1 runs the stages back to back, 2 simulates and
+		// prepares the next frame on the job system while this one is submitted, 3 also simulates the frame after
+		// it while the next one is prepared. Every extra stage adds a frame of latency.
+		void					SetPipelineDepth(uint32 depth);
+		uint32					GetPipelineDepth() const	{ return m_pipelineDepth; }
+		// Scene options read by the prepare stage, changing one flushes the pipeline like a depth change.
+		void					SetDepthPrepass(bool enabled);
+		void					SetFrontToBack(bool enabled);
+		FrameTimings const&		GetFrameTimings() const		{ return m_completedTimings; }
+		// Scales the render resolution to hold the frame rate. Settings with equal scale bounds keep it fixed.
+		FramePacer&				GetFramePacer()				{ return m_framePacer; }
+		// GPU time of the clear, the scene and the HUD, a few frames behind.
+		GpuProfiler const&		GetGpuProfiler() const		{ return *m_gpuProfiler; }
 
-		virtual void	OnDeviceLost() override;
-		virtual void	OnDeviceRestored() override;
+		// Called by the platform layer around a device reset.
+		void	OnDeviceLost();
+		void	OnDeviceRestored();
 
 	private:
-		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
+		void	Simulate(uint64 frame);
+		void	Prepare(uint64 frame);
+		// Waits for the stages running on the job system, the next Update starts the pipeline over.
+		void	FlushPipeline();
+		void	ReportTimings(DX::StepTimer const& timer);
+		// CPU time bounding the frame, the longest chain of stages that do not overlap.
+		double	GetCpuFrameTime() const;
+		void	PaceFrame();
+		void	UpdateHud();
+
+		std::shared_ptr<RenderDevice>			m_renderDevice;
 
 		std::unique_ptr<Sample3DRenderer>		m_sampleRenderer;
-		std::unique_ptr<SampleFPSTextRenderer>	m_fpsTextRenderer;
+		std::unique_ptr<PerformanceHud>			m_performanceHud;
+		std::unique_ptr<GpuProfiler>			m_gpuProfiler;
 
 		DX::StepTimer	m_timer;
+
+		// Timer state each simulated frame was built with, handed to the render data by Prepare.
+		DX::StepTimer	m_simulatedTimers[Sample3DRenderer::FrameSlots];
+		DX::StepTimer	m_preparedTimers[Sample3DRenderer::FrameSlots];
+
+		uint32			m_pipelineDepth;
+		// Next frame to submit, the frames after it are in flight.
+		uint64			m_frame;
+		bool			m_pipelineFilled;
+		JobCounter		m_pipelineJobs;
+
+		// Written by the stages as they finish, m_completedTimings copies them while no stage runs.
+		FrameTimings	m_timings;
+		FrameTimings	m_completedTimings;
+		FrameTimings	m_timingSums;
+		uint32			m_timingFrames;
+		double			m_lastFrameTime;
+		uint64			m_reportedDroppedTicks;
+
+		FramePacer		m_framePacer;
 	};
 }
\ No newline at end of file
@@ -1,16 +1,69 @@
 #include "pch.h"
 #include "FBXManager.h"
+#include "MemoryTracker.h"
 
 #include <locale>
+#include <malloc.h>
 
 using namespace Dive;
 
+namespace
+{
+	// The SDK does not pass sizes when it frees, _msize looks them up from the CRT heap.
+	void* TrackedMalloc(size_t size)
+	{
+		void* const	memory = malloc(size);
+		if (memory)
+			MemoryTracker::Get().Allocate(MEMORY_FBX_SDK, MEMORY_CPU, _msize(memory));
+		return memory;
+	}
+
+	void* TrackedCalloc(size_t count, size_t size)
+	{
+		void* const	memory = calloc(count, size);
+		if (memory)
+			MemoryTracker::Get().Allocate(MEMORY_FBX_SDK, MEMORY_CPU, _msize(memory));
+		return memory;
+	}
+
+	void* TrackedRealloc(void* memory, size_t size)
+	{
+		size_t const	previousSize = memory ? _msize(memory) : 0;
+		void* const		reallocated = realloc(memory, size);
+		// A failed realloc leaves the block as it was, a zero size frees it.
+		if (!reallocated && size)
+			return nullptr;
+
+		MemoryTracker&	tracker = MemoryTracker::Get();
+		if (previousSize)
+			tracker.Free(MEMORY_FBX_SDK, MEMORY_CPU, previousSize);
+		if (reallocated)
+			tracker.Allocate(MEMORY_FBX_SDK, MEMORY_CPU, _msize(reallocated));
+		return reallocated;
+	}
+
+	void TrackedFree(void* memory)
+	{
+		if (!memory)
+			return;
+
+		MemoryTracker::Get().Free(MEMORY_FBX_SDK, MEMORY_CPU, _msize(memory));
+		free(memory);
+	}
+}
+
 FBXManager::FBXManager()
 {
 }
 
 bool FBXManager::Initialize()
 {
+	// Set before the manager allocates anything, the SDK keeps using them until it is unloaded.
+	FbxSetMallocHandler(TrackedMalloc);
+	FbxSetCallocHandler(TrackedCalloc);
+	FbxSetReallocHandler(TrackedRealloc);
+	FbxSetFreeHandler(TrackedFree);
+
 	m_manager = FbxManager::Create();
 	if (!m_manager)
 		return false;
@@ -34,6 +87,11 @@ void FBXManager::Deinitialize()
 	m_scenes.clear();
 }
 
+FbxManager* FBXManager::GetManager() const
+{
+	return m_manager;
+}
+
 FbxScene* FBXManager::LoadScene(std::string const& filename)
 {
 	/*FbxImporter*	importer = FbxImporter::Create(m_manager, "");
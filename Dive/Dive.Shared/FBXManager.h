@@ -14,6 +14,7 @@ namespace Dive
 		bool		Initialize();
 		void		Deinitialize();
 		FbxScene*	LoadScene(std::string const& name);
+		FbxManager*	GetManager() const;
 
 	private:
 		FbxManager*						m_manager;
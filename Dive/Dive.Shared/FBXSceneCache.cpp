@@ -1,7 +1,9 @@
 #include "pch.h"
 #include "ShaderStructures.h"
-#include "Common/directxhelper.h"
 #include "FBXSceneCache.h"
+#include "MemoryTracker.h"
+#include "MeshSimplification.h"
+#include "Profiler.h"
 
 using namespace DirectX;
 using namespace Dive;
@@ -12,14 +14,24 @@ namespace
 	int const	VERTEX_STRIDE = 4;
 	int const	NORMAL_STRIDE = 3;
 	int const	UV_STRIDE = 2;
+
+	// Simplification error allowed for each level, relative to the submesh size.
+	float const	LOD_TARGET_ERRORS[VBOMesh::MaxLods] = { 0.0f, 0.01f, 0.02f, 0.04f };
+	// A level keeping more than this share of the previous level's triangles is not worth its indices.
+	float const	LOD_MIN_REDUCTION = 0.8f;
+	// Smaller submeshes are culled whole, splitting them buys nothing.
+	int const	CLUSTER_MIN_TRIANGLES = 2048;
+	// Occluders are rasterized on the CPU every frame, submeshes that cannot get this small within the error have none.
+	uint32 const	OCCLUDER_MAX_TRIANGLES = 256;
 }
 
-VBOMesh::VBOMesh(std::shared_ptr<DX::DeviceResources> const& deviceResources) :
-m_deviceResources(deviceResources),
+VBOMesh::VBOMesh(std::shared_ptr<RenderDevice> const& renderDevice) :
+m_renderDevice(renderDevice),
 m_hasNormal(false),
 m_hasUV(false),
 m_allByControlPoint(false),
-m_indexCount(0)
+m_indexCount(0),
+m_memory(MEMORY_MESH, MEMORY_CPU)
 {
 }
 
@@ -30,8 +42,10 @@ VBOMesh::~VBOMesh()
 	m_subMeshes.Clear();
 }
 
-bool VBOMesh::Initialize(FbxMesh const* mesh)
+bool VBOMesh::Initialize(FbxMesh const* mesh, std::vector<TextureAtlas::Region> const& atlasRegions, float occluderError)
 {
+	DIVE_PROFILE_SCOPE("Cook mesh");
+	MemoryScope	memoryScope(MEMORY_MESH);
 	if (!mesh->GetNode())
 		return false;
 
@@ -113,6 +127,11 @@ bool VBOMesh::Initialize(FbxMesh const* mesh)
 			m_allByControlPoint = false;
 	}
 
+	// Atlas regions apply per material, and a control point can be shared by polygons of different
+	// materials. Meshes with a packed texture are loaded by polygon vertex, where the UVs are moved.
+	if (!atlasRegions.empty())
+		m_allByControlPoint = false;
+
 	// Allocate the array memory, by control point or by polygon vertex.
 	auto	polygonVertexCount = mesh->GetControlPointsCount();
 	if (!m_allByControlPoint)
@@ -131,6 +150,14 @@ bool VBOMesh::Initialize(FbxMesh const* mesh)
 		UVs = new float[polygonVertexCount * UV_STRIDE];
 		UVName = UVNames[0];
 	}
+	else
+		m_hasUV = false;
+
+	MemoryAllocation	scratch(MEMORY_SCRATCH, MEMORY_CPU, sizeof(float) * polygonVertexCount * VERTEX_STRIDE + sizeof(unsigned int) * polygonCount * TRIANGLE_VERTEX_COUNT);
+	if (normals)
+		scratch.AddBytes(sizeof(float) * polygonVertexCount * NORMAL_STRIDE);
+	if (UVs)
+		scratch.AddBytes(sizeof(float) * polygonVertexCount * UV_STRIDE);
 
 	// Populate the array with vertex attributes, if by control point.
 	FbxVector4 const*	controlPoints = mesh->GetControlPoints();
@@ -221,6 +248,14 @@ bool VBOMesh::Initialize(FbxMesh const* mesh)
 					mesh->GetPolygonVertexUV(polygonIndex, verticeIndex, UVName, currentUV, unmappedUV);
 					UVs[vertexCount * UV_STRIDE] = static_cast<float>(currentUV[0]);
 					UVs[vertexCount * UV_STRIDE + 1] = static_cast<float>(currentUV[1]);
+
+					// FBX UVs have their origin at the bottom left, atlas regions at the top left.
+					if (materialIndex < static_cast<int>(atlasRegions.size()))
+					{
+						XMFLOAT2 const	atlasUV = atlasRegions[materialIndex].Transform(XMFLOAT2(UVs[vertexCount * UV_STRIDE], 1.0f - UVs[vertexCount * UV_STRIDE + 1]));
+						UVs[vertexCount * UV_STRIDE] = atlasUV.x;
+						UVs[vertexCount * UV_STRIDE + 1] = 1.0f - atlasUV.y;
+					}
 				}
 			}
 			++vertexCount;
@@ -228,69 +263,180 @@ bool VBOMesh::Initialize(FbxMesh const* mesh)
 		m_subMeshes[materialIndex]->TriangleCount += 1;
 	}
 
+	// Bounds of every submesh, from the positions its triangles reference.
+	for (auto subMeshIndex = 0; subMeshIndex < m_subMeshes.GetCount(); ++subMeshIndex)
+	{
+		SubMesh* const	subMesh = m_subMeshes[subMeshIndex];
+		auto const		indexEnd = subMesh->IndexOffset + subMesh->TriangleCount * TRIANGLE_VERTEX_COUNT;
+		if (subMesh->IndexOffset == indexEnd)
+			continue;
+
+		XMVECTOR	minimum = g_XMFltMax;
+		XMVECTOR	maximum = XMVectorNegate(g_XMFltMax);
+		for (auto index = subMesh->IndexOffset; index < indexEnd; ++index)
+		{
+			XMVECTOR const	position = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const*>(&vertices[indices[index] * VERTEX_STRIDE]));
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+
+		BoundingBox::CreateFromPoints(subMesh->Box, minimum, maximum);
+		BoundingSphere::CreateFromBoundingBox(subMesh->Sphere, subMesh->Box);
+	}
+
 	// Create usable directx object
 	VertexPositionColorNormalUV*	dxObject = new VertexPositionColorNormalUV[polygonVertexCount]();
-	for (auto vertexCount = 0; vertexCount < polygonVertexCount; vertexCount += VERTEX_STRIDE)
+	scratch.AddBytes(sizeof(VertexPositionColorNormalUV) * polygonVertexCount);
+	for (auto vertexIndex = 0; vertexIndex < polygonVertexCount; ++vertexIndex)
 	{
-		dxObject[vertexCount].Pos.x = vertices[vertexCount];
-		dxObject[vertexCount + 1].Pos.y = vertices[vertexCount + 1];
-		dxObject[vertexCount + 2].Pos.z = vertices[vertexCount + 2];
+		dxObject[vertexIndex].Pos.x = vertices[vertexIndex * VERTEX_STRIDE];
+		dxObject[vertexIndex].Pos.y = vertices[vertexIndex * VERTEX_STRIDE + 1];
+		dxObject[vertexIndex].Pos.z = vertices[vertexIndex * VERTEX_STRIDE + 2];
 
 		if (m_hasNormal)
 		{
-			dxObject[vertexCount].Normal.x = normals[vertexCount];
-			dxObject[vertexCount + 1].Normal.y = normals[vertexCount + 1];
-			dxObject[vertexCount + 2].Normal.z = normals[vertexCount + 2];
+			dxObject[vertexIndex].Normal.x = normals[vertexIndex * NORMAL_STRIDE];
+			dxObject[vertexIndex].Normal.y = normals[vertexIndex * NORMAL_STRIDE + 1];
+			dxObject[vertexIndex].Normal.z = normals[vertexIndex * NORMAL_STRIDE + 2];
 		}
 
 		if (m_hasUV)
 		{
-			dxObject[vertexCount].UV.x = UVs[vertexCount];
-			dxObject[vertexCount + 1].UV.y = UVs[vertexCount + 1];
+			dxObject[vertexIndex].UV.x = UVs[vertexIndex * UV_STRIDE];
+			dxObject[vertexIndex].UV.y = UVs[vertexIndex * UV_STRIDE + 1];
 		}
 
-		dxObject[vertexCount].Color.x = 1.0f;
-		dxObject[vertexCount].Color.y = 1.0f;
-		dxObject[vertexCount].Color.z = 1.0f;
+		dxObject[vertexIndex].Color.x = 1.0f;
+		dxObject[vertexIndex].Color.y = 1.0f;
+		dxObject[vertexIndex].Color.z = 1.0f;
 	}
 
-	D3D11_SUBRESOURCE_DATA	vertexBufferData = { 0 };
-	vertexBufferData.pSysMem = dxObject;
-	vertexBufferData.SysMemPitch = 0;
-	vertexBufferData.SysMemSlicePitch = 0;
-	CD3D11_BUFFER_DESC	vertexBufferDesc(sizeof(dxObject), D3D11_BIND_VERTEX_BUFFER);
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD3DDevice()->CreateBuffer(
-		&vertexBufferDesc,
-		&vertexBufferData,
-		&m_vertexBuffer
-		)
-		);
-
-	m_indexCount = polygonCount * TRIANGLE_VERTEX_COUNT;
-
-	D3D11_SUBRESOURCE_DATA	indexBufferData = { 0 };
-	indexBufferData.pSysMem = indices;
-	indexBufferData.SysMemPitch = 0;
-	indexBufferData.SysMemSlicePitch = 0;
-	CD3D11_BUFFER_DESC	indexBufferDesc(sizeof(unsigned int), D3D11_BIND_INDEX_BUFFER);
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD3DDevice()->CreateBuffer(
-		&indexBufferDesc,
-		&indexBufferData,
-		&m_indexBuffer
-		)
-		);
+	m_vertexBuffer = m_renderDevice->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_DEFAULT, sizeof(VertexPositionColorNormalUV) * polygonVertexCount, dxObject);
+
+	std::vector<uint32>	allIndices(indices, indices + polygonCount * TRIANGLE_VERTEX_COUNT);
+	scratch.AddBytes(sizeof(uint32) * allIndices.capacity());
+	WeldVertices(allIndices.data(), static_cast<uint32>(allIndices.size()), dxObject);
+	GenerateLods(dxObject, static_cast<uint32>(polygonVertexCount), allIndices);
+	BuildClusters(dxObject, static_cast<uint32>(polygonVertexCount), allIndices);
+	BuildOccluders(dxObject, static_cast<uint32>(polygonVertexCount), allIndices, occluderError);
+
+	m_indexCount = static_cast<uint32>(allIndices.size());
+	m_indexBuffer = m_renderDevice->CreateBuffer(BIND_INDEX_BUFFER, USAGE_DEFAULT, sizeof(uint32) * m_indexCount, allIndices.data());
 
+	delete[] dxObject;
+	delete[] indices;
 	delete[] vertices;
 	delete[] normals;
 	delete[] UVs;
 
+	m_memory.SetBytes(sizeof(SubMesh) * m_subMeshes.GetCount() +
+		sizeof(MeshCluster) * m_clusters.capacity() + sizeof(uint32) * m_clusterIndices.capacity() +
+		sizeof(XMFLOAT3) * m_occluderPositions.capacity() + sizeof(uint32) * m_occluderIndices.capacity());
+
 	return true;
 }
 
+// Every level is simplified from the previous one and appended to indices, a level that barely
+// removes anything ends the chain.
+void VBOMesh::GenerateLods(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32>& indices)
+{
+	std::vector<uint32>	lodIndices;
+	for (auto subMeshIndex = 0; subMeshIndex < m_subMeshes.GetCount(); ++subMeshIndex)
+	{
+		SubMesh* const	subMesh = m_subMeshes[subMeshIndex];
+		subMesh->Lods[0].IndexOffset = static_cast<uint32>(subMesh->IndexOffset);
+		subMesh->Lods[0].IndexCount = static_cast<uint32>(subMesh->TriangleCount * TRIANGLE_VERTEX_COUNT);
+		subMesh->LodCount = 1;
+		if (!subMesh->TriangleCount)
+			continue;
+
+		while (subMesh->LodCount < MaxLods)
+		{
+			Lod const		source = subMesh->Lods[subMesh->LodCount - 1];
+			uint32 const	targetIndexCount = source.IndexCount / (2 * TRIANGLE_VERTEX_COUNT) * TRIANGLE_VERTEX_COUNT;
+
+			float	error = 0.0f;
+			lodIndices.resize(source.IndexCount);
+			uint32 const	indexCount = SimplifyMesh(lodIndices.data(), &indices[source.IndexOffset], source.IndexCount, vertices, vertexCount,
+													  targetIndexCount, LOD_TARGET_ERRORS[subMesh->LodCount], error);
+			if (!indexCount || indexCount > source.IndexCount * LOD_MIN_REDUCTION)
+				break;
+
+			Lod&	lod = subMesh->Lods[subMesh->LodCount++];
+			lod.IndexOffset = static_cast<uint32>(indices.size());
+			lod.IndexCount = indexCount;
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + indexCount);
+		}
+	}
+}
+
+void VBOMesh::BuildClusters(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32> const& indices)
+{
+	for (auto subMeshIndex = 0; subMeshIndex < m_subMeshes.GetCount(); ++subMeshIndex)
+	{
+		SubMesh* const	subMesh = m_subMeshes[subMeshIndex];
+		subMesh->ClusterOffset = static_cast<uint32>(m_clusters.size());
+		if (subMesh->TriangleCount >= CLUSTER_MIN_TRIANGLES)
+			BuildMeshClusters(&indices[subMesh->IndexOffset], subMesh->TriangleCount * TRIANGLE_VERTEX_COUNT, vertices, vertexCount, m_clusters, m_clusterIndices);
+		subMesh->ClusterCount = static_cast<uint32>(m_clusters.size()) - subMesh->ClusterOffset;
+	}
+}
+
+// Only positions matter to an occluder, so normals and UVs are dropped and their seams no longer hold the simplification back.
+void VBOMesh::BuildOccluders(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32> const& indices, float targetError)
+{
+	std::vector<VertexPositionColorNormalUV>	positions(vertexCount);
+	for (uint32 i = 0; i < vertexCount; ++i)
+	{
+		positions[i].Pos = vertices[i].Pos;
+		positions[i].Color = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		positions[i].Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		positions[i].UV = XMFLOAT2(0.0f, 0.0f);
+	}
+
+	std::vector<uint32>	source;
+	std::vector<uint32>	simplified;
+	std::vector<uint32>	remap(vertexCount, ~0u);
+	for (auto subMeshIndex = 0; subMeshIndex < m_subMeshes.GetCount(); ++subMeshIndex)
+	{
+		SubMesh* const	subMesh = m_subMeshes[subMeshIndex];
+		subMesh->OccluderVertexOffset = static_cast<uint32>(m_occluderPositions.size());
+		subMesh->OccluderIndexOffset = static_cast<uint32>(m_occluderIndices.size());
+		if (!subMesh->TriangleCount)
+			continue;
+
+		Lod const&	coarsest = subMesh->Lods[subMesh->LodCount - 1];
+		source.assign(indices.begin() + coarsest.IndexOffset, indices.begin() + coarsest.IndexOffset + coarsest.IndexCount);
+		WeldVertices(source.data(), coarsest.IndexCount, positions.data());
+
+		float	error = 0.0f;
+		simplified.resize(coarsest.IndexCount);
+		uint32 const	indexCount = SimplifyMesh(simplified.data(), source.data(), coarsest.IndexCount, positions.data(), vertexCount,
+												  OCCLUDER_MAX_TRIANGLES * TRIANGLE_VERTEX_COUNT, targetError, error);
+		if (!indexCount || indexCount > OCCLUDER_MAX_TRIANGLES * TRIANGLE_VERTEX_COUNT)
+			continue;
+
+		for (uint32 i = 0; i < indexCount; ++i)
+		{
+			uint32&	local = remap[simplified[i]];
+			if (local == ~0u)
+			{
+				local = static_cast<uint32>(m_occluderPositions.size()) - subMesh->OccluderVertexOffset;
+				m_occluderPositions.push_back(positions[simplified[i]].Pos);
+			}
+			m_occluderIndices.push_back(local);
+		}
+		for (uint32 i = 0; i < indexCount; ++i)
+			remap[simplified[i]] = ~0u;
+
+		subMesh->OccluderVertexCount = static_cast<uint32>(m_occluderPositions.size()) - subMesh->OccluderVertexOffset;
+		subMesh->OccluderIndexCount = indexCount;
+	}
+}
+
 void Dive::VBOMesh::UpdateVertexPosition(FbxMesh const* mesh, FbxVector4 const* vertices) const
 {
+	DIVE_PROFILE_SCOPE("Skinning");
 	float*	newVertices = nullptr;
 	auto	vertexCount = 0;
 	if (m_allByControlPoint)
@@ -326,30 +472,23 @@ void Dive::VBOMesh::UpdateVertexPosition(FbxMesh const* mesh, FbxVector4 const*
 		}
 	}
 
+	MemoryAllocation	skinnedVertices(MEMORY_ANIMATION, MEMORY_CPU, sizeof(float) * vertexCount * VERTEX_STRIDE);
 	if (newVertices)
 	{
-		D3D11_MAPPED_SUBRESOURCE	mappedResource;
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDeviceContext()->Map(
-			m_vertexBuffer.Get(),
-			0,
-			D3D11_MAP_WRITE_NO_OVERWRITE,
-			0,
-			&mappedResource
-			)
-			);
-		VertexPositionColorNormalUV*	dataPtr = (VertexPositionColorNormalUV*)mappedResource.pData;
+		VertexPositionColorNormalUV*	dataPtr = static_cast<VertexPositionColorNormalUV*>(m_renderDevice->MapBuffer(m_vertexBuffer.get(), MAP_WRITE_NO_OVERWRITE));
 		vertexCount *= TRIANGLE_VERTEX_COUNT;
+		uint32	writtenVertices = 0;
 		for (auto i = 0; i < vertexCount; i += VERTEX_STRIDE)
 		{
 			dataPtr[i].Pos.x = newVertices[i];
 			dataPtr[i + 1].Pos.y = newVertices[i + 1];
 			dataPtr[i + 2].Pos.z = newVertices[i + 2];
+			writtenVertices = i + 3;
 		}
 
 		delete[] newVertices;
 
-		m_deviceResources->GetD3DDeviceContext()->Unmap(m_vertexBuffer.Get(), 0);
+		m_renderDevice->UnmapBuffer(m_vertexBuffer.get(), 0, writtenVertices * sizeof(VertexPositionColorNormalUV));
 	}
 }
 
@@ -358,8 +497,66 @@ int Dive::VBOMesh::GetSubMeshCount() const
 	return m_subMeshes.GetCount();
 }
 
+void VBOMesh::GetSubMeshRange(int subMeshIndex, uint32& startIndex, uint32& indexCount) const
+{
+	startIndex = static_cast<uint32>(m_subMeshes[subMeshIndex]->IndexOffset);
+	indexCount = static_cast<uint32>(m_subMeshes[subMeshIndex]->TriangleCount * TRIANGLE_VERTEX_COUNT);
+}
+
+int VBOMesh::GetSubMeshLodCount(int subMeshIndex) const
+{
+	return m_subMeshes[subMeshIndex]->LodCount;
+}
+
+void VBOMesh::GetSubMeshLodRange(int subMeshIndex, int lod, uint32& startIndex, uint32& indexCount) const
+{
+	startIndex = m_subMeshes[subMeshIndex]->Lods[lod].IndexOffset;
+	indexCount = m_subMeshes[subMeshIndex]->Lods[lod].IndexCount;
+}
+
+void VBOMesh::GetSubMeshClusters(int subMeshIndex, MeshCluster const*& clusters, uint32& clusterCount) const
+{
+	clusterCount = m_subMeshes[subMeshIndex]->ClusterCount;
+	clusters = clusterCount ? &m_clusters[m_subMeshes[subMeshIndex]->ClusterOffset] : nullptr;
+}
+
+void VBOMesh::GetSubMeshOccluder(int subMeshIndex, OccluderMesh& occluder) const
+{
+	SubMesh const* const	subMesh = m_subMeshes[subMeshIndex];
+	occluder = OccluderMesh();
+	if (!subMesh->OccluderIndexCount)
+		return;
+
+	occluder.Positions = &m_occluderPositions[subMesh->OccluderVertexOffset];
+	occluder.VertexCount = subMesh->OccluderVertexCount;
+	occluder.Indices = &m_occluderIndices[subMesh->OccluderIndexOffset];
+	occluder.IndexCount = subMesh->OccluderIndexCount;
+}
+
+void VBOMesh::GetSubMeshBounds(int subMeshIndex, BoundingBox& box, BoundingSphere& sphere) const
+{
+	box = m_subMeshes[subMeshIndex]->Box;
+	sphere = m_subMeshes[subMeshIndex]->Sphere;
+}
+
+RenderBuffer* VBOMesh::GetVertexBuffer() const
+{
+	return m_vertexBuffer.get();
+}
+
+RenderBuffer* VBOMesh::GetIndexBuffer() const
+{
+	return m_indexBuffer.get();
+}
+
+uint32 const* VBOMesh::GetClusterIndices() const
+{
+	return m_clusterIndices.data();
+}
+
 MaterialCache::MaterialCache() :
-m_shinness(0)
+m_shinness(0),
+m_materialIndex(MaterialTable::DefaultMaterial)
 {
 }
 
@@ -367,27 +564,27 @@ MaterialCache::~MaterialCache()
 {
 }
 
-bool MaterialCache::Initialize(FbxSurfaceMaterial const* material)
+bool MaterialCache::Initialize(FbxSurfaceMaterial const* material, MaterialTable& materialTable)
 {
 	FbxDouble3 const	emissive = GetMaterialProperty(material, FbxSurfaceMaterial::sEmissive, FbxSurfaceMaterial::sEmissiveFactor, m_emissive.m_texture);
 	m_emissive.m_color[0] = static_cast<float>(emissive[0]);
 	m_emissive.m_color[1] = static_cast<float>(emissive[1]);
 	m_emissive.m_color[2] = static_cast<float>(emissive[2]);
 
-	FbxDouble3 const	ambient = GetMaterialProperty(material, FbxSurfaceMaterial::sAmbient, FbxSurfaceMaterial::sAmbientFactor, m_emissive.m_texture);
-	m_ambient.m_color[0] = static_cast<float>(emissive[0]);
-	m_ambient.m_color[1] = static_cast<float>(emissive[1]);
-	m_ambient.m_color[2] = static_cast<float>(emissive[2]);
+	FbxDouble3 const	ambient = GetMaterialProperty(material, FbxSurfaceMaterial::sAmbient, FbxSurfaceMaterial::sAmbientFactor, m_ambient.m_texture);
+	m_ambient.m_color[0] = static_cast<float>(ambient[0]);
+	m_ambient.m_color[1] = static_cast<float>(ambient[1]);
+	m_ambient.m_color[2] = static_cast<float>(ambient[2]);
 
-	FbxDouble3 const	diffuse = GetMaterialProperty(material, FbxSurfaceMaterial::sDiffuse, FbxSurfaceMaterial::sDiffuseFactor, m_emissive.m_texture);
-	m_diffuse.m_color[0] = static_cast<float>(emissive[0]);
-	m_diffuse.m_color[1] = static_cast<float>(emissive[1]);
-	m_diffuse.m_color[2] = static_cast<float>(emissive[2]);
+	FbxDouble3 const	diffuse = GetMaterialProperty(material, FbxSurfaceMaterial::sDiffuse, FbxSurfaceMaterial::sDiffuseFactor, m_diffuse.m_texture);
+	m_diffuse.m_color[0] = static_cast<float>(diffuse[0]);
+	m_diffuse.m_color[1] = static_cast<float>(diffuse[1]);
+	m_diffuse.m_color[2] = static_cast<float>(diffuse[2]);
 
-	FbxDouble3 const	specular = GetMaterialProperty(material, FbxSurfaceMaterial::sSpecular, FbxSurfaceMaterial::sSpecularFactor, m_emissive.m_texture);
-	m_specular.m_color[0] = static_cast<float>(emissive[0]);
-	m_specular.m_color[1] = static_cast<float>(emissive[1]);
-	m_specular.m_color[2] = static_cast<float>(emissive[2]);
+	FbxDouble3 const	specular = GetMaterialProperty(material, FbxSurfaceMaterial::sSpecular, FbxSurfaceMaterial::sSpecularFactor, m_specular.m_texture);
+	m_specular.m_color[0] = static_cast<float>(specular[0]);
+	m_specular.m_color[1] = static_cast<float>(specular[1]);
+	m_specular.m_color[2] = static_cast<float>(specular[2]);
 
 	FbxProperty	shininessProperty = material->FindProperty(FbxSurfaceMaterial::sShininess);
 	if (shininessProperty.IsValid())
@@ -396,25 +593,48 @@ bool MaterialCache::Initialize(FbxSurfaceMaterial const* material)
 		m_shinness = static_cast<float>(shininess);
 	}
 
+	m_materialIndex = materialTable.Add(GetConstants());
+
 	return true;
 }
 
-void MaterialCache::SetCurrentMaterials() const
+void MaterialCache::SetCurrentMaterials(ModelViewProjectionConstantBuffer& constants) const
 {
-	// todo bind shader material and texture
+	constants.MaterialIndex = static_cast<float>(m_materialIndex);
 }
 
-void MaterialCache::SetDefaultMaterial()
+void MaterialCache::SetDefaultMaterial(ModelViewProjectionConstantBuffer& constants)
 {
-	// todo bind shader default material and empty texture
+	constants.MaterialIndex = static_cast<float>(MaterialTable::DefaultMaterial);
 }
 
+uint32 MaterialCache::GetMaterialIndex() const
+{
+	return m_materialIndex;
+}
+
+MaterialConstants MaterialCache::GetConstants() const
+{
+	MaterialConstants	constants;
+	ZeroMemory(&constants, sizeof(MaterialConstants));
+	constants.Emissive = XMFLOAT4(m_emissive.m_color);
+	constants.Ambient = XMFLOAT4(m_ambient.m_color);
+	constants.Diffuse = XMFLOAT4(m_diffuse.m_color);
+	constants.Specular = XMFLOAT4(m_specular.m_color);
+	constants.Shininess = m_shinness;
+	return constants;
+}
 
 bool MaterialCache::HasTexture() const
 {
 	return m_diffuse.m_texture != nullptr;
 }
 
+ScratchImage const* MaterialCache::GetDiffuseTexture() const
+{
+	return m_diffuse.m_texture;
+}
+
 FbxDouble3 MaterialCache::GetMaterialProperty(FbxSurfaceMaterial const* material, char const* propertyName, char const* factorPropertyName, DirectX::ScratchImage*& pTexture)
 {
 	FbxDouble3			result(0.0, 0.0, 0.0);
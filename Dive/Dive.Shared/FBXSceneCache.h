@@ -1,20 +1,49 @@
 #pragma once
 
 #include "fbxsdk.h"
-#include "Common/DeviceResources.h"
+#include "MaterialTable.h"
+#include "MemoryTracker.h"
+#include "MeshClusters.h"
+#include "OcclusionCuller.h"
+#include "RenderDevice.h"
+#include "TextureAtlas.h"
+
+#include <vector>
+#include <DirectXCollision.h>
 
 namespace Dive
 {
 	class VBOMesh
 	{
 	public:
-		VBOMesh(std::shared_ptr<DX::DeviceResources> const& m_deviceResources);
+		// Level 0 is the imported mesh, every further level has about half the triangles of the previous one.
+		static int const	MaxLods = 4;
+
+		VBOMesh(std::shared_ptr<RenderDevice> const& renderDevice);
 		~VBOMesh();
 
-		bool	Initialize(FbxMesh const* mesh);
+		// atlasRegions holds, per submesh, where the diffuse texture ended up in the texture atlas, empty when
+		// none was packed. occluderError is the simplification error allowed for occluders, relative to the submesh size.
+		bool	Initialize(FbxMesh const* mesh, std::vector<TextureAtlas::Region> const& atlasRegions, float occluderError);
 
 		void	UpdateVertexPosition(FbxMesh const* mesh, FbxVector4 const* vertices) const;
 		int		GetSubMeshCount() const;
+		void	GetSubMeshRange(int subMeshIndex, uint32& startIndex, uint32& indexCount) const;
+		// Levels of detail share the vertex buffer and live past the full-detail ranges in the index buffer.
+		int		GetSubMeshLodCount(int subMeshIndex) const;
+		void	GetSubMeshLodRange(int subMeshIndex, int lod, uint32& startIndex, uint32& indexCount) const;
+		// Full-detail clusters of large submeshes, none for the others. Their index ranges point into GetClusterIndices.
+		void	GetSubMeshClusters(int subMeshIndex, MeshCluster const*& clusters, uint32& clusterCount) const;
+		// Positions-only simplification of the coarsest level, empty when it cannot get cheap enough to rasterize.
+		// Approximate: within the error, collapses can close holes and concavities and bulge past the surface, so the
+		// occluder may hide a little of what is seen through or around its mesh.
+		void	GetSubMeshOccluder(int subMeshIndex, OccluderMesh& occluder) const;
+		// Bounds in mesh space.
+		void	GetSubMeshBounds(int subMeshIndex, DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere) const;
+
+		RenderBuffer*	GetVertexBuffer() const;
+		RenderBuffer*	GetIndexBuffer() const;
+		uint32 const*	GetClusterIndices() const;
 
 	private:
 		enum
@@ -26,24 +55,56 @@ namespace Dive
 			VBO_COUNT
 		};
 
-		struct SubMesh
+		struct Lod
 		{
-			SubMesh() : IndexOffset(0), TriangleCount(0) { }
+			Lod() : IndexOffset(0), IndexCount(0) { }
 
-			int	IndexOffset;
-			int	TriangleCount;
+			uint32	IndexOffset;
+			uint32	IndexCount;
+		};
+
+		struct SubMesh
+		{
+			SubMesh() : IndexOffset(0), TriangleCount(0), LodCount(0), ClusterOffset(0), ClusterCount(0),
+				OccluderVertexOffset(0), OccluderVertexCount(0), OccluderIndexOffset(0), OccluderIndexCount(0) { }
+
+			int						IndexOffset;
+			int						TriangleCount;
+			int						LodCount;
+			Lod						Lods[MaxLods];
+			uint32					ClusterOffset;
+			uint32					ClusterCount;
+			uint32					OccluderVertexOffset;
+			uint32					OccluderVertexCount;
+			uint32					OccluderIndexOffset;
+			uint32					OccluderIndexCount;
+			DirectX::BoundingBox	Box;
+			DirectX::BoundingSphere	Sphere;
 		};
 
-		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
+		void	GenerateLods(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32>& indices);
+		void	BuildClusters(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32> const& indices);
+		void	BuildOccluders(VertexPositionColorNormalUV const* vertices, uint32 vertexCount, std::vector<uint32> const& indices, float targetError);
+
+		std::shared_ptr<RenderDevice>	m_renderDevice;
 
 		FbxArray<SubMesh*>	m_subMeshes;
 		bool				m_hasNormal;
 		bool				m_hasUV;
 		bool				m_allByControlPoint;
 
-		Microsoft::WRL::ComPtr<ID3D11Buffer>	m_vertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>	m_indexBuffer;
-		uint32									m_indexCount;
+		std::unique_ptr<RenderBuffer>	m_vertexBuffer;
+		std::unique_ptr<RenderBuffer>	m_indexBuffer;
+		uint32							m_indexCount;
+
+		std::vector<MeshCluster>	m_clusters;
+		std::vector<uint32>			m_clusterIndices;
+
+		std::vector<DirectX::XMFLOAT3>	m_occluderPositions;
+		std::vector<uint32>				m_occluderIndices;
+
+		// What the mesh keeps on the CPU once cooked, the buffers count themselves.
+		MemoryAllocation	m_memory;
 	};
 
 	class MaterialCache
@@ -52,11 +113,14 @@ namespace Dive
 		MaterialCache();
 		~MaterialCache();
 
-		bool	Initialize(FbxSurfaceMaterial const* material);
-		void	SetCurrentMaterials() const;
+		bool	Initialize(FbxSurfaceMaterial const* material, MaterialTable& materialTable);
+		void	SetCurrentMaterials(ModelViewProjectionConstantBuffer& constants) const;
 		bool	HasTexture() const;
+		uint32	GetMaterialIndex() const;
+
+		DirectX::ScratchImage const*	GetDiffuseTexture() const;
 
-		static void	SetDefaultMaterial();
+		static void	SetDefaultMaterial(ModelViewProjectionConstantBuffer& constants);
 
 	private:
 		struct ColorChannel
@@ -77,8 +141,10 @@ namespace Dive
 		ColorChannel	m_diffuse;
 		ColorChannel	m_specular;
 		float			m_shinness;
+		uint32			m_materialIndex;
 
 	private:
-		FbxDouble3	GetMaterialProperty(FbxSurfaceMaterial const* material, char const* propertyName, char const* factorPropertyName, DirectX::ScratchImage*& texture);
+		MaterialConstants	GetConstants() const;
+		FbxDouble3			GetMaterialProperty(FbxSurfaceMaterial const* material, char const* propertyName, char const* factorPropertyName, DirectX::ScratchImage*& texture);
 	};
 }
\ No newline at end of file
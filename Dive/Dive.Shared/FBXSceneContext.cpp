@@ -1,24 +1,98 @@
 #include "pch.h"
 #include "FBXSceneCache.h"
 #include "FBXSceneContext.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "TextureProcessing.h"
 
+#include <cstring>
 #include <string>
+#include <unordered_set>
 
 using namespace DirectX;
 using namespace Dive;
 
-FBXSceneContext::FBXSceneContext(char const* filename, FbxManager* fbxManager, std::shared_ptr<DX::DeviceResources> const& deviceResources) :
+namespace
+{
+	float const		ATLAS_UV_EPSILON = 1.0e-3f;
+	uint32 const	HIERARCHY_CULL_MIN_DRAWS = 1024;
+	// Screen height fraction covered by a submesh's bounding sphere below which level i + 1 replaces level i.
+	float const		LOD_SCREEN_SIZES[VBOMesh::MaxLods - 1] = { 0.4f, 0.2f, 0.08f };
+	// Switching back needs the size to clear the threshold by this much, so levels do not flicker at the boundary.
+	float const		LOD_HYSTERESIS = 0.15f;
+	// Submeshes smaller than this share of the scene radius hide too little to be worth rasterizing as occluders.
+	float const		OCCLUDER_MIN_SCENE_SIZE = 0.02f;
+	// Occluder simplification error unless SetOccluderError says otherwise.
+	float const		DEFAULT_OCCLUDER_ERROR = 0.02f;
+	// Screen height fraction an occluder's bounding sphere has to cover to be rasterized this frame.
+	float const		OCCLUDER_MIN_SCREEN_SIZE = 0.1f;
+	// Screen height fraction a draw's bounding sphere has to cover to be drawn in the depth prepass.
+	float const		DEPTH_PREPASS_MIN_SCREEN_SIZE = 0.25f;
+
+	FbxFileTexture* GetDiffuseTexture(FbxSurfaceMaterial const* material)
+	{
+		FbxProperty const	property = material->FindProperty(FbxSurfaceMaterial::sDiffuse);
+		return property.IsValid() ? property.GetSrcObject<FbxFileTexture>() : nullptr;
+	}
+
+	// Moving a texture into the atlas rewrites the UVs of the whole submesh,
+	// so only materials whose single texture is the diffuse one can take part.
+	bool HasOnlyDiffuseTexture(FbxSurfaceMaterial const* material)
+	{
+		for (FbxProperty property = material->GetFirstProperty(); property.IsValid(); property = material->GetNextProperty(property))
+		{
+			auto const	textureCount = property.GetSrcObjectCount<FbxTexture>();
+			if (!textureCount)
+				continue;
+			if (property.GetName() != FbxSurfaceMaterial::sDiffuse || textureCount != 1 || !property.GetSrcObject<FbxFileTexture>())
+				return false;
+		}
+		return true;
+	}
+
+	// Same submesh mapping as VBOMesh::Initialize.
+	int GetPolygonMaterial(FbxMesh const* mesh, int polygonIndex)
+	{
+		FbxGeometryElementMaterial const*	element = mesh->GetElementMaterial();
+		if (element && element->GetMappingMode() == FbxGeometryElement::eByPolygon)
+			return element->GetIndexArray().GetAt(polygonIndex);
+		return 0;
+	}
+
+	uint32 SelectLod(float screenSize, uint32 current, uint32 lodCount)
+	{
+		uint32	lod = current < lodCount ? current : lodCount - 1;
+		while (lod + 1 < lodCount && screenSize < LOD_SCREEN_SIZES[lod] * (1.0f - LOD_HYSTERESIS))
+			++lod;
+		while (lod > 0 && screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.0f + LOD_HYSTERESIS))
+			--lod;
+		return lod;
+	}
+
+	float GetScreenSize(float radius, float depth, float projectionScale)
+	{
+		return depth > radius ? radius * projectionScale / depth : 1.0f;
+	}
+}
+
+FBXSceneContext::FBXSceneContext(char const* filename, FbxManager* fbxManager, std::shared_ptr<RenderDevice> const& renderDevice, std::shared_ptr<MaterialTable> const& materialTable) :
 m_filename(filename),
 m_manager(fbxManager),
 m_scene(nullptr),
 m_importer(nullptr),
 m_currentAnimLayer(nullptr),
-m_deviceResources(deviceResources)
+m_renderDevice(renderDevice),
+m_materialTable(materialTable),
+m_clusterIndexCapacity(0),
+m_occluderError(DEFAULT_OCCLUDER_ERROR),
+m_depthProgram(nullptr),
+m_instancedDepthProgram(nullptr)
 {
 }
 
 bool FBXSceneContext::Initialize()
 {
+	DIVE_PROFILE_SCOPE("Cook scene");
 	m_scene = FbxScene::Create(m_manager, "");
 	if (!m_scene)
 	{
@@ -136,26 +210,75 @@ void FBXSceneContext::LoadCacheRecursive()
 				_RPT1(0, "Failed to load texture file: %s\n", filename.Buffer());
 			}
 
+			if (SUCCEEDED(status) && info.mipLevels == 1)
+			{
+				DIVE_PROFILE_SCOPE("Generate mip maps");
+				DirectX::ScratchImage*	mipChain = new DirectX::ScratchImage();
+				if (SUCCEEDED(GenerateTextureMipMaps(img->GetImages(), img->GetImageCount(), img->GetMetadata(), DirectX::TEX_FILTER_DEFAULT, 0, *mipChain, true)))
+				{
+					delete img;
+					img = mipChain;
+				}
+				else
+					delete mipChain;
+			}
+
 			if (SUCCEEDED(status))
+			{
+				MemoryTracker::Get().Allocate(MEMORY_TEXTURE, MEMORY_CPU, img->GetPixelsSize());
 				fileTexture->SetUserDataPtr(img);
+			}
 		}
 	}
 
+	PackTextures();
+
 	LoadCacheRecursive(m_scene->GetRootNode());
+
+	CreateTextureViews();
+
+	m_draws.clear();
+	m_culler.Clear();
+	m_clusterIndexCapacity = 0;
+	BuildDrawsRecursive(m_scene->GetRootNode());
+	BuildHierarchy();
+	SelectOccluders();
+
+	// Room for every clustered draw with all of its clusters visible.
+	if (m_clusterIndexCapacity)
+	{
+		MemoryScope	memoryScope(MEMORY_MESH);
+		m_clusterIndexBuffer = m_renderDevice->CreateBuffer(BIND_INDEX_BUFFER, USAGE_DYNAMIC, m_clusterIndexCapacity * sizeof(uint32), nullptr);
+	}
+
+	// Every material of the scene has been registered, upload the packed table once.
+	m_materialTable->CreateDeviceDependentResources();
 }
 
 void FBXSceneContext::LoadCacheRecursive(FbxNode* node)
 {
 	auto const	materialCount = node->GetMaterialCount();
+	std::vector<TextureAtlas::Region>	atlasRegions;
 	for (auto materialIndex = 0; materialIndex < materialCount; ++materialIndex)
 	{
 		FbxSurfaceMaterial*	material = node->GetMaterial(materialIndex);
-		if (material && !material->GetUserDataPtr())
+		if (!material)
+			continue;
+
+		if (!material->GetUserDataPtr())
 		{
 			FbxAutoPtr<MaterialCache>	materialCache(new MaterialCache());
-			if (materialCache->Initialize(material))
+			if (materialCache->Initialize(material, *m_materialTable))
 				material->SetUserDataPtr(materialCache.Release());
 		}
+
+		auto const	region = m_atlasRegions.find(GetDiffuseTexture(material));
+		if (region != m_atlasRegions.end())
+		{
+			// Left empty for nodes without a packed texture, their meshes load unchanged.
+			atlasRegions.resize(materialCount);
+			atlasRegions[materialIndex] = region->second;
+		}
 	}
 
 	FbxNodeAttribute*	nodeAttribute = node->GetNodeAttribute();
@@ -166,8 +289,8 @@ void FBXSceneContext::LoadCacheRecursive(FbxNode* node)
 			FbxMesh*	mesh = node->GetMesh();
 			if (mesh && !mesh->GetUserDataPtr())
 			{
-				FbxAutoPtr<VBOMesh>	meshCache(new VBOMesh(m_deviceResources));
-				if (meshCache->Initialize(mesh))
+				FbxAutoPtr<VBOMesh>	meshCache(new VBOMesh(m_renderDevice));
+				if (meshCache->Initialize(mesh, atlasRegions, m_occluderError))
 					mesh->SetUserDataPtr(meshCache.Release());
 			}
 		}
@@ -180,4 +303,343 @@ void FBXSceneContext::LoadCacheRecursive(FbxNode* node)
 	auto const	childCount = node->GetChildCount();
 	for (auto childIndex = 0; childIndex < childCount; ++childIndex)
 		LoadCacheRecursive(node->GetChild(childIndex));
+}
+
+void FBXSceneContext::PackTextures()
+{
+	DIVE_PROFILE_SCOPE("Pack textures");
+	std::unordered_set<FbxFileTexture const*>	candidates;
+	std::unordered_set<FbxFileTexture const*>	excluded;
+
+	auto const	materialCount = m_scene->GetMaterialCount();
+	for (auto materialIndex = 0; materialIndex < materialCount; ++materialIndex)
+	{
+		FbxSurfaceMaterial const*	material = m_scene->GetMaterial(materialIndex);
+		FbxFileTexture const*		texture = GetDiffuseTexture(material);
+		if (!texture)
+			continue;
+
+		if (HasOnlyDiffuseTexture(material))
+			candidates.insert(texture);
+		else
+			excluded.insert(texture);
+	}
+
+	// A texture sampled outside [0, 1] relies on wrapping, which an atlas tile cannot do.
+	auto const	meshCount = m_scene->GetSrcObjectCount<FbxMesh>();
+	for (auto meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+	{
+		FbxMesh const*	mesh = m_scene->GetSrcObject<FbxMesh>(meshIndex);
+		FbxNode const*	node = mesh->GetNode();
+		FbxStringList	UVNames;
+		mesh->GetUVSetNames(UVNames);
+		if (!node || !UVNames.GetCount())
+			continue;
+
+		auto const	polygonCount = mesh->GetPolygonCount();
+		for (auto polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex)
+		{
+			FbxSurfaceMaterial const*	material = node->GetMaterial(GetPolygonMaterial(mesh, polygonIndex));
+			FbxFileTexture const*		texture = material ? GetDiffuseTexture(material) : nullptr;
+			if (!texture || !candidates.count(texture) || excluded.count(texture))
+				continue;
+
+			auto const	polygonSize = mesh->GetPolygonSize(polygonIndex);
+			for (auto verticeIndex = 0; verticeIndex < polygonSize; ++verticeIndex)
+			{
+				FbxVector2	UV;
+				bool		unmappedUV;
+				mesh->GetPolygonVertexUV(polygonIndex, verticeIndex, UVNames[0], UV, unmappedUV);
+				if (UV[0] < -ATLAS_UV_EPSILON || UV[0] > 1.0f + ATLAS_UV_EPSILON ||
+					UV[1] < -ATLAS_UV_EPSILON || UV[1] > 1.0f + ATLAS_UV_EPSILON)
+				{
+					excluded.insert(texture);
+					break;
+				}
+			}
+		}
+	}
+
+	// Walk the scene textures rather than the sets to keep the layout stable between runs.
+	std::vector<std::pair<FbxFileTexture*, uint32>>	tiles;
+	auto const	textureCount = m_scene->GetTextureCount();
+	for (auto textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+	{
+		FbxFileTexture*	fileTexture = FbxCast<FbxFileTexture>(m_scene->GetTexture(textureIndex));
+		if (!fileTexture || !candidates.count(fileTexture) || excluded.count(fileTexture))
+			continue;
+
+		uint32 const	tile = m_textureAtlas.Add(static_cast<ScratchImage const*>(fileTexture->GetUserDataPtr()));
+		if (tile != TextureAtlas::InvalidTile)
+			tiles.push_back(std::make_pair(fileTexture, tile));
+	}
+
+	if (tiles.empty())
+		return;
+
+	if (FAILED(m_textureAtlas.Build()))
+	{
+		_RPT0(0, "Failed to build the texture atlas, textures are left unpacked\n");
+		m_textureAtlas.Clear();
+		return;
+	}
+
+	for (auto const& tile : tiles)
+	{
+		TextureAtlas::Region	region;
+		if (!m_textureAtlas.GetRegion(tile.second, region))
+			continue;
+
+		ScratchImage* const	image = static_cast<ScratchImage*>(tile.first->GetUserDataPtr());
+		MemoryTracker::Get().Free(MEMORY_TEXTURE, MEMORY_CPU, image->GetPixelsSize());
+		delete image;
+		tile.first->SetUserDataPtr(m_textureAtlas.GetPage(region.Page));
+		m_atlasRegions[tile.first] = region;
+	}
+
+	TextureAtlas::Report const&	report = m_textureAtlas.GetReport();
+	_RPT4(0, "Texture atlas: %u of %u textures packed into %u pages, %.1f%% of the page area used\n",
+		report.PackedCount, report.TextureCount, report.PageCount, report.GetEfficiency() * 100.0f);
+	_RPT2(0, "Texture atlas: %u texture binds down to %u\n", report.GetBindsBefore(), report.GetBindsAfter());
+}
+
+void FBXSceneContext::CreateTextureViews()
+{
+	auto const	textureCount = m_scene->GetTextureCount();
+	for (auto textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+	{
+		FbxFileTexture const*	fileTexture = FbxCast<FbxFileTexture>(m_scene->GetTexture(textureIndex));
+		ScratchImage const*		image = fileTexture ? static_cast<ScratchImage const*>(fileTexture->GetUserDataPtr()) : nullptr;
+		if (!image || m_textureViews.count(image))
+			continue;
+
+		TextureView	textureView;
+		textureView.View = m_renderDevice->CreateTextureView(*image);
+		// 0 is the texture set of draws without texture.
+		textureView.TextureSet = static_cast<uint32>(m_textureViews.size() + 1);
+		m_textureViews[image] = textureView;
+	}
+}
+
+void FBXSceneContext::SubmitDraws(RenderQueue& renderQueue, ClusterIndices& clusterIndices, ShaderProgram const& program, ShaderProgram const* instancedProgram, CXMMATRIX view, CXMMATRIX projection, float farPlane)
+{
+	DIVE_PROFILE_SCOPE("Submit scene");
+	XMMATRIX const	viewProjection = XMMatrixMultiply(view, projection);
+	m_visible.clear();
+	{
+		DIVE_PROFILE_SCOPE("Frustum culling");
+		if (m_draws.size() >= HIERARCHY_CULL_MIN_DRAWS)
+			m_hierarchy.Cull(viewProjection, m_visible);
+		else
+			m_culler.Cull(viewProjection, m_visible);
+	}
+
+	// The second row keeps the vertical scale whichever way the display is rotated.
+	float const	projectionScale = XMVectorGetX(XMVector3Length(projection.r[1]));
+
+	{
+		DIVE_PROFILE_SCOPE("Occlusion culling");
+		m_occlusionCuller.BeginFrame(viewProjection);
+		for (auto index : m_visible)
+		{
+			SceneDraw const&	draw = m_draws[index];
+			if (!draw.Occluder.IndexCount)
+				continue;
+
+			XMFLOAT3 const	center = m_culler.GetCenter(index);
+			float const		depth = -XMVectorGetZ(XMVector3Transform(XMLoadFloat3(&center), view));
+			if (GetScreenSize(m_culler.GetSphere(index).Radius, depth, projectionScale) >= OCCLUDER_MIN_SCREEN_SIZE)
+				m_occlusionCuller.AddOccluder(XMMatrixTranspose(XMLoadFloat4x4(&draw.Item.Model)), draw.Occluder);
+		}
+		m_occlusionCuller.Rasterize();
+	}
+
+	// Visible clusters of full-detail draws are compacted into one index buffer rewritten every frame.
+	if (clusterIndices.Indices.size() < m_clusterIndexCapacity)
+		clusterIndices.Indices.resize(m_clusterIndexCapacity);
+	clusterIndices.Count = 0;
+	m_clusterCuller.ResetStats();
+
+	for (auto index : m_visible)
+	{
+		if (!m_occlusionCuller.IsVisible(m_culler.GetBox(index)))
+			continue;
+
+		SceneDraw&			draw = m_draws[index];
+		XMFLOAT3 const		center = m_culler.GetCenter(index);
+		XMVECTOR const		viewPosition = XMVector3Transform(XMLoadFloat3(&center), view);
+		float const			depth = -XMVectorGetZ(viewPosition);
+		float const			normalizedDepth = depth / farPlane;
+
+		float const	screenSize = GetScreenSize(m_culler.GetSphere(index).Radius, depth, projectionScale);
+		draw.Lod = SelectLod(screenSize, draw.Lod, draw.LodCount);
+
+		DrawItem	item = draw.Item;
+		item.StartIndex = draw.LodStartIndex[draw.Lod];
+		item.IndexCount = draw.LodIndexCount[draw.Lod];
+		if (!draw.Lod && draw.ClusterCount && m_clusterIndexBuffer)
+		{
+			m_clusterCuller.SetView(XMMatrixTranspose(XMLoadFloat4x4(&item.Model)), view, projection);
+			item.IndexBuffer = m_clusterIndexBuffer.get();
+			item.StartIndex = clusterIndices.Count;
+			item.IndexCount = m_clusterCuller.Cull(draw.Clusters, draw.ClusterCount, draw.ClusterIndices, clusterIndices.Indices.data() + clusterIndices.Count);
+			clusterIndices.Count += item.IndexCount;
+			if (!item.IndexCount)
+				continue;
+		}
+
+		item.Program = &program;
+		item.InstancedProgram = instancedProgram;
+		item.SortKey = RenderQueue::MakeSortKey(RenderQueue::PASS_OPAQUE, program.Id, item.MaterialIndex, draw.TextureSet, normalizedDepth);
+		renderQueue.Submit(item);
+
+		// Texture and material only keep the batching, and so the vertex shader and the depths, the same as the opaque draw.
+		if (m_depthProgram && screenSize >= DEPTH_PREPASS_MIN_SCREEN_SIZE)
+		{
+			item.Program = m_depthProgram;
+			item.InstancedProgram = instancedProgram ? m_instancedDepthProgram : nullptr;
+			item.SortKey = RenderQueue::MakeSortKey(RenderQueue::PASS_DEPTH, m_depthProgram->Id, item.MaterialIndex, draw.TextureSet, normalizedDepth);
+			renderQueue.Submit(item);
+		}
+	}
+}
+
+void FBXSceneContext::UploadClusterIndices(ClusterIndices const& clusterIndices)
+{
+	if (!clusterIndices.Count || !m_clusterIndexBuffer)
+		return;
+
+	void* const	destination = m_renderDevice->MapBuffer(m_clusterIndexBuffer.get(), MAP_WRITE_DISCARD);
+	memcpy(destination, clusterIndices.Indices.data(), clusterIndices.Count * sizeof(uint32));
+	m_renderDevice->UnmapBuffer(m_clusterIndexBuffer.get(), 0, clusterIndices.Count * sizeof(uint32));
+}
+
+void FBXSceneContext::SetDepthPrepass(ShaderProgram const* program, ShaderProgram const* instancedProgram)
+{
+	m_depthProgram = program;
+	m_instancedDepthProgram = instancedProgram;
+}
+
+FbxNode* FBXSceneContext::Pick(FXMVECTOR origin, FXMVECTOR direction, float& distance) const
+{
+	uint32 const	draw = m_hierarchy.RayCast(origin, direction, distance);
+	return draw != BoundingVolumeHierarchy::InvalidPrimitive ? m_draws[draw].Node : nullptr;
+}
+
+void FBXSceneContext::BuildDrawsRecursive(FbxNode* node)
+{
+	FbxMesh const*	mesh = node->GetMesh();
+	VBOMesh const*	meshCache = mesh ? static_cast<VBOMesh const*>(mesh->GetUserDataPtr()) : nullptr;
+	if (meshCache)
+	{
+		// FbxAMatrix uses the same row-vector convention as DirectXMath.
+		FbxAMatrix const	globalTransform = node->EvaluateGlobalTransform();
+		XMFLOAT4X4			world;
+		for (auto row = 0; row < 4; ++row)
+		{
+			for (auto column = 0; column < 4; ++column)
+				world.m[row][column] = static_cast<float>(globalTransform.Get(row, column));
+		}
+		XMMATRIX const	worldMatrix = XMLoadFloat4x4(&world);
+
+		SceneDraw	draw;
+		draw.Node = node;
+		draw.Item.SortKey = 0;
+		draw.Item.Program = nullptr;
+		draw.Item.InstancedProgram = nullptr;
+		draw.Item.Texture = nullptr;
+		draw.Item.VertexBuffer = meshCache->GetVertexBuffer();
+		draw.Item.IndexBuffer = meshCache->GetIndexBuffer();
+		draw.Item.IndexFormat = DXGI_FORMAT_R32_UINT;
+		draw.Item.VertexStride = sizeof(VertexPositionColorNormalUV);
+		XMStoreFloat4x4(&draw.Item.Model, XMMatrixTranspose(worldMatrix));
+
+		auto const	subMeshCount = meshCache->GetSubMeshCount();
+		for (auto subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
+		{
+			meshCache->GetSubMeshRange(subMeshIndex, draw.Item.StartIndex, draw.Item.IndexCount);
+			if (!draw.Item.IndexCount)
+				continue;
+
+			draw.LodCount = static_cast<uint32>(meshCache->GetSubMeshLodCount(subMeshIndex));
+			draw.Lod = 0;
+			for (uint32 lod = 0; lod < draw.LodCount; ++lod)
+				meshCache->GetSubMeshLodRange(subMeshIndex, lod, draw.LodStartIndex[lod], draw.LodIndexCount[lod]);
+
+			meshCache->GetSubMeshClusters(subMeshIndex, draw.Clusters, draw.ClusterCount);
+			draw.ClusterIndices = meshCache->GetClusterIndices();
+			meshCache->GetSubMeshOccluder(subMeshIndex, draw.Occluder);
+			if (draw.ClusterCount)
+				m_clusterIndexCapacity += draw.LodIndexCount[0];
+
+			FbxSurfaceMaterial const*	material = node->GetMaterial(subMeshIndex);
+			MaterialCache const*		materialCache = material ? static_cast<MaterialCache const*>(material->GetUserDataPtr()) : nullptr;
+			draw.Item.MaterialIndex = materialCache ? materialCache->GetMaterialIndex() : MaterialTable::DefaultMaterial;
+
+			ScratchImage const*	texture = materialCache ? materialCache->GetDiffuseTexture() : nullptr;
+			auto const			textureView = m_textureViews.find(texture);
+			bool const			hasTexture = textureView != m_textureViews.end();
+			draw.Item.Texture = hasTexture ? textureView->second.View.get() : nullptr;
+			draw.TextureSet = hasTexture ? textureView->second.TextureSet : 0;
+
+			BoundingBox		box;
+			BoundingSphere	sphere;
+			meshCache->GetSubMeshBounds(subMeshIndex, box, sphere);
+			box.Transform(box, worldMatrix);
+			sphere.Transform(sphere, worldMatrix);
+			m_culler.Add(box, sphere);
+			m_draws.push_back(draw);
+		}
+	}
+
+	auto const	childCount = node->GetChildCount();
+	for (auto childIndex = 0; childIndex < childCount; ++childIndex)
+		BuildDrawsRecursive(node->GetChild(childIndex));
+}
+
+void FBXSceneContext::BuildHierarchy()
+{
+	std::vector<BoundingBox>	bounds(m_culler.GetCount());
+	for (uint32 i = 0; i < m_culler.GetCount(); ++i)
+		bounds[i] = m_culler.GetBox(i);
+
+	m_hierarchy.Build(bounds.data(), static_cast<uint32>(bounds.size()), true);
+	_RPT2(0, "Scene: %u submesh draws, %u hierarchy nodes\n", static_cast<uint32>(m_draws.size()), m_hierarchy.GetNodeCount());
+
+	uint32	triangles[VBOMesh::MaxLods] = { };
+	for (auto const& draw : m_draws)
+	{
+		for (uint32 lod = 0; lod < VBOMesh::MaxLods; ++lod)
+			triangles[lod] += draw.LodIndexCount[lod < draw.LodCount ? lod : draw.LodCount - 1] / 3;
+	}
+	_RPT4(0, "Scene: %u / %u / %u / %u triangles per level of detail\n", triangles[0], triangles[1], triangles[2], triangles[3]);
+}
+
+void FBXSceneContext::SelectOccluders()
+{
+	if (m_draws.empty())
+		return;
+
+	BoundingBox	sceneBox = m_culler.GetBox(0);
+	for (uint32 i = 1; i < m_culler.GetCount(); ++i)
+	{
+		BoundingBox const	merged = sceneBox;
+		BoundingBox::CreateMerged(sceneBox, merged, m_culler.GetBox(i));
+	}
+
+	float const	minRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&sceneBox.Extents))) * OCCLUDER_MIN_SCENE_SIZE;
+	uint32		occluderCount = 0;
+	uint32		occluderTriangles = 0;
+	for (uint32 i = 0; i < m_draws.size(); ++i)
+	{
+		OccluderMesh&	occluder = m_draws[i].Occluder;
+		if (m_culler.GetSphere(i).Radius < minRadius)
+			occluder = OccluderMesh();
+		if (!occluder.IndexCount)
+			continue;
+
+		++occluderCount;
+		occluderTriangles += occluder.IndexCount / 3;
+	}
+	_RPT2(0, "Scene: %u occluders, %u occluder triangles\n", occluderCount, occluderTriangles);
 }
\ No newline at end of file
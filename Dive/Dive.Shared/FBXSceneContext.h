@@ -1,17 +1,58 @@
 #pragma once
 
+#include "BoundingVolumeHierarchy.h"
 #include "fbxsdk.h"
-#include "Common/DeviceResources.h"
+#include "FBXSceneCache.h"
+#include "FrustumCuller.h"
+#include "MaterialTable.h"
+#include "OcclusionCuller.h"
+#include "RenderDevice.h"
+#include "RenderQueue.h"
+#include "TextureAtlas.h"
+
+#include <unordered_map>
 
 namespace Dive
 {
 	class FBXSceneContext
 	{
 	public:
-		FBXSceneContext(char const* filename, FbxManager* fbxManager, std::shared_ptr<DX::DeviceResources> const& m_deviceResources);
+		// Visible clusters compacted by SubmitDraws, uploaded to the cluster index buffer before the draws run.
+		struct ClusterIndices
+		{
+			ClusterIndices() : Count(0) { }
+
+			std::vector<uint32>	Indices;
+			uint32				Count;
+		};
+
+		FBXSceneContext(char const* filename, FbxManager* fbxManager, std::shared_ptr<RenderDevice> const& renderDevice, std::shared_ptr<MaterialTable> const& materialTable);
+
+		// Simplification error allowed for occluders, relative to the submesh size, set before Initialize. Occluders can
+		// close gaps and concavities up to about that size and hide what is seen through them. Assets with thin
+		// openings want a lower value, which keeps occluders closer to their mesh but leaves fewer submeshes one.
+		void	SetOccluderError(float error)		{ m_occluderError = error; }
+		float	GetOccluderError() const			{ return m_occluderError; }
 
 		bool	Initialize();
 		void	Deinitialize();
+		// Submits the submeshes inside the view frustum and not hidden behind the occluders, each at the level of
+		// detail its screen size calls for. Touches no device state, so it can run off the render thread while
+		// the previous frame is drawn.
+		// view and projection are not transposed.
+		// Nodes sharing a mesh are drawn with instancedProgram when the queue has an instance buffer.
+		void	SubmitDraws(RenderQueue& renderQueue, ClusterIndices& clusterIndices, ShaderProgram const& program, ShaderProgram const* instancedProgram, DirectX::CXMMATRIX view, DirectX::CXMMATRIX projection, float farPlane);
+		// Render thread, before the draws submitted with clusterIndices are executed.
+		void	UploadClusterIndices(ClusterIndices const& clusterIndices);
+		// Draws covering a large part of the screen are also submitted to the depth pass with program, a depth-only
+		// program sharing the vertex shader of the one given to SubmitDraws. nullptr turns the prepass off.
+		void	SetDepthPrepass(ShaderProgram const* program, ShaderProgram const* instancedProgram);
+		// Node owning the nearest submesh box along the ray, nullptr when nothing is hit.
+		FbxNode*	Pick(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& distance) const;
+		// Clusters tested by the last SubmitDraws. Only valid on its thread until the next one, copy them from there.
+		ClusterCuller::Stats const&	GetClusterStats() const	{ return m_clusterCuller.GetStats(); }
+		// Occluders and draws tested by the last SubmitDraws, same as GetClusterStats.
+		OcclusionCuller::Stats const&	GetOcclusionStats() const	{ return m_occlusionCuller.GetStats(); }
 
 	private:
 		char const*	m_filename;
@@ -25,12 +66,63 @@ namespace Dive
 		FbxArray<FbxNode*>		m_cameraArray;
 		FbxArray<FbxPose*>		m_poseArray;
 
-		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
+		std::shared_ptr<RenderDevice>	m_renderDevice;
+		std::shared_ptr<MaterialTable>	m_materialTable;
+
+		struct TextureView
+		{
+			std::shared_ptr<RenderTextureView>	View;
+			uint32								TextureSet;
+		};
+
+		TextureAtlas													m_textureAtlas;
+		std::unordered_map<FbxFileTexture const*, TextureAtlas::Region>	m_atlasRegions;
+		std::unordered_map<DirectX::ScratchImage const*, TextureView>		m_textureViews;
+
+		// The scene is not animated, so every submesh draw and its world bounds are built once at load.
+		// Draws, culler entries and hierarchy primitives share their index. Large scenes are culled
+		// through the hierarchy, small ones are cheaper to test flat. Lod is the level drawn last time.
+		struct SceneDraw
+		{
+			DrawItem	Item;
+			uint32		TextureSet;
+			FbxNode*	Node;
+			uint32		LodCount;
+			uint32		Lod;
+			uint32		LodStartIndex[VBOMesh::MaxLods];
+			uint32		LodIndexCount[VBOMesh::MaxLods];
+			// Clusters of the full-detail level, owned by the mesh cache.
+			MeshCluster const*	Clusters;
+			uint32				ClusterCount;
+			uint32 const*		ClusterIndices;
+			// Empty unless the submesh is large enough in the scene to hide others.
+			OccluderMesh		Occluder;
+		};
+
+		std::vector<SceneDraw>		m_draws;
+		FrustumCuller				m_culler;
+		BoundingVolumeHierarchy		m_hierarchy;
+		std::vector<uint32>			m_visible;
+
+		ClusterCuller					m_clusterCuller;
+		std::unique_ptr<RenderBuffer>	m_clusterIndexBuffer;
+		uint32							m_clusterIndexCapacity;
+
+		OcclusionCuller	m_occlusionCuller;
+		float			m_occluderError;
+
+		ShaderProgram const*	m_depthProgram;
+		ShaderProgram const*	m_instancedDepthProgram;
 
 	private:
 		void	FillCameraArray();
 		void	FillCameraArrayRecursive(FbxNode* node);
 		void	LoadCacheRecursive();
 		void	LoadCacheRecursive(FbxNode* node);
+		void	PackTextures();
+		void	CreateTextureViews();
+		void	BuildDrawsRecursive(FbxNode* node);
+		void	BuildHierarchy();
+		void	SelectOccluders();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "FramePacer.h"
+
+#include <cmath>
+
+using namespace Dive;
+
+namespace
+{
+	float const	NO_FAILED_SCALE = 1000.0f;
+}
+
+FramePacerSettings::FramePacerSettings() :
+TargetFrameMs(1000.0 / 60.0),
+MinScale(0.5f),
+MaxScale(1.0f),
+ScaleDownStep(0.1f),
+ScaleUpStep(0.05f),
+SlowRatio(1.15),
+FastRatio(0.8),
+SlowFrames(3),
+FastFrames(60),
+SettleFrames(5),
+MaxBackoff(8),
+HistoryLength(240)
+{
+}
+
+FramePacer::FramePacer(FramePacerSettings const& settings) :
+m_scale(1.0f),
+m_lastDecision(PACING_HOLD),
+m_lastChange(PACING_HOLD),
+m_slowFrames(0),
+m_fastFrames(0),
+m_settleFrames(0),
+m_framesSinceChange(0),
+m_failedScale(NO_FAILED_SCALE),
+m_scaleChanges(0),
+m_frame(0),
+m_historyNext(0)
+{
+	SetSettings(settings);
+}
+
+void FramePacer::SetSettings(FramePacerSettings const& settings)
+{
+	m_settings = settings;
+	m_scale = ClampScale(m_scale);
+	m_upscaleDelay = m_settings.FastFrames;
+
+	m_history.clear();
+	m_history.reserve(m_settings.HistoryLength);
+	m_historyNext = 0;
+}
+
+bool FramePacer::AddFrame(double frameMs, double cpuMs, double gpuMs)
+{
+	float const	scale = m_scale;
+	m_lastDecision = Decide(frameMs, cpuMs, gpuMs);
+
+	PacingRecord	record;
+	record.Frame = m_frame++;
+	record.FrameMs = frameMs;
+	record.CpuMs = cpuMs;
+	record.GpuMs = gpuMs;
+	record.Scale = scale;
+	record.Decision = m_lastDecision;
+
+	if (m_history.size() < m_settings.HistoryLength)
+		m_history.push_back(record);
+	else if (!m_history.empty())
+		m_history[m_historyNext] = record;
+	if (m_settings.HistoryLength)
+		m_historyNext = (m_historyNext + 1) % m_settings.HistoryLength;
+
+	return m_scale != scale;
+}
+
+void FramePacer::Settle()
+{
+	m_settleFrames = m_settings.SettleFrames;
+	m_slowFrames = 0;
+	m_fastFrames = 0;
+}
+
+void FramePacer::GetHistory(std::vector<PacingRecord>& history) const
+{
+	history.clear();
+	history.reserve(m_history.size());
+	uint32 const	start = m_history.size() < m_settings.HistoryLength ? 0 : m_historyNext;
+	for (size_t i = 0; i < m_history.size(); ++i)
+		history.push_back(m_history[(start + i) % m_history.size()]);
+}
+
+PacingDecision FramePacer::Decide(double frameMs, double cpuMs, double gpuMs)
+{
+	++m_framesSinceChange;
+
+	// A step up to the failed scale that held for a while clears it.
+	if (m_lastChange == PACING_SCALE_UP && m_framesSinceChange == m_settings.FastFrames && m_scale >= m_failedScale)
+	{
+		m_failedScale = NO_FAILED_SCALE;
+		m_upscaleDelay = m_settings.FastFrames;
+	}
+
+	if (m_settleFrames)
+	{
+		--m_settleFrames;
+		return PACING_SETTLING;
+	}
+
+	double const	target = m_settings.TargetFrameMs;
+	double const	slowLimit = target * m_settings.SlowRatio;
+	bool const		gpuKnown = gpuMs > 0.0;
+
+	if (frameMs > slowLimit || (gpuKnown && gpuMs > slowLimit))
+	{
+		m_fastFrames = 0;
+		if (++m_slowFrames < m_settings.SlowFrames)
+			return PACING_HOLD;
+		m_slowFrames = 0;
+
+		// Without a GPU time, a late frame with the CPU in time is put down to the GPU.
+		if (gpuKnown ? cpuMs >= gpuMs : cpuMs > slowLimit)
+			return PACING_CPU_BOUND;
+		if (m_scale <= m_settings.MinScale)
+			return PACING_HOLD;
+
+		// The GPU time goes with the pixel count, the square of the scale.
+		float	step = m_settings.ScaleDownStep;
+		if (gpuKnown)
+		{
+			float const	fit = m_scale * static_cast<float>(std::sqrt(target / gpuMs));
+			if (m_scale - fit > step)
+				step = m_scale - fit;
+		}
+
+		// Taking back a step up makes the next try at that scale wait longer, twice as long for every failure in a row.
+		if (m_lastChange == PACING_SCALE_UP && m_framesSinceChange < m_settings.FastFrames)
+		{
+			uint32 const	maxDelay = m_settings.FastFrames * m_settings.MaxBackoff;
+			uint32 const	delay = m_scale == m_failedScale ? m_upscaleDelay * 2 : m_settings.FastFrames * 2;
+			m_upscaleDelay = delay < maxDelay ? delay : maxDelay;
+			m_failedScale = m_scale;
+		}
+
+		ChangeScale(m_scale - step, PACING_SCALE_DOWN);
+		return PACING_SCALE_DOWN;
+	}
+	m_slowFrames = 0;
+
+	if (m_scale >= m_settings.MaxScale)
+	{
+		m_fastFrames = 0;
+		return PACING_HOLD;
+	}
+
+	// With a GPU time the next scale has to fit with room to spare, without one every frame in time counts
+	// and the backoff keeps the probing in check.
+	float const		scale = ClampScale(m_scale + m_settings.ScaleUpStep);
+	double const	fastLimit = target * m_settings.FastRatio;
+	bool			fast = cpuMs < fastLimit;
+	if (gpuKnown)
+	{
+		double const	ratio = static_cast<double>(scale) / m_scale;
+		fast = fast && gpuMs * ratio * ratio < fastLimit;
+	}
+
+	if (!fast)
+	{
+		m_fastFrames = 0;
+		return PACING_HOLD;
+	}
+	if (++m_fastFrames < (scale >= m_failedScale ? m_upscaleDelay : m_settings.FastFrames))
+		return PACING_HOLD;
+
+	ChangeScale(scale, PACING_SCALE_UP);
+	return PACING_SCALE_UP;
+}
+
+void FramePacer::ChangeScale(float scale, PacingDecision decision)
+{
+	// Whole percents, so that a scale reached twice compares equal.
+	m_scale = ClampScale(static_cast<float>(std::floor(scale * 100.0f + 0.5f)) / 100.0f);
+	m_lastChange = decision;
+	m_framesSinceChange = 0;
+	m_slowFrames = 0;
+	m_fastFrames = 0;
+	m_settleFrames = m_settings.SettleFrames;
+	++m_scaleChanges;
+}
+
+float FramePacer::ClampScale(float scale) const
+{
+	if (scale < m_settings.MinScale)
+		return m_settings.MinScale;
+	if (scale > m_settings.MaxScale)
+		return m_settings.MaxScale;
+	return scale;
+}
\ No newline at end of file
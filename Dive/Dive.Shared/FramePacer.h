@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+
+namespace Dive
+{
+	enum PacingDecision
+	{
+		PACING_HOLD,
+		// Frames right after a change or a resize are not judged.
+		PACING_SETTLING,
+		PACING_SCALE_DOWN,
+		PACING_SCALE_UP,
+		// Frames are late but the CPU is the limit, a lower resolution would not help.
+		PACING_CPU_BOUND
+	};
+
+	// Durations in milliseconds, ratios relative to TargetFrameMs.
+	struct FramePacerSettings
+	{
+		FramePacerSettings();
+
+		double	TargetFrameMs;
+		// Equal bounds turn the controller off.
+		float	MinScale;
+		float	MaxScale;
+		// Smallest step down, larger when the GPU time shows a larger overload. Steps up are fixed and smaller,
+		// so that the scale settles below the limit instead of oscillating around it.
+		float	ScaleDownStep;
+		float	ScaleUpStep;
+		// A frame slower than this misses the target.
+		double	SlowRatio;
+		// Busy time below this leaves room for a larger scale.
+		double	FastRatio;
+		// Consecutive frames needed before scaling down and up.
+		uint32	SlowFrames;
+		uint32	FastFrames;
+		uint32	SettleFrames;
+		// Scaling back down shortly after scaling up multiplies the frames needed before trying that scale again,
+		// up to this factor.
+		uint32	MaxBackoff;
+		uint32	HistoryLength;
+	};
+
+	struct PacingRecord
+	{
+		uint64			Frame;
+		double			FrameMs;
+		double			CpuMs;
+		double			GpuMs;
+		// Scale the frame was judged at, the decision applies from the next one.
+		float			Scale;
+		PacingDecision	Decision;
+	};
+
+	// Picks the fraction of the output resolution the scene is rendered at to hold a target frame rate. Slow frames
+	// scale down right away, frames with headroom scale up slowly, and a step up that had to be taken back makes
+	// the next one wait longer. Only works on the timings it is fed, so traces can be replayed on any platform.
+	class FramePacer
+	{
+	public:
+		explicit FramePacer(FramePacerSettings const& settings = FramePacerSettings());
+
+		void						SetSettings(FramePacerSettings const& settings);
+		FramePacerSettings const&	GetSettings() const		{ return m_settings; }
+
+		// frameMs is the time between the last two presents, cpuMs the longest CPU work on the way to it and
+		// gpuMs the GPU time of the frame, 0 when unknown. Returns true when the render scale changed.
+		bool	AddFrame(double frameMs, double cpuMs, double gpuMs);
+		// Skips the next frames, for example after the render targets were recreated for another reason.
+		void	Settle();
+
+		float			GetRenderScale() const		{ return m_scale; }
+		PacingDecision	GetLastDecision() const		{ return m_lastDecision; }
+		// Frames with headroom needed before stepping up to the last scale that had to be taken back.
+		uint32			GetUpscaleDelay() const		{ return m_upscaleDelay; }
+		uint32			GetScaleChanges() const		{ return m_scaleChanges; }
+		// The last HistoryLength frames, oldest first.
+		void			GetHistory(std::vector<PacingRecord>& history) const;
+
+	private:
+		PacingDecision	Decide(double frameMs, double cpuMs, double gpuMs);
+		void			ChangeScale(float scale, PacingDecision decision);
+		float			ClampScale(float scale) const;
+
+		FramePacerSettings	m_settings;
+
+		float			m_scale;
+		PacingDecision	m_lastDecision;
+		PacingDecision	m_lastChange;
+		uint32			m_slowFrames;
+		uint32			m_fastFrames;
+		uint32			m_settleFrames;
+		uint32			m_framesSinceChange;
+		float			m_failedScale;
+		uint32			m_upscaleDelay;
+		uint32			m_scaleChanges;
+
+		uint64						m_frame;
+		std::vector<PacingRecord>	m_history;
+		uint32						m_historyNext;
+	};
+}
\ No newline at end of file
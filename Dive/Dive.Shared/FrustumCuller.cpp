@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+
+#include <cfloat>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DIVE_CULLING_SSE2
+#if defined(__AVX__)
+#include <immintrin.h>
+#define DIVE_CULLING_AVX
+#endif
+#elif defined(_M_ARM) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DIVE_CULLING_NEON
+#endif
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	// Widest batch of any kernel, the arrays are always padded to it.
+	uint32 const	BATCH_SIZE = 8;
+
+	struct BoundsArrays
+	{
+		float const*	centerX;
+		float const*	centerY;
+		float const*	centerZ;
+		float const*	extentX;
+		float const*	extentY;
+		float const*	extentZ;
+	};
+
+	// A box is outside when, for some plane, its center is further behind it than its projected extent.
+	bool IsBoxVisible(XMFLOAT4 const planes[FrustumCuller::PlaneCount], BoundsArrays const& bounds, uint32 index)
+	{
+		for (auto i = 0; i < FrustumCuller::PlaneCount; ++i)
+		{
+			XMFLOAT4 const&	plane = planes[i];
+			float const		distance = plane.x * bounds.centerX[index] + plane.y * bounds.centerY[index] + plane.z * bounds.centerZ[index] + plane.w;
+			float const		radius = fabsf(plane.x) * bounds.extentX[index] + fabsf(plane.y) * bounds.extentY[index] + fabsf(plane.z) * bounds.extentZ[index];
+			if (distance + radius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	void CullBoxes(XMFLOAT4 const planes[FrustumCuller::PlaneCount], BoundsArrays const& bounds, uint32 count, std::vector<uint32>& visible)
+	{
+		uint32	index = 0;
+
+#if defined(DIVE_CULLING_AVX)
+		for (; index < count; index += 8)
+		{
+			__m256 const	centerX = _mm256_loadu_ps(bounds.centerX + index);
+			__m256 const	centerY = _mm256_loadu_ps(bounds.centerY + index);
+			__m256 const	centerZ = _mm256_loadu_ps(bounds.centerZ + index);
+			__m256 const	extentX = _mm256_loadu_ps(bounds.extentX + index);
+			__m256 const	extentY = _mm256_loadu_ps(bounds.extentY + index);
+			__m256 const	extentZ = _mm256_loadu_ps(bounds.extentZ + index);
+
+			__m256	inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (auto i = 0; i < FrustumCuller::PlaneCount; ++i)
+			{
+				XMFLOAT4 const&	plane = planes[i];
+				__m256	distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), centerX), _mm256_set1_ps(plane.w));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.y), centerY));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.z), centerZ));
+				__m256	radius = _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.x)), extentX);
+				radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.y)), extentY));
+				radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.z)), extentZ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			int	mask = _mm256_movemask_ps(inside);
+			for (uint32 lane = index; mask; ++lane, mask >>= 1)
+			{
+				if ((mask & 1) && lane < count)
+					visible.push_back(lane);
+			}
+		}
+#elif defined(DIVE_CULLING_SSE2)
+		for (; index < count; index += 4)
+		{
+			__m128 const	centerX = _mm_loadu_ps(bounds.centerX + index);
+			__m128 const	centerY = _mm_loadu_ps(bounds.centerY + index);
+			__m128 const	centerZ = _mm_loadu_ps(bounds.centerZ + index);
+			__m128 const	extentX = _mm_loadu_ps(bounds.extentX + index);
+			__m128 const	extentY = _mm_loadu_ps(bounds.extentY + index);
+			__m128 const	extentZ = _mm_loadu_ps(bounds.extentZ + index);
+
+			__m128	inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (auto i = 0; i < FrustumCuller::PlaneCount; ++i)
+			{
+				XMFLOAT4 const&	plane = planes[i];
+				__m128	distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), centerY));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), centerZ));
+				__m128	radius = _mm_mul_ps(_mm_set1_ps(fabsf(plane.x)), extentX);
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(plane.y)), extentY));
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(plane.z)), extentZ));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			int	mask = _mm_movemask_ps(inside);
+			for (uint32 lane = index; mask; ++lane, mask >>= 1)
+			{
+				if ((mask & 1) && lane < count)
+					visible.push_back(lane);
+			}
+		}
+#elif defined(DIVE_CULLING_NEON)
+		for (; index < count; index += 4)
+		{
+			float32x4_t const	centerX = vld1q_f32(bounds.centerX + index);
+			float32x4_t const	centerY = vld1q_f32(bounds.centerY + index);
+			float32x4_t const	centerZ = vld1q_f32(bounds.centerZ + index);
+			float32x4_t const	extentX = vld1q_f32(bounds.extentX + index);
+			float32x4_t const	extentY = vld1q_f32(bounds.extentY + index);
+			float32x4_t const	extentZ = vld1q_f32(bounds.extentZ + index);
+
+			uint32x4_t	inside = vdupq_n_u32(0xFFFFFFFF);
+			for (auto i = 0; i < FrustumCuller::PlaneCount; ++i)
+			{
+				XMFLOAT4 const&	plane = planes[i];
+				float32x4_t	distance = vmlaq_n_f32(vdupq_n_f32(plane.w), centerX, plane.x);
+				distance = vmlaq_n_f32(distance, centerY, plane.y);
+				distance = vmlaq_n_f32(distance, centerZ, plane.z);
+				float32x4_t	radius = vmulq_n_f32(extentX, fabsf(plane.x));
+				radius = vmlaq_n_f32(radius, extentY, fabsf(plane.y));
+				radius = vmlaq_n_f32(radius, extentZ, fabsf(plane.z));
+				inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(distance, radius), vdupq_n_f32(0.0f)));
+			}
+
+			uint32	lanes[4];
+			vst1q_u32(lanes, inside);
+			for (uint32 lane = 0; lane < 4; ++lane)
+			{
+				if (lanes[lane] && index + lane < count)
+					visible.push_back(index + lane);
+			}
+		}
+#endif
+
+		for (; index < count; ++index)
+		{
+			if (IsBoxVisible(planes, bounds, index))
+				visible.push_back(index);
+		}
+	}
+}
+
+// Gribb/Hartmann extraction for a row-vector matrix and D3D clip depth in [0, 1].
+// The planes are left unnormalized, the box tests only look at the sign.
+void FrustumCuller::ExtractPlanes(CXMMATRIX viewProjection, XMFLOAT4 planes[PlaneCount])
+{
+	XMMATRIX const	columns = XMMatrixTranspose(viewProjection);
+	XMVECTOR const	vectors[PlaneCount] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2])
+	};
+
+	for (auto i = 0; i < PlaneCount; ++i)
+		XMStoreFloat4(&planes[i], vectors[i]);
+}
+
+FrustumCuller::FrustumCuller() :
+m_count(0)
+{
+}
+
+void FrustumCuller::Clear()
+{
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_extentZ.clear();
+	m_sphereX.clear();
+	m_sphereY.clear();
+	m_sphereZ.clear();
+	m_radius.clear();
+	m_count = 0;
+}
+
+uint32 FrustumCuller::Add(BoundingBox const& box, BoundingSphere const& sphere)
+{
+	if (m_count == m_centerX.size())
+	{
+		// Padding boxes have a negative extent large enough to fail every plane.
+		size_t const	size = m_count + BATCH_SIZE;
+		m_centerX.resize(size, 0.0f);
+		m_centerY.resize(size, 0.0f);
+		m_centerZ.resize(size, 0.0f);
+		m_extentX.resize(size, -FLT_MAX);
+		m_extentY.resize(size, -FLT_MAX);
+		m_extentZ.resize(size, -FLT_MAX);
+		m_sphereX.resize(size, 0.0f);
+		m_sphereY.resize(size, 0.0f);
+		m_sphereZ.resize(size, 0.0f);
+		m_radius.resize(size, 0.0f);
+	}
+
+	uint32 const	index = m_count++;
+	Update(index, box, sphere);
+	return index;
+}
+
+void FrustumCuller::Update(uint32 index, BoundingBox const& box, BoundingSphere const& sphere)
+{
+	m_centerX[index] = box.Center.x;
+	m_centerY[index] = box.Center.y;
+	m_centerZ[index] = box.Center.z;
+	m_extentX[index] = box.Extents.x;
+	m_extentY[index] = box.Extents.y;
+	m_extentZ[index] = box.Extents.z;
+	m_sphereX[index] = sphere.Center.x;
+	m_sphereY[index] = sphere.Center.y;
+	m_sphereZ[index] = sphere.Center.z;
+	m_radius[index] = sphere.Radius;
+}
+
+void FrustumCuller::Cull(CXMMATRIX viewProjection, std::vector<uint32>& visible) const
+{
+	if (!m_count)
+		return;
+
+	XMFLOAT4	planes[PlaneCount];
+	ExtractPlanes(viewProjection, planes);
+
+	BoundsArrays	bounds;
+	bounds.centerX = m_centerX.data();
+	bounds.centerY = m_centerY.data();
+	bounds.centerZ = m_centerZ.data();
+	bounds.extentX = m_extentX.data();
+	bounds.extentY = m_extentY.data();
+	bounds.extentZ = m_extentZ.data();
+
+	CullBoxes(planes, bounds, m_count, visible);
+}
+
+uint32 FrustumCuller::GetCount() const
+{
+	return m_count;
+}
+
+XMFLOAT3 FrustumCuller::GetCenter(uint32 index) const
+{
+	return XMFLOAT3(m_centerX[index], m_centerY[index], m_centerZ[index]);
+}
+
+BoundingBox FrustumCuller::GetBox(uint32 index) const
+{
+	return BoundingBox(GetCenter(index), XMFLOAT3(m_extentX[index], m_extentY[index], m_extentZ[index]));
+}
+
+BoundingSphere FrustumCuller::GetSphere(uint32 index) const
+{
+	return BoundingSphere(XMFLOAT3(m_sphereX[index], m_sphereY[index], m_sphereZ[index]), m_radius[index]);
+}
\ No newline at end of file
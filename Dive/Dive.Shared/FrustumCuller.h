@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace Dive
+{
+	// World-space bounds of the scene draws, kept as a structure of arrays so the frustum test
+	// runs on 4 boxes per instruction (SSE2/NEON), or 8 with AVX. Spheres are stored alongside
+	// for distance and screen size estimates, the visibility test itself uses the boxes.
+	class FrustumCuller
+	{
+	public:
+		static int const	PlaneCount = 6;
+
+		// Frustum planes of a view projection that is not transposed, unnormalized and facing inwards.
+		static void	ExtractPlanes(DirectX::CXMMATRIX viewProjection, DirectX::XMFLOAT4 planes[PlaneCount]);
+
+		FrustumCuller();
+
+		void	Clear();
+		uint32	Add(DirectX::BoundingBox const& box, DirectX::BoundingSphere const& sphere);
+		void	Update(uint32 index, DirectX::BoundingBox const& box, DirectX::BoundingSphere const& sphere);
+
+		// Appends the index of every box touching the frustum. viewProjection uses the
+		// DirectXMath row-vector convention, i.e. it is not transposed for the shaders.
+		void	Cull(DirectX::CXMMATRIX viewProjection, std::vector<uint32>& visible) const;
+
+		uint32					GetCount() const;
+		DirectX::XMFLOAT3		GetCenter(uint32 index) const;
+		DirectX::BoundingBox	GetBox(uint32 index) const;
+		DirectX::BoundingSphere	GetSphere(uint32 index) const;
+
+	private:
+		// Every array is padded to a whole batch with boxes that never pass the test.
+		std::vector<float>	m_centerX;
+		std::vector<float>	m_centerY;
+		std::vector<float>	m_centerZ;
+		std::vector<float>	m_extentX;
+		std::vector<float>	m_extentY;
+		std::vector<float>	m_extentZ;
+		std::vector<float>	m_sphereX;
+		std::vector<float>	m_sphereY;
+		std::vector<float>	m_sphereZ;
+		std::vector<float>	m_radius;
+		uint32				m_count;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "Common/StepTimer.h"
+
+using namespace Dive;
+
+namespace
+{
+	double TicksToMilliseconds(uint64 begin, uint64 end, uint64 frequency)
+	{
+		return end > begin ? static_cast<double>(end - begin) * 1000.0 / static_cast<double>(frequency) : 0.0;
+	}
+}
+
+GpuProfiler::GpuProfiler(std::shared_ptr<RenderDevice> const& renderDevice) :
+m_renderDevice(renderDevice),
+m_created(false),
+m_frame(0),
+m_readFrame(0),
+m_inFrame(false),
+m_depth(0),
+m_frameMs(0.0),
+m_zoneCount(0),
+m_droppedFrames(0),
+m_track(0)
+{
+	CreateDeviceDependentResources();
+}
+
+// Zone queries are created the first time a zone is used.
+void GpuProfiler::CreateDeviceDependentResources()
+{
+	for (auto& frame : m_frames)
+	{
+		frame.Disjoint = m_renderDevice->CreateQuery(QUERY_TIMESTAMP_DISJOINT);
+		frame.Begin = m_renderDevice->CreateQuery(QUERY_TIMESTAMP);
+		frame.End = m_renderDevice->CreateQuery(QUERY_TIMESTAMP);
+		frame.ZoneCount = 0;
+		frame.CpuBegin = 0;
+	}
+	m_readFrame = m_frame;
+	m_created = true;
+}
+
+void GpuProfiler::ReleaseDeviceDependentResources()
+{
+	for (auto& frame : m_frames)
+	{
+		frame.Disjoint.reset();
+		frame.Begin.reset();
+		frame.End.reset();
+		for (auto& zone : frame.Zones)
+		{
+			zone.Begin.reset();
+			zone.End.reset();
+		}
+	}
+	m_created = false;
+	m_inFrame = false;
+}
+
+void GpuProfiler::BeginFrame()
+{
+	if (!m_created)
+		return;
+
+	while (m_readFrame < m_frame && ReadBack(m_frames[m_readFrame % FrameLatency]))
+		++m_readFrame;
+
+	// Reusing the queries of a frame still in flight discards its results.
+	if (m_frame - m_readFrame == FrameLatency)
+	{
+		++m_readFrame;
+		++m_droppedFrames;
+	}
+
+	Frame&	frame = m_frames[m_frame % FrameLatency];
+	frame.ZoneCount = 0;
+	frame.CpuBegin = DX::SystemStepClock::Get().GetCounter();
+	m_renderDevice->BeginQuery(frame.Disjoint.get());
+	m_renderDevice->EndQuery(frame.Begin.get());
+	m_inFrame = true;
+	m_depth = 0;
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!m_inFrame)
+		return;
+
+	Frame&	frame = m_frames[m_frame % FrameLatency];
+	m_renderDevice->EndQuery(frame.End.get());
+	m_renderDevice->EndQuery(frame.Disjoint.get());
+	m_inFrame = false;
+	++m_frame;
+}
+
+uint32 GpuProfiler::BeginZone(char const* name)
+{
+	Frame&	frame = m_frames[m_frame % FrameLatency];
+	if (!m_inFrame || frame.ZoneCount == MaxZones)
+		return NoZone;
+
+	Zone&	zone = frame.Zones[frame.ZoneCount];
+	if (!zone.Begin)
+	{
+		zone.Begin = m_renderDevice->CreateQuery(QUERY_TIMESTAMP);
+		zone.End = m_renderDevice->CreateQuery(QUERY_TIMESTAMP);
+	}
+	zone.Name = name;
+	zone.Depth = m_depth++;
+	m_renderDevice->EndQuery(zone.Begin.get());
+	return frame.ZoneCount++;
+}
+
+void GpuProfiler::EndZone(uint32 zone)
+{
+	if (zone == NoZone || !m_inFrame)
+		return;
+
+	--m_depth;
+	m_renderDevice->EndQuery(m_frames[m_frame % FrameLatency].Zones[zone].End.get());
+}
+
+bool GpuProfiler::ReadBack(Frame& frame)
+{
+	uint64	frequency;
+	bool	disjoint;
+	if (!m_renderDevice->GetTimestampFrequency(frame.Disjoint.get(), frequency, disjoint))
+		return false;
+
+	// The clock changed on the way, e.g. the GPU was throttled. The timestamps cannot be trusted.
+	if (disjoint || !frequency)
+	{
+		++m_droppedFrames;
+		return true;
+	}
+
+	uint64	begin;
+	uint64	end;
+	uint64	zoneBegins[MaxZones];
+	uint64	zoneEnds[MaxZones];
+	if (!m_renderDevice->GetTimestamp(frame.Begin.get(), begin) || !m_renderDevice->GetTimestamp(frame.End.get(), end))
+		return false;
+	for (uint32 i = 0; i < frame.ZoneCount; ++i)
+	{
+		if (!m_renderDevice->GetTimestamp(frame.Zones[i].Begin.get(), zoneBegins[i]) || !m_renderDevice->GetTimestamp(frame.Zones[i].End.get(), zoneEnds[i]))
+			return false;
+	}
+
+	m_frameMs = TicksToMilliseconds(begin, end, frequency);
+	m_zoneCount = frame.ZoneCount;
+	for (uint32 i = 0; i < frame.ZoneCount; ++i)
+	{
+		m_zoneTimes[i].Name = frame.Zones[i].Name;
+		m_zoneTimes[i].Depth = frame.Zones[i].Depth;
+		m_zoneTimes[i].Milliseconds = TicksToMilliseconds(zoneBegins[i], zoneEnds[i], frequency);
+	}
+
+	if (!Profiler::IsEnabled())
+		return true;
+
+	Profiler&	profiler = Profiler::Get();
+	if (!m_track)
+		m_track = profiler.CreateTrack("GPU");
+
+	// Both clocks run at a steady rate, only the offset between them is unknown.
+	double const	cpuTicksPerGpuTick = static_cast<double>(DX::SystemStepClock::Get().GetFrequency()) / static_cast<double>(frequency);
+	ProfileZone		zone;
+	zone.Name = "GPU frame";
+	zone.Begin = frame.CpuBegin;
+	zone.End = frame.CpuBegin + static_cast<uint64>(static_cast<double>(end > begin ? end - begin : 0) * cpuTicksPerGpuTick);
+	zone.Depth = 0;
+	profiler.AddZone(m_track, zone);
+
+	for (uint32 i = 0; i < frame.ZoneCount; ++i)
+	{
+		uint64 const	zoneBegin = zoneBegins[i] > begin ? zoneBegins[i] - begin : 0;
+		uint64 const	zoneEnd = zoneEnds[i] > zoneBegins[i] ? zoneEnds[i] - begin : zoneBegin;
+		zone.Name = frame.Zones[i].Name;
+		zone.Begin = frame.CpuBegin + static_cast<uint64>(static_cast<double>(zoneBegin) * cpuTicksPerGpuTick);
+		zone.End = frame.CpuBegin + static_cast<uint64>(static_cast<double>(zoneEnd) * cpuTicksPerGpuTick);
+		zone.Depth = frame.Zones[i].Depth + 1;
+		profiler.AddZone(m_track, zone);
+	}
+	return true;
+}
\ No newline at end of file
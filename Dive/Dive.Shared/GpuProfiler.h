@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+
+#include "RenderDevice.h"
+
+namespace Dive
+{
+	struct GpuZoneTime
+	{
+		char const*	Name;
+		// Zones open around it in the same frame.
+		uint32		Depth;
+		double		Milliseconds;
+	};
+
+	// Times named zones of every frame on the GPU with timestamp queries inside a disjoint query. Frames are read
+	// back up to FrameLatency frames later without waiting, one still in flight by then or whose timestamps were
+	// disjoint is dropped. The frames read back also go to the CPU profiler on a GPU track, starting at the CPU
+	// time they were submitted.
+	class GpuProfiler
+	{
+	public:
+		static uint32 const	FrameLatency = 4;
+		// Zones of a frame past this many are not timed.
+		static uint32 const	MaxZones = 16;
+
+		GpuProfiler(std::shared_ptr<RenderDevice> const& renderDevice);
+		void	CreateDeviceDependentResources();
+		void	ReleaseDeviceDependentResources();
+
+		// Brackets the zones of a frame, BeginFrame reads back the frames the GPU is done with.
+		void	BeginFrame();
+		void	EndFrame();
+		// Zones nest. name is kept as a pointer, a string literal.
+		uint32	BeginZone(char const* name);
+		void	EndZone(uint32 zone);
+
+		// Of the latest frame read back, nothing before the first one.
+		double				GetFrameTime() const			{ return m_frameMs; }
+		uint32				GetZoneCount() const			{ return m_zoneCount; }
+		GpuZoneTime const&	GetZone(uint32 index) const		{ return m_zoneTimes[index]; }
+		uint64				GetDroppedFrames() const		{ return m_droppedFrames; }
+
+	private:
+		struct Zone
+		{
+			char const*						Name;
+			uint32							Depth;
+			std::unique_ptr<RenderQuery>	Begin;
+			std::unique_ptr<RenderQuery>	End;
+		};
+
+		struct Frame
+		{
+			std::unique_ptr<RenderQuery>	Disjoint;
+			std::unique_ptr<RenderQuery>	Begin;
+			std::unique_ptr<RenderQuery>	End;
+			Zone							Zones[MaxZones];
+			uint32							ZoneCount;
+			uint64							CpuBegin;
+		};
+
+		static uint32 const	NoZone = uint32(-1);
+
+		GpuProfiler(GpuProfiler const&);
+		GpuProfiler&	operator=(GpuProfiler const&);
+
+		// False while the GPU has not finished the frame.
+		bool	ReadBack(Frame& frame);
+
+		std::shared_ptr<RenderDevice>	m_renderDevice;
+		bool							m_created;
+
+		Frame	m_frames[FrameLatency];
+		// Frames begun, the ones from m_readFrame on are in flight.
+		uint64	m_frame;
+		uint64	m_readFrame;
+		bool	m_inFrame;
+		uint32	m_depth;
+
+		double		m_frameMs;
+		GpuZoneTime	m_zoneTimes[MaxZones];
+		uint32		m_zoneCount;
+		uint64		m_droppedFrames;
+		// Profiler track, 0 until the first frame is read back.
+		uint32		m_track;
+	};
+
+	class GpuProfileScope
+	{
+	public:
+		GpuProfileScope(GpuProfiler& profiler, char const* name) : m_profiler(profiler), m_zone(profiler.BeginZone(name)) { }
+		~GpuProfileScope()		{ m_profiler.EndZone(m_zone); }
+
+	private:
+		GpuProfileScope(GpuProfileScope const&);
+		GpuProfileScope&	operator=(GpuProfileScope const&);
+
+		GpuProfiler&	m_profiler;
+		uint32			m_zone;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+using namespace Dive;
+
+namespace
+{
+	// Failed searches before a worker goes to sleep.
+	uint32 const	SPIN_COUNT = 64;
+	uint32 const	NOT_A_QUEUE = ~0u;
+
+	DIVE_THREAD_LOCAL JobSystem const*	s_owner = nullptr;
+	DIVE_THREAD_LOCAL uint32			s_queue = NOT_A_QUEUE;
+
+	struct FunctionJob : Job
+	{
+		std::function<void()>	Function;
+	};
+
+	void RunFunction(Job* job)
+	{
+		FunctionJob* const	functionJob = static_cast<FunctionJob*>(job);
+		functionJob->Function();
+		delete functionJob;
+	}
+}
+
+JobSystem::WorkQueue::WorkQueue() :
+m_top(0),
+m_bottom(0)
+{
+	for (uint32 i = 0; i < QueueCapacity; ++i)
+		m_jobs[i].store(nullptr, std::memory_order_relaxed);
+}
+
+bool JobSystem::WorkQueue::Push(Job* job)
+{
+	int64_t const	bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t const	top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= static_cast<int64_t>(QueueCapacity))
+		return false;
+
+	m_jobs[bottom & (QueueCapacity - 1)].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobSystem::WorkQueue::Pop()
+{
+	int64_t const	bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t	top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job*	job = m_jobs[bottom & (QueueCapacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job, a thief may be taking it at the same time.
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobSystem::WorkQueue::Steal()
+{
+	int64_t	top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t const	bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+
+	Job* const	job = m_jobs[top & (QueueCapacity - 1)].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem	s_jobSystem;
+	return s_jobSystem;
+}
+
+JobSystem::JobSystem(uint32 workerCount) :
+m_mainThread(std::this_thread::get_id()),
+m_sharedCount(0),
+m_workerJobCount(0),
+m_epoch(0),
+m_sleeping(0),
+m_quit(false)
+{
+	if (!workerCount)
+	{
+		uint32 const	hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (uint32 i = 0; i <= workerCount; ++i)
+		m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+
+	s_owner = this;
+	s_queue = 0;
+
+	for (uint32 i = 0; i < workerCount; ++i)
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i + 1));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex>	lock(m_sleepMutex);
+		m_quit.store(true);
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+
+	if (s_owner == this)
+	{
+		s_owner = nullptr;
+		s_queue = NOT_A_QUEUE;
+	}
+}
+
+void JobSystem::Run(std::function<void()> function, JobCounter* counter)
+{
+	Schedule(CreateJob(std::move(function), counter));
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter)
+{
+	Job* const	job = CreateJob(std::move(function), counter);
+	{
+		// Whoever brings the dependency to zero takes the waiting list under the same lock.
+		std::lock_guard<std::mutex>	lock(dependency.m_mutex);
+		if (!dependency.IsDone())
+		{
+			dependency.m_waiting.push_back(job);
+			return;
+		}
+	}
+	Schedule(job);
+}
+
+void JobSystem::RunOnMainThread(std::function<void()> function, JobCounter* counter)
+{
+	AddToMainThread(CreateJob(std::move(function), counter));
+}
+
+void JobSystem::Submit(Job& job)
+{
+	if (job.Counter)
+		job.Counter->m_value.fetch_add(1);
+	Schedule(&job);
+}
+
+void JobSystem::SubmitToMainThread(Job& job)
+{
+	if (job.Counter)
+		job.Counter->m_value.fetch_add(1);
+	AddToMainThread(&job);
+}
+
+void JobSystem::SubmitToWorker(Job& job)
+{
+	if (job.Counter)
+		job.Counter->m_value.fetch_add(1);
+	{
+		std::lock_guard<std::mutex>	lock(m_sharedMutex);
+		m_workerJobs.push_back(&job);
+		m_workerJobCount.fetch_add(1);
+	}
+	WakeWorker();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	uint32 const	queue = GetQueueIndex();
+	bool const		mainThread = IsMainThread();
+	while (!counter.IsDone())
+	{
+		if (mainThread)
+			RunMainThreadJobs();
+		if (!RunOneJob(queue))
+			std::this_thread::yield();
+	}
+
+	// The last job may still hold the lock, the counter cannot go away before it lets go.
+	std::lock_guard<std::mutex>	lock(counter.m_mutex);
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+	for (;;)
+	{
+		Job*	job;
+		{
+			std::lock_guard<std::mutex>	lock(m_mainMutex);
+			if (m_mainJobs.empty())
+				return;
+			job = m_mainJobs.front();
+			m_mainJobs.pop_front();
+		}
+		Execute(job);
+	}
+}
+
+Job* JobSystem::CreateJob(std::function<void()>&& function, JobCounter* counter)
+{
+	FunctionJob* const	job = new FunctionJob;
+	job->Entry = &RunFunction;
+	job->Function = std::move(function);
+	job->Counter = counter;
+	if (counter)
+		counter->m_value.fetch_add(1);
+	return job;
+}
+
+void JobSystem::AddToMainThread(Job* job)
+{
+	std::lock_guard<std::mutex>	lock(m_mainMutex);
+	m_mainJobs.push_back(job);
+}
+
+void JobSystem::Schedule(Job* job)
+{
+	uint32 const	queue = GetQueueIndex();
+	if (queue == NOT_A_QUEUE || !m_queues[queue]->Push(job))
+	{
+		std::lock_guard<std::mutex>	lock(m_sharedMutex);
+		m_sharedJobs.push_back(job);
+		m_sharedCount.fetch_add(1);
+	}
+	WakeWorker();
+}
+
+void JobSystem::WakeWorker()
+{
+	m_epoch.fetch_add(1);
+	if (m_sleeping.load())
+	{
+		{
+			std::lock_guard<std::mutex>	lock(m_sleepMutex);
+		}
+		m_wake.notify_one();
+	}
+}
+
+void JobSystem::Execute(Job* job)
+{
+	// The entry may free the job.
+	JobCounter* const	counter = job->Counter;
+	job->Entry(job);
+	if (!counter)
+		return;
+
+	// Jobs other than the last only count down. The last one decrements under the lock, so RunAfter cannot
+	// add to the waiting list once the counter is done and Wait cannot return before the list is taken.
+	uint32	value = counter->m_value.load(std::memory_order_relaxed);
+	while (value > 1)
+	{
+		if (counter->m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel))
+			return;
+	}
+
+	std::vector<Job*>	released;
+	{
+		std::lock_guard<std::mutex>	lock(counter->m_mutex);
+		if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		released.swap(counter->m_waiting);
+	}
+	for (auto releasedJob : released)
+		Schedule(releasedJob);
+}
+
+bool JobSystem::RunOneJob(uint32 queue)
+{
+	Job* const	job = FindJob(queue);
+	if (!job)
+		return false;
+	Execute(job);
+	return true;
+}
+
+Job* JobSystem::FindJob(uint32 queue)
+{
+	if (queue != NOT_A_QUEUE)
+	{
+		if (Job* const job = m_queues[queue]->Pop())
+			return job;
+	}
+
+	if (m_sharedCount.load())
+	{
+		std::lock_guard<std::mutex>	lock(m_sharedMutex);
+		if (!m_sharedJobs.empty())
+		{
+			Job* const	job = m_sharedJobs.front();
+			m_sharedJobs.pop_front();
+			m_sharedCount.fetch_sub(1);
+			return job;
+		}
+	}
+
+	if (queue != 0 && queue != NOT_A_QUEUE && m_workerJobCount.load())
+	{
+		std::lock_guard<std::mutex>	lock(m_sharedMutex);
+		if (!m_workerJobs.empty())
+		{
+			Job* const	job = m_workerJobs.front();
+			m_workerJobs.pop_front();
+			m_workerJobCount.fetch_sub(1);
+			return job;
+		}
+	}
+
+	// Start with the next queue so thieves spread over the victims.
+	uint32 const	queueCount = static_cast<uint32>(m_queues.size());
+	uint32 const	start = queue != NOT_A_QUEUE ? queue + 1 : 0;
+	for (uint32 i = 0; i < queueCount; ++i)
+	{
+		uint32 const	victim = (start + i) % queueCount;
+		if (victim == queue)
+			continue;
+		if (Job* const job = m_queues[victim]->Steal())
+			return job;
+	}
+	return nullptr;
+}
+
+void JobSystem::WorkerMain(uint32 queue)
+{
+	s_owner = this;
+	s_queue = queue;
+	DIVE_PROFILE_THREAD("Worker");
+
+	uint32	failures = 0;
+	while (!m_quit.load())
+	{
+		uint32 const	epoch = m_epoch.load();
+		if (RunOneJob(queue))
+		{
+			failures = 0;
+			continue;
+		}
+
+		if (++failures < SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Anything scheduled after the epoch was read changes it, so the wake-up cannot be missed.
+		std::unique_lock<std::mutex>	lock(m_sleepMutex);
+		m_sleeping.fetch_add(1);
+		m_wake.wait(lock, [&]() { return m_quit.load() || m_epoch.load() != epoch; });
+		m_sleeping.fetch_sub(1);
+		failures = 0;
+	}
+}
+
+uint32 JobSystem::GetQueueIndex() const
+{
+	return s_owner == this ? s_queue : NOT_A_QUEUE;
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Dive
+{
+	class JobCounter;
+
+	// Jobs made by Run own their function and free themselves. Jobs given to Submit belong to the caller,
+	// coroutine awaiters embed one so that resuming a coroutine allocates nothing.
+	struct Job
+	{
+		void		(*Entry)(Job* job);
+		JobCounter*	Counter;
+	};
+
+	// Number of jobs still to finish. A job run with a counter increments it when scheduled and
+	// decrements it when done, jobs run after a counter are held until it drops to zero. A counter with jobs
+	// in flight may only be destroyed once Wait returned.
+	class JobCounter
+	{
+	public:
+		JobCounter() : m_value(0) { }
+
+		bool	IsDone() const		{ return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		JobCounter(JobCounter const&);
+		JobCounter&	operator=(JobCounter const&);
+
+		std::atomic<uint32>	m_value;
+		std::mutex			m_mutex;
+		std::vector<Job*>	m_waiting;
+	};
+
+	// Work-stealing scheduler built on the standard library only. Every worker and the main thread own
+	// a lock-free deque (Chase-Lev): the owner pushes and pops at the bottom, idle threads steal the oldest
+	// job from the top. Jobs scheduled from other threads go through a shared queue. Threads waiting on a
+	// counter run jobs until it reaches zero, so jobs may wait on the jobs they spawn. Main-thread jobs only
+	// run from RunMainThreadJobs or while the main thread waits, worker jobs never run on the main thread.
+	// Jobs must not throw.
+	class JobSystem
+	{
+	public:
+		// Created on first use, the thread using it first is the main thread.
+		static JobSystem&	Get();
+
+		// 0 workers starts one per hardware thread besides the calling one.
+		explicit JobSystem(uint32 workerCount = 0);
+		~JobSystem();
+
+		void	Run(std::function<void()> function, JobCounter* counter = nullptr);
+		// function is scheduled once dependency reaches zero.
+		void	RunAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr);
+		void	RunOnMainThread(std::function<void()> function, JobCounter* counter = nullptr);
+		// job has to stay alive until its entry returns.
+		void	Submit(Job& job);
+		void	SubmitToMainThread(Job& job);
+		// Not even taken by the main thread while it waits, for work too long to run inside a frame.
+		void	SubmitToWorker(Job& job);
+		// Runs other jobs on the calling thread until counter reaches zero.
+		void	Wait(JobCounter& counter);
+		// Called once per frame from the main thread.
+		void	RunMainThreadJobs();
+
+		// Calls function(index) for every index in [begin, end), grainSize indices per job. Returns once all are done.
+		template <class Function>
+		void	ParallelFor(uint32 begin, uint32 end, uint32 grainSize, Function const& function);
+
+		uint32	GetWorkerCount() const		{ return static_cast<uint32>(m_workers.size()); }
+		bool	IsMainThread() const		{ return std::this_thread::get_id() == m_mainThread; }
+
+	private:
+		static uint32 const	QueueCapacity = 4096;
+
+		class WorkQueue
+		{
+		public:
+			WorkQueue();
+
+			// Owner only. False when full.
+			bool	Push(Job* job);
+			Job*	Pop();
+			// Any thread.
+			Job*	Steal();
+
+		private:
+			std::atomic<int64_t>	m_top;
+			std::atomic<int64_t>	m_bottom;
+			std::atomic<Job*>		m_jobs[QueueCapacity];
+		};
+
+		JobSystem(JobSystem const&);
+		JobSystem&	operator=(JobSystem const&);
+
+		Job*	CreateJob(std::function<void()>&& function, JobCounter* counter);
+		void	AddToMainThread(Job* job);
+		void	Schedule(Job* job);
+		void	WakeWorker();
+		void	Execute(Job* job);
+		// Runs one job, false when none was found.
+		bool	RunOneJob(uint32 queue);
+		Job*	FindJob(uint32 queue);
+		void	WorkerMain(uint32 queue);
+		uint32	GetQueueIndex() const;
+
+		std::vector<std::thread>				m_workers;
+		// Queue 0 belongs to the main thread, queue i + 1 to worker i.
+		std::vector<std::unique_ptr<WorkQueue>>	m_queues;
+		std::thread::id							m_mainThread;
+
+		std::mutex			m_sharedMutex;
+		std::deque<Job*>	m_sharedJobs;
+		// Lets idle threads skip the lock.
+		std::atomic<uint32>	m_sharedCount;
+		// Guarded by m_sharedMutex as well.
+		std::deque<Job*>	m_workerJobs;
+		std::atomic<uint32>	m_workerJobCount;
+		std::mutex			m_mainMutex;
+		std::deque<Job*>	m_mainJobs;
+
+		// Sleeping workers are woken whenever the epoch changes.
+		std::mutex					m_sleepMutex;
+		std::condition_variable		m_wake;
+		std::atomic<uint32>			m_epoch;
+		std::atomic<uint32>			m_sleeping;
+		std::atomic<bool>			m_quit;
+	};
+
+	template <class Function>
+	void JobSystem::ParallelFor(uint32 begin, uint32 end, uint32 grainSize, Function const& function)
+	{
+		if (begin >= end)
+			return;
+		if (!grainSize)
+			grainSize = 1;
+
+		// The first chunk runs on the calling thread while the others are stolen.
+		uint32 const	chunkCount = (end - begin - 1) / grainSize + 1;
+		JobCounter		counter;
+		for (uint32 chunk = 1; chunk < chunkCount; ++chunk)
+		{
+			uint32 const	first = begin + chunk * grainSize;
+			uint32 const	last = end - first > grainSize ? first + grainSize : end;
+			Run([&function, first, last]()
+			{
+				for (uint32 index = first; index < last; ++index)
+					function(index);
+			}, &counter);
+		}
+
+		uint32 const	last = end - begin > grainSize ? begin + grainSize : end;
+		for (uint32 index = begin; index < last; ++index)
+			function(index);
+
+		Wait(counter);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "MaterialTable.h"
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	uint32 const	MATERIAL_SLOT = 1;
+}
+
+MaterialTable::MaterialTable(std::shared_ptr<RenderDevice> const& renderDevice) :
+m_renderDevice(renderDevice),
+m_maxMaterials(renderDevice->SupportsShaderModel4() ? MaxMaterials : MaxMaterialsLevel9)
+{
+	MaterialConstants	defaultMaterial;
+	ZeroMemory(&defaultMaterial, sizeof(MaterialConstants));
+	defaultMaterial.Emissive.w = 1.0f;
+	defaultMaterial.Ambient.w = 1.0f;
+	defaultMaterial.Diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	defaultMaterial.Specular.w = 1.0f;
+	Add(defaultMaterial);
+}
+
+uint32 MaterialTable::Add(MaterialConstants const& material)
+{
+	MaterialConstants	key = material;
+	key.Padding = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	size_t const	hash = Hash(key);
+	auto const		range = m_materialIndices.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (!memcmp(&m_materials[it->second], &key, sizeof(MaterialConstants)))
+			return it->second;
+	}
+
+	if (m_materials.size() >= m_maxMaterials)
+	{
+		_RPT1(0, "Material table is full (%u entries), using the default material\n", m_maxMaterials);
+		return DefaultMaterial;
+	}
+
+	uint32 const	index = static_cast<uint32>(m_materials.size());
+	m_materials.push_back(key);
+	m_materialIndices.insert(std::make_pair(hash, index));
+
+	// The table changed, it is uploaded again on the next CreateDeviceDependentResources.
+	m_constantBuffer.reset();
+
+	return index;
+}
+
+void MaterialTable::CreateDeviceDependentResources()
+{
+	std::vector<MaterialConstants>	data(m_maxMaterials);
+	memcpy(data.data(), m_materials.data(), m_materials.size() * sizeof(MaterialConstants));
+
+	m_constantBuffer = m_renderDevice->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_IMMUTABLE, m_maxMaterials * sizeof(MaterialConstants), data.data());
+}
+
+void MaterialTable::ReleaseDeviceDependentResources()
+{
+	m_constantBuffer.reset();
+}
+
+void MaterialTable::Bind() const
+{
+	m_renderDevice->SetVertexConstantBuffer(MATERIAL_SLOT, m_constantBuffer.get());
+}
+
+uint32 MaterialTable::GetMaterialCount() const
+{
+	return static_cast<uint32>(m_materials.size());
+}
+
+// FNV-1a over the raw parameter block, padding is zeroed by Add.
+size_t MaterialTable::Hash(MaterialConstants const& material)
+{
+	uint8 const*	bytes = reinterpret_cast<uint8 const*>(&material);
+	uint32			hash = 2166136261u;
+	for (size_t i = 0; i < sizeof(MaterialConstants); ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
\ No newline at end of file
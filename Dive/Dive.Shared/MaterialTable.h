@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "ShaderStructures.h"
+
+namespace Dive
+{
+	// Every unique material parameter block of a scene, packed into a single constant buffer
+	// that is uploaded once at load time. Identical blocks are shared, draws only carry the
+	// index of their entry (ModelViewProjectionConstantBuffer::MaterialIndex).
+	class MaterialTable
+	{
+	public:
+		// Must match MAX_MATERIALS in SampleVertexShader10.hlsl and SampleShaderConstants.hlsli, level 9
+		// shaders only have room for the smaller table.
+		static uint32 const	MaxMaterials = 256;
+		static uint32 const	MaxMaterialsLevel9 = 32;
+		static uint32 const	DefaultMaterial = 0;
+
+		MaterialTable(std::shared_ptr<RenderDevice> const& renderDevice);
+
+		uint32	Add(MaterialConstants const& material);
+		void	CreateDeviceDependentResources();
+		void	ReleaseDeviceDependentResources();
+		void	Bind() const;
+
+		uint32	GetMaterialCount() const;
+
+	private:
+		static size_t	Hash(MaterialConstants const& material);
+
+		std::shared_ptr<RenderDevice>	m_renderDevice;
+		uint32							m_maxMaterials;
+
+		std::vector<MaterialConstants>				m_materials;
+		std::unordered_multimap<size_t, uint32>		m_materialIndices;
+		std::unique_ptr<RenderBuffer>				m_constantBuffer;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "MemoryTracker.h"
+
+using namespace Dive;
+
+namespace
+{
+	wchar_t const* const	CATEGORY_NAMES[MEMORY_CATEGORY_COUNT] = { L"Mesh", L"Texture", L"Animation", L"FBX SDK", L"Scratch", L"Other" };
+	char const* const		HEAP_NAMES[MEMORY_HEAP_COUNT] = { "CPU", "GPU" };
+
+	double ToMegabytes(int64 bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+}
+
+MemoryTracker							MemoryTracker::s_tracker;
+DIVE_THREAD_LOCAL MemoryCategory		MemoryTracker::s_scopeCategory = MEMORY_OTHER;
+
+MemoryTracker& MemoryTracker::Get()
+{
+	return s_tracker;
+}
+
+wchar_t const* MemoryTracker::GetName(MemoryCategory category)
+{
+	return CATEGORY_NAMES[category];
+}
+
+void MemoryTracker::Allocate(MemoryCategory category, MemoryHeap heap, uint64 bytes)
+{
+	Counter&		counter = m_counters[category][heap];
+	int64 const		size = static_cast<int64>(bytes);
+	int64 const		inUse = counter.Bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+	int64	peak = counter.Peak.load(std::memory_order_relaxed);
+	while (inUse > peak && !counter.Peak.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+	{
+	}
+
+	int64 const	budget = counter.Budget.load(std::memory_order_relaxed);
+	if (budget && inUse > budget && !counter.OverBudget.exchange(true, std::memory_order_relaxed))
+		WarnOverBudget(category, heap, inUse, budget);
+}
+
+void MemoryTracker::Free(MemoryCategory category, MemoryHeap heap, uint64 bytes)
+{
+	Counter&		counter = m_counters[category][heap];
+	int64 const		size = static_cast<int64>(bytes);
+	int64 const		inUse = counter.Bytes.fetch_sub(size, std::memory_order_relaxed) - size;
+
+	if (counter.OverBudget.load(std::memory_order_relaxed) && inUse <= counter.Budget.load(std::memory_order_relaxed))
+		counter.OverBudget.store(false, std::memory_order_relaxed);
+}
+
+uint64 MemoryTracker::GetBytes(MemoryCategory category, MemoryHeap heap) const
+{
+	int64 const	bytes = m_counters[category][heap].Bytes.load(std::memory_order_relaxed);
+	return bytes > 0 ? static_cast<uint64>(bytes) : 0;
+}
+
+uint64 MemoryTracker::GetPeakBytes(MemoryCategory category, MemoryHeap heap) const
+{
+	return static_cast<uint64>(m_counters[category][heap].Peak.load(std::memory_order_relaxed));
+}
+
+void MemoryTracker::ResetPeaks()
+{
+	for (auto& heaps : m_counters)
+	{
+		for (auto& counter : heaps)
+		{
+			int64 const	bytes = counter.Bytes.load(std::memory_order_relaxed);
+			counter.Peak.store(bytes > 0 ? bytes : 0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void MemoryTracker::SetBudget(MemoryCategory category, MemoryHeap heap, uint64 bytes)
+{
+	Counter&		counter = m_counters[category][heap];
+	int64 const		budget = static_cast<int64>(bytes);
+	counter.Budget.store(budget, std::memory_order_relaxed);
+
+	int64 const	inUse = counter.Bytes.load(std::memory_order_relaxed);
+	bool const	overBudget = budget && inUse > budget;
+	if (counter.OverBudget.exchange(overBudget, std::memory_order_relaxed) != overBudget && overBudget)
+		WarnOverBudget(category, heap, inUse, budget);
+}
+
+uint64 MemoryTracker::GetBudget(MemoryCategory category, MemoryHeap heap) const
+{
+	return static_cast<uint64>(m_counters[category][heap].Budget.load(std::memory_order_relaxed));
+}
+
+bool MemoryTracker::IsOverBudget(MemoryCategory category, MemoryHeap heap) const
+{
+	return m_counters[category][heap].OverBudget.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::WarnOverBudget(MemoryCategory category, MemoryHeap heap, int64 bytes, int64 budget) const
+{
+	_RPT4(0, "Warning: %ls %s memory over budget, %.1f of %.1f MB\n", CATEGORY_NAMES[category], HEAP_NAMES[heap], ToMegabytes(bytes), ToMegabytes(budget));
+}
+
+MemoryAllocation::MemoryAllocation(MemoryCategory category, MemoryHeap heap, uint64 bytes) :
+m_category(category),
+m_heap(heap),
+m_bytes(bytes)
+{
+	if (m_bytes)
+		MemoryTracker::Get().Allocate(m_category, m_heap, m_bytes);
+}
+
+MemoryAllocation::~MemoryAllocation()
+{
+	if (m_bytes)
+		MemoryTracker::Get().Free(m_category, m_heap, m_bytes);
+}
+
+void MemoryAllocation::SetBytes(uint64 bytes)
+{
+	MemoryTracker&	tracker = MemoryTracker::Get();
+	if (bytes > m_bytes)
+		tracker.Allocate(m_category, m_heap, bytes - m_bytes);
+	else if (bytes < m_bytes)
+		tracker.Free(m_category, m_heap, m_bytes - bytes);
+	m_bytes = bytes;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+
+namespace Dive
+{
+	enum MemoryCategory
+	{
+		MEMORY_MESH,
+		MEMORY_TEXTURE,
+		MEMORY_ANIMATION,
+		MEMORY_FBX_SDK,
+		// Buffers that only live while something is being built.
+		MEMORY_SCRATCH,
+		// Buffers created outside of any MemoryScope, like the constant and instance buffers.
+		MEMORY_OTHER,
+		MEMORY_CATEGORY_COUNT
+	};
+
+	enum MemoryHeap
+	{
+		MEMORY_CPU,
+		MEMORY_GPU,
+		MEMORY_HEAP_COUNT
+	};
+
+	// Bytes in use by category and heap, with their high-water marks and optional budgets. Counting is a relaxed
+	// atomic add per allocation, cheap enough to stay on in release builds. Going over a budget warns once, and
+	// again after the category went back under it.
+	class MemoryTracker
+	{
+	public:
+		static MemoryTracker&	Get();
+		static wchar_t const*	GetName(MemoryCategory category);
+		// Category of the GPU buffers created on the calling thread, MEMORY_OTHER outside of a MemoryScope.
+		static MemoryCategory	GetScopeCategory()		{ return s_scopeCategory; }
+
+		void	Allocate(MemoryCategory category, MemoryHeap heap, uint64 bytes);
+		void	Free(MemoryCategory category, MemoryHeap heap, uint64 bytes);
+
+		uint64	GetBytes(MemoryCategory category, MemoryHeap heap) const;
+		uint64	GetPeakBytes(MemoryCategory category, MemoryHeap heap) const;
+		// Peaks start over from what is in use now.
+		void	ResetPeaks();
+
+		// 0 leaves the category without budget, which is the default.
+		void	SetBudget(MemoryCategory category, MemoryHeap heap, uint64 bytes);
+		uint64	GetBudget(MemoryCategory category, MemoryHeap heap) const;
+		bool	IsOverBudget(MemoryCategory category, MemoryHeap heap) const;
+
+	private:
+		friend class MemoryScope;
+
+		// Signed, memory handed out before the tracker could see it may be freed through it.
+		struct Counter
+		{
+			std::atomic<int64>	Bytes;
+			std::atomic<int64>	Peak;
+			std::atomic<int64>	Budget;
+			std::atomic<bool>	OverBudget;
+		};
+
+		// Leaves the counters to the zero initialization of static storage, allocations made by other static
+		// constructors may already have counted.
+		MemoryTracker()		{ }
+		MemoryTracker(MemoryTracker const&);
+		MemoryTracker&	operator=(MemoryTracker const&);
+
+		void	WarnOverBudget(MemoryCategory category, MemoryHeap heap, int64 bytes, int64 budget) const;
+
+		static MemoryTracker							s_tracker;
+		static DIVE_THREAD_LOCAL MemoryCategory			s_scopeCategory;
+
+		Counter	m_counters[MEMORY_CATEGORY_COUNT][MEMORY_HEAP_COUNT];
+	};
+
+	// Tags the GPU buffers created on this thread with category while it lives. Texture views are always textures.
+	class MemoryScope
+	{
+	public:
+		explicit MemoryScope(MemoryCategory category) : m_previous(MemoryTracker::s_scopeCategory)	{ MemoryTracker::s_scopeCategory = category; }
+		~MemoryScope()																				{ MemoryTracker::s_scopeCategory = m_previous; }
+
+	private:
+		MemoryScope(MemoryScope const&);
+		MemoryScope&	operator=(MemoryScope const&);
+
+		MemoryCategory	m_previous;
+	};
+
+	// Bytes held by its owner, counted until it is destroyed.
+	class MemoryAllocation
+	{
+	public:
+		MemoryAllocation(MemoryCategory category, MemoryHeap heap, uint64 bytes = 0);
+		~MemoryAllocation();
+
+		void	SetBytes(uint64 bytes);
+		void	AddBytes(uint64 bytes)		{ SetBytes(m_bytes + bytes); }
+		uint64	GetBytes() const			{ return m_bytes; }
+
+	private:
+		MemoryAllocation(MemoryAllocation const&);
+		MemoryAllocation&	operator=(MemoryAllocation const&);
+
+		MemoryCategory	m_category;
+		MemoryHeap		m_heap;
+		uint64			m_bytes;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "MeshClusters.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	uint32 const	INVALID_TRIANGLE = uint32(-1);
+	// Cones wider than this, as the cosine between the axis and the farthest normal, are never culled.
+	float const		MIN_CONE_SPREAD = 0.1f;
+
+	XMVECTOR LoadPosition(VertexPositionColorNormalUV const* vertices, uint32 index)
+	{
+		return XMLoadFloat3(&vertices[index].Pos);
+	}
+
+	void ComputeBounds(MeshCluster& cluster, uint32 const* indices, std::vector<uint32> const& clusterVertices, VertexPositionColorNormalUV const* vertices)
+	{
+		XMVECTOR	minimum = g_XMFltMax;
+		XMVECTOR	maximum = XMVectorNegate(g_XMFltMax);
+		for (auto vertex : clusterVertices)
+		{
+			minimum = XMVectorMin(minimum, LoadPosition(vertices, vertex));
+			maximum = XMVectorMax(maximum, LoadPosition(vertices, vertex));
+		}
+
+		XMVECTOR const	center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+		XMVECTOR		radius = XMVectorZero();
+		for (auto vertex : clusterVertices)
+			radius = XMVectorMax(radius, XMVector3LengthSq(XMVectorSubtract(LoadPosition(vertices, vertex), center)));
+		XMStoreFloat3(&cluster.Center, center);
+		cluster.Radius = sqrtf(XMVectorGetX(radius));
+
+		// Clockwise front faces, so (c - a) x (b - a) points out of the surface.
+		XMVECTOR	normals[MaxClusterTriangles];
+		uint32		normalCount = 0;
+		XMVECTOR	axis = XMVectorZero();
+		for (auto i = cluster.IndexOffset; i < cluster.IndexOffset + cluster.IndexCount; i += 3)
+		{
+			XMVECTOR const	a = LoadPosition(vertices, indices[i]);
+			XMVECTOR const	normal = XMVector3Cross(XMVectorSubtract(LoadPosition(vertices, indices[i + 2]), a), XMVectorSubtract(LoadPosition(vertices, indices[i + 1]), a));
+			if (XMVector3Equal(normal, XMVectorZero()))
+				continue;
+			normals[normalCount] = XMVector3Normalize(normal);
+			axis = XMVectorAdd(axis, normals[normalCount++]);
+		}
+
+		cluster.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		cluster.ConeCutoff = 1.0f;
+		if (!normalCount || XMVector3Equal(axis, XMVectorZero()))
+			return;
+
+		axis = XMVector3Normalize(axis);
+		float	spread = 1.0f;
+		for (uint32 i = 0; i < normalCount; ++i)
+		{
+			float const	cosine = XMVectorGetX(XMVector3Dot(axis, normals[i]));
+			spread = cosine < spread ? cosine : spread;
+		}
+		if (spread <= MIN_CONE_SPREAD)
+			return;
+
+		XMStoreFloat3(&cluster.ConeAxis, axis);
+		cluster.ConeCutoff = sqrtf(1.0f - spread * spread);
+	}
+}
+
+// Each cluster starts from the first triangle left and keeps taking the neighbouring triangle that adds the
+// fewest vertices, the one closest to the cluster's centre among equals, until a limit is reached.
+void Dive::BuildMeshClusters(uint32 const* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices, uint32 vertexCount,
+							 std::vector<MeshCluster>& clusters, std::vector<uint32>& clusterIndices)
+{
+	uint32 const	triangleCount = indexCount / 3;
+
+	std::vector<uint32>	offsets(vertexCount + 1);
+	for (uint32 i = 0; i < triangleCount * 3; ++i)
+		++offsets[indices[i] + 1];
+	for (uint32 i = 0; i < vertexCount; ++i)
+		offsets[i + 1] += offsets[i];
+	std::vector<uint32>	adjacency(triangleCount * 3);
+	std::vector<uint32>	fill(offsets.begin(), offsets.end() - 1);
+	for (uint32 i = 0; i < triangleCount * 3; ++i)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<XMFLOAT3>	centers(triangleCount);
+	for (uint32 i = 0; i < triangleCount; ++i)
+	{
+		XMVECTOR const	sum = XMVectorAdd(XMVectorAdd(LoadPosition(vertices, indices[i * 3]), LoadPosition(vertices, indices[i * 3 + 1])), LoadPosition(vertices, indices[i * 3 + 2]));
+		XMStoreFloat3(&centers[i], XMVectorScale(sum, 1.0f / 3.0f));
+	}
+
+	std::vector<uint8>	emitted(triangleCount);
+	std::vector<uint8>	used(vertexCount);
+	std::vector<uint32>	clusterVertices;
+	std::vector<uint32>	candidates;
+	clusterVertices.reserve(MaxClusterVertices);
+
+	uint32	seed = 0;
+	for (;;)
+	{
+		while (seed < triangleCount && emitted[seed])
+			++seed;
+		if (seed == triangleCount)
+			break;
+
+		MeshCluster	cluster;
+		cluster.IndexOffset = static_cast<uint32>(clusterIndices.size());
+		cluster.IndexCount = 0;
+		clusterVertices.clear();
+		candidates.clear();
+
+		XMVECTOR	centerSum = XMVectorZero();
+		uint32		triangle = seed;
+		while (triangle != INVALID_TRIANGLE)
+		{
+			emitted[triangle] = 1;
+			for (uint32 corner = 0; corner < 3; ++corner)
+			{
+				uint32 const	vertex = indices[triangle * 3 + corner];
+				clusterIndices.push_back(vertex);
+				if (used[vertex])
+					continue;
+
+				used[vertex] = 1;
+				clusterVertices.push_back(vertex);
+				for (auto i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+				{
+					if (!emitted[adjacency[i]])
+						candidates.push_back(adjacency[i]);
+				}
+			}
+			cluster.IndexCount += 3;
+			centerSum = XMVectorAdd(centerSum, XMLoadFloat3(&centers[triangle]));
+			if (cluster.IndexCount == MaxClusterTriangles * 3)
+				break;
+
+			XMFLOAT3	center;
+			XMStoreFloat3(&center, XMVectorScale(centerSum, 3.0f / cluster.IndexCount));
+			uint32	bestNewVertices = 3;
+			float	bestDistance = FLT_MAX;
+			triangle = INVALID_TRIANGLE;
+			for (size_t i = 0; i < candidates.size();)
+			{
+				uint32 const	candidate = candidates[i];
+				if (emitted[candidate])
+				{
+					candidates[i] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+				++i;
+
+				uint32 const	newVertices = !used[indices[candidate * 3]] + !used[indices[candidate * 3 + 1]] + !used[indices[candidate * 3 + 2]];
+				if (clusterVertices.size() + newVertices > MaxClusterVertices || newVertices > bestNewVertices)
+					continue;
+
+				float const	x = centers[candidate].x - center.x;
+				float const	y = centers[candidate].y - center.y;
+				float const	z = centers[candidate].z - center.z;
+				float const	distance = x * x + y * y + z * z;
+				if (newVertices < bestNewVertices || distance < bestDistance)
+				{
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+					triangle = candidate;
+				}
+			}
+		}
+
+		ComputeBounds(cluster, clusterIndices.data(), clusterVertices, vertices);
+		clusters.push_back(cluster);
+		for (auto vertex : clusterVertices)
+			used[vertex] = 0;
+	}
+}
+
+void ClusterCuller::SetView(CXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
+{
+	// Planes of the whole transform are the frustum in mesh space.
+	FrustumCuller::ExtractPlanes(XMMatrixMultiply(XMMatrixMultiply(world, view), projection), m_planes);
+	for (auto& plane : m_planes)
+		XMStoreFloat4(&plane, XMPlaneNormalize(XMLoadFloat4(&plane)));
+
+	XMMATRIX const	worldView = XMMatrixMultiply(world, view);
+	XMStoreFloat3(&m_eye, XMMatrixInverse(nullptr, worldView).r[3]);
+}
+
+uint32 ClusterCuller::Cull(MeshCluster const* clusters, uint32 clusterCount, uint32 const* clusterIndices, uint32* destination)
+{
+	uint32	indexCount = 0;
+	for (uint32 i = 0; i < clusterCount; ++i)
+	{
+		MeshCluster const&	cluster = clusters[i];
+		++m_stats.Clusters;
+
+		bool	inside = true;
+		for (auto const& plane : m_planes)
+		{
+			if (plane.x * cluster.Center.x + plane.y * cluster.Center.y + plane.z * cluster.Center.z + plane.w < -cluster.Radius)
+			{
+				inside = false;
+				break;
+			}
+		}
+		if (!inside)
+		{
+			++m_stats.FrustumCulled;
+			continue;
+		}
+
+		float const	x = cluster.Center.x - m_eye.x;
+		float const	y = cluster.Center.y - m_eye.y;
+		float const	z = cluster.Center.z - m_eye.z;
+		if (x * cluster.ConeAxis.x + y * cluster.ConeAxis.y + z * cluster.ConeAxis.z >= cluster.ConeCutoff * sqrtf(x * x + y * y + z * z) + cluster.Radius)
+		{
+			++m_stats.BackfaceCulled;
+			continue;
+		}
+
+		memcpy(destination + indexCount, clusterIndices + cluster.IndexOffset, cluster.IndexCount * sizeof(uint32));
+		indexCount += cluster.IndexCount;
+	}
+	return indexCount;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "FrustumCuller.h"
+#include "ShaderStructures.h"
+
+namespace Dive
+{
+	uint32 const	MaxClusterVertices = 64;
+	uint32 const	MaxClusterTriangles = 124;
+
+	// Bounds of a run of at most MaxClusterTriangles triangles over at most MaxClusterVertices vertices.
+	// The normal cone holds the outward normal of every triangle, all of them face away from an eye with
+	// dot(Center - eye, ConeAxis) >= ConeCutoff * length(Center - eye) + Radius.
+	struct MeshCluster
+	{
+		DirectX::XMFLOAT3	Center;
+		float				Radius;
+		DirectX::XMFLOAT3	ConeAxis;
+		float				ConeCutoff;
+		uint32				IndexOffset;
+		uint32				IndexCount;
+	};
+
+	// Splits an indexed triangle list into clusters grown greedily over shared vertices and appends them,
+	// along with their triangles' indices in cluster order. Triangles wind clockwise seen from the front,
+	// as the default rasterizer state expects. Indices need welding first or no two triangles connect.
+	void	BuildMeshClusters(uint32 const* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices, uint32 vertexCount,
+						  std::vector<MeshCluster>& clusters, std::vector<uint32>& clusterIndices);
+
+	// Tests the clusters of one mesh against the frustum and their normal cones, in mesh space,
+	// and copies the indices of the clusters left over into a per-frame index buffer.
+	class ClusterCuller
+	{
+	public:
+		struct Stats
+		{
+			Stats() : Clusters(0), FrustumCulled(0), BackfaceCulled(0) { }
+
+			uint32	Clusters;
+			uint32	FrustumCulled;
+			uint32	BackfaceCulled;
+		};
+
+		// None of the matrices is transposed.
+		void	SetView(DirectX::CXMMATRIX world, DirectX::CXMMATRIX view, DirectX::CXMMATRIX projection);
+		// Writes the indices of the visible clusters to destination and returns how many there are.
+		uint32	Cull(MeshCluster const* clusters, uint32 clusterCount, uint32 const* clusterIndices, uint32* destination);
+
+		Stats const&	GetStats() const	{ return m_stats; }
+		void			ResetStats()		{ m_stats = Stats(); }
+
+	private:
+		// Normalized, so spheres are tested against true distances.
+		DirectX::XMFLOAT4	m_planes[FrustumCuller::PlaneCount];
+		DirectX::XMFLOAT3	m_eye;
+		Stats				m_stats;
+	};
+}
\ No newline at end of file
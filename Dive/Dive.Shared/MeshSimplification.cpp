@@ -0,0 +1,495 @@
+#include "pch.h"
+#include "MeshSimplification.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	uint32 const	INVALID_VERTEX = uint32(-1);
+	// Border planes outweigh the triangles' own so borders do not get eaten into from the side.
+	float const		BORDER_WEIGHT = 10.0f;
+	float const		MIN_NORMAL_COSINE = 0.25f;
+
+	uint8 const	KIND_MANIFOLD = 0;
+	uint8 const	KIND_BORDER = 1;
+	uint8 const	KIND_LOCKED = 2;
+
+	struct Quadric
+	{
+		float	A00, A11, A22;
+		float	A01, A02, A12;
+		float	B0, B1, B2;
+		float	C;
+		float	Weight;
+	};
+
+	struct Collapse
+	{
+		uint32	From;
+		uint32	To;
+		float	Error;
+	};
+
+	// Hashes and compares vertices on their first Size bytes, the position comes first in the vertex.
+	template <size_t Size>
+	struct VertexKey
+	{
+		explicit VertexKey(VertexPositionColorNormalUV const* vertices) : Vertices(vertices) { }
+
+		size_t operator()(uint32 index) const
+		{
+			uint32	words[Size / sizeof(uint32)];
+			memcpy(words, &Vertices[index], Size);
+
+			uint32	hash = 2166136261u;
+			for (auto word : words)
+				hash = (hash ^ word) * 16777619u;
+			return hash;
+		}
+
+		bool operator()(uint32 left, uint32 right) const
+		{
+			return !memcmp(&Vertices[left], &Vertices[right], Size);
+		}
+
+		VertexPositionColorNormalUV const*	Vertices;
+	};
+
+	XMFLOAT3 Subtract(XMFLOAT3 const& a, XMFLOAT3 const& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	XMFLOAT3 Cross(XMFLOAT3 const& a, XMFLOAT3 const& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	float Dot(XMFLOAT3 const& a, XMFLOAT3 const& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	void AddPlane(Quadric& quadric, XMFLOAT3 const& normal, float distance, float weight)
+	{
+		quadric.A00 += weight * normal.x * normal.x;
+		quadric.A11 += weight * normal.y * normal.y;
+		quadric.A22 += weight * normal.z * normal.z;
+		quadric.A01 += weight * normal.x * normal.y;
+		quadric.A02 += weight * normal.x * normal.z;
+		quadric.A12 += weight * normal.y * normal.z;
+		quadric.B0 += weight * normal.x * distance;
+		quadric.B1 += weight * normal.y * distance;
+		quadric.B2 += weight * normal.z * distance;
+		quadric.C += weight * distance * distance;
+		quadric.Weight += weight;
+	}
+
+	void AddQuadric(Quadric& quadric, Quadric const& other)
+	{
+		quadric.A00 += other.A00;
+		quadric.A11 += other.A11;
+		quadric.A22 += other.A22;
+		quadric.A01 += other.A01;
+		quadric.A02 += other.A02;
+		quadric.A12 += other.A12;
+		quadric.B0 += other.B0;
+		quadric.B1 += other.B1;
+		quadric.B2 += other.B2;
+		quadric.C += other.C;
+		quadric.Weight += other.Weight;
+	}
+
+	// Weighted mean of the squared distances from position to the quadric's planes.
+	float Evaluate(Quadric const& quadric, XMFLOAT3 const& position)
+	{
+		float const	x = quadric.A00 * position.x + quadric.A01 * position.y + quadric.A02 * position.z;
+		float const	y = quadric.A01 * position.x + quadric.A11 * position.y + quadric.A12 * position.z;
+		float const	z = quadric.A02 * position.x + quadric.A12 * position.y + quadric.A22 * position.z;
+		float const	error = x * position.x + y * position.y + z * position.z +
+							2.0f * (quadric.B0 * position.x + quadric.B1 * position.y + quadric.B2 * position.z) + quadric.C;
+		return quadric.Weight > 0.0f ? fabsf(error) / quadric.Weight : 0.0f;
+	}
+
+	class Simplifier
+	{
+	public:
+		Simplifier(VertexPositionColorNormalUV const* vertices, uint32 vertexCount);
+
+		void	Initialize(uint32 const* indices, uint32 indexCount);
+		float	Simplify(uint32 targetIndexCount, float errorLimit);
+
+		std::vector<uint32> const&	GetTriangles() const	{ return m_triangles; }
+
+	private:
+		void	BuildAdjacency();
+		uint32	CountShared(uint32 from, uint32 to) const;
+		void	Classify();
+		bool	CanCollapse(uint32 from, uint32 to, uint32& shared);
+		void	AddCollapse(uint32 from, uint32 to, float errorLimit);
+
+		VertexPositionColorNormalUV const*	m_vertices;
+		uint32								m_vertexCount;
+
+		// Wedges are welded vertices, points welded positions, both named after their first vertex.
+		// m_triangles holds wedges, m_points maps a wedge to its point.
+		std::vector<uint32>		m_wedges;
+		std::vector<uint32>		m_points;
+		std::vector<XMFLOAT3>	m_positions;
+		std::vector<uint32>		m_triangles;
+		std::vector<Quadric>	m_quadrics;
+		std::vector<uint8>		m_kinds;
+		std::vector<uint32>		m_remap;
+
+		// Triangles around every point.
+		std::vector<uint32>		m_adjacencyOffsets;
+		std::vector<uint32>		m_adjacency;
+
+		std::vector<Collapse>						m_collapses;
+		std::vector<uint8>							m_touched;
+		std::vector<std::pair<uint32, uint32>>		m_wedgeMap;
+	};
+
+	Simplifier::Simplifier(VertexPositionColorNormalUV const* vertices, uint32 vertexCount) :
+	m_vertices(vertices),
+	m_vertexCount(vertexCount),
+	m_wedges(vertexCount, INVALID_VERTEX),
+	m_points(vertexCount, INVALID_VERTEX),
+	m_positions(vertexCount),
+	m_quadrics(vertexCount),
+	m_kinds(vertexCount, KIND_MANIFOLD),
+	m_remap(vertexCount),
+	m_touched(vertexCount)
+	{
+	}
+
+	void Simplifier::Initialize(uint32 const* indices, uint32 indexCount)
+	{
+		typedef VertexKey<sizeof(VertexPositionColorNormalUV)>	WedgeKey;
+		typedef VertexKey<sizeof(XMFLOAT3)>						PointKey;
+
+		WedgeKey const	wedgeKey(m_vertices);
+		PointKey const	pointKey(m_vertices);
+		std::unordered_map<uint32, uint32, WedgeKey, WedgeKey>	wedgeLookup(indexCount, wedgeKey, wedgeKey);
+		std::unordered_map<uint32, uint32, PointKey, PointKey>	pointLookup(indexCount, pointKey, pointKey);
+
+		XMFLOAT3	minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3	maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32 i = 0; i < indexCount; ++i)
+		{
+			uint32 const	vertex = indices[i];
+			if (m_wedges[vertex] != INVALID_VERTEX)
+				continue;
+
+			m_wedges[vertex] = wedgeLookup.insert(std::make_pair(vertex, vertex)).first->second;
+			m_points[vertex] = pointLookup.insert(std::make_pair(vertex, vertex)).first->second;
+
+			XMFLOAT3 const&	position = m_vertices[vertex].Pos;
+			minimum = XMFLOAT3(position.x < minimum.x ? position.x : minimum.x, position.y < minimum.y ? position.y : minimum.y, position.z < minimum.z ? position.z : minimum.z);
+			maximum = XMFLOAT3(position.x > maximum.x ? position.x : maximum.x, position.y > maximum.y ? position.y : maximum.y, position.z > maximum.z ? position.z : maximum.z);
+		}
+
+		// Errors are measured in a unit cube around the mesh.
+		XMFLOAT3 const	size = Subtract(maximum, minimum);
+		float			extent = size.x > size.y ? size.x : size.y;
+		extent = extent > size.z ? extent : size.z;
+		float const		scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+		m_triangles.clear();
+		for (uint32 i = 0; i + 2 < indexCount; i += 3)
+		{
+			uint32 const	a = m_wedges[indices[i]];
+			uint32 const	b = m_wedges[indices[i + 1]];
+			uint32 const	c = m_wedges[indices[i + 2]];
+			if (m_points[a] == m_points[b] || m_points[b] == m_points[c] || m_points[a] == m_points[c])
+				continue;
+
+			m_triangles.push_back(a);
+			m_triangles.push_back(b);
+			m_triangles.push_back(c);
+		}
+
+		for (uint32 i = 0; i < indexCount; ++i)
+		{
+			uint32 const	vertex = indices[i];
+			XMFLOAT3 const	offset = Subtract(m_vertices[vertex].Pos, minimum);
+			m_positions[vertex] = XMFLOAT3(offset.x * scale, offset.y * scale, offset.z * scale);
+			m_remap[vertex] = vertex;
+		}
+
+		// Every triangle adds its plane to its three points, weighted by its area.
+		for (size_t i = 0; i < m_triangles.size(); i += 3)
+		{
+			uint32 const	a = m_points[m_triangles[i]];
+			uint32 const	b = m_points[m_triangles[i + 1]];
+			uint32 const	c = m_points[m_triangles[i + 2]];
+
+			XMFLOAT3	normal = Cross(Subtract(m_positions[b], m_positions[a]), Subtract(m_positions[c], m_positions[a]));
+			float const	length = sqrtf(Dot(normal, normal));
+			if (length <= 0.0f)
+				continue;
+			normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+
+			float const	distance = -Dot(normal, m_positions[a]);
+			AddPlane(m_quadrics[a], normal, distance, length * 0.5f);
+			AddPlane(m_quadrics[b], normal, distance, length * 0.5f);
+			AddPlane(m_quadrics[c], normal, distance, length * 0.5f);
+		}
+
+		BuildAdjacency();
+		Classify();
+	}
+
+	void Simplifier::BuildAdjacency()
+	{
+		m_adjacencyOffsets.assign(m_vertexCount + 1, 0);
+		for (auto wedge : m_triangles)
+			++m_adjacencyOffsets[m_points[wedge] + 1];
+		for (uint32 i = 0; i < m_vertexCount; ++i)
+			m_adjacencyOffsets[i + 1] += m_adjacencyOffsets[i];
+
+		m_adjacency.resize(m_triangles.size());
+		std::vector<uint32>	fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < m_triangles.size(); ++i)
+			m_adjacency[fill[m_points[m_triangles[i]]]++] = static_cast<uint32>(i / 3);
+	}
+
+	uint32 Simplifier::CountShared(uint32 from, uint32 to) const
+	{
+		uint32	shared = 0;
+		for (auto i = m_adjacencyOffsets[from]; i < m_adjacencyOffsets[from + 1]; ++i)
+		{
+			uint32 const* const	triangle = &m_triangles[m_adjacency[i] * 3];
+			if (m_points[triangle[0]] == to || m_points[triangle[1]] == to || m_points[triangle[2]] == to)
+				++shared;
+		}
+		return shared;
+	}
+
+	// Edges with a single triangle are borders, border edges add a plane through them perpendicular to
+	// their triangle. Points on more than two border edges or on edges with more than two triangles are locked.
+	void Simplifier::Classify()
+	{
+		std::vector<uint8>	borderEdges(m_vertexCount);
+		for (size_t i = 0; i < m_triangles.size(); i += 3)
+		{
+			for (int edge = 0; edge < 3; ++edge)
+			{
+				uint32 const	a = m_points[m_triangles[i + edge]];
+				uint32 const	b = m_points[m_triangles[i + (edge + 1) % 3]];
+				uint32 const	c = m_points[m_triangles[i + (edge + 2) % 3]];
+				uint32 const	shared = CountShared(a, b);
+				if (shared > 2)
+				{
+					m_kinds[a] = KIND_LOCKED;
+					m_kinds[b] = KIND_LOCKED;
+				}
+				if (shared != 1)
+					continue;
+
+				if (borderEdges[a] < 255)
+					++borderEdges[a];
+				if (borderEdges[b] < 255)
+					++borderEdges[b];
+
+				XMFLOAT3 const	direction = Subtract(m_positions[b], m_positions[a]);
+				XMFLOAT3		plane = Cross(direction, Cross(direction, Subtract(m_positions[c], m_positions[a])));
+				float const		length = sqrtf(Dot(plane, plane));
+				if (length <= 0.0f)
+					continue;
+				plane = XMFLOAT3(plane.x / length, plane.y / length, plane.z / length);
+
+				float const	distance = -Dot(plane, m_positions[a]);
+				float const	weight = Dot(direction, direction) * BORDER_WEIGHT;
+				AddPlane(m_quadrics[a], plane, distance, weight);
+				AddPlane(m_quadrics[b], plane, distance, weight);
+			}
+		}
+
+		for (uint32 point = 0; point < m_vertexCount; ++point)
+		{
+			if (m_kinds[point] == KIND_LOCKED || borderEdges[point] > 2)
+				m_kinds[point] = KIND_LOCKED;
+			else if (borderEdges[point])
+				m_kinds[point] = KIND_BORDER;
+		}
+	}
+
+	// Every wedge of from has to find its wedge of to across a triangle holding both, border points only
+	// move along a border edge and no remaining triangle may turn too far.
+	bool Simplifier::CanCollapse(uint32 from, uint32 to, uint32& shared)
+	{
+		m_wedgeMap.clear();
+		shared = 0;
+		for (auto i = m_adjacencyOffsets[from]; i < m_adjacencyOffsets[from + 1]; ++i)
+		{
+			uint32 const* const	triangle = &m_triangles[m_adjacency[i] * 3];
+			uint32	fromWedge = INVALID_VERTEX;
+			uint32	toWedge = INVALID_VERTEX;
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				if (m_points[triangle[corner]] == from)
+					fromWedge = triangle[corner];
+				else if (m_points[triangle[corner]] == to)
+					toWedge = triangle[corner];
+			}
+			if (toWedge == INVALID_VERTEX)
+				continue;
+
+			++shared;
+			auto const	mapped = std::find_if(m_wedgeMap.begin(), m_wedgeMap.end(), [=](std::pair<uint32, uint32> const& pair) { return pair.first == fromWedge; });
+			if (mapped == m_wedgeMap.end())
+				m_wedgeMap.push_back(std::make_pair(fromWedge, toWedge));
+			else if (mapped->second != toWedge)
+				return false;
+		}
+
+		if (m_kinds[from] == KIND_BORDER && shared != 1)
+			return false;
+
+		for (auto i = m_adjacencyOffsets[from]; i < m_adjacencyOffsets[from + 1]; ++i)
+		{
+			uint32 const* const	triangle = &m_triangles[m_adjacency[i] * 3];
+			uint32 const		a = m_points[triangle[0]];
+			uint32 const		b = m_points[triangle[1]];
+			uint32 const		c = m_points[triangle[2]];
+			if (a == to || b == to || c == to)
+				continue;
+
+			uint32 const	fromWedge = triangle[a == from ? 0 : b == from ? 1 : 2];
+			auto const		mapped = std::find_if(m_wedgeMap.begin(), m_wedgeMap.end(), [=](std::pair<uint32, uint32> const& pair) { return pair.first == fromWedge; });
+			if (mapped == m_wedgeMap.end())
+				return false;
+
+			XMFLOAT3 const&	positionA = m_positions[a == from ? to : a];
+			XMFLOAT3 const&	positionB = m_positions[b == from ? to : b];
+			XMFLOAT3 const&	positionC = m_positions[c == from ? to : c];
+			XMFLOAT3 const	before = Cross(Subtract(m_positions[b], m_positions[a]), Subtract(m_positions[c], m_positions[a]));
+			XMFLOAT3 const	after = Cross(Subtract(positionB, positionA), Subtract(positionC, positionA));
+			if (Dot(before, after) < MIN_NORMAL_COSINE * sqrtf(Dot(before, before) * Dot(after, after)))
+				return false;
+		}
+		return true;
+	}
+
+	void Simplifier::AddCollapse(uint32 from, uint32 to, float errorLimit)
+	{
+		if (m_kinds[from] == KIND_LOCKED || (m_kinds[from] == KIND_BORDER && m_kinds[to] != KIND_BORDER && m_kinds[to] != KIND_LOCKED))
+			return;
+
+		Quadric	quadric = m_quadrics[from];
+		AddQuadric(quadric, m_quadrics[to]);
+
+		Collapse	collapse;
+		collapse.From = from;
+		collapse.To = to;
+		collapse.Error = Evaluate(quadric, m_positions[to]);
+		if (collapse.Error <= errorLimit)
+			m_collapses.push_back(collapse);
+	}
+
+	// Runs passes of the cheapest independent collapses until the target is met or nothing is left
+	// under the error limit. Returns the largest squared error accepted.
+	float Simplifier::Simplify(uint32 targetIndexCount, float errorLimit)
+	{
+		float	maxError = 0.0f;
+		while (m_triangles.size() > targetIndexCount)
+		{
+			m_collapses.clear();
+			for (size_t i = 0; i < m_triangles.size(); i += 3)
+			{
+				for (int edge = 0; edge < 3; ++edge)
+				{
+					uint32 const	a = m_points[m_triangles[i + edge]];
+					uint32 const	b = m_points[m_triangles[i + (edge + 1) % 3]];
+					AddCollapse(a, b, errorLimit);
+					AddCollapse(b, a, errorLimit);
+				}
+			}
+			if (m_collapses.empty())
+				break;
+
+			std::sort(m_collapses.begin(), m_collapses.end(), [](Collapse const& left, Collapse const& right) { return left.Error < right.Error; });
+
+			// A collapse changes the triangles around its point, none of their points can move again this pass.
+			size_t const	trianglesToRemove = (m_triangles.size() - targetIndexCount + 2) / 3;
+			size_t			removed = 0;
+			std::fill(m_touched.begin(), m_touched.end(), uint8(0));
+			for (auto const& collapse : m_collapses)
+			{
+				if (removed >= trianglesToRemove)
+					break;
+
+				uint32	shared = 0;
+				if (m_touched[collapse.From] || m_touched[collapse.To] || !CanCollapse(collapse.From, collapse.To, shared))
+					continue;
+
+				for (auto const& pair : m_wedgeMap)
+					m_remap[pair.first] = pair.second;
+				AddQuadric(m_quadrics[collapse.To], m_quadrics[collapse.From]);
+
+				for (auto i = m_adjacencyOffsets[collapse.From]; i < m_adjacencyOffsets[collapse.From + 1]; ++i)
+				{
+					uint32 const* const	triangle = &m_triangles[m_adjacency[i] * 3];
+					m_touched[m_points[triangle[0]]] = 1;
+					m_touched[m_points[triangle[1]]] = 1;
+					m_touched[m_points[triangle[2]]] = 1;
+				}
+
+				removed += shared;
+				maxError = collapse.Error > maxError ? collapse.Error : maxError;
+			}
+			if (!removed)
+				break;
+
+			size_t	write = 0;
+			for (size_t i = 0; i < m_triangles.size(); i += 3)
+			{
+				uint32 const	a = m_remap[m_triangles[i]];
+				uint32 const	b = m_remap[m_triangles[i + 1]];
+				uint32 const	c = m_remap[m_triangles[i + 2]];
+				if (m_points[a] == m_points[b] || m_points[b] == m_points[c] || m_points[a] == m_points[c])
+					continue;
+
+				m_triangles[write++] = a;
+				m_triangles[write++] = b;
+				m_triangles[write++] = c;
+			}
+			m_triangles.resize(write);
+
+			BuildAdjacency();
+		}
+		return maxError;
+	}
+}
+
+void Dive::WeldVertices(uint32* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices)
+{
+	typedef VertexKey<sizeof(VertexPositionColorNormalUV)>	WedgeKey;
+
+	WedgeKey const	wedgeKey(vertices);
+	std::unordered_map<uint32, uint32, WedgeKey, WedgeKey>	lookup(indexCount, wedgeKey, wedgeKey);
+	for (uint32 i = 0; i < indexCount; ++i)
+		indices[i] = lookup.insert(std::make_pair(indices[i], indices[i])).first->second;
+}
+
+uint32 Dive::SimplifyMesh(uint32* destination, uint32 const* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices, uint32 vertexCount,
+						  uint32 targetIndexCount, float targetError, float& resultError)
+{
+	Simplifier	simplifier(vertices, vertexCount);
+	simplifier.Initialize(indices, indexCount);
+	resultError = sqrtf(simplifier.Simplify(targetIndexCount, targetError * targetError));
+
+	std::vector<uint32> const&	triangles = simplifier.GetTriangles();
+	if (!triangles.empty())
+		memcpy(destination, triangles.data(), triangles.size() * sizeof(uint32));
+	return static_cast<uint32>(triangles.size());
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ShaderStructures.h"
+
+namespace Dive
+{
+	// Points every index at the first of the vertices it references with exactly the same attributes.
+	// Meshes imported by polygon vertex share no vertices until welded.
+	void	WeldVertices(uint32* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices);
+
+	// Quadric error edge collapse (Garland and Heckbert) over an indexed triangle list. Vertices only
+	// ever collapse onto other existing vertices, so the result indexes the same vertex buffer.
+	//
+	// Vertices with equal attributes are welded first. Vertices sharing a position with different
+	// normals or UVs are wedges of one corner: a collapse has to carry every wedge of the removed
+	// corner onto a wedge of the kept one across a triangle they share, which keeps UV seams and
+	// hard normal edges in place and lets them only slide along themselves. Open borders only
+	// collapse along border edges, and collapses turning a triangle's normal by more than about
+	// 75 degrees are rejected.
+	//
+	// targetError and resultError are distances relative to the largest extent of the referenced
+	// vertices. Simplification stops at targetIndexCount or when the next collapse would exceed
+	// targetError, whichever comes first. Returns the number of indices written to destination,
+	// which needs room for indexCount of them.
+	uint32	SimplifyMesh(uint32* destination, uint32 const* indices, uint32 indexCount, VertexPositionColorNormalUV const* vertices, uint32 vertexCount,
+					 uint32 targetIndexCount, float targetError, float& resultError);
+}
\ No newline at end of file
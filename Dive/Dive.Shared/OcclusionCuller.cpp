@@ -0,0 +1,368 @@
+#include "pch.h"
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DIVE_OCCLUSION_SSE2
+#elif defined(_M_ARM) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DIVE_OCCLUSION_NEON
+#endif
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	// Tiles are rasterized by separate tasks, their width is a whole number of 4 pixel spans.
+	uint32 const	TILE_WIDTH = 64;
+	uint32 const	TILE_HEIGHT = 32;
+	uint32 const	TILES_X = OcclusionCuller::Width / TILE_WIDTH;
+	uint32 const	TILES_Y = OcclusionCuller::Height / TILE_HEIGHT;
+	float const		CLEAR_DEPTH = 1.0f;
+	// Boxes are compared against at most this many texels per side of the mip level they fit in.
+	int const		MAX_TEST_TEXELS = 4;
+
+	// Point of the segment where the clip-space z crosses 0, the D3D near plane.
+	XMFLOAT4 ClipNear(XMFLOAT4 const& a, XMFLOAT4 const& b)
+	{
+		float const	t = a.z / (a.z - b.z);
+		return XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t);
+	}
+}
+
+OcclusionCuller::OcclusionCuller() :
+m_bins(TILES_X * TILES_Y),
+m_hasOccluders(false)
+{
+	uint32	width = Width;
+	uint32	height = Height;
+	uint32	size = 0;
+	for (;;)
+	{
+		m_levelOffsets.push_back(size);
+		size += width * height;
+		if (width == 1 && height == 1)
+			break;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	m_depth.resize(size, CLEAR_DEPTH);
+	XMStoreFloat4x4(&m_viewProjection, XMMatrixIdentity());
+}
+
+void OcclusionCuller::BeginFrame(CXMMATRIX viewProjection)
+{
+	XMStoreFloat4x4(&m_viewProjection, viewProjection);
+	m_triangles.clear();
+	for (auto& bin : m_bins)
+		bin.clear();
+	m_hasOccluders = false;
+	m_stats = Stats();
+}
+
+void OcclusionCuller::AddOccluder(CXMMATRIX world, OccluderMesh const& mesh)
+{
+	XMMATRIX const	worldViewProjection = XMMatrixMultiply(world, XMLoadFloat4x4(&m_viewProjection));
+	m_clipVertices.resize(mesh.VertexCount);
+	for (uint32 i = 0; i < mesh.VertexCount; ++i)
+		XMStoreFloat4(&m_clipVertices[i], XMVector3Transform(XMLoadFloat3(&mesh.Positions[i]), worldViewProjection));
+
+	++m_stats.Occluders;
+	m_hasOccluders = true;
+
+	for (uint32 i = 0; i + 2 < mesh.IndexCount; i += 3)
+	{
+		XMFLOAT4 const	vertices[3] = { m_clipVertices[mesh.Indices[i]], m_clipVertices[mesh.Indices[i + 1]], m_clipVertices[mesh.Indices[i + 2]] };
+		bool const		inFront[3] = { vertices[0].z >= 0.0f, vertices[1].z >= 0.0f, vertices[2].z >= 0.0f };
+		if (inFront[0] && inFront[1] && inFront[2])
+		{
+			AddTriangle(vertices[0], vertices[1], vertices[2]);
+			continue;
+		}
+
+		// Triangles crossing the near plane are clipped into a polygon of 3 or 4 vertices, keeping the winding.
+		XMFLOAT4	polygon[4];
+		uint32		polygonSize = 0;
+		for (uint32 j = 0; j < 3; ++j)
+		{
+			uint32 const	next = j < 2 ? j + 1 : 0;
+			if (inFront[j])
+				polygon[polygonSize++] = vertices[j];
+			if (inFront[j] != inFront[next])
+				polygon[polygonSize++] = ClipNear(vertices[j], vertices[next]);
+		}
+		for (uint32 j = 2; j < polygonSize; ++j)
+			AddTriangle(polygon[0], polygon[j - 1], polygon[j]);
+	}
+}
+
+void OcclusionCuller::AddTriangle(XMFLOAT4 const& v0, XMFLOAT4 const& v1, XMFLOAT4 const& v2)
+{
+	XMFLOAT4 const* const	vertices[3] = { &v0, &v1, &v2 };
+	float	x[3];
+	float	y[3];
+	float	z[3];
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		float const	inverseW = 1.0f / vertices[i]->w;
+		x[i] = (vertices[i]->x * inverseW * 0.5f + 0.5f) * Width;
+		y[i] = (0.5f - vertices[i]->y * inverseW * 0.5f) * Height;
+		z[i] = vertices[i]->z * inverseW;
+	}
+
+	// With y pointing down, clockwise triangles have a positive area.
+	float const	area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0.0f))
+		return;
+
+	// Pixels whose center lies inside the bounds.
+	float const	minX = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+	float const	maxX = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+	float const	minY = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+	float const	maxY = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+	if (maxX < 0.5f || maxY < 0.5f || minX > Width - 0.5f || minY > Height - 0.5f)
+		return;
+
+	Triangle	triangle;
+	triangle.MinX = minX > 0.5f ? static_cast<int>(ceilf(minX - 0.5f)) : 0;
+	triangle.MinY = minY > 0.5f ? static_cast<int>(ceilf(minY - 0.5f)) : 0;
+	triangle.MaxX = maxX < Width - 0.5f ? static_cast<int>(floorf(maxX - 0.5f)) : static_cast<int>(Width - 1);
+	triangle.MaxY = maxY < Height - 0.5f ? static_cast<int>(floorf(maxY - 0.5f)) : static_cast<int>(Height - 1);
+	if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		return;
+
+	// Edge i faces vertex i and evaluates to its barycentric weight times the area, at integer pixel coordinates.
+	float const	inverseArea = 1.0f / area;
+	triangle.DepthA = 0.0f;
+	triangle.DepthB = 0.0f;
+	triangle.DepthC = 0.0f;
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		uint32 const	a = i < 2 ? i + 1 : 0;
+		uint32 const	b = a < 2 ? a + 1 : 0;
+		float const		edgeA = y[a] - y[b];
+		float const		edgeB = x[b] - x[a];
+		float const		edgeC = -(edgeA * x[a] + edgeB * y[a]) + 0.5f * (edgeA + edgeB);
+		triangle.EdgeA[i] = edgeA;
+		triangle.EdgeB[i] = edgeB;
+		triangle.EdgeC[i] = edgeC;
+		triangle.DepthA += edgeA * inverseArea * z[i];
+		triangle.DepthB += edgeB * inverseArea * z[i];
+		triangle.DepthC += edgeC * inverseArea * z[i];
+	}
+
+	uint32 const	index = static_cast<uint32>(m_triangles.size());
+	m_triangles.push_back(triangle);
+	++m_stats.OccluderTriangles;
+
+	for (auto tileY = triangle.MinY / TILE_HEIGHT; tileY <= triangle.MaxY / TILE_HEIGHT; ++tileY)
+	{
+		for (auto tileX = triangle.MinX / TILE_WIDTH; tileX <= triangle.MaxX / TILE_WIDTH; ++tileX)
+			m_bins[tileY * TILES_X + tileX].push_back(index);
+	}
+}
+
+void OcclusionCuller::Rasterize()
+{
+	if (!m_hasOccluders)
+		return;
+
+	JobSystem::Get().ParallelFor(0, TILES_X * TILES_Y, 1, [this](uint32 tile)
+	{
+		RasterizeTile(tile);
+	});
+	BuildMipChain();
+}
+
+void OcclusionCuller::RasterizeTile(uint32 tile)
+{
+	int const	tileX = static_cast<int>(tile % TILES_X * TILE_WIDTH);
+	int const	tileY = static_cast<int>(tile / TILES_X * TILE_HEIGHT);
+	int const	lastX = tileX + static_cast<int>(TILE_WIDTH) - 1;
+	int const	lastY = tileY + static_cast<int>(TILE_HEIGHT) - 1;
+	for (int y = tileY; y <= lastY; ++y)
+	{
+		float* const	row = &m_depth[y * Width + tileX];
+		for (uint32 x = 0; x < TILE_WIDTH; ++x)
+			row[x] = CLEAR_DEPTH;
+	}
+
+	for (auto index : m_bins[tile])
+	{
+		Triangle const&	triangle = m_triangles[index];
+		// Spans start 4 pixel aligned, pixels outside the triangle fail the edge test anyway.
+		int const	startX = (triangle.MinX > tileX ? triangle.MinX : tileX) & ~3;
+		int const	endX = triangle.MaxX < lastX ? triangle.MaxX : lastX;
+		int const	startY = triangle.MinY > tileY ? triangle.MinY : tileY;
+		int const	endY = triangle.MaxY < lastY ? triangle.MaxY : lastY;
+
+		for (int y = startY; y <= endY; ++y)
+		{
+			float* const	row = &m_depth[y * Width];
+			float const		fx = static_cast<float>(startX);
+			float const		fy = static_cast<float>(y);
+			float const		edge0 = triangle.EdgeA[0] * fx + triangle.EdgeB[0] * fy + triangle.EdgeC[0];
+			float const		edge1 = triangle.EdgeA[1] * fx + triangle.EdgeB[1] * fy + triangle.EdgeC[1];
+			float const		edge2 = triangle.EdgeA[2] * fx + triangle.EdgeB[2] * fy + triangle.EdgeC[2];
+			float const		depth = triangle.DepthA * fx + triangle.DepthB * fy + triangle.DepthC;
+
+#if defined(DIVE_OCCLUSION_SSE2)
+			__m128 const	offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+			__m128 const	zero = _mm_setzero_ps();
+			__m128			e0 = _mm_add_ps(_mm_set1_ps(edge0), _mm_mul_ps(_mm_set1_ps(triangle.EdgeA[0]), offsets));
+			__m128			e1 = _mm_add_ps(_mm_set1_ps(edge1), _mm_mul_ps(_mm_set1_ps(triangle.EdgeA[1]), offsets));
+			__m128			e2 = _mm_add_ps(_mm_set1_ps(edge2), _mm_mul_ps(_mm_set1_ps(triangle.EdgeA[2]), offsets));
+			__m128			z = _mm_add_ps(_mm_set1_ps(depth), _mm_mul_ps(_mm_set1_ps(triangle.DepthA), offsets));
+			__m128 const	step0 = _mm_set1_ps(triangle.EdgeA[0] * 4.0f);
+			__m128 const	step1 = _mm_set1_ps(triangle.EdgeA[1] * 4.0f);
+			__m128 const	step2 = _mm_set1_ps(triangle.EdgeA[2] * 4.0f);
+			__m128 const	stepZ = _mm_set1_ps(triangle.DepthA * 4.0f);
+			for (int x = startX; x <= endX; x += 4)
+			{
+				__m128 const	inside = _mm_cmpge_ps(_mm_min_ps(_mm_min_ps(e0, e1), e2), zero);
+				__m128 const	previous = _mm_loadu_ps(row + x);
+				__m128 const	nearest = _mm_min_ps(previous, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+				e0 = _mm_add_ps(e0, step0);
+				e1 = _mm_add_ps(e1, step1);
+				e2 = _mm_add_ps(e2, step2);
+				z = _mm_add_ps(z, stepZ);
+			}
+#elif defined(DIVE_OCCLUSION_NEON)
+			float const		offsetValues[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+			float32x4_t const	offsets = vld1q_f32(offsetValues);
+			float32x4_t const	zero = vdupq_n_f32(0.0f);
+			float32x4_t		e0 = vmlaq_n_f32(vdupq_n_f32(edge0), offsets, triangle.EdgeA[0]);
+			float32x4_t		e1 = vmlaq_n_f32(vdupq_n_f32(edge1), offsets, triangle.EdgeA[1]);
+			float32x4_t		e2 = vmlaq_n_f32(vdupq_n_f32(edge2), offsets, triangle.EdgeA[2]);
+			float32x4_t		z = vmlaq_n_f32(vdupq_n_f32(depth), offsets, triangle.DepthA);
+			float32x4_t const	step0 = vdupq_n_f32(triangle.EdgeA[0] * 4.0f);
+			float32x4_t const	step1 = vdupq_n_f32(triangle.EdgeA[1] * 4.0f);
+			float32x4_t const	step2 = vdupq_n_f32(triangle.EdgeA[2] * 4.0f);
+			float32x4_t const	stepZ = vdupq_n_f32(triangle.DepthA * 4.0f);
+			for (int x = startX; x <= endX; x += 4)
+			{
+				uint32x4_t const	inside = vcgeq_f32(vminq_f32(vminq_f32(e0, e1), e2), zero);
+				float32x4_t const	previous = vld1q_f32(row + x);
+				vst1q_f32(row + x, vbslq_f32(inside, vminq_f32(previous, z), previous));
+				e0 = vaddq_f32(e0, step0);
+				e1 = vaddq_f32(e1, step1);
+				e2 = vaddq_f32(e2, step2);
+				z = vaddq_f32(z, stepZ);
+			}
+#else
+			for (int x = startX; x <= endX; ++x)
+			{
+				float const	offset = static_cast<float>(x - startX);
+				if (edge0 + triangle.EdgeA[0] * offset >= 0.0f && edge1 + triangle.EdgeA[1] * offset >= 0.0f && edge2 + triangle.EdgeA[2] * offset >= 0.0f)
+				{
+					float const	z = depth + triangle.DepthA * offset;
+					if (z < row[x])
+						row[x] = z;
+				}
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionCuller::BuildMipChain()
+{
+	uint32	sourceWidth = Width;
+	uint32	sourceHeight = Height;
+	for (size_t level = 1; level < m_levelOffsets.size(); ++level)
+	{
+		float const* const	source = &m_depth[m_levelOffsets[level - 1]];
+		float* const		destination = &m_depth[m_levelOffsets[level]];
+		uint32 const		width = sourceWidth > 1 ? sourceWidth / 2 : 1;
+		uint32 const		height = sourceHeight > 1 ? sourceHeight / 2 : 1;
+		for (uint32 y = 0; y < height; ++y)
+		{
+			float const* const	row0 = source + (y * 2) * sourceWidth;
+			float const* const	row1 = sourceHeight > 1 ? row0 + sourceWidth : row0;
+			for (uint32 x = 0; x < width; ++x)
+			{
+				uint32 const	x0 = x * 2;
+				uint32 const	x1 = sourceWidth > 1 ? x0 + 1 : x0;
+				float const		top = row0[x0] > row0[x1] ? row0[x0] : row0[x1];
+				float const		bottom = row1[x0] > row1[x1] ? row1[x0] : row1[x1];
+				destination[y * width + x] = top > bottom ? top : bottom;
+			}
+		}
+		sourceWidth = width;
+		sourceHeight = height;
+	}
+}
+
+bool OcclusionCuller::IsVisible(BoundingBox const& box)
+{
+	++m_stats.Tested;
+	if (!m_hasOccluders)
+		return true;
+
+	XMFLOAT3	corners[BoundingBox::CORNER_COUNT];
+	box.GetCorners(corners);
+
+	XMMATRIX const	viewProjection = XMLoadFloat4x4(&m_viewProjection);
+	float	minX = FLT_MAX;
+	float	minY = FLT_MAX;
+	float	maxX = -FLT_MAX;
+	float	maxY = -FLT_MAX;
+	float	minZ = FLT_MAX;
+	for (auto const& corner : corners)
+	{
+		XMFLOAT4	clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corner), viewProjection));
+		if (clip.z < 0.0f)
+			return true;
+
+		float const	inverseW = 1.0f / clip.w;
+		float const	x = (clip.x * inverseW * 0.5f + 0.5f) * Width;
+		float const	y = (0.5f - clip.y * inverseW * 0.5f) * Height;
+		float const	z = clip.z * inverseW;
+		minX = x < minX ? x : minX;
+		maxX = x > maxX ? x : maxX;
+		minY = y < minY ? y : minY;
+		maxY = y > maxY ? y : maxY;
+		minZ = z < minZ ? z : minZ;
+	}
+
+	// Off screen boxes are the frustum's business.
+	if (maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height)
+		return true;
+
+	// Every pixel the box touches, then the mip level covering them with a few texels.
+	int	x0 = minX > 0.0f ? static_cast<int>(minX) : 0;
+	int	y0 = minY > 0.0f ? static_cast<int>(minY) : 0;
+	int	x1 = maxX < Width - 1 ? static_cast<int>(maxX) : static_cast<int>(Width - 1);
+	int	y1 = maxY < Height - 1 ? static_cast<int>(maxY) : static_cast<int>(Height - 1);
+	size_t	level = 0;
+	while (x1 - x0 >= MAX_TEST_TEXELS || y1 - y0 >= MAX_TEST_TEXELS)
+	{
+		x0 >>= 1;
+		y0 >>= 1;
+		x1 >>= 1;
+		y1 >>= 1;
+		++level;
+	}
+
+	uint32 const		levelWidth = Width >> level ? Width >> level : 1;
+	float const* const	depth = &m_depth[m_levelOffsets[level]];
+	float				maxDepth = 0.0f;
+	for (int y = y0; y <= y1; ++y)
+	{
+		for (int x = x0; x <= x1; ++x)
+			maxDepth = depth[y * levelWidth + x] > maxDepth ? depth[y * levelWidth + x] : maxDepth;
+	}
+
+	if (minZ <= maxDepth)
+		return true;
+
+	++m_stats.Culled;
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace Dive
+{
+	// Simplified stand-in for a submesh, rasterized into the occlusion depth buffer. Indices are local to Positions.
+	struct OccluderMesh
+	{
+		OccluderMesh() : Positions(nullptr), VertexCount(0), Indices(nullptr), IndexCount(0) { }
+
+		DirectX::XMFLOAT3 const*	Positions;
+		uint32						VertexCount;
+		uint32 const*				Indices;
+		uint32						IndexCount;
+	};
+
+	// Software occlusion culling. Every frame the occluders in view are rasterized into a small depth buffer,
+	// tile by tile in parallel and 4 pixels per instruction (SSE2/NEON), and a max-depth mip chain built from
+	// it rejects boxes lying entirely behind them. Only front faces are rasterized, clockwise as on the GPU.
+	class OcclusionCuller
+	{
+	public:
+		static uint32 const	Width = 256;
+		static uint32 const	Height = 128;
+
+		struct Stats
+		{
+			Stats() : Occluders(0), OccluderTriangles(0), Tested(0), Culled(0) { }
+
+			uint32	Occluders;
+			// Front-facing triangles left after near plane clipping.
+			uint32	OccluderTriangles;
+			uint32	Tested;
+			uint32	Culled;
+		};
+
+		OcclusionCuller();
+
+		// viewProjection is not transposed. Forgets the occluders of the previous frame.
+		void	BeginFrame(DirectX::CXMMATRIX viewProjection);
+		// world is not transposed.
+		void	AddOccluder(DirectX::CXMMATRIX world, OccluderMesh const& mesh);
+		// Rasterizes the occluders added since BeginFrame and builds the mip chain.
+		void	Rasterize();
+		// False when the world-space box is hidden behind the occluders. Boxes crossing the near plane are always visible.
+		bool	IsVisible(DirectX::BoundingBox const& box);
+
+		Stats const&	GetStats() const	{ return m_stats; }
+
+	private:
+		// Edge functions are positive inside and z is a plane in screen space.
+		struct Triangle
+		{
+			float	EdgeA[3];
+			float	EdgeB[3];
+			float	EdgeC[3];
+			float	DepthA;
+			float	DepthB;
+			float	DepthC;
+			int		MinX;
+			int		MinY;
+			int		MaxX;
+			int		MaxY;
+		};
+
+		void	AddTriangle(DirectX::XMFLOAT4 const& v0, DirectX::XMFLOAT4 const& v1, DirectX::XMFLOAT4 const& v2);
+		void	RasterizeTile(uint32 tile);
+		void	BuildMipChain();
+
+		DirectX::XMFLOAT4X4				m_viewProjection;
+		std::vector<DirectX::XMFLOAT4>	m_clipVertices;
+		std::vector<Triangle>			m_triangles;
+		std::vector<std::vector<uint32>>	m_bins;
+		// Level 0 is the depth buffer, every further level holds the farthest depth of 2x2 texels of the previous one.
+		std::vector<float>				m_depth;
+		std::vector<uint32>				m_levelOffsets;
+		bool							m_hasOccluders;
+		Stats							m_stats;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "PerformanceHud.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <cwchar>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	// Percentiles cover about five seconds, the graph the last two.
+	size_t const	FRAME_WINDOW = 300;
+	size_t const	GRAPH_BARS = 120;
+	double const	REFRESH_MS = 250.0;
+
+	float const	FONT_SIZE = 14.0f;
+	float const	LINE_WIDTH = 400.0f;
+	float const	LINE_HEIGHT = 20.0f;
+	float const	MARGIN = 12.0f;
+	float const	PADDING = 6.0f;
+	float const	BAR_WIDTH = 2.0f;
+	// Twice the target frame time fills the graph.
+	float const	GRAPH_HEIGHT = 60.0f;
+	float const	GRAPH_WIDTH = GRAPH_BARS * BAR_WIDTH;
+
+	float const	BACKGROUND_COLOR[4] = { 0.0f, 0.0f, 0.0f, 0.6f };
+	float const	TARGET_COLOR[4] = { 1.0f, 1.0f, 1.0f, 0.5f };
+	float const	FAST_COLOR[4] = { 0.3f, 0.9f, 0.3f, 1.0f };
+	float const	SLOW_COLOR[4] = { 1.0f, 0.3f, 0.2f, 1.0f };
+
+	std::wstring Format(wchar_t const* format, ...)
+	{
+		wchar_t	buffer[128];
+		va_list	arguments;
+		va_start(arguments, format);
+		int const	length = vswprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), format, arguments);
+		va_end(arguments);
+		return std::wstring(buffer, length > 0 ? length : 0);
+	}
+
+	std::wstring FormatBytes(uint64 bytes)
+	{
+		if (bytes < 1024 * 1024)
+			return Format(L"%.0f KB", bytes / 1024.0);
+		return Format(L"%.1f MB", bytes / (1024.0 * 1024.0));
+	}
+
+	// Nearest rank, values are partly reordered.
+	double GetPercentile(std::vector<double>& values, double percentile)
+	{
+		size_t	rank = static_cast<size_t>(percentile * values.size() + 0.999999);
+		rank = rank ? rank - 1 : 0;
+		std::nth_element(values.begin(), values.begin() + rank, values.end());
+		return values[rank];
+	}
+}
+
+PerformanceHud::PerformanceHud(std::shared_ptr<RenderDevice> const& renderDevice) :
+m_renderDevice(renderDevice),
+m_lineCount(0),
+m_nextFrame(0),
+m_sinceRefreshMs(0.0),
+m_targetFrameMs(1000.0 / 60.0),
+m_stageFrames(0),
+m_gpuFrameMs(0.0),
+m_gpuZoneCount(0),
+m_renderScale(1.0f)
+{
+	m_stageMs[0] = m_stageMs[1] = m_stageMs[2] = 0.0;
+	m_frameTimes.reserve(FRAME_WINDOW);
+	m_sortedFrameTimes.reserve(FRAME_WINDOW);
+
+	m_textFormat = m_renderDevice->CreateTextFormat(L"Segoe UI", FONT_SIZE, TEXT_ALIGNMENT_LEADING);
+
+	CreateDeviceDependentResources();
+}
+
+void PerformanceHud::CreateDeviceDependentResources()
+{
+}
+
+void PerformanceHud::ReleaseDeviceDependentResources()
+{
+}
+
+void PerformanceHud::AddFrame(double frameMs)
+{
+	if (m_frameTimes.size() < FRAME_WINDOW)
+		m_frameTimes.push_back(frameMs);
+	else
+		m_frameTimes[m_nextFrame] = frameMs;
+	m_nextFrame = (m_nextFrame + 1) % FRAME_WINDOW;
+	m_sinceRefreshMs += frameMs;
+}
+
+void PerformanceHud::SetStageTimes(double simulateMs, double prepareMs, double submitMs)
+{
+	m_stageMs[0] += simulateMs;
+	m_stageMs[1] += prepareMs;
+	m_stageMs[2] += submitMs;
+	++m_stageFrames;
+}
+
+void PerformanceHud::SetCullingStats(ClusterCuller::Stats const& clusters, OcclusionCuller::Stats const& occlusion)
+{
+	m_clusterStats = clusters;
+	m_occlusionStats = occlusion;
+}
+
+void PerformanceHud::SetGpuTimes(GpuProfiler const& profiler)
+{
+	m_gpuFrameMs = profiler.GetFrameTime();
+	m_gpuZoneCount = profiler.GetZoneCount();
+	for (uint32 zone = 0; zone < m_gpuZoneCount; ++zone)
+		m_gpuZones[zone] = profiler.GetZone(zone);
+}
+
+void PerformanceHud::SetMemory(wchar_t const* category, uint64 cpuBytes, uint64 gpuBytes, bool overBudget)
+{
+	MemoryUsage const	usage = { category, cpuBytes, gpuBytes, overBudget };
+	for (auto& memory : m_memory)
+	{
+		if (memory.Name == category)
+		{
+			memory = usage;
+			return;
+		}
+	}
+	m_memory.push_back(usage);
+}
+
+void PerformanceHud::Update()
+{
+	if (m_lineCount && m_sinceRefreshMs < REFRESH_MS)
+		return;
+	m_sinceRefreshMs = 0.0;
+
+	uint32	line = 0;
+	if (m_frameTimes.empty())
+		SetLine(line++, L"- FPS");
+	else
+	{
+		double	total = 0.0;
+		for (auto frameMs : m_frameTimes)
+			total += frameMs;
+		double const	average = total / m_frameTimes.size();
+
+		m_sortedFrameTimes.assign(m_frameTimes.begin(), m_frameTimes.end());
+		double const	p50 = GetPercentile(m_sortedFrameTimes, 0.50);
+		double const	p95 = GetPercentile(m_sortedFrameTimes, 0.95);
+		double const	p99 = GetPercentile(m_sortedFrameTimes, 0.99);
+
+		SetLine(line++, Format(L"%.0f FPS  %.2f ms  scale %.0f%%", average > 0.0 ? 1000.0 / average : 0.0, average, m_renderScale * 100.0f));
+		SetLine(line++, Format(L"p50 %.1f  p95 %.1f  p99 %.1f ms", p50, p95, p99));
+	}
+
+	if (m_stageFrames)
+	{
+		double const	frames = static_cast<double>(m_stageFrames);
+		SetLine(line++, Format(L"CPU simulate %.2f  prepare %.2f  submit %.2f ms", m_stageMs[0] / frames, m_stageMs[1] / frames, m_stageMs[2] / frames));
+		m_stageMs[0] = m_stageMs[1] = m_stageMs[2] = 0.0;
+		m_stageFrames = 0;
+	}
+
+	if (m_gpuFrameMs > 0.0)
+	{
+		std::wstring	text = Format(L"GPU %.2f ms", m_gpuFrameMs);
+		for (uint32 zone = 0; zone < m_gpuZoneCount; ++zone)
+		{
+			if (m_gpuZones[zone].Depth)
+				continue;
+
+			char const* const	name = m_gpuZones[zone].Name;
+			text += L"  " + std::wstring(name, name + strlen(name)) + Format(L" %.2f", m_gpuZones[zone].Milliseconds);
+		}
+		SetLine(line++, text);
+	}
+
+	SetLine(line++, Format(L"%u draws  %u instanced  %u triangles", m_renderStats.DrawCalls, m_renderStats.InstancedDrawCalls, m_renderStats.Triangles));
+	SetLine(line++, Format(L"%u state changes  %ls uploaded", m_renderStats.GetStateChanges(), FormatBytes(m_renderStats.UploadBytes).c_str()));
+	SetLine(line++, Format(L"%u of %u clusters culled  %u of %u draws behind %u occluders", m_clusterStats.FrustumCulled + m_clusterStats.BackfaceCulled,
+		m_clusterStats.Clusters, m_occlusionStats.Culled, m_occlusionStats.Tested, m_occlusionStats.Occluders));
+
+	for (auto const& memory : m_memory)
+	{
+		if (line == MaxLines)
+			break;
+		SetLine(line++, Format(L"%ls  CPU %ls  GPU %ls%ls", memory.Name, FormatBytes(memory.CpuBytes).c_str(), FormatBytes(memory.GpuBytes).c_str(),
+			memory.OverBudget ? L"  over budget" : L""));
+	}
+
+	for (uint32 unused = line; unused < m_lineCount; ++unused)
+	{
+		m_lines[unused].Text.clear();
+		m_lines[unused].Layout.reset();
+	}
+	m_lineCount = line;
+}
+
+void PerformanceHud::Render()
+{
+	if (!m_lineCount)
+		return;
+
+	float	width = GRAPH_WIDTH;
+	float	height = 0.0f;
+	for (uint32 line = 0; line < m_lineCount; ++line)
+	{
+		if (m_lines[line].Metrics.Width > width)
+			width = m_lines[line].Metrics.Width;
+		height += m_lines[line].Metrics.Height;
+	}
+
+	m_renderDevice->BeginOverlay();
+
+	m_renderDevice->FillRectangle(MARGIN - PADDING, MARGIN - PADDING, width + 2.0f * PADDING, height + PADDING + GRAPH_HEIGHT + 2.0f * PADDING, BACKGROUND_COLOR);
+
+	float	y = MARGIN;
+	for (uint32 line = 0; line < m_lineCount; ++line)
+	{
+		m_renderDevice->DrawTextLayout(m_lines[line].Layout.get(), MARGIN, y);
+		y += m_lines[line].Metrics.Height;
+	}
+
+	float const		bottom = y + PADDING + GRAPH_HEIGHT;
+	double const	scale = GRAPH_HEIGHT / (2.0 * m_targetFrameMs);
+	m_renderDevice->FillRectangle(MARGIN, bottom - static_cast<float>(m_targetFrameMs * scale), GRAPH_WIDTH, 1.0f, TARGET_COLOR);
+
+	size_t const	count = m_frameTimes.size();
+	size_t const	bars = count < GRAPH_BARS ? count : GRAPH_BARS;
+	size_t const	oldest = count < FRAME_WINDOW ? 0 : m_nextFrame;
+	for (size_t bar = 0; bar < bars; ++bar)
+	{
+		double const	frameMs = m_frameTimes[(oldest + count - bars + bar) % count];
+		float			barHeight = static_cast<float>(frameMs * scale);
+		if (barHeight > GRAPH_HEIGHT)
+			barHeight = GRAPH_HEIGHT;
+
+		// Vsync jitter stays green, a missed interval does not.
+		float const* const	color = frameMs > m_targetFrameMs * 1.2 ? SLOW_COLOR : FAST_COLOR;
+		m_renderDevice->FillRectangle(MARGIN + bar * BAR_WIDTH, bottom - barHeight, BAR_WIDTH, barHeight, color);
+	}
+
+	m_renderDevice->EndOverlay();
+}
+
+void PerformanceHud::SetLine(uint32 index, std::wstring const& text)
+{
+	Line&	line = m_lines[index];
+	if (line.Layout && line.Text == text)
+		return;
+
+	line.Text = text;
+	line.Layout = m_renderDevice->CreateTextLayout(line.Text, m_textFormat.get(), LINE_WIDTH, LINE_HEIGHT, line.Metrics);
+}
\ No newline at end of file
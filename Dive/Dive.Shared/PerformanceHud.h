@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "GpuProfiler.h"
+#include "MeshClusters.h"
+#include "OcclusionCuller.h"
+#include "RenderDevice.h"
+#include "RenderQueue.h"
+
+namespace Dive
+{
+	// Overlay with the frame time percentiles over the last frames, the CPU time of each frame stage, the GPU time
+	// of each pass, the render stats and the memory in use by category, above a graph of the latest frame times.
+	// The numbers are refreshed a few times a second and a line's text layout is only rebuilt when its text changed.
+	class PerformanceHud
+	{
+	public:
+		PerformanceHud(std::shared_ptr<RenderDevice> const& renderDevice);
+		void	CreateDeviceDependentResources();
+		void	ReleaseDeviceDependentResources();
+
+		// Milliseconds between the last two frames, the graph marks frames slower than the target.
+		void	AddFrame(double frameMs);
+		void	SetTargetFrameTime(double frameMs)		{ m_targetFrameMs = frameMs; }
+		void	SetStageTimes(double simulateMs, double prepareMs, double submitMs);
+		// The frame time and outermost zones of the latest frame read back.
+		void	SetGpuTimes(GpuProfiler const& profiler);
+		void	SetRenderStats(RenderStats const& stats)	{ m_renderStats = stats; }
+		void	SetCullingStats(ClusterCuller::Stats const& clusters, OcclusionCuller::Stats const& occlusion);
+		void	SetRenderScale(float scale)				{ m_renderScale = scale; }
+		// Shown until set again. Categories are told apart by address and have to outlive the HUD.
+		void	SetMemory(wchar_t const* category, uint64 cpuBytes, uint64 gpuBytes, bool overBudget);
+
+		void	Update();
+		void	Render();
+
+	private:
+		struct Line
+		{
+			std::wstring						Text;
+			TextMetrics							Metrics;
+			std::unique_ptr<RenderTextLayout>	Layout;
+		};
+
+		struct MemoryUsage
+		{
+			wchar_t const*	Name;
+			uint64			CpuBytes;
+			uint64			GpuBytes;
+			bool			OverBudget;
+		};
+
+		static uint32 const	MaxLines = 16;
+
+		void	SetLine(uint32 index, std::wstring const& text);
+
+		std::shared_ptr<RenderDevice>		m_renderDevice;
+		std::unique_ptr<RenderTextFormat>	m_textFormat;
+		Line								m_lines[MaxLines];
+		uint32								m_lineCount;
+
+		// Latest frame times, oldest at m_nextFrame once full.
+		std::vector<double>		m_frameTimes;
+		std::vector<double>		m_sortedFrameTimes;
+		size_t					m_nextFrame;
+		double					m_sinceRefreshMs;
+		double					m_targetFrameMs;
+
+		// Summed since the last refresh.
+		double					m_stageMs[3];
+		uint32					m_stageFrames;
+
+		double					m_gpuFrameMs;
+		GpuZoneTime				m_gpuZones[GpuProfiler::MaxZones];
+		uint32					m_gpuZoneCount;
+
+		RenderStats					m_renderStats;
+		ClusterCuller::Stats		m_clusterStats;
+		OcclusionCuller::Stats		m_occlusionStats;
+		float						m_renderScale;
+		std::vector<MemoryUsage>	m_memory;
+	};
+}
\ No newline at end of file
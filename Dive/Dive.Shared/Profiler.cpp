@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "Common/StepTimer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace Dive;
+
+namespace
+{
+	bool IsEarlier(ProfileZone const& first, ProfileZone const& second)
+	{
+		return first.Begin != second.Begin ? first.Begin < second.Begin : first.Depth < second.Depth;
+	}
+
+	void WriteString(std::ostream& stream, char const* text)
+	{
+		stream << '"';
+		for (char const* character = text; *character; ++character)
+		{
+			unsigned char const	value = static_cast<unsigned char>(*character);
+			if (value == '"' || value == '\\')
+				stream << '\\' << *character;
+			else if (value < 0x20)
+				stream << "\\u00" << "0123456789abcdef"[value >> 4] << "0123456789abcdef"[value & 15];
+			else
+				stream << *character;
+		}
+		stream << '"';
+	}
+}
+
+Profiler									Profiler::s_profiler;
+std::atomic<bool>							Profiler::s_enabled(DIVE_PROFILING != 0);
+DIVE_THREAD_LOCAL Profiler::ThreadBuffer*	Profiler::s_threadBuffer = nullptr;
+
+Profiler& Profiler::Get()
+{
+	return s_profiler;
+}
+
+Profiler::Profiler() :
+m_frequency(DX::SystemStepClock::Get().GetFrequency())
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::SetThreadName(char const* name)
+{
+	ThreadBuffer* const	buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	buffer->Name = name;
+}
+
+uint32 Profiler::CreateTrack(char const* name)
+{
+	ThreadBuffer* const	buffer = CreateBuffer();
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	buffer->Name = name;
+	return buffer->Id;
+}
+
+void Profiler::AddZone(uint32 track, ProfileZone const& zone)
+{
+	ThreadBuffer*	buffer;
+	{
+		std::lock_guard<std::mutex>	lock(m_mutex);
+		buffer = m_threads[track - 1].get();
+	}
+
+	uint64 const	head = buffer->Head.load(std::memory_order_relaxed);
+	buffer->Zones[head % ZonesPerThread] = zone;
+	buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::Clear()
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	for (auto& buffer : m_threads)
+		buffer->Start = buffer->Head.load(std::memory_order_acquire);
+}
+
+void Profiler::Capture(std::vector<ProfileThread>& threads) const
+{
+	threads.clear();
+
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	threads.resize(m_threads.size());
+	for (size_t i = 0; i < m_threads.size(); ++i)
+	{
+		ThreadBuffer const&	buffer = *m_threads[i];
+		ProfileThread&		thread = threads[i];
+		thread.Id = buffer.Id;
+		thread.Name = buffer.Name;
+
+		uint64 const	head = buffer.Head.load(std::memory_order_acquire);
+		uint64			first = head > ZonesPerThread ? head - ZonesPerThread : 0;
+		if (first < buffer.Start)
+			first = buffer.Start;
+		for (uint64 index = first; index < head; ++index)
+			thread.Zones.push_back(buffer.Zones[index % ZonesPerThread]);
+
+		// The owner went on recording meanwhile, the zones it reached again may be torn.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64 const	after = buffer.Head.load(std::memory_order_relaxed);
+		uint64 const	overwritten = after > ZonesPerThread ? after - ZonesPerThread : 0;
+		if (overwritten > first)
+			thread.Zones.erase(thread.Zones.begin(), thread.Zones.begin() + static_cast<size_t>((overwritten < head ? overwritten : head) - first));
+
+		std::sort(thread.Zones.begin(), thread.Zones.end(), IsEarlier);
+	}
+}
+
+void Profiler::ExportChromeTrace(std::ostream& stream) const
+{
+	std::vector<ProfileThread>	threads;
+	Capture(threads);
+	ExportChromeTrace(threads, m_frequency, stream);
+}
+
+void Profiler::ExportChromeTrace(std::vector<ProfileThread> const& threads, uint64 frequency, std::ostream& stream)
+{
+	uint64	origin = ~0ull;
+	for (auto const& thread : threads)
+	{
+		if (!thread.Zones.empty() && thread.Zones.front().Begin < origin)
+			origin = thread.Zones.front().Begin;
+	}
+
+	std::ostringstream	trace;
+	trace << std::fixed << std::setprecision(3);
+	trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	double const	microseconds = 1000000.0 / static_cast<double>(frequency);
+	bool			first = true;
+	for (auto const& thread : threads)
+	{
+		std::string const	name = thread.Name.empty() ? "Thread " + std::to_string(static_cast<unsigned long long>(thread.Id)) : thread.Name;
+		trace << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.Id << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+		WriteString(trace, name.c_str());
+		trace << "}}";
+		first = false;
+
+		for (auto const& zone : thread.Zones)
+		{
+			trace << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.Id << ",\"name\":";
+			WriteString(trace, zone.Name);
+			trace << ",\"ts\":" << static_cast<double>(zone.Begin - origin) * microseconds
+				<< ",\"dur\":" << static_cast<double>(zone.End - zone.Begin) * microseconds << "}";
+		}
+	}
+
+	trace << "\n]}\n";
+	stream << trace.str();
+}
+
+uint64 Profiler::BeginZone()
+{
+	++GetThreadBuffer()->Depth;
+	return DX::SystemStepClock::Get().GetCounter();
+}
+
+void Profiler::EndZone(char const* name, uint64 begin)
+{
+	uint64 const		end = DX::SystemStepClock::Get().GetCounter();
+	ThreadBuffer* const	buffer = s_threadBuffer;
+
+	uint64 const	head = buffer->Head.load(std::memory_order_relaxed);
+	ProfileZone&	zone = buffer->Zones[head % ZonesPerThread];
+	zone.Name = name;
+	zone.Begin = begin;
+	zone.End = end;
+	zone.Depth = --buffer->Depth;
+	buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (!s_threadBuffer)
+		s_threadBuffer = CreateBuffer();
+	return s_threadBuffer;
+}
+
+Profiler::ThreadBuffer* Profiler::CreateBuffer()
+{
+	std::unique_ptr<ThreadBuffer>	buffer(new ThreadBuffer);
+	buffer->Head.store(0, std::memory_order_relaxed);
+	buffer->Start = 0;
+	buffer->Depth = 0;
+
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	buffer->Id = static_cast<uint32>(m_threads.size()) + 1;
+	m_threads.push_back(std::move(buffer));
+	return m_threads.back().get();
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Builds without it compile the markers out.
+#if !defined(DIVE_PROFILING)
+#define DIVE_PROFILING 1
+#endif
+
+#if DIVE_PROFILING
+#define DIVE_PROFILE_JOIN_INNER(a, b)	a##b
+#define DIVE_PROFILE_JOIN(a, b)			DIVE_PROFILE_JOIN_INNER(a, b)
+// Times the rest of the enclosing block. name is kept as a pointer, a string literal.
+#define DIVE_PROFILE_SCOPE(name)		Dive::ProfileScope DIVE_PROFILE_JOIN(profileScope, __LINE__)(name)
+#define DIVE_PROFILE_THREAD(name)		Dive::Profiler::Get().SetThreadName(name)
+#else
+#define DIVE_PROFILE_SCOPE(name)		((void)0)
+#define DIVE_PROFILE_THREAD(name)		((void)0)
+#endif
+
+namespace Dive
+{
+	// Begin and End are counts of the system step clock.
+	struct ProfileZone
+	{
+		char const*	Name;
+		uint64		Begin;
+		uint64		End;
+		// Zones open around it on the same thread.
+		uint32		Depth;
+	};
+
+	struct ProfileThread
+	{
+		uint32						Id;
+		std::string					Name;
+		std::vector<ProfileZone>	Zones;
+	};
+
+	// Every thread records the zones it closes into a ring buffer of its own with no locking, the oldest zones
+	// are overwritten once ZonesPerThread are held. A capture copies what the buffers hold since the last Clear.
+	class Profiler
+	{
+	public:
+		static Profiler&	Get();
+
+		static bool	IsEnabled()					{ return s_enabled.load(std::memory_order_relaxed); }
+		static void	SetEnabled(bool enabled)	{ s_enabled.store(enabled, std::memory_order_relaxed); }
+
+		// Shown as the calling thread's name.
+		void	SetThreadName(char const* name);
+		// Timeline for zones timed by something other than a thread, like the GPU, shown as a thread of its own.
+		// One thread at a time adds to it, with Begin and End already converted to the system step clock.
+		uint32	CreateTrack(char const* name);
+		void	AddZone(uint32 track, ProfileZone const& zone);
+		// Starts the next capture from here.
+		void	Clear();
+
+		// Zones come sorted by begin, parents before their children. Zones being overwritten while copying are left out.
+		void	Capture(std::vector<ProfileThread>& threads) const;
+		uint64	GetFrequency() const	{ return m_frequency; }
+
+		// Complete events in the Chrome trace event format, for chrome://tracing or Perfetto.
+		void		ExportChromeTrace(std::ostream& stream) const;
+		static void	ExportChromeTrace(std::vector<ProfileThread> const& threads, uint64 frequency, std::ostream& stream);
+
+		// Used by ProfileScope. BeginZone returns 0 when the zone is not recorded.
+		uint64	BeginZone();
+		void	EndZone(char const* name, uint64 begin);
+
+		static uint32 const	ZonesPerThread = 8192;
+
+	private:
+		struct ThreadBuffer
+		{
+			ProfileZone				Zones[ZonesPerThread];
+			// Zones ever written, only the owner moves it.
+			std::atomic<uint64>		Head;
+			// Where the capture starts, guarded by m_mutex like the name.
+			uint64					Start;
+			uint32					Depth;
+			uint32					Id;
+			std::string				Name;
+		};
+
+		Profiler();
+		~Profiler();
+		Profiler(Profiler const&);
+		Profiler&	operator=(Profiler const&);
+
+		ThreadBuffer*	GetThreadBuffer();
+		ThreadBuffer*	CreateBuffer();
+
+		// Created before any thread records, Visual C++ 2013 does not guard function statics.
+		static Profiler								s_profiler;
+		static std::atomic<bool>					s_enabled;
+		static DIVE_THREAD_LOCAL ThreadBuffer*		s_threadBuffer;
+
+		uint64	m_frequency;
+
+		mutable std::mutex							m_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>>	m_threads;
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(char const* name) : m_name(name), m_begin(Profiler::IsEnabled() ? Profiler::Get().BeginZone() : 0) { }
+		~ProfileScope()
+		{
+			if (m_begin)
+				Profiler::Get().EndZone(m_name, m_begin);
+		}
+
+	private:
+		ProfileScope(ProfileScope const&);
+		ProfileScope&	operator=(ProfileScope const&);
+
+		char const*	m_name;
+		uint64		m_begin;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,507 @@
+#include "pch.h"
+#include "RecordingRenderDevice.h"
+#include "MemoryTracker.h"
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	// Rough metrics for text that is never rasterized.
+	float const	GLYPH_WIDTH_RATIO = 0.5f;
+	float const	LINE_HEIGHT_RATIO = 1.2f;
+	uint32 const	DEFAULT_FENCE_LATENCY = 2;
+	// Synthetic GPU costs in nanoseconds, enough to tell the passes apart and to follow the work they do.
+	uint64 const	TIMESTAMP_FREQUENCY = 1000000000;
+	uint64 const	CLEAR_PIXELS_PER_NANOSECOND = 20;
+	uint64 const	DRAW_COST = 5000;
+	uint64 const	TRIANGLE_COST = 2;
+	uint64 const	TEXT_COST = 2000;
+	uint64 const	RECTANGLE_COST = 500;
+
+	class RecordedBuffer : public RenderBuffer
+	{
+	public:
+		explicit RecordedBuffer(uint32 byteWidth) : Memory(MemoryTracker::GetScopeCategory(), MEMORY_GPU, byteWidth) { }
+
+		uint32				Id;
+		BufferBinding		Binding;
+		BufferUsage			Usage;
+		MapMode				Mode;
+		std::vector<uint8>	Data;
+		MemoryAllocation	Memory;
+	};
+
+	class RecordedInputLayout : public RenderInputLayout
+	{
+	public:
+		uint32	Id;
+	};
+
+	class RecordedVertexShader : public RenderVertexShader
+	{
+	public:
+		uint32	Id;
+	};
+
+	class RecordedPixelShader : public RenderPixelShader
+	{
+	public:
+		uint32	Id;
+	};
+
+	class RecordedTextureView : public RenderTextureView
+	{
+	public:
+		explicit RecordedTextureView(uint64 byteSize) : Memory(MEMORY_TEXTURE, MEMORY_GPU, byteSize) { }
+
+		uint32				Id;
+		MemoryAllocation	Memory;
+	};
+
+	class RecordedTextFormat : public RenderTextFormat
+	{
+	public:
+		uint32	Id;
+		float	FontSize;
+	};
+
+	class RecordedTextLayout : public RenderTextLayout
+	{
+	public:
+		uint32			Id;
+		std::wstring	Text;
+	};
+
+	class RecordedQuery : public RenderQuery
+	{
+	public:
+		uint32		Id;
+		QueryType	Type;
+		uint64		Timestamp;
+		// Presents after which the result can be read, 0 until the query was ended.
+		uint64		ReadyAfter;
+	};
+
+	template <typename T, typename Resource>
+	uint32 GetId(Resource* resource)
+	{
+		return resource ? static_cast<T*>(resource)->Id : 0;
+	}
+}
+
+RecordingRenderDevice::RecordingRenderDevice(float width, float height) :
+m_width(width),
+m_height(height),
+m_renderScale(1.0f),
+m_lastFence(0),
+m_completedFence(0),
+m_fenceLatency(DEFAULT_FENCE_LATENCY),
+m_presents(0),
+m_gpuTime(0),
+m_nextResourceId(1),
+m_resources(0),
+m_resourceBytes(0)
+{
+}
+
+std::unique_ptr<RenderBuffer> RecordingRenderDevice::CreateBuffer(BufferBinding binding, BufferUsage usage, uint32 byteWidth, void const* initialData)
+{
+	std::unique_ptr<RecordedBuffer>	buffer(new RecordedBuffer(byteWidth));
+	buffer->Id = NextResourceId();
+	buffer->Binding = binding;
+	buffer->Usage = usage;
+	buffer->Mode = MAP_WRITE_DISCARD;
+	buffer->Data.resize(byteWidth);
+	if (initialData)
+		memcpy(buffer->Data.data(), initialData, byteWidth);
+
+	AddResource(byteWidth);
+	return std::move(buffer);
+}
+
+std::unique_ptr<RenderVertexShader> RecordingRenderDevice::CreateVertexShader(void const* bytecode, size_t bytecodeLength)
+{
+	std::unique_ptr<RecordedVertexShader>	vertexShader(new RecordedVertexShader());
+	vertexShader->Id = NextResourceId();
+	AddResource(bytecodeLength);
+	return std::move(vertexShader);
+}
+
+std::unique_ptr<RenderPixelShader> RecordingRenderDevice::CreatePixelShader(void const* bytecode, size_t bytecodeLength)
+{
+	std::unique_ptr<RecordedPixelShader>	pixelShader(new RecordedPixelShader());
+	pixelShader->Id = NextResourceId();
+	AddResource(bytecodeLength);
+	return std::move(pixelShader);
+}
+
+std::unique_ptr<RenderInputLayout> RecordingRenderDevice::CreateInputLayout(InputElement const* elements, uint32 elementCount, void const* vertexShaderBytecode, size_t bytecodeLength)
+{
+	std::unique_ptr<RecordedInputLayout>	inputLayout(new RecordedInputLayout());
+	inputLayout->Id = NextResourceId();
+	AddResource(elementCount * sizeof(InputElement));
+	return std::move(inputLayout);
+}
+
+std::unique_ptr<RenderTextureView> RecordingRenderDevice::CreateTextureView(ScratchImage const& image)
+{
+	std::unique_ptr<RecordedTextureView>	textureView(new RecordedTextureView(image.GetPixelsSize()));
+	textureView->Id = NextResourceId();
+	AddResource(image.GetPixelsSize());
+	return std::move(textureView);
+}
+
+std::unique_ptr<RenderTextFormat> RecordingRenderDevice::CreateTextFormat(wchar_t const* fontFamily, float fontSize, TextAlignment alignment)
+{
+	std::unique_ptr<RecordedTextFormat>	textFormat(new RecordedTextFormat());
+	textFormat->Id = NextResourceId();
+	textFormat->FontSize = fontSize;
+	AddResource(0);
+	return std::move(textFormat);
+}
+
+std::unique_ptr<RenderTextLayout> RecordingRenderDevice::CreateTextLayout(std::wstring const& text, RenderTextFormat* format, float maxWidth, float maxHeight, TextMetrics& metrics)
+{
+	std::unique_ptr<RecordedTextLayout>	textLayout(new RecordedTextLayout());
+	textLayout->Id = NextResourceId();
+	textLayout->Text = text;
+
+	float const	fontSize = static_cast<RecordedTextFormat*>(format)->FontSize;
+	size_t		lineCount = 1;
+	size_t		lineLength = 0;
+	size_t		longestLine = 0;
+	for (auto character : text)
+	{
+		if (character == L'\n')
+		{
+			++lineCount;
+			lineLength = 0;
+		}
+		else if (++lineLength > longestLine)
+			longestLine = lineLength;
+	}
+
+	float const	width = longestLine * fontSize * GLYPH_WIDTH_RATIO;
+	metrics.Width = width < maxWidth ? width : maxWidth;
+	metrics.Height = lineCount * fontSize * LINE_HEIGHT_RATIO;
+	metrics.LayoutWidth = maxWidth;
+	metrics.LayoutHeight = maxHeight;
+
+	AddResource(text.length() * sizeof(wchar_t));
+	return std::move(textLayout);
+}
+
+std::unique_ptr<RenderQuery> RecordingRenderDevice::CreateQuery(QueryType type)
+{
+	std::unique_ptr<RecordedQuery>	query(new RecordedQuery());
+	query->Id = NextResourceId();
+	query->Type = type;
+	query->Timestamp = 0;
+	query->ReadyAfter = 0;
+	AddResource(0);
+	return std::move(query);
+}
+
+void RecordingRenderDevice::ReleaseDeviceDependentResources()
+{
+}
+
+void RecordingRenderDevice::BeginFrame(float const clearColor[4])
+{
+	Record(COMMAND_BEGIN_FRAME);
+	AdvanceGpuTime(static_cast<uint64>(m_width * m_height * m_renderScale * m_renderScale) / CLEAR_PIXELS_PER_NANOSECOND);
+}
+
+void RecordingRenderDevice::Present()
+{
+	Record(COMMAND_PRESENT);
+	++m_stats.Frames;
+	++m_presents;
+
+	m_frameFences.push_back(m_lastFence);
+	while (m_frameFences.size() > m_fenceLatency)
+	{
+		m_completedFence = m_frameFences.front();
+		m_frameFences.pop_front();
+	}
+
+	m_lastFrameCommands.swap(m_commands);
+	m_lastFrameUploads.swap(m_uploads);
+	m_commands.clear();
+	m_uploads.clear();
+}
+
+void RecordingRenderDevice::SetInputLayout(RenderInputLayout* inputLayout)
+{
+	Record(COMMAND_SET_INPUT_LAYOUT, GetId<RecordedInputLayout>(inputLayout));
+}
+
+void RecordingRenderDevice::SetVertexShader(RenderVertexShader* vertexShader)
+{
+	Record(COMMAND_SET_VERTEX_SHADER, GetId<RecordedVertexShader>(vertexShader));
+}
+
+void RecordingRenderDevice::SetPixelShader(RenderPixelShader* pixelShader)
+{
+	Record(COMMAND_SET_PIXEL_SHADER, GetId<RecordedPixelShader>(pixelShader));
+}
+
+void RecordingRenderDevice::SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride)
+{
+	Record(COMMAND_SET_VERTEX_BUFFER, GetId<RecordedBuffer>(vertexBuffer), stride);
+}
+
+void RecordingRenderDevice::SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 stride)
+{
+	Record(COMMAND_SET_INSTANCE_BUFFER, GetId<RecordedBuffer>(instanceBuffer), stride);
+}
+
+void RecordingRenderDevice::SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format)
+{
+	Record(COMMAND_SET_INDEX_BUFFER, GetId<RecordedBuffer>(indexBuffer), static_cast<uint32>(format));
+}
+
+void RecordingRenderDevice::SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer)
+{
+	Record(COMMAND_SET_VERTEX_CONSTANT_BUFFER, GetId<RecordedBuffer>(constantBuffer), slot);
+}
+
+void RecordingRenderDevice::SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size)
+{
+	Record(COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE, GetId<RecordedBuffer>(constantBuffer), slot, offset, size);
+}
+
+void RecordingRenderDevice::SetPixelTexture(uint32 slot, RenderTextureView* textureView)
+{
+	Record(COMMAND_SET_PIXEL_TEXTURE, GetId<RecordedTextureView>(textureView), slot);
+}
+
+void RecordingRenderDevice::UpdateBuffer(RenderBuffer* buffer, void const* data)
+{
+	RecordedBuffer*	recordedBuffer = static_cast<RecordedBuffer*>(buffer);
+	memcpy(recordedBuffer->Data.data(), data, recordedBuffer->Data.size());
+	RecordUpload(COMMAND_UPDATE_BUFFER, recordedBuffer->Id, data, static_cast<uint32>(recordedBuffer->Data.size()));
+}
+
+void* RecordingRenderDevice::MapBuffer(RenderBuffer* buffer, MapMode mode)
+{
+	RecordedBuffer*	recordedBuffer = static_cast<RecordedBuffer*>(buffer);
+	recordedBuffer->Mode = mode;
+	return recordedBuffer->Data.data();
+}
+
+// Only the written range is recorded, Arguments[2] is its offset in the buffer.
+void RecordingRenderDevice::UnmapBuffer(RenderBuffer* buffer, uint32 writtenOffset, uint32 writtenSize)
+{
+	RecordedBuffer*	recordedBuffer = static_cast<RecordedBuffer*>(buffer);
+	RecordUpload(COMMAND_MAP_BUFFER, recordedBuffer->Id, recordedBuffer->Data.data() + writtenOffset, writtenSize);
+	m_commands.back().Arguments[1] = static_cast<uint32>(recordedBuffer->Mode);
+	m_commands.back().Arguments[2] = writtenOffset;
+}
+
+void RecordingRenderDevice::DrawIndexed(uint32 indexCount, uint32 startIndex)
+{
+	Record(COMMAND_DRAW_INDEXED, indexCount, startIndex);
+	m_stats.Triangles += indexCount / 3;
+	AdvanceGpuTime(DRAW_COST + indexCount / 3 * TRIANGLE_COST);
+}
+
+void RecordingRenderDevice::DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance)
+{
+	Record(COMMAND_DRAW_INDEXED_INSTANCED, indexCount, instanceCount, startIndex, startInstance);
+	m_stats.Triangles += indexCount / 3 * instanceCount;
+	AdvanceGpuTime(DRAW_COST + indexCount / 3 * instanceCount * TRIANGLE_COST);
+}
+
+uint64 RecordingRenderDevice::InsertFence()
+{
+	return ++m_lastFence;
+}
+
+bool RecordingRenderDevice::IsFenceComplete(uint64 fence)
+{
+	return fence <= m_completedFence;
+}
+
+void RecordingRenderDevice::WaitForFence(uint64 fence)
+{
+	if (IsFenceComplete(fence))
+		return;
+
+	// Stands for the GPU catching up with every frame up to the fence.
+	++m_stats.FenceStalls;
+	while (!m_frameFences.empty() && m_frameFences.front() < fence)
+		m_frameFences.pop_front();
+	m_completedFence = fence < m_lastFence ? fence : m_lastFence;
+}
+
+void RecordingRenderDevice::BeginQuery(RenderQuery* query)
+{
+	Record(COMMAND_BEGIN_QUERY, GetId<RecordedQuery>(query));
+}
+
+// Answered when a fence inserted now would complete.
+void RecordingRenderDevice::EndQuery(RenderQuery* query)
+{
+	RecordedQuery*	recordedQuery = static_cast<RecordedQuery*>(query);
+	Record(COMMAND_END_QUERY, recordedQuery->Id);
+	recordedQuery->Timestamp = m_gpuTime;
+	recordedQuery->ReadyAfter = m_presents + 1 + m_fenceLatency;
+}
+
+bool RecordingRenderDevice::GetTimestamp(RenderQuery* query, uint64& timestamp)
+{
+	RecordedQuery const*	recordedQuery = static_cast<RecordedQuery const*>(query);
+	if (!recordedQuery->ReadyAfter || m_presents < recordedQuery->ReadyAfter)
+		return false;
+
+	timestamp = recordedQuery->Timestamp;
+	return true;
+}
+
+bool RecordingRenderDevice::GetTimestampFrequency(RenderQuery* query, uint64& frequency, bool& disjoint)
+{
+	RecordedQuery const*	recordedQuery = static_cast<RecordedQuery const*>(query);
+	if (!recordedQuery->ReadyAfter || m_presents < recordedQuery->ReadyAfter)
+		return false;
+
+	frequency = TIMESTAMP_FREQUENCY;
+	disjoint = false;
+	return true;
+}
+
+void RecordingRenderDevice::BeginOverlay()
+{
+}
+
+void RecordingRenderDevice::DrawTextLayout(RenderTextLayout* layout, float x, float y)
+{
+	RecordedTextLayout*	textLayout = static_cast<RecordedTextLayout*>(layout);
+	Record(COMMAND_DRAW_TEXT, textLayout->Id, static_cast<uint32>(textLayout->Text.length()));
+	AdvanceGpuTime(TEXT_COST);
+}
+
+void RecordingRenderDevice::FillRectangle(float x, float y, float width, float height, float const color[4])
+{
+	Record(COMMAND_FILL_RECTANGLE, static_cast<uint32>(x), static_cast<uint32>(y), static_cast<uint32>(width), static_cast<uint32>(height));
+	AdvanceGpuTime(RECTANGLE_COST);
+}
+
+void RecordingRenderDevice::EndOverlay()
+{
+}
+
+void RecordingRenderDevice::SetRenderScale(float scale)
+{
+	m_renderScale = scale;
+}
+
+float RecordingRenderDevice::GetRenderScale() const
+{
+	return m_renderScale;
+}
+
+XMFLOAT2 RecordingRenderDevice::GetOutputSize() const
+{
+	return XMFLOAT2(m_width, m_height);
+}
+
+XMFLOAT2 RecordingRenderDevice::GetLogicalSize() const
+{
+	return XMFLOAT2(m_width, m_height);
+}
+
+XMFLOAT4X4 RecordingRenderDevice::GetOrientationTransform3D() const
+{
+	XMFLOAT4X4	identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	return identity;
+}
+
+bool RecordingRenderDevice::SupportsConstantBufferOffsets() const
+{
+	return true;
+}
+
+bool RecordingRenderDevice::SupportsShaderModel4() const
+{
+	return true;
+}
+
+void RecordingRenderDevice::SetOutputSize(float width, float height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+void RecordingRenderDevice::SetFenceLatency(uint32 frames)
+{
+	m_fenceLatency = frames;
+}
+
+void RecordingRenderDevice::ResetStats()
+{
+	m_stats.Reset();
+	m_resources.store(0);
+	m_resourceBytes.store(0);
+}
+
+std::vector<RecordingRenderDevice::Command> const& RecordingRenderDevice::GetCommands() const
+{
+	return m_commands;
+}
+
+std::vector<RecordingRenderDevice::Command> const& RecordingRenderDevice::GetLastFrameCommands() const
+{
+	return m_lastFrameCommands;
+}
+
+std::vector<uint8> const& RecordingRenderDevice::GetLastFrameUploads() const
+{
+	return m_lastFrameUploads;
+}
+
+RecordingRenderDevice::Stats RecordingRenderDevice::GetStats() const
+{
+	Stats	stats = m_stats;
+	stats.Resources = m_resources.load();
+	stats.ResourceBytes = m_resourceBytes.load();
+	return stats;
+}
+
+uint32 RecordingRenderDevice::NextResourceId()
+{
+	return m_nextResourceId++;
+}
+
+void RecordingRenderDevice::AddResource(uint64 byteSize)
+{
+	m_resources.fetch_add(1);
+	m_resourceBytes.fetch_add(byteSize);
+}
+
+void RecordingRenderDevice::Record(CommandType type, uint32 argument0, uint32 argument1, uint32 argument2, uint32 argument3)
+{
+	Command	command;
+	command.Type = type;
+	command.Arguments[0] = argument0;
+	command.Arguments[1] = argument1;
+	command.Arguments[2] = argument2;
+	command.Arguments[3] = argument3;
+	command.UploadOffset = 0;
+	command.UploadSize = 0;
+	m_commands.push_back(command);
+	++m_stats.Commands[type];
+}
+
+void RecordingRenderDevice::RecordUpload(CommandType type, uint32 bufferId, void const* data, uint32 size)
+{
+	Record(type, bufferId);
+	m_commands.back().UploadOffset = static_cast<uint32>(m_uploads.size());
+	m_commands.back().UploadSize = size;
+
+	uint8 const*	bytes = static_cast<uint8 const*>(data);
+	m_uploads.insert(m_uploads.end(), bytes, bytes + size);
+	m_stats.UploadBytes += size;
+}
\ No newline at end of file
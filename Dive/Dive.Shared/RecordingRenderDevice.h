@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace Dive
+{
+	// Headless RenderDevice: no GPU work, every call is appended to an in-memory command list and
+	// counted, buffer contents are kept so uploads can be inspected. The list holds the frame being
+	// recorded, Present moves it to the last frame and starts a new one. Fences complete a fixed
+	// number of presents after they were inserted, like a GPU running that many frames behind. Queries are
+	// answered the same way, with timestamps from a synthetic GPU clock that every command moves by a rough cost.
+	class RecordingRenderDevice : public RenderDevice
+	{
+	public:
+		enum CommandType
+		{
+			COMMAND_BEGIN_FRAME,
+			COMMAND_PRESENT,
+			COMMAND_SET_INPUT_LAYOUT,
+			COMMAND_SET_VERTEX_SHADER,
+			COMMAND_SET_PIXEL_SHADER,
+			COMMAND_SET_VERTEX_BUFFER,
+			COMMAND_SET_INSTANCE_BUFFER,
+			COMMAND_SET_INDEX_BUFFER,
+			COMMAND_SET_VERTEX_CONSTANT_BUFFER,
+			COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE,
+			COMMAND_SET_PIXEL_TEXTURE,
+			COMMAND_UPDATE_BUFFER,
+			COMMAND_MAP_BUFFER,
+			COMMAND_DRAW_INDEXED,
+			COMMAND_DRAW_INDEXED_INSTANCED,
+			COMMAND_DRAW_TEXT,
+			COMMAND_FILL_RECTANGLE,
+			COMMAND_BEGIN_QUERY,
+			COMMAND_END_QUERY,
+			COMMAND_COUNT
+		};
+
+		// Arguments are resource ids (0 for none) followed by the call's own values.
+		// Buffer uploads point into the frame's upload data.
+		struct Command
+		{
+			CommandType	Type;
+			uint32		Arguments[4];
+			uint32		UploadOffset;
+			uint32		UploadSize;
+		};
+
+		struct Stats
+		{
+			Stats() { Reset(); }
+
+			void	Reset()		{ memset(this, 0, sizeof(Stats)); }
+
+			uint32	Frames;
+			uint32	Commands[COMMAND_COUNT];
+			uint32	Triangles;
+			uint64	UploadBytes;
+			uint32	Resources;
+			uint64	ResourceBytes;
+			// Waits on fences that had not completed yet.
+			uint32	FenceStalls;
+		};
+
+		RecordingRenderDevice(float width, float height);
+
+		virtual std::unique_ptr<RenderBuffer>		CreateBuffer(BufferBinding binding, BufferUsage usage, uint32 byteWidth, void const* initialData) override;
+		virtual std::unique_ptr<RenderVertexShader>	CreateVertexShader(void const* bytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderPixelShader>	CreatePixelShader(void const* bytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderInputLayout>	CreateInputLayout(InputElement const* elements, uint32 elementCount, void const* vertexShaderBytecode, size_t bytecodeLength) override;
+		virtual std::unique_ptr<RenderTextureView>	CreateTextureView(DirectX::ScratchImage const& image) override;
+		virtual std::unique_ptr<RenderTextFormat>	CreateTextFormat(wchar_t const* fontFamily, float fontSize, TextAlignment alignment) override;
+		virtual std::unique_ptr<RenderTextLayout>	CreateTextLayout(std::wstring const& text, RenderTextFormat* format, float maxWidth, float maxHeight, TextMetrics& metrics) override;
+		virtual std::unique_ptr<RenderQuery>		CreateQuery(QueryType type) override;
+		virtual void								ReleaseDeviceDependentResources() override;
+
+		virtual void	BeginFrame(float const clearColor[4]) override;
+		virtual void	Present() override;
+
+		virtual void	SetInputLayout(RenderInputLayout* inputLayout) override;
+		virtual void	SetVertexShader(RenderVertexShader* vertexShader) override;
+		virtual void	SetPixelShader(RenderPixelShader* pixelShader) override;
+		virtual void	SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride) override;
+		virtual void	SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 stride) override;
+		virtual void	SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format) override;
+		virtual void	SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer) override;
+		virtual void	SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size) override;
+		virtual void	SetPixelTexture(uint32 slot, RenderTextureView* textureView) override;
+		virtual void	UpdateBuffer(RenderBuffer* buffer, void const* data) override;
+		virtual void*	MapBuffer(RenderBuffer* buffer, MapMode mode) override;
+		virtual void	UnmapBuffer(RenderBuffer* buffer, uint32 writtenOffset, uint32 writtenSize) override;
+		virtual void	DrawIndexed(uint32 indexCount, uint32 startIndex) override;
+		virtual void	DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance) override;
+
+		virtual uint64	InsertFence() override;
+		virtual bool	IsFenceComplete(uint64 fence) override;
+		virtual void	WaitForFence(uint64 fence) override;
+
+		virtual void	BeginQuery(RenderQuery* query) override;
+		virtual void	EndQuery(RenderQuery* query) override;
+		virtual bool	GetTimestamp(RenderQuery* query, uint64& timestamp) override;
+		virtual bool	GetTimestampFrequency(RenderQuery* query, uint64& frequency, bool& disjoint) override;
+
+		virtual void	BeginOverlay() override;
+		virtual void	DrawTextLayout(RenderTextLayout* layout, float x, float y) override;
+		virtual void	FillRectangle(float x, float y, float width, float height, float const color[4]) override;
+		virtual void	EndOverlay() override;
+
+		virtual void				SetRenderScale(float scale) override;
+		virtual float				GetRenderScale() const override;
+		virtual DirectX::XMFLOAT2	GetOutputSize() const override;
+		virtual DirectX::XMFLOAT2	GetLogicalSize() const override;
+		virtual DirectX::XMFLOAT4X4	GetOrientationTransform3D() const override;
+		virtual bool				SupportsConstantBufferOffsets() const override;
+		virtual bool				SupportsShaderModel4() const override;
+
+		void	SetOutputSize(float width, float height);
+		void	SetFenceLatency(uint32 frames);
+		void	ResetStats();
+
+		std::vector<Command> const&	GetCommands() const;
+		std::vector<Command> const&	GetLastFrameCommands() const;
+		std::vector<uint8> const&	GetLastFrameUploads() const;
+		// A copy, the resource counts are kept apart from the render thread's counts.
+		Stats						GetStats() const;
+
+	private:
+		uint32	NextResourceId();
+		void	AddResource(uint64 byteSize);
+		void	Record(CommandType type, uint32 argument0 = 0, uint32 argument1 = 0, uint32 argument2 = 0, uint32 argument3 = 0);
+		void	RecordUpload(CommandType type, uint32 bufferId, void const* data, uint32 size);
+		void	AdvanceGpuTime(uint64 nanoseconds)		{ m_gpuTime += nanoseconds; }
+
+		float	m_width;
+		float	m_height;
+		float	m_renderScale;
+
+		std::vector<Command>	m_commands;
+		std::vector<uint8>		m_uploads;
+		std::vector<Command>	m_lastFrameCommands;
+		std::vector<uint8>		m_lastFrameUploads;
+		// Render thread only, like the command list.
+		Stats					m_stats;
+
+		std::deque<uint64>	m_frameFences;
+		uint64				m_lastFence;
+		uint64				m_completedFence;
+		uint32				m_fenceLatency;
+		uint64				m_presents;
+		uint64				m_gpuTime;
+
+		// Resources are created from loading threads.
+		std::atomic<uint32>	m_nextResourceId;
+		std::atomic<uint32>	m_resources;
+		std::atomic<uint64>	m_resourceBytes;
+	};
+}
\ No newline at end of file
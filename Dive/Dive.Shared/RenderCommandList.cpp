@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "RenderCommandList.h"
+
+#include <cstring>
+
+using namespace DirectX;
+using namespace Dive;
+
+void RenderCommandList::Clear()
+{
+	m_commands.clear();
+	m_data.clear();
+}
+
+void RenderCommandList::SetInputLayout(RenderInputLayout* inputLayout)
+{
+	Record(COMMAND_SET_INPUT_LAYOUT, inputLayout);
+}
+
+void RenderCommandList::SetVertexShader(RenderVertexShader* vertexShader)
+{
+	Record(COMMAND_SET_VERTEX_SHADER, vertexShader);
+}
+
+void RenderCommandList::SetPixelShader(RenderPixelShader* pixelShader)
+{
+	Record(COMMAND_SET_PIXEL_SHADER, pixelShader);
+}
+
+void RenderCommandList::SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride)
+{
+	Record(COMMAND_SET_VERTEX_BUFFER, vertexBuffer, stride);
+}
+
+void RenderCommandList::SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format)
+{
+	Record(COMMAND_SET_INDEX_BUFFER, indexBuffer, static_cast<uint32>(format));
+}
+
+void RenderCommandList::SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer)
+{
+	Record(COMMAND_SET_VERTEX_CONSTANT_BUFFER, constantBuffer, slot);
+}
+
+void RenderCommandList::SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size)
+{
+	Record(COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE, constantBuffer, slot, offset, size);
+}
+
+void RenderCommandList::SetPixelTexture(uint32 slot, RenderTextureView* textureView)
+{
+	Record(COMMAND_SET_PIXEL_TEXTURE, textureView, slot);
+}
+
+void RenderCommandList::UpdateBuffer(RenderBuffer* buffer, void const* data, uint32 size)
+{
+	uint32 const	offset = static_cast<uint32>(m_data.size());
+	m_data.resize(offset + size);
+	memcpy(&m_data[offset], data, size);
+	Record(COMMAND_UPDATE_BUFFER, buffer, offset);
+}
+
+void RenderCommandList::DrawIndexed(uint32 indexCount, uint32 startIndex)
+{
+	Record(COMMAND_DRAW_INDEXED, nullptr, indexCount, startIndex);
+}
+
+void RenderCommandList::DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance)
+{
+	Record(COMMAND_DRAW_INDEXED_INSTANCED, nullptr, indexCount, instanceCount, startIndex, startInstance);
+}
+
+void RenderCommandList::Execute(RenderDevice& device) const
+{
+	for (auto const& command : m_commands)
+	{
+		uint32 const* const	arguments = command.Arguments;
+		switch (command.Type)
+		{
+		case COMMAND_SET_INPUT_LAYOUT:
+			device.SetInputLayout(static_cast<RenderInputLayout*>(command.Object));
+			break;
+		case COMMAND_SET_VERTEX_SHADER:
+			device.SetVertexShader(static_cast<RenderVertexShader*>(command.Object));
+			break;
+		case COMMAND_SET_PIXEL_SHADER:
+			device.SetPixelShader(static_cast<RenderPixelShader*>(command.Object));
+			break;
+		case COMMAND_SET_VERTEX_BUFFER:
+			device.SetVertexBuffer(static_cast<RenderBuffer*>(command.Object), arguments[0]);
+			break;
+		case COMMAND_SET_INDEX_BUFFER:
+			device.SetIndexBuffer(static_cast<RenderBuffer*>(command.Object), static_cast<DXGI_FORMAT>(arguments[0]));
+			break;
+		case COMMAND_SET_VERTEX_CONSTANT_BUFFER:
+			device.SetVertexConstantBuffer(arguments[0], static_cast<RenderBuffer*>(command.Object));
+			break;
+		case COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE:
+			device.SetVertexConstantBufferRange(arguments[0], static_cast<RenderBuffer*>(command.Object), arguments[1], arguments[2]);
+			break;
+		case COMMAND_SET_PIXEL_TEXTURE:
+			device.SetPixelTexture(arguments[0], static_cast<RenderTextureView*>(command.Object));
+			break;
+		case COMMAND_UPDATE_BUFFER:
+			device.UpdateBuffer(static_cast<RenderBuffer*>(command.Object), &m_data[arguments[0]]);
+			break;
+		case COMMAND_DRAW_INDEXED:
+			device.DrawIndexed(arguments[0], arguments[1]);
+			break;
+		case COMMAND_DRAW_INDEXED_INSTANCED:
+			device.DrawIndexedInstanced(arguments[0], arguments[1], arguments[2], arguments[3]);
+			break;
+		}
+	}
+}
+
+void RenderCommandList::Record(CommandType type, void* object, uint32 a0, uint32 a1, uint32 a2, uint32 a3)
+{
+	Command	command;
+	command.Type = type;
+	command.Object = object;
+	command.Arguments[0] = a0;
+	command.Arguments[1] = a1;
+	command.Arguments[2] = a2;
+	command.Arguments[3] = a3;
+	m_commands.push_back(command);
+}
\ No newline at end of file
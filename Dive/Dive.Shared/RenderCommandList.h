@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace Dive
+{
+	// Device calls recorded on any thread and replayed later on the render thread.
+	// A backend-neutral stand-in for a deferred context: recording only touches the list,
+	// so several lists can be filled at once and executed one after another in order.
+	// Buffer contents passed to UpdateBuffer are copied, everything else is kept by pointer.
+	class RenderCommandList
+	{
+	public:
+		void	Clear();
+
+		void	SetInputLayout(RenderInputLayout* inputLayout);
+		void	SetVertexShader(RenderVertexShader* vertexShader);
+		void	SetPixelShader(RenderPixelShader* pixelShader);
+		void	SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride);
+		void	SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format);
+		void	SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer);
+		void	SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size);
+		void	SetPixelTexture(uint32 slot, RenderTextureView* textureView);
+		void	UpdateBuffer(RenderBuffer* buffer, void const* data, uint32 size);
+		void	DrawIndexed(uint32 indexCount, uint32 startIndex);
+		void	DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance);
+
+		void	Execute(RenderDevice& device) const;
+
+		size_t	GetCommandCount() const		{ return m_commands.size(); }
+
+	private:
+		enum CommandType
+		{
+			COMMAND_SET_INPUT_LAYOUT,
+			COMMAND_SET_VERTEX_SHADER,
+			COMMAND_SET_PIXEL_SHADER,
+			COMMAND_SET_VERTEX_BUFFER,
+			COMMAND_SET_INDEX_BUFFER,
+			COMMAND_SET_VERTEX_CONSTANT_BUFFER,
+			COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE,
+			COMMAND_SET_PIXEL_TEXTURE,
+			COMMAND_UPDATE_BUFFER,
+			COMMAND_DRAW_INDEXED,
+			COMMAND_DRAW_INDEXED_INSTANCED
+		};
+
+		struct Command
+		{
+			CommandType	Type;
+			void*		Object;
+			uint32		Arguments[4];
+		};
+
+		void	Record(CommandType type, void* object, uint32 a0 = 0, uint32 a1 = 0, uint32 a2 = 0, uint32 a3 = 0);
+
+		std::vector<Command>	m_commands;
+		// UpdateBuffer contents, Arguments[0] is the offset of a command's data.
+		std::vector<uint8>		m_data;
+	};
+}
\ No newline at end of file
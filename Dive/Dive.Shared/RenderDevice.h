@@ -0,0 +1,140 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace Dive
+{
+	// Objects handed out by a RenderDevice, only the device that created one can use it.
+	class RenderBuffer { public: virtual ~RenderBuffer() { } };
+	class RenderInputLayout { public: virtual ~RenderInputLayout() { } };
+	class RenderVertexShader { public: virtual ~RenderVertexShader() { } };
+	class RenderPixelShader { public: virtual ~RenderPixelShader() { } };
+	class RenderTextureView { public: virtual ~RenderTextureView() { } };
+	class RenderTextFormat { public: virtual ~RenderTextFormat() { } };
+	class RenderTextLayout { public: virtual ~RenderTextLayout() { } };
+	class RenderQuery { public: virtual ~RenderQuery() { } };
+
+	enum BufferBinding
+	{
+		BIND_VERTEX_BUFFER,
+		BIND_INDEX_BUFFER,
+		BIND_CONSTANT_BUFFER
+	};
+
+	enum BufferUsage
+	{
+		USAGE_IMMUTABLE,
+		USAGE_DEFAULT,
+		USAGE_DYNAMIC
+	};
+
+	enum MapMode
+	{
+		MAP_WRITE_DISCARD,
+		MAP_WRITE_NO_OVERWRITE
+	};
+
+	enum QueryType
+	{
+		QUERY_TIMESTAMP,
+		// Brackets the timestamps of a frame, gives their frequency and whether they can be trusted.
+		QUERY_TIMESTAMP_DISJOINT
+	};
+
+	enum TextAlignment
+	{
+		TEXT_ALIGNMENT_LEADING,
+		TEXT_ALIGNMENT_TRAILING
+	};
+
+	// Slot 0 is the vertex stream, slot 1 the instance stream. InstanceStepRate is 0 for per-vertex data.
+	struct InputElement
+	{
+		char const*	SemanticName;
+		uint32		SemanticIndex;
+		DXGI_FORMAT	Format;
+		uint32		InputSlot;
+		uint32		AlignedByteOffset;
+		uint32		InstanceStepRate;
+	};
+
+	struct TextMetrics
+	{
+		float	Width;
+		float	Height;
+		float	LayoutWidth;
+		float	LayoutHeight;
+	};
+
+	// Everything the render path asks of the GPU. D3D11RenderDevice forwards to DX::DeviceResources,
+	// RecordingRenderDevice keeps the calls in memory so the loop runs without a GPU.
+	// Resources can be created from any thread, everything else belongs to the render thread.
+	class RenderDevice
+	{
+	public:
+		virtual ~RenderDevice() { }
+
+		virtual std::unique_ptr<RenderBuffer>		CreateBuffer(BufferBinding binding, BufferUsage usage, uint32 byteWidth, void const* initialData) = 0;
+		virtual std::unique_ptr<RenderVertexShader>	CreateVertexShader(void const* bytecode, size_t bytecodeLength) = 0;
+		virtual std::unique_ptr<RenderPixelShader>	CreatePixelShader(void const* bytecode, size_t bytecodeLength) = 0;
+		virtual std::unique_ptr<RenderInputLayout>	CreateInputLayout(InputElement const* elements, uint32 elementCount, void const* vertexShaderBytecode, size_t bytecodeLength) = 0;
+		virtual std::unique_ptr<RenderTextureView>	CreateTextureView(DirectX::ScratchImage const& image) = 0;
+		virtual std::unique_ptr<RenderTextFormat>	CreateTextFormat(wchar_t const* fontFamily, float fontSize, TextAlignment alignment) = 0;
+		virtual std::unique_ptr<RenderTextLayout>	CreateTextLayout(std::wstring const& text, RenderTextFormat* format, float maxWidth, float maxHeight, TextMetrics& metrics) = 0;
+		virtual std::unique_ptr<RenderQuery>		CreateQuery(QueryType type) = 0;
+		virtual void								ReleaseDeviceDependentResources() = 0;
+
+		// Binds the back buffer and clears it along with the depth buffer. The depth test passes equal depths,
+		// so a draw shades the pixels its own depth prepass laid down.
+		virtual void	BeginFrame(float const clearColor[4]) = 0;
+		virtual void	Present() = 0;
+
+		virtual void	SetInputLayout(RenderInputLayout* inputLayout) = 0;
+		virtual void	SetVertexShader(RenderVertexShader* vertexShader) = 0;
+		virtual void	SetPixelShader(RenderPixelShader* pixelShader) = 0;
+		virtual void	SetVertexBuffer(RenderBuffer* vertexBuffer, uint32 stride) = 0;
+		virtual void	SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 stride) = 0;
+		virtual void	SetIndexBuffer(RenderBuffer* indexBuffer, DXGI_FORMAT format) = 0;
+		virtual void	SetVertexConstantBuffer(uint32 slot, RenderBuffer* constantBuffer) = 0;
+		// Binds size bytes from offset, both multiples of 256. Only valid when SupportsConstantBufferOffsets.
+		virtual void	SetVertexConstantBufferRange(uint32 slot, RenderBuffer* constantBuffer, uint32 offset, uint32 size) = 0;
+		virtual void	SetPixelTexture(uint32 slot, RenderTextureView* textureView) = 0;
+		virtual void	UpdateBuffer(RenderBuffer* buffer, void const* data) = 0;
+		virtual void*	MapBuffer(RenderBuffer* buffer, MapMode mode) = 0;
+		// writtenOffset and writtenSize are the bytes written since the map, devices may upload only those.
+		virtual void	UnmapBuffer(RenderBuffer* buffer, uint32 writtenOffset, uint32 writtenSize) = 0;
+		// Triangle lists only.
+		virtual void	DrawIndexed(uint32 indexCount, uint32 startIndex) = 0;
+		// Needs feature level 9_3.
+		virtual void	DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32 startIndex, uint32 startInstance) = 0;
+
+		// Fences complete in order, once the GPU has finished everything submitted before them.
+		virtual uint64	InsertFence() = 0;
+		virtual bool	IsFenceComplete(uint64 fence) = 0;
+		virtual void	WaitForFence(uint64 fence) = 0;
+
+		// Timestamps only take End. Results are read without waiting, false until the GPU got past the query.
+		virtual void	BeginQuery(RenderQuery* query) = 0;
+		virtual void	EndQuery(RenderQuery* query) = 0;
+		virtual bool	GetTimestamp(RenderQuery* query, uint64& timestamp) = 0;
+		virtual bool	GetTimestampFrequency(RenderQuery* query, uint64& frequency, bool& disjoint) = 0;
+
+		virtual void	BeginOverlay() = 0;
+		virtual void	DrawTextLayout(RenderTextLayout* layout, float x, float y) = 0;
+		// Color is RGBA, the rectangle in DIPs like the text.
+		virtual void	FillRectangle(float x, float y, float width, float height, float const color[4]) = 0;
+		virtual void	EndOverlay() = 0;
+
+		// Fraction of the output size the frame is rendered at, stretched over the window when presented.
+		virtual void				SetRenderScale(float scale) = 0;
+		virtual float				GetRenderScale() const = 0;
+		virtual DirectX::XMFLOAT2	GetOutputSize() const = 0;
+		virtual DirectX::XMFLOAT2	GetLogicalSize() const = 0;
+		virtual DirectX::XMFLOAT4X4	GetOrientationTransform3D() const = 0;
+		// Constant buffer ranges and no-overwrite maps of dynamic constant buffers, D3D11.1 features missing from some 9_x drivers.
+		virtual bool				SupportsConstantBufferOffsets() const = 0;
+		// Feature level 10 and up, level 9 shaders are limited to 256 vertex shader constant registers.
+		virtual bool				SupportsShaderModel4() const = 0;
+	};
+}
\ No newline at end of file
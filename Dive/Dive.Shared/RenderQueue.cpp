@@ -0,0 +1,531 @@
+#include "pch.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstring>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	int const	PASS_SHIFT = 60;
+	int const	BUCKET_SHIFT = 54;
+	int const	SHADER_SHIFT = 44;
+	int const	MATERIAL_SHIFT = 32;
+	int const	TEXTURE_SHIFT = 16;
+	int const	DEPTH_SHIFT = 0;
+
+	uint64 const	PASS_MASK = 0xF;
+	uint64 const	BUCKET_MASK = 0x3F;
+	uint64 const	SHADER_MASK = 0x3FF;
+	uint64 const	MATERIAL_MASK = 0xFFF;
+	uint64 const	TEXTURE_MASK = 0xFFFF;
+	uint64 const	DEPTH_MASK = 0xFFFF;
+
+	int const	RADIX_BITS = 8;
+	int const	RADIX_SIZE = 1 << RADIX_BITS;
+	int const	RADIX_PASSES = 64 / RADIX_BITS;
+
+	uint32 const	DRAW_CONSTANTS_SIZE = (sizeof(ModelViewProjectionConstantBuffer) + ConstantBufferRing::Alignment - 1) & ~(ConstantBufferRing::Alignment - 1);
+	// Fewer draws than this per list do not pay for handing the list to another thread.
+	uint32 const	MIN_DRAWS_PER_LIST = 256;
+
+	void AddStats(RenderStats& total, RenderStats const& stats)
+	{
+		total.DrawCalls += stats.DrawCalls;
+		total.Triangles += stats.Triangles;
+		total.ShaderChanges += stats.ShaderChanges;
+		total.GeometryChanges += stats.GeometryChanges;
+		total.TextureChanges += stats.TextureChanges;
+		total.MaterialChanges += stats.MaterialChanges;
+		total.ConstantUpdates += stats.ConstantUpdates;
+		total.InstancedDrawCalls += stats.InstancedDrawCalls;
+		total.Instances += stats.Instances;
+		total.DepthPassDrawCalls += stats.DepthPassDrawCalls;
+		total.DepthPassTriangles += stats.DepthPassTriangles;
+		total.UploadBytes += stats.UploadBytes;
+	}
+
+	RenderQueue::Pass GetPass(uint64 key)
+	{
+		return static_cast<RenderQueue::Pass>((key >> PASS_SHIFT) & PASS_MASK);
+	}
+
+	uint32 GetDepth(uint64 key)
+	{
+		return static_cast<uint32>((key >> DEPTH_SHIFT) & DEPTH_MASK);
+	}
+
+	// Logarithmic, 4 buckets per doubling of the depth, so near draws are told apart as well as far ones
+	// relative to their distance.
+	uint64 GetDepthBucket(uint64 key)
+	{
+		uint32 const	depth = GetDepth(key);
+		if (depth < 4)
+			return depth;
+
+		uint32	highBit = 2;
+		while (depth >> (highBit + 1))
+			++highBit;
+		return (highBit - 1) * 4 + ((depth >> (highBit - 2)) & 3);
+	}
+}
+
+uint64 RenderQueue::MakeSortKey(Pass pass, uint32 shader, uint32 material, uint32 textureSet, float normalizedDepth)
+{
+	if (normalizedDepth < 0.0f)
+		normalizedDepth = 0.0f;
+	else if (normalizedDepth > 1.0f)
+		normalizedDepth = 1.0f;
+	uint64 const	depth = static_cast<uint64>(normalizedDepth * DEPTH_MASK);
+
+	return ((static_cast<uint64>(pass) & PASS_MASK) << PASS_SHIFT) |
+		   ((static_cast<uint64>(shader) & SHADER_MASK) << SHADER_SHIFT) |
+		   ((static_cast<uint64>(material) & MATERIAL_MASK) << MATERIAL_SHIFT) |
+		   ((static_cast<uint64>(textureSet) & TEXTURE_MASK) << TEXTURE_SHIFT) |
+		   ((depth & DEPTH_MASK) << DEPTH_SHIFT);
+}
+
+bool RenderQueue::BatchKey::operator==(BatchKey const& other) const
+{
+	return Program == other.Program && Texture == other.Texture && VertexBuffer == other.VertexBuffer && IndexBuffer == other.IndexBuffer &&
+		   StartIndex == other.StartIndex && IndexCount == other.IndexCount && MaterialIndex == other.MaterialIndex;
+}
+
+size_t RenderQueue::BatchKeyHash::operator()(BatchKey const& key) const
+{
+	std::hash<void const*> const	pointerHash;
+	size_t	hash = pointerHash(key.VertexBuffer);
+	hash = hash * 31 + pointerHash(key.IndexBuffer);
+	hash = hash * 31 + pointerHash(key.Texture);
+	hash = hash * 31 + pointerHash(key.Program);
+	hash = hash * 31 + key.StartIndex;
+	hash = hash * 31 + key.IndexCount;
+	return hash * 31 + key.MaterialIndex;
+}
+
+RenderQueue::RenderQueue() :
+m_sortEnabled(true),
+m_frontToBack(false),
+m_instanceBuffer(nullptr),
+m_instanceCapacity(0),
+m_constantRing(nullptr),
+m_recordingThreads(JobSystem::Get().GetWorkerCount() + 1)
+{
+}
+
+void RenderQueue::Clear()
+{
+	m_items.clear();
+	m_order.clear();
+}
+
+void RenderQueue::Submit(DrawItem const& item)
+{
+	SortEntry	entry;
+	entry.Key = item.SortKey;
+	entry.Index = static_cast<uint32>(m_items.size());
+	m_order.push_back(entry);
+	m_items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	m_stats.Reset();
+	m_stats.UnsortedStateChanges = CountStateChanges();
+
+	if (m_sortEnabled)
+	{
+		if (m_frontToBack)
+			AssignDepthBuckets();
+		RadixSort();
+	}
+
+	BuildBatches();
+	m_stats.DepthInversions = CountDepthInversions();
+}
+
+void RenderQueue::SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 capacity)
+{
+	m_instanceBuffer = instanceBuffer;
+	m_instanceCapacity = instanceBuffer ? capacity : 0;
+}
+
+void RenderQueue::Execute(RenderDevice& device, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants)
+{
+	WriteInstances(device);
+	uint32 const	listCount = SplitBatches(AllocateConstants());
+
+	// Lists only write to their own memory and to disjoint ring ranges, so they record independently.
+	auto const	record = [&](uint32 list) { RecordBatches(*m_recorders[list], constantBuffer, constants); };
+	if (listCount > 1)
+		JobSystem::Get().ParallelFor(0, listCount, 1, record);
+	else if (listCount)
+		record(0);
+
+	if (m_constantRing)
+		m_constantRing->Unmap();
+
+	DIVE_PROFILE_SCOPE("Replay command lists");
+	for (uint32 list = 0; list < listCount; ++list)
+	{
+		Recorder const&	recorder = *m_recorders[list];
+		recorder.List.Execute(device);
+		AddStats(m_stats, recorder.Stats);
+	}
+	m_stats.CommandLists = listCount;
+
+	if (listCount && m_recorders[listCount - 1]->State.ConstantOffset != NoOffset)
+		device.SetVertexConstantBuffer(0, constantBuffer);
+}
+
+void RenderQueue::RecordBatches(Recorder& recorder, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants)
+{
+	DIVE_PROFILE_SCOPE("Record batches");
+	recorder.List.Clear();
+	recorder.State = BoundState();
+	recorder.State.Draw = m_batches[recorder.FirstBatch].FirstDraw;
+	// Execute is entered with the caller's constant buffer bound.
+	if (!recorder.FirstBatch)
+		recorder.State.ConstantOffset = NoOffset;
+	recorder.Stats.Reset();
+
+	RenderCommandList&	list = recorder.List;
+	RenderStats&		stats = recorder.Stats;
+
+	ModelViewProjectionConstantBuffer	drawConstants = constants;
+	for (auto b = recorder.FirstBatch; b < recorder.EndBatch; ++b)
+	{
+		Batch const&	batch = m_batches[b];
+		DrawItem const&	first = m_items[m_batchItems[batch.First]];
+
+		// One constant update covers the whole batch, the instanced program only reads the material from it.
+		if (batch.StartInstance != NoInstance)
+		{
+			Bind(recorder, first, first.InstancedProgram);
+
+			drawConstants.MaterialIndex = static_cast<float>(first.MaterialIndex);
+			SetDrawConstants(recorder, constantBuffer, drawConstants);
+
+			list.DrawIndexedInstanced(first.IndexCount, batch.Count, first.StartIndex, batch.StartInstance);
+			++stats.DrawCalls;
+			++stats.InstancedDrawCalls;
+			stats.Instances += batch.Count;
+			stats.Triangles += first.IndexCount / 3 * batch.Count;
+			if (GetPass(first.SortKey) == PASS_DEPTH)
+			{
+				++stats.DepthPassDrawCalls;
+				stats.DepthPassTriangles += first.IndexCount / 3 * batch.Count;
+			}
+			continue;
+		}
+
+		for (auto i = batch.First; i < batch.First + batch.Count; ++i)
+		{
+			DrawItem const&	item = m_items[m_batchItems[i]];
+			Bind(recorder, item, item.Program);
+
+			drawConstants.Model = item.Model;
+			drawConstants.MaterialIndex = static_cast<float>(item.MaterialIndex);
+			SetDrawConstants(recorder, constantBuffer, drawConstants);
+
+			list.DrawIndexed(item.IndexCount, item.StartIndex);
+			++stats.DrawCalls;
+			stats.Triangles += item.IndexCount / 3;
+			if (GetPass(item.SortKey) == PASS_DEPTH)
+			{
+				++stats.DepthPassDrawCalls;
+				stats.DepthPassTriangles += item.IndexCount / 3;
+			}
+		}
+	}
+}
+
+void RenderQueue::Bind(Recorder& recorder, DrawItem const& item, ShaderProgram const* program)
+{
+	RenderCommandList&	list = recorder.List;
+	BoundState&			state = recorder.State;
+	RenderStats&		stats = recorder.Stats;
+
+	if (program != state.Program)
+	{
+		// Programs may share objects, a depth program only differs from its opaque one in the pixel shader.
+		ShaderProgram const*	bound = state.Program;
+		if (!bound || program->InputLayout != bound->InputLayout)
+			list.SetInputLayout(program->InputLayout.get());
+		if (!bound || program->VertexShader != bound->VertexShader)
+			list.SetVertexShader(program->VertexShader.get());
+		if (!bound || program->PixelShader != bound->PixelShader)
+			list.SetPixelShader(program->PixelShader.get());
+		state.Program = program;
+		++stats.ShaderChanges;
+	}
+
+	if (item.VertexBuffer != state.VertexBuffer || item.IndexBuffer != state.IndexBuffer)
+	{
+		list.SetVertexBuffer(item.VertexBuffer, item.VertexStride);
+		list.SetIndexBuffer(item.IndexBuffer, item.IndexFormat);
+		state.VertexBuffer = item.VertexBuffer;
+		state.IndexBuffer = item.IndexBuffer;
+		++stats.GeometryChanges;
+	}
+
+	if (item.Texture != state.Texture)
+	{
+		list.SetPixelTexture(0, item.Texture);
+		state.Texture = item.Texture;
+		++stats.TextureChanges;
+	}
+
+	// The material only costs its index in the per-draw constants.
+	if (item.MaterialIndex != state.Material)
+	{
+		state.Material = item.MaterialIndex;
+		++stats.MaterialChanges;
+	}
+}
+
+// Numbers the draw calls and reserves ring space for each up front. The ring cannot be mapped
+// from the recording threads, they fill the reserved ranges through the returned pointers.
+uint32 RenderQueue::AllocateConstants()
+{
+	uint32	drawCount = 0;
+	for (auto& batch : m_batches)
+	{
+		batch.FirstDraw = drawCount;
+		drawCount += batch.StartInstance != NoInstance ? 1 : batch.Count;
+	}
+
+	m_drawConstants.clear();
+	if (!m_constantRing || !m_constantRing->IsAvailable())
+		return drawCount;
+
+	m_drawConstants.resize(drawCount);
+	for (auto& draw : m_drawConstants)
+		draw.Data = m_constantRing->Allocate(sizeof(ModelViewProjectionConstantBuffer), draw.Offset);
+	return drawCount;
+}
+
+// Cuts the batches into contiguous runs of about the same number of draw calls, one per command list.
+uint32 RenderQueue::SplitBatches(uint32 drawCount)
+{
+	uint32	listCount = drawCount / MIN_DRAWS_PER_LIST;
+	if (listCount > m_recordingThreads)
+		listCount = m_recordingThreads;
+	if (!listCount && drawCount)
+		listCount = 1;
+
+	while (m_recorders.size() < listCount)
+		m_recorders.push_back(std::unique_ptr<Recorder>(new Recorder()));
+
+	uint32	batch = 0;
+	for (uint32 list = 0; list < listCount; ++list)
+	{
+		uint32 const	endDraw = static_cast<uint32>(static_cast<uint64>(drawCount) * (list + 1) / listCount);
+		m_recorders[list]->FirstBatch = batch;
+		while (batch < m_batches.size() && m_batches[batch].FirstDraw < endDraw)
+			++batch;
+		m_recorders[list]->EndBatch = batch;
+	}
+	return listCount;
+}
+
+void RenderQueue::SetDrawConstants(Recorder& recorder, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants)
+{
+	BoundState&	state = recorder.State;
+	DrawConstants const* const	draw = state.Draw < m_drawConstants.size() ? &m_drawConstants[state.Draw] : nullptr;
+	++state.Draw;
+	++recorder.Stats.ConstantUpdates;
+	recorder.Stats.UploadBytes += sizeof(constants);
+
+	if (draw && draw->Data)
+	{
+		memcpy(draw->Data, &constants, sizeof(constants));
+		recorder.List.SetVertexConstantBufferRange(0, m_constantRing->GetBuffer(), draw->Offset, DRAW_CONSTANTS_SIZE);
+		state.ConstantOffset = draw->Offset;
+		return;
+	}
+
+	if (state.ConstantOffset != NoOffset)
+	{
+		recorder.List.SetVertexConstantBuffer(0, constantBuffer);
+		state.ConstantOffset = NoOffset;
+	}
+	recorder.List.UpdateBuffer(constantBuffer, &constants, sizeof(constants));
+}
+
+// Groups the sorted draws sharing their geometry range, material, texture and instanced program.
+// A batch sits where its first draw was sorted, the draws it absorbs are pulled forward to it.
+void RenderQueue::BuildBatches()
+{
+	m_batches.clear();
+	m_batchLookup.clear();
+	m_itemBatches.resize(m_order.size());
+
+	for (size_t i = 0; i < m_order.size(); ++i)
+	{
+		DrawItem const&	item = m_items[m_order[i].Index];
+
+		uint32	batchIndex = static_cast<uint32>(m_batches.size());
+		if (m_instanceBuffer && item.InstancedProgram)
+		{
+			BatchKey	key;
+			key.Program = item.InstancedProgram;
+			key.Texture = item.Texture;
+			key.VertexBuffer = item.VertexBuffer;
+			key.IndexBuffer = item.IndexBuffer;
+			key.StartIndex = item.StartIndex;
+			key.IndexCount = item.IndexCount;
+			key.MaterialIndex = item.MaterialIndex;
+			batchIndex = m_batchLookup.insert(std::make_pair(key, batchIndex)).first->second;
+		}
+
+		if (batchIndex == m_batches.size())
+		{
+			Batch	batch;
+			batch.First = 0;
+			batch.Count = 0;
+			batch.StartInstance = NoInstance;
+			batch.FirstDraw = 0;
+			m_batches.push_back(batch);
+		}
+		++m_batches[batchIndex].Count;
+		m_itemBatches[i] = batchIndex;
+	}
+
+	uint32	offset = 0;
+	for (auto& batch : m_batches)
+	{
+		batch.First = offset;
+		offset += batch.Count;
+		batch.Count = 0;
+	}
+
+	m_batchItems.resize(m_order.size());
+	for (size_t i = 0; i < m_order.size(); ++i)
+	{
+		Batch&	batch = m_batches[m_itemBatches[i]];
+		m_batchItems[batch.First + batch.Count++] = m_order[i].Index;
+	}
+}
+
+// Batches that do not fit in the instance buffer any more fall back to separate draws.
+void RenderQueue::WriteInstances(RenderDevice& device)
+{
+	uint32	instanceCount = 0;
+	for (auto& batch : m_batches)
+	{
+		batch.StartInstance = NoInstance;
+		if (batch.Count >= MinInstances && instanceCount + batch.Count <= m_instanceCapacity)
+		{
+			batch.StartInstance = instanceCount;
+			instanceCount += batch.Count;
+		}
+	}
+
+	if (!instanceCount)
+		return;
+
+	InstanceData* const	instances = static_cast<InstanceData*>(device.MapBuffer(m_instanceBuffer, MAP_WRITE_DISCARD));
+	for (auto const& batch : m_batches)
+	{
+		if (batch.StartInstance == NoInstance)
+			continue;
+		for (uint32 i = 0; i < batch.Count; ++i)
+			instances[batch.StartInstance + i].Model = m_items[m_batchItems[batch.First + i]].Model;
+	}
+	device.UnmapBuffer(m_instanceBuffer, 0, instanceCount * sizeof(InstanceData));
+	m_stats.UploadBytes += instanceCount * sizeof(InstanceData);
+	device.SetInstanceBuffer(m_instanceBuffer, sizeof(InstanceData));
+}
+
+uint32 RenderQueue::CountStateChanges() const
+{
+	uint32	changes = 0;
+	DrawItem const*	previous = nullptr;
+	for (auto const& item : m_items)
+	{
+		if (!previous || item.Program != previous->Program)
+			++changes;
+		if (!previous || item.VertexBuffer != previous->VertexBuffer || item.IndexBuffer != previous->IndexBuffer)
+			++changes;
+		if (previous ? item.Texture != previous->Texture : item.Texture != nullptr)
+			++changes;
+		if (!previous || item.MaterialIndex != previous->MaterialIndex)
+			++changes;
+		previous = &item;
+	}
+	return changes;
+}
+
+// In the order the batches issue them.
+uint32 RenderQueue::CountDepthInversions() const
+{
+	uint32	inversions = 0;
+	uint64	farthestBucket = 0;
+	for (auto index : m_batchItems)
+	{
+		uint64 const	key = m_items[index].SortKey;
+		if (GetPass(key) != PASS_OPAQUE)
+			continue;
+
+		uint64 const	bucket = GetDepthBucket(key);
+		if (bucket < farthestBucket)
+			++inversions;
+		else
+			farthestBucket = bucket;
+	}
+	return inversions;
+}
+
+void RenderQueue::AssignDepthBuckets()
+{
+	for (auto& entry : m_order)
+	{
+		Pass const	pass = GetPass(entry.Key);
+		if (pass == PASS_DEPTH || pass == PASS_OPAQUE)
+			entry.Key |= (GetDepthBucket(entry.Key) & BUCKET_MASK) << BUCKET_SHIFT;
+	}
+}
+
+// LSD radix sort, one byte per pass. Passes where every key has the same byte are skipped,
+// which is the common case for the pass and unused bits.
+void RenderQueue::RadixSort()
+{
+	size_t const	count = m_order.size();
+	if (count < 2)
+		return;
+
+	m_sortScratch.resize(count);
+	SortEntry*	source = m_order.data();
+	SortEntry*	destination = m_sortScratch.data();
+
+	for (auto pass = 0; pass < RADIX_PASSES; ++pass)
+	{
+		int const	shift = pass * RADIX_BITS;
+		size_t		histogram[RADIX_SIZE] = { 0 };
+		for (size_t i = 0; i < count; ++i)
+			++histogram[(source[i].Key >> shift) & (RADIX_SIZE - 1)];
+
+		if (histogram[(source[0].Key >> shift) & (RADIX_SIZE - 1)] == count)
+			continue;
+
+		size_t	offset = 0;
+		for (auto bucket = 0; bucket < RADIX_SIZE; ++bucket)
+		{
+			size_t const	bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			destination[histogram[(source[i].Key >> shift) & (RADIX_SIZE - 1)]++] = source[i];
+
+		std::swap(source, destination);
+	}
+
+	if (source != m_order.data())
+		m_order.swap(m_sortScratch);
+}
\ No newline at end of file
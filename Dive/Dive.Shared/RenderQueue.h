@@ -0,0 +1,219 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ConstantBufferRing.h"
+#include "RenderCommandList.h"
+#include "RenderDevice.h"
+#include "ShaderStructures.h"
+
+namespace Dive
+{
+	struct ShaderProgram
+	{
+		ShaderProgram() : Id(0) { }
+
+		uint32									Id;
+		std::shared_ptr<RenderInputLayout>		InputLayout;
+		std::shared_ptr<RenderVertexShader>		VertexShader;
+		std::shared_ptr<RenderPixelShader>		PixelShader;
+	};
+
+	// One submesh draw. The sort key orders the queue, the remaining fields are the
+	// state the draw needs and are compared against what is bound to skip redundant changes.
+	// InstancedProgram reads the model matrix from the instance stream, nullptr keeps the draw out of instancing.
+	struct DrawItem
+	{
+		uint64					SortKey;
+		ShaderProgram const*	Program;
+		ShaderProgram const*	InstancedProgram;
+		RenderTextureView*		Texture;
+		RenderBuffer*			VertexBuffer;
+		RenderBuffer*			IndexBuffer;
+		DXGI_FORMAT				IndexFormat;
+		uint32					VertexStride;
+		uint32					IndexCount;
+		uint32					StartIndex;
+		uint32					MaterialIndex;
+		DirectX::XMFLOAT4X4		Model;
+	};
+
+	struct RenderStats
+	{
+		RenderStats() { Reset(); }
+
+		void	Reset()								{ ZeroMemory(this, sizeof(RenderStats)); }
+		uint32	GetStateChanges() const				{ return ShaderChanges + GeometryChanges + TextureChanges + MaterialChanges; }
+
+		uint32	DrawCalls;
+		uint32	Triangles;
+		uint32	ShaderChanges;
+		uint32	GeometryChanges;
+		uint32	TextureChanges;
+		uint32	MaterialChanges;
+		uint32	ConstantUpdates;
+		uint32	InstancedDrawCalls;
+		uint32	Instances;
+		uint32	CommandLists;
+		// Written to buffers by the CPU: draw constants, instances and cluster indices.
+		uint32	UploadBytes;
+		uint32	DepthPassDrawCalls;
+		uint32	DepthPassTriangles;
+		// Opaque draws issued after one at least a depth bucket further away, they may shade pixels over again.
+		uint32	DepthInversions;
+		// State changes the same draws would have cost in submission order.
+		uint32	UnsortedStateChanges;
+	};
+
+	class RenderQueue
+	{
+	public:
+		enum Pass
+		{
+			PASS_DEPTH,
+			PASS_OPAQUE,
+			PASS_TRANSPARENT,
+			PASS_OVERLAY
+		};
+
+		// Key layout, most significant first:
+		// pass (4) | depth bucket (6) | shader (10) | material (12) | texture set (16) | depth (16)
+		// The depth bucket is left at 0 here, Sort fills it in for depth and opaque draws when front to back is on.
+		static uint64	MakeSortKey(Pass pass, uint32 shader, uint32 material, uint32 textureSet, float normalizedDepth);
+
+		// Fewer draws than this sharing geometry, material and texture are not worth an instanced draw.
+		static uint32 const	MinInstances = 2;
+
+		RenderQueue();
+
+		void	Clear();
+		void	Submit(DrawItem const& item);
+		void	Sort();
+		// Records the sorted draws into command lists, in parallel once there are enough of them,
+		// and replays the lists on device in sort order.
+		void	Execute(RenderDevice& device, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants);
+
+		void	SetSortEnabled(bool sortEnabled)	{ m_sortEnabled = sortEnabled; }
+		bool	IsSortEnabled() const				{ return m_sortEnabled; }
+		// Orders depth and opaque draws by coarse depth before state, so they hide more of what follows them.
+		void	SetFrontToBack(bool frontToBack)	{ m_frontToBack = frontToBack; }
+		bool	IsFrontToBack() const				{ return m_frontToBack; }
+		// Dynamic vertex buffer of capacity InstanceData elements, rewritten every Execute. nullptr turns instancing off.
+		void	SetInstanceBuffer(RenderBuffer* instanceBuffer, uint32 capacity);
+		// Per-draw constants are written to the ring and bound by offset, the caller's constant buffer
+		// is only updated for draws the ring has no room for. nullptr updates it for every draw.
+		void	SetConstantRing(ConstantBufferRing* constantRing)	{ m_constantRing = constantRing; }
+		// Most command lists Execute records at once, 1 records everything on the calling thread.
+		void	SetRecordingThreads(uint32 threadCount)		{ m_recordingThreads = threadCount ? threadCount : 1; }
+		size_t	GetDrawCount() const				{ return m_items.size(); }
+		RenderStats const&	GetStats() const		{ return m_stats; }
+		// Counts bytes the caller uploaded for the draws of this frame.
+		void	AddUploadBytes(uint32 bytes)		{ m_stats.UploadBytes += bytes; }
+
+	private:
+		struct SortEntry
+		{
+			uint64	Key;
+			uint32	Index;
+		};
+
+		// Consecutive entries of m_batchItems drawn together, StartInstance is NoInstance for separate draws.
+		// FirstDraw counts the draw calls issued before the batch.
+		struct Batch
+		{
+			uint32	First;
+			uint32	Count;
+			uint32	StartInstance;
+			uint32	FirstDraw;
+		};
+
+		struct BatchKey
+		{
+			bool	operator==(BatchKey const& other) const;
+
+			ShaderProgram const*	Program;
+			RenderTextureView*		Texture;
+			RenderBuffer*			VertexBuffer;
+			RenderBuffer*			IndexBuffer;
+			uint32					StartIndex;
+			uint32					IndexCount;
+			uint32					MaterialIndex;
+		};
+
+		struct BatchKeyHash
+		{
+			size_t	operator()(BatchKey const& key) const;
+		};
+
+		struct BoundState
+		{
+			BoundState() : Program(nullptr), VertexBuffer(nullptr), IndexBuffer(nullptr), Texture(nullptr), Material(uint32(-1)), Draw(0), ConstantOffset(UnknownOffset) { }
+
+			ShaderProgram const*	Program;
+			RenderBuffer*			VertexBuffer;
+			RenderBuffer*			IndexBuffer;
+			RenderTextureView*		Texture;
+			uint32					Material;
+			uint32					Draw;
+			// Offset of the ring range bound to slot 0, NoOffset while the caller's buffer is bound.
+			// A list cannot know what the list replayed before it left bound.
+			uint32					ConstantOffset;
+		};
+
+		// One command list and the state it was recorded against, covering batches [FirstBatch, EndBatch).
+		struct Recorder
+		{
+			RenderCommandList	List;
+			BoundState			State;
+			RenderStats			Stats;
+			uint32				FirstBatch;
+			uint32				EndBatch;
+		};
+
+		// Ring memory of one draw's constants, Data is nullptr for draws the ring had no room for.
+		struct DrawConstants
+		{
+			void*	Data;
+			uint32	Offset;
+		};
+
+		static uint32 const	NoInstance = uint32(-1);
+		static uint32 const	NoOffset = uint32(-1);
+		static uint32 const	UnknownOffset = uint32(-2);
+
+		uint32	CountStateChanges() const;
+		uint32	CountDepthInversions() const;
+		void	AssignDepthBuckets();
+		void	RadixSort();
+		void	BuildBatches();
+		void	WriteInstances(RenderDevice& device);
+		uint32	AllocateConstants();
+		uint32	SplitBatches(uint32 drawCount);
+		void	RecordBatches(Recorder& recorder, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants);
+		void	SetDrawConstants(Recorder& recorder, RenderBuffer* constantBuffer, ModelViewProjectionConstantBuffer const& constants);
+		void	Bind(Recorder& recorder, DrawItem const& item, ShaderProgram const* program);
+
+		std::vector<DrawItem>	m_items;
+		std::vector<SortEntry>	m_order;
+		std::vector<SortEntry>	m_sortScratch;
+		RenderStats				m_stats;
+		bool					m_sortEnabled;
+		bool					m_frontToBack;
+
+		std::vector<Batch>									m_batches;
+		std::vector<uint32>									m_batchItems;
+		std::vector<uint32>									m_itemBatches;
+		std::unordered_map<BatchKey, uint32, BatchKeyHash>	m_batchLookup;
+		RenderBuffer*										m_instanceBuffer;
+		uint32												m_instanceCapacity;
+
+		ConstantBufferRing*			m_constantRing;
+		// Ring memory of every draw Execute issues, in issue order.
+		std::vector<DrawConstants>	m_drawConstants;
+
+		std::vector<std::unique_ptr<Recorder>>	m_recorders;
+		uint32									m_recordingThreads;
+	};
+}
\ No newline at end of file
@@ -1,29 +1,58 @@
 #include "pch.h"
 #include "Sample3DRenderer.h"
 #include "fbxsdk.h"
-#include "Common/directxhelper.h"
+#include "AsyncFile.h"
+#include "Profiler.h"
 
 using namespace Dive;
 
 using namespace DirectX;
-using namespace Windows::Foundation;
 
-Sample3DRenderer::Sample3DRenderer(std::shared_ptr<DX::DeviceResources> const& deviceResources) :
+namespace
+{
+	float const		NEAR_PLANE = 0.01f;
+	float const		FAR_PLANE = 100.0f;
+	uint32 const	MAX_INSTANCES = 4096;
+	// Room for 256 draws a frame, the ring grows past that on its own.
+	uint32 const	CONSTANT_RING_FRAME_SIZE = 64 * 1024;
+
+#if !defined(DIVE_COROUTINES)
+	Concurrency::task<std::vector<uint8>> ReadShaderAsync(std::string const& filename)
+	{
+		return Concurrency::create_task([filename]() { return ReadFileBytes(filename); });
+	}
+#endif
+}
+
+Sample3DRenderer::Sample3DRenderer(std::shared_ptr<RenderDevice> const& renderDevice) :
 m_loadingComplete(false),
+m_depthPrepass(false),
 m_degreesPerSeconds(45.0f),
+m_previousRotation(0.0),
+m_rotation(0.0),
 m_indexCount(0),
-m_deviceResources(deviceResources)
+m_renderedSlot(0),
+m_renderDevice(renderDevice),
+m_constantRing(renderDevice, CONSTANT_RING_FRAME_SIZE)
 {
-	CreateDeviceDependantResources();
-	CreateWindowSizeDependantResources();
 	m_fbxManager = new FBXManager();
 	m_fbxManager->Initialize();
+	m_materialTable = std::make_shared<MaterialTable>(m_renderDevice);
+	m_constantBufferData.MaterialIndex = static_cast<float>(MaterialTable::DefaultMaterial);
+	for (auto& frame : m_frames)
+	{
+		frame.Queue.SetConstantRing(&m_constantRing);
+		frame.Queue.SetFrontToBack(true);
+	}
+
+	CreateDeviceDependantResources();
+	CreateWindowSizeDependantResources();
 }
 
 void Sample3DRenderer::CreateWindowSizeDependantResources()
 {
-	Size	outputSize = m_deviceResources->GetOutputSize();
-	float	aspectRatio = outputSize.Width / outputSize.Height;
+	XMFLOAT2	outputSize = m_renderDevice->GetOutputSize();
+	float		aspectRatio = outputSize.x / outputSize.y;
 	float	fovAngleY = 70.0f * XM_PI / 180.0f;
 
 	if (aspectRatio < 1.0f)
@@ -32,11 +61,11 @@ void Sample3DRenderer::CreateWindowSizeDependantResources()
 	XMMATRIX	perspectiveMatrix = XMMatrixPerspectiveFovRH(
 		fovAngleY,
 		aspectRatio,
-		0.01f,
-		100.0f
+		NEAR_PLANE,
+		FAR_PLANE
 		);
 
-	XMFLOAT4X4	orientation = m_deviceResources->GetOrientationTransform3D();
+	XMFLOAT4X4	orientation = m_renderDevice->GetOrientationTransform3D();
 
 	XMMATRIX	orientationMatrix = XMLoadFloat4x4(&orientation);
 
@@ -52,247 +81,324 @@ void Sample3DRenderer::CreateWindowSizeDependantResources()
 	XMStoreFloat4x4(&m_constantBufferData.View, XMMatrixTranspose(XMMatrixLookAtRH(eye, at, up)));
 }
 
-void Sample3DRenderer::Update(DX::StepTimer const& timer)
+void Sample3DRenderer::Step(DX::StepTimer const& timer)
 {
 	float	radiansPerSecond = XMConvertToRadians(m_degreesPerSeconds);
-	double	totalRotation = timer.GetTotalSeconds() * radiansPerSecond;
+
+	m_previousRotation = m_rotation;
+	m_rotation = timer.GetTotalSeconds() * radiansPerSecond;
+}
+
+void Sample3DRenderer::Update(DX::StepTimer const& timer)
+{
+	double	alpha = timer.GetInterpolationAlpha();
+	double	totalRotation = m_previousRotation + (m_rotation - m_previousRotation) * alpha;
 	float	radians = static_cast<float>(fmod(totalRotation, XM_2PI));
 
 	Rotate(radians);
 }
 
-void Sample3DRenderer::Render()
+void Sample3DRenderer::Capture(uint32 slot)
 {
+	m_snapshots[slot] = m_constantBufferData;
+}
+
+void Sample3DRenderer::Prepare(uint32 slot)
+{
+	PreparedFrame&	frame = m_frames[slot];
+	frame.Prepared = false;
 	if (!m_loadingComplete)
 		return;
 
-	auto	context = m_deviceResources->GetD3DDeviceContext();
+	frame.Constants = m_snapshots[slot];
+	frame.Queue.Clear();
+
+	DrawItem	cube;
+	cube.Program = &m_shaderProgram;
+	cube.InstancedProgram = nullptr;
+	cube.Texture = nullptr;
+	cube.VertexBuffer = m_vertexBuffer.get();
+	cube.IndexBuffer = m_indexBuffer.get();
+	cube.IndexFormat = DXGI_FORMAT_R16_UINT;
+	cube.VertexStride = sizeof(VertexPositionColor);
+	cube.IndexCount = m_indexCount;
+	cube.StartIndex = 0;
+	cube.MaterialIndex = MaterialTable::DefaultMaterial;
+	cube.Model = frame.Constants.Model;
+	cube.SortKey = RenderQueue::MakeSortKey(RenderQueue::PASS_OPAQUE, m_shaderProgram.Id, cube.MaterialIndex, 0, 0.0f);
+	frame.Queue.Submit(cube);
+
+	XMMATRIX const	view = XMMatrixTranspose(XMLoadFloat4x4(&frame.Constants.View));
+	XMMATRIX const	projection = XMMatrixTranspose(XMLoadFloat4x4(&frame.Constants.Projection));
+	frame.ClusterStats = ClusterCuller::Stats();
+	frame.OcclusionStats = OcclusionCuller::Stats();
+	if (m_sceneContext)
+	{
+		m_sceneContext->SubmitDraws(frame.Queue, frame.ClusterIndices, m_shaderProgram, &m_instancedProgram, view, projection, FAR_PLANE);
+		frame.ClusterStats = m_sceneContext->GetClusterStats();
+		frame.OcclusionStats = m_sceneContext->GetOcclusionStats();
+	}
+
+	DIVE_PROFILE_SCOPE("Sort draws");
+	frame.Queue.Sort();
+	frame.Prepared = true;
+}
 
-	context->UpdateSubresource(
-		m_constantBuffer.Get(),
-		0,
-		nullptr,
-		&m_constantBufferData,
-		0,
-		0
-		);
+void Sample3DRenderer::Render(uint32 slot)
+{
+	PreparedFrame&	frame = m_frames[slot];
+	if (!m_loadingComplete || !frame.Prepared)
+		return;
 
-	UINT	stride = sizeof(VertexPositionColor);
-	UINT	offset = 0;
-	context->IASetVertexBuffers(
-		0,
-		1,
-		m_vertexBuffer.GetAddressOf(),
-		&stride,
-		&offset
-		);
+	m_renderedSlot = slot;
+	if (m_sceneContext)
+		m_sceneContext->UploadClusterIndices(frame.ClusterIndices);
 
-	context->IASetIndexBuffer(
-		m_indexBuffer.Get(),
-		DXGI_FORMAT_R16_UINT,
-		0
-		);
+	m_renderDevice->SetVertexConstantBuffer(0, m_constantBuffer.get());
 
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_materialTable->Bind();
 
-	context->IASetInputLayout(m_inputLayout.Get());
+	DIVE_PROFILE_SCOPE("Execute draws");
+	m_constantRing.BeginFrame();
+	frame.Queue.Execute(*m_renderDevice, m_constantBuffer.get(), frame.Constants);
+	m_constantRing.EndFrame();
+	frame.Queue.AddUploadBytes(frame.ClusterIndices.Count * sizeof(uint32));
+}
 
-	context->VSSetShader(
-		m_vertexShader.Get(),
-		nullptr,
-		0
-		);
+RenderStats const& Sample3DRenderer::GetRenderStats() const
+{
+	return m_frames[m_renderedSlot].Queue.GetStats();
+}
 
-	context->VSSetConstantBuffers(
-		0,
-		1,
-		m_constantBuffer.GetAddressOf()
-		);
+ClusterCuller::Stats const& Sample3DRenderer::GetClusterStats() const
+{
+	return m_frames[m_renderedSlot].ClusterStats;
+}
 
-	context->PSSetShader(
-		m_pixelShader.Get(),
-		nullptr,
-		0
-		);
+OcclusionCuller::Stats const& Sample3DRenderer::GetOcclusionStats() const
+{
+	return m_frames[m_renderedSlot].OcclusionStats;
+}
 
-	context->DrawIndexed(
-		m_indexCount,
-		0,
-		0
-		);
+void Sample3DRenderer::SetFrontToBack(bool enabled)
+{
+	for (auto& frame : m_frames)
+		frame.Queue.SetFrontToBack(enabled);
+}
+
+void Sample3DRenderer::SetDepthPrepass(bool enabled)
+{
+	m_depthPrepass = enabled;
+	if (m_sceneContext)
+		m_sceneContext->SetDepthPrepass(enabled ? &m_depthProgram : nullptr, &m_instancedDepthProgram);
 }
 
 void Sample3DRenderer::CreateDeviceDependantResources()
 {
-	auto	loadVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso");
-	auto	loadPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso");
+#if defined(DIVE_COROUTINES)
+	LoadAsync().Detach();
+#else
+	// The level 9 vertex shaders only hold part of the material table, see MaterialTable.
+	bool const	shaderModel4 = m_renderDevice->SupportsShaderModel4();
+	auto	loadVSTask = ReadShaderAsync(shaderModel4 ? "SampleVertexShader10.cso" : "SampleVertexShader.cso");
+	auto	loadPSTask = ReadShaderAsync("SamplePixelShader.cso");
+	auto	loadInstancedVSTask = ReadShaderAsync(shaderModel4 ? "SampleInstancedVertexShader10.cso" : "SampleInstancedVertexShader.cso");
+
+	auto	createVSTask = loadVSTask.then([this](std::vector<uint8> const& fileData)
+	{
+		CreateVertexShaders(fileData.data(), fileData.size());
+	});
 
-	auto	createVSTask = loadVSTask.then([this](std::vector<byte> const& fileData)
+	auto	createInstancedVSTask = loadInstancedVSTask.then([this](std::vector<uint8> const& fileData)
 	{
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateVertexShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_vertexShader
-				)
-			);
-
-		static const D3D11_INPUT_ELEMENT_DESC	vertexDesc[] =
-		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-		};
-
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateInputLayout(
-				vertexDesc,
-				ARRAYSIZE(vertexDesc),
-				&fileData[0],
-				fileData.size(),
-				&m_inputLayout
-				)
-			);
+		CreateInstancedVertexShaders(fileData.data(), fileData.size());
 	});
 
-	auto	createPSTask = loadPSTask.then([this](std::vector<byte> const& fileData)
+	auto	createPSTask = loadPSTask.then([this](std::vector<uint8> const& fileData)
 	{
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreatePixelShader(
-			&fileData[0],
-			fileData.size(),
-			nullptr,
-			&m_pixelShader
-			)
-			);
-
-		CD3D11_BUFFER_DESC	constantBufferDesc(sizeof(ModelViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-			&constantBufferDesc,
-			nullptr,
-			&m_constantBuffer
-			)
-			);
+		CreatePixelShader(fileData.data(), fileData.size());
 	});
 
 	auto	createCubeTask = (createPSTask && createVSTask).then([this]()
 	{
-		static const VertexPositionColor	cubeVertices[] =
-		{
-			{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) },
-			{ XMFLOAT3(-0.5f, -0.5f, 0.5f), XMFLOAT3(0.0f, 0.0f, 1.0f) },
-			{ XMFLOAT3(-0.5f, 0.5f, -0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
-			{ XMFLOAT3(-0.5f, 0.5f, 0.5f), XMFLOAT3(0.0f, 1.0f, 1.0f) },
-			{ XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, 0.0f, 0.0f) },
-			{ XMFLOAT3(0.5f, -0.5f, 0.5f), XMFLOAT3(1.0f, 0.0f, 1.0f) },
-			{ XMFLOAT3(0.5f, 0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f) },
-			{ XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f) },
-		};
-
-		D3D11_SUBRESOURCE_DATA	vertexBufferData = { 0 };
-		vertexBufferData.pSysMem = cubeVertices;
-		vertexBufferData.SysMemPitch = 0;
-		vertexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC	vertexBufferDesc(sizeof(cubeVertices), D3D11_BIND_VERTEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-			&vertexBufferDesc,
-			&vertexBufferData,
-			&m_vertexBuffer
-			)
-			);
-
-		static const unsigned short cubeIndices[] =
-		{
-			0, 2, 1, // -x
-			1, 2, 3,
-
-			4, 5, 6, // +x
-			5, 7, 6,
-
-			0, 1, 5, // -y
-			0, 5, 4,
-
-			2, 6, 7, // +y
-			2, 7, 3,
-
-			0, 4, 6, // -z
-			0, 6, 2,
-
-			1, 3, 7, // +z
-			1, 7, 5,
-		};
-
-		m_indexCount = ARRAYSIZE(cubeIndices);
-
-		D3D11_SUBRESOURCE_DATA	indexBufferData = { 0 };
-		indexBufferData.pSysMem = cubeIndices;
-		indexBufferData.SysMemPitch = 0;
-		indexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC	indexBufferDesc(sizeof(cubeIndices), D3D11_BIND_INDEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-			&indexBufferDesc,
-			&indexBufferData,
-			&m_indexBuffer
-			)
-			);
+		CreateCube();
 	});
 
-	auto	createHumanoidTask = (createPSTask && createVSTask && createCubeTask).then([this]()
+	auto	createHumanoidTask = (createPSTask && createVSTask && createInstancedVSTask && createCubeTask).then([this]()
 	{
-
-
-		//FbxScene*	scene = m_fbxManager->LoadScene("humanoid.fbx");
-		//FbxNode*	node = (FbxNode*)scene;
-
-		//FbxNodeAttribute::EType	attributeType;
-
-		//if (!node->GetNodeAttribute())
-		//{
-		//	//throw ref new FailureException();
-		//}
-		//else
-		//{
-		//	attributeType = node->GetNodeAttribute()->GetAttributeType();
-		//	if (attributeType == FbxNodeAttribute::eMesh)
-		//	{
-		//		FbxMesh*	mesh = (FbxMesh*)node;
-		//		auto		controls = mesh->GetControlPoints();
-		//		auto		vertexCount = mesh->GetControlPointsCount();
-		//		auto		polyCount = mesh->GetPolygonCount();
-
-		//		VertexPositionColor*	vertices = new VertexPositionColor[vertexCount];
-		//		unsigned short*			indices = new unsigned short[polyCount * 3];
-
-		//		FbxVector4	vertexVect;
-		//		for (auto i = 0; i < vertexCount; ++i)
-		//		{
-		//			vertexVect = controls[i];
-		//			vertices[i].Pos.x = static_cast<float>(vertexVect[0]);
-		//			vertices[i].Pos.y = static_cast<float>(vertexVect[1]);
-		//			vertices[i].Pos.z = static_cast<float>(vertexVect[2]);
-		//		}
-		//	}
-		//}
+		LoadScene();
 	});
 
 	createHumanoidTask.then([this]()
 	{
 		m_loadingComplete = true;
 	});
+#endif
+}
+
+#if defined(DIVE_COROUTINES)
+Task<void> Sample3DRenderer::LoadAsync()
+{
+	// The level 9 vertex shaders only hold part of the material table, see MaterialTable.
+	bool const	shaderModel4 = m_renderDevice->SupportsShaderModel4();
+	auto	shaders = co_await WhenAll(
+		ReadFileAsync(shaderModel4 ? "SampleVertexShader10.cso" : "SampleVertexShader.cso"),
+		ReadFileAsync("SamplePixelShader.cso"),
+		ReadFileAsync(shaderModel4 ? "SampleInstancedVertexShader10.cso" : "SampleInstancedVertexShader.cso"));
+	// Resumed by whichever thread finished last, or still on the calling thread when the reads were that fast.
+	// The rest of the load is far too long for the main thread.
+	co_await ResumeOnWorker();
+
+	std::vector<uint8> const&	vertexShader = std::get<0>(shaders);
+	std::vector<uint8> const&	pixelShader = std::get<1>(shaders);
+	std::vector<uint8> const&	instancedVertexShader = std::get<2>(shaders);
+	if (vertexShader.empty() || pixelShader.empty() || instancedVertexShader.empty())
+	{
+		_RPT0(2, "Error: Unable to read the sample shaders!\n");
+		co_return;
+	}
+
+	CreateVertexShaders(vertexShader.data(), vertexShader.size());
+	CreateInstancedVertexShaders(instancedVertexShader.data(), instancedVertexShader.size());
+	CreatePixelShader(pixelShader.data(), pixelShader.size());
+	CreateCube();
+	LoadScene();
+
+	co_await ResumeOnMainThread();
+	m_loadingComplete = true;
+}
+#endif
+
+void Sample3DRenderer::CreateVertexShaders(uint8 const* data, size_t size)
+{
+	m_shaderProgram.VertexShader = m_renderDevice->CreateVertexShader(data, size);
+
+	static const InputElement	vertexDesc[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, 0 }
+	};
+
+	m_shaderProgram.InputLayout = m_renderDevice->CreateInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), data, size);
+
+	// The depth pass runs the same vertex shader objects without a pixel shader.
+	m_depthProgram.Id = 2;
+	m_depthProgram.VertexShader = m_shaderProgram.VertexShader;
+	m_depthProgram.InputLayout = m_shaderProgram.InputLayout;
+}
+
+void Sample3DRenderer::CreateInstancedVertexShaders(uint8 const* data, size_t size)
+{
+	m_instancedProgram.Id = 1;
+	m_instancedProgram.VertexShader = m_renderDevice->CreateVertexShader(data, size);
+
+	static const InputElement	vertexDesc[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, 0 },
+		{ "MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, 1 },
+		{ "MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, 1 },
+		{ "MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, 1 },
+		{ "MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, 1 }
+	};
+
+	m_instancedProgram.InputLayout = m_renderDevice->CreateInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), data, size);
+
+	m_instancedDepthProgram.Id = 3;
+	m_instancedDepthProgram.VertexShader = m_instancedProgram.VertexShader;
+	m_instancedDepthProgram.InputLayout = m_instancedProgram.InputLayout;
+
+	m_instanceBuffer = m_renderDevice->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_DYNAMIC, sizeof(InstanceData) * MAX_INSTANCES, nullptr);
+}
+
+void Sample3DRenderer::CreatePixelShader(uint8 const* data, size_t size)
+{
+	m_shaderProgram.PixelShader = m_renderDevice->CreatePixelShader(data, size);
+	m_instancedProgram.PixelShader = m_shaderProgram.PixelShader;
+
+	m_constantBuffer = m_renderDevice->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_DEFAULT, sizeof(ModelViewProjectionConstantBuffer), nullptr);
+	m_constantRing.CreateDeviceDependentResources();
+
+	m_materialTable->CreateDeviceDependentResources();
+}
+
+void Sample3DRenderer::CreateCube()
+{
+	static const VertexPositionColor	cubeVertices[] =
+	{
+		{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) },
+		{ XMFLOAT3(-0.5f, -0.5f, 0.5f), XMFLOAT3(0.0f, 0.0f, 1.0f) },
+		{ XMFLOAT3(-0.5f, 0.5f, -0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
+		{ XMFLOAT3(-0.5f, 0.5f, 0.5f), XMFLOAT3(0.0f, 1.0f, 1.0f) },
+		{ XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, 0.0f, 0.0f) },
+		{ XMFLOAT3(0.5f, -0.5f, 0.5f), XMFLOAT3(1.0f, 0.0f, 1.0f) },
+		{ XMFLOAT3(0.5f, 0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f) },
+		{ XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f) },
+	};
+
+	m_vertexBuffer = m_renderDevice->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_DEFAULT, sizeof(cubeVertices), cubeVertices);
+
+	static const unsigned short cubeIndices[] =
+	{
+		0, 2, 1, // -x
+		1, 2, 3,
+
+		4, 5, 6, // +x
+		5, 7, 6,
+
+		0, 1, 5, // -y
+		0, 5, 4,
+
+		2, 6, 7, // +y
+		2, 7, 3,
+
+		0, 4, 6, // -z
+		0, 6, 2,
+
+		1, 3, 7, // +z
+		1, 7, 5,
+	};
+
+	m_indexCount = ARRAYSIZE(cubeIndices);
+
+	m_indexBuffer = m_renderDevice->CreateBuffer(BIND_INDEX_BUFFER, USAGE_DEFAULT, sizeof(cubeIndices), cubeIndices);
+}
+
+void Sample3DRenderer::LoadScene()
+{
+	for (auto& frame : m_frames)
+		frame.Queue.SetInstanceBuffer(m_instanceBuffer.get(), MAX_INSTANCES);
+
+	m_sceneContext = std::unique_ptr<FBXSceneContext>(new FBXSceneContext("humanoid.fbx", m_fbxManager->GetManager(), m_renderDevice, m_materialTable));
+	m_sceneContext->Initialize();
+	SetDepthPrepass(m_depthPrepass);
 }
 
 void Sample3DRenderer::ReleaseDeviceDependantResources()
 {
 	m_loadingComplete = false;
-	m_vertexShader.Reset();
-	m_inputLayout.Reset();
-	m_pixelShader.Reset();
-	m_constantBuffer.Reset();
-	m_vertexBuffer.Reset();
-	m_indexBuffer.Reset();
+	m_sceneContext.reset();
+	m_shaderProgram.VertexShader.reset();
+	m_shaderProgram.InputLayout.reset();
+	m_shaderProgram.PixelShader.reset();
+	m_instancedProgram.VertexShader.reset();
+	m_instancedProgram.InputLayout.reset();
+	m_instancedProgram.PixelShader.reset();
+	m_depthProgram.VertexShader.reset();
+	m_depthProgram.InputLayout.reset();
+	m_instancedDepthProgram.VertexShader.reset();
+	m_instancedDepthProgram.InputLayout.reset();
+	for (auto& frame : m_frames)
+	{
+		frame.Queue.SetInstanceBuffer(nullptr, 0);
+		frame.Prepared = false;
+	}
+	m_instanceBuffer.reset();
+	m_constantBuffer.reset();
+	m_constantRing.ReleaseDeviceDependentResources();
+	m_materialTable->ReleaseDeviceDependentResources();
+	m_vertexBuffer.reset();
+	m_indexBuffer.reset();
 }
 
 void Dive::Sample3DRenderer::Rotate(float radians)
@@ -1,40 +1,106 @@
 #pragma once
 
-#include "Common/DeviceResources.h"
+#include "RenderDevice.h"
 #include "ShaderStructures.h"
 #include "Common/StepTimer.h"
+#include "ConstantBufferRing.h"
 #include "FBXManager.h"
+#include "FBXSceneContext.h"
+#include "MaterialTable.h"
+#include "RenderQueue.h"
+#include "Task.h"
+
+#include <atomic>
 
 namespace Dive
 {
+	// Frames are built in stages that each touch their own slot, so consecutive frames can be in different
+	// stages at once: Step, Update and Capture simulate into a snapshot, Prepare culls and sorts a snapshot into
+	// render data without touching the device, Render submits the render data on the render thread.
 	class Sample3DRenderer
 	{
 	public:
-		Sample3DRenderer(std::shared_ptr<DX::DeviceResources> const& deviceResources);
+		static uint32 const	FrameSlots = 2;
+
+		Sample3DRenderer(std::shared_ptr<RenderDevice> const& renderDevice);
 		void	CreateDeviceDependantResources();
 		void	CreateWindowSizeDependantResources();
 		void	ReleaseDeviceDependantResources();
+		// One simulation step, run by the timer as many times as the frame needs.
+		void	Step(DX::StepTimer const& timer);
+		// Once per frame, blends the two latest steps by the timer's interpolation alpha.
 		void	Update(DX::StepTimer const& timer);
-		void	Render();
+		void	Capture(uint32 slot);
+		void	Prepare(uint32 slot);
+		void	Render(uint32 slot);
+
+		// Stats of the last slot rendered.
+		RenderStats const&				GetRenderStats() const;
+		ClusterCuller::Stats const&		GetClusterStats() const;
+		OcclusionCuller::Stats const&	GetOcclusionStats() const;
+		// The options below change what Prepare builds, they are only set while no Prepare runs, see DiveMain.
+		// Depth-only pass over the draws covering most of the screen, off by default.
+		void				SetDepthPrepass(bool enabled);
+		bool				IsDepthPrepass() const		{ return m_depthPrepass; }
+		// Opaque draws ordered front to back by depth bucket, then by state. On by default.
+		void				SetFrontToBack(bool enabled);
+		bool				IsFrontToBack() const		{ return m_frames[0].Queue.IsFrontToBack(); }
 
 	private:
 		void	Rotate(float radians);
+		// Loading steps, run on worker threads.
+		void	CreateVertexShaders(uint8 const* data, size_t size);
+		void	CreateInstancedVertexShaders(uint8 const* data, size_t size);
+		void	CreatePixelShader(uint8 const* data, size_t size);
+		void	CreateCube();
+		void	LoadScene();
+#if defined(DIVE_COROUTINES)
+		Task<void>	LoadAsync();
+#endif
 
 	private:
-		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
-		FBXManager*								m_fbxManager;
+		std::shared_ptr<RenderDevice>		m_renderDevice;
+		FBXManager*							m_fbxManager;
+		std::shared_ptr<MaterialTable>		m_materialTable;
+		std::unique_ptr<FBXSceneContext>	m_sceneContext;
+		ConstantBufferRing					m_constantRing;
+
+		struct PreparedFrame
+		{
+			PreparedFrame() : Prepared(false) { }
+
+			ModelViewProjectionConstantBuffer	Constants;
+			RenderQueue							Queue;
+			FBXSceneContext::ClusterIndices		ClusterIndices;
+			// Copied from the scene by Prepare, the scene's own are rewritten by the next Prepare while this slot renders.
+			ClusterCuller::Stats				ClusterStats;
+			OcclusionCuller::Stats				OcclusionStats;
+			bool								Prepared;
+		};
+
+		ModelViewProjectionConstantBuffer	m_snapshots[FrameSlots];
+		PreparedFrame						m_frames[FrameSlots];
+		uint32								m_renderedSlot;
 
-		Microsoft::WRL::ComPtr<ID3D11InputLayout>	m_inputLayout;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_vertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_indexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11VertexShader>	m_vertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader>	m_pixelShader;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_constantBuffer;
+		ShaderProgram					m_shaderProgram;
+		ShaderProgram					m_instancedProgram;
+		// Same vertex shaders and no pixel shader.
+		ShaderProgram					m_depthProgram;
+		ShaderProgram					m_instancedDepthProgram;
+		std::unique_ptr<RenderBuffer>	m_vertexBuffer;
+		std::unique_ptr<RenderBuffer>	m_indexBuffer;
+		std::unique_ptr<RenderBuffer>	m_constantBuffer;
+		std::unique_ptr<RenderBuffer>	m_instanceBuffer;
 
 		ModelViewProjectionConstantBuffer	m_constantBufferData;
 		uint32	m_indexCount;
 
-		bool	m_loadingComplete;
+		// Set by the loading steps and read by Prepare on another thread.
+		std::atomic<bool>	m_loadingComplete;
+		bool	m_depthPrepass;
 		float	m_degreesPerSeconds;
+		// Rotation of the two latest steps, not wrapped so they blend across a full turn.
+		double	m_previousRotation;
+		double	m_rotation;
 	};
 }
\ No newline at end of file
@@ -1,102 +0,0 @@
-#include "pch.h"
-#include "SampleFPSTextRenderer.h"
-
-#include "Common/directxhelper.h"
-
-using namespace Dive;
-
-SampleFPSTextRenderer::SampleFPSTextRenderer(std::shared_ptr<DX::DeviceResources> const& deviceResources) :
-m_text(L""),
-m_deviceResources(deviceResources)
-{
-	ZeroMemory(&m_textMetrics, sizeof(DWRITE_TEXT_METRICS));
-
-	DX::ThrowIfFailed(
-		m_deviceResources->GetDWriteFactory()->CreateTextFormat(
-		L"Segoe UI",
-		nullptr,
-		DWRITE_FONT_WEIGHT_LIGHT,
-		DWRITE_FONT_STYLE_NORMAL,
-		DWRITE_FONT_STRETCH_NORMAL,
-		32.0f,
-		L"en-US",
-		&m_textFormat
-		)
-		);
-
-	DX::ThrowIfFailed(
-		m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR)
-		);
-
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD2DFactory()->CreateDrawingStateBlock(&m_stateBlock)
-		);
-
-	CreateDeviceDependentResources();
-}
-
-void SampleFPSTextRenderer::Update(DX::StepTimer const& timer)
-{
-	uint32	fps = timer.GetFramePerSecond();
-
-	m_text = (fps > 0) ? std::to_wstring(fps) + L"FPS" : L" - FPS";
-
-	DX::ThrowIfFailed(
-		m_deviceResources->GetDWriteFactory()->CreateTextLayout(
-		m_text.c_str(),
-		(uint32)m_text.length(),
-		m_textFormat.Get(),
-		240.0f,
-		50.0f,
-		&m_textLayout
-		)
-		);
-
-	DX::ThrowIfFailed(
-		m_textLayout->GetMetrics(&m_textMetrics)
-		);
-}
-
-void SampleFPSTextRenderer::Render()
-{
-	ID2D1DeviceContext*			context = m_deviceResources->GetD2DDeviceContext();
-	Windows::Foundation::Size	logicalSize = m_deviceResources->GetLogicalSize();
-
-	context->SaveDrawingState(m_stateBlock.Get());
-	context->BeginDraw();
-
-	D2D1::Matrix3x2F	screenTranslation = D2D1::Matrix3x2F::Translation(
-		logicalSize.Width - m_textMetrics.layoutWidth,
-		logicalSize.Height - m_textMetrics.height
-		);
-
-	context->SetTransform(screenTranslation * m_deviceResources->GetOrientationTransform2D());
-
-	DX::ThrowIfFailed(
-		m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING)
-		);
-
-	context->DrawTextLayout(
-		D2D1::Point2F(0.0f, 0.0f),
-		m_textLayout.Get(),
-		m_whiteBrush.Get()
-		);
-
-	HRESULT	hr = context->EndDraw();
-	if (hr != D2DERR_RECREATE_TARGET)
-		DX::ThrowIfFailed(hr);
-
-	context->RestoreDrawingState(m_stateBlock.Get());
-}
-
-void SampleFPSTextRenderer::CreateDeviceDependentResources()
-{
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD2DDeviceContext()->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_whiteBrush)
-		);
-}
-
-void SampleFPSTextRenderer::ReleaseDeviceDependentResources()
-{
-	m_whiteBrush.Reset();
-}
\ No newline at end of file
@@ -0,0 +1,40 @@
+// The model matrix of the constants is ignored in favour of the instance stream.
+#include "SampleShaderConstants.hlsli"
+
+// Per-vertex data from slot 0, per-instance data from slot 1.
+struct VertexShaderInput
+{
+	float3 pos : POSITION;
+	float3 color : COLOR0;
+	// Rows of the transposed model matrix, as stored in the constant buffer.
+	float4 model0 : MODEL0;
+	float4 model1 : MODEL1;
+	float4 model2 : MODEL2;
+	float4 model3 : MODEL3;
+};
+
+// Per-pixel color data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float3 color : COLOR0;
+};
+
+PixelShaderInput main(VertexShaderInput input)
+{
+	PixelShaderInput output;
+	float4 pos = float4(input.pos, 1.0f);
+
+	// Transform the vertex position into projected space.
+	float4x4 instanceModel = float4x4(input.model0, input.model1, input.model2, input.model3);
+	pos = mul(instanceModel, pos);
+	pos = mul(pos, view);
+	pos = mul(pos, projection);
+	output.pos = pos;
+
+	// Modulate the vertex color by the material of the draw.
+	Material material = materials[(uint)materialIndex];
+	output.color = input.color * material.diffuse.rgb + material.emissive.rgb;
+
+	return output;
+}
@@ -0,0 +1,4 @@
+// SampleInstancedVertexShader.hlsl with the full material table, for feature level 10 and up.
+#define MAX_MATERIALS 256
+
+#include "SampleInstancedVertexShader.hlsl"
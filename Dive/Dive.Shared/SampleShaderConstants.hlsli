@@ -0,0 +1,33 @@
+// Constants shared by SampleVertexShader.hlsl and SampleInstancedVertexShader.hlsl.
+
+// A constant buffer that stores the three basic column-major matrices for composing geometry.
+cbuffer ModelViewProjectionConstantBuffer : register(b0)
+{
+	matrix model;
+	matrix view;
+	matrix projection;
+	// Level 9 shaders have no integer constants.
+	float materialIndex;
+};
+
+// Five registers per material. Level 9 vertex shaders only have 256 registers, so this build keeps the
+// table small. The *10.hlsl variants for feature level 10 and up define the full size.
+// Must match MaterialTable::MaxMaterialsLevel9 and MaxMaterials.
+#ifndef MAX_MATERIALS
+#define MAX_MATERIALS 32
+#endif
+
+struct Material
+{
+	float4 emissive;
+	float4 ambient;
+	float4 diffuse;
+	float4 specular;
+	float shininess;
+};
+
+// Every unique material of the scene, indexed by materialIndex.
+cbuffer MaterialConstantBuffer : register(b1)
+{
+	Material materials[MAX_MATERIALS];
+};
@@ -1,10 +1,4 @@
-// A constant buffer that stores the three basic column-major matrices for composing geometry.
-cbuffer ModelViewProjectionConstantBuffer : register(b0)
-{
-	matrix model;
-	matrix view;
-	matrix projection;
-};
+#include "SampleShaderConstants.hlsli"
 
 // Per-vertex data used as input to the vertex shader.
 struct VertexShaderInput
@@ -32,8 +26,9 @@ PixelShaderInput main(VertexShaderInput input)
 	pos = mul(pos, projection);
 	output.pos = pos;
 
-	// Pass the color through without modification.
-	output.color = input.color;
+	// Modulate the vertex color by the material of the draw.
+	Material material = materials[(uint)materialIndex];
+	output.color = input.color * material.diffuse.rgb + material.emissive.rgb;
 
 	return output;
 }
@@ -7,6 +7,26 @@ namespace Dive
 		DirectX::XMFLOAT4X4	Model;
 		DirectX::XMFLOAT4X4	View;
 		DirectX::XMFLOAT4X4	Projection;
+		// A float, level 9 shaders have no integer constants.
+		float				MaterialIndex;
+		DirectX::XMFLOAT3	Padding;
+	};
+
+	// One element of the instance stream, the model matrix stored transposed like in the constant buffer.
+	struct InstanceData
+	{
+		DirectX::XMFLOAT4X4	Model;
+	};
+
+	// One entry of the MaterialConstantBuffer array, laid out as five float4 registers.
+	struct MaterialConstants
+	{
+		DirectX::XMFLOAT4	Emissive;
+		DirectX::XMFLOAT4	Ambient;
+		DirectX::XMFLOAT4	Diffuse;
+		DirectX::XMFLOAT4	Specular;
+		float				Shininess;
+		DirectX::XMFLOAT3	Padding;
 	};
 
 	struct VertexPositionColor
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "JobSystem.h"
+
+// Builds may also define DIVE_COROUTINES themselves.
+#if defined(__cpp_impl_coroutine) && !defined(DIVE_COROUTINES)
+#define DIVE_COROUTINES
+#endif
+
+#if defined(DIVE_COROUTINES)
+
+#include <coroutine>
+#include <exception>
+#include <tuple>
+#include <utility>
+
+namespace Dive
+{
+	template <class T>
+	class Task;
+
+	namespace Detail
+	{
+		struct TaskPromiseBase
+		{
+			// Resumes whoever awaits the task, or destroys a detached task. A task started by WhenAll only
+			// resumes its awaiter once all its siblings are done too.
+			struct FinalAwaiter
+			{
+				bool	await_ready() const noexcept	{ return false; }
+				void	await_resume() const noexcept	{ }
+
+				template <class Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					TaskPromiseBase&	promise = handle.promise();
+					if (promise.Pending && promise.Pending->fetch_sub(1) != 1)
+						return std::noop_coroutine();
+					if (promise.Detached)
+					{
+						handle.destroy();
+						return std::noop_coroutine();
+					}
+					return promise.Continuation ? promise.Continuation : std::noop_coroutine();
+				}
+			};
+
+			TaskPromiseBase() : Pending(nullptr), Detached(false) { }
+
+			std::suspend_always	initial_suspend() const noexcept	{ return std::suspend_always(); }
+			FinalAwaiter		final_suspend() const noexcept		{ return FinalAwaiter(); }
+
+			void	unhandled_exception()
+			{
+				// Nobody is left to rethrow to.
+				if (Detached)
+					std::terminate();
+				Exception = std::current_exception();
+			}
+
+			void	RethrowIfFailed()
+			{
+				if (Exception)
+					std::rethrow_exception(Exception);
+			}
+
+			std::coroutine_handle<>	Continuation;
+			std::atomic<uint32>*	Pending;
+			std::exception_ptr		Exception;
+			bool					Detached;
+		};
+
+		template <class T>
+		struct TaskPromise : TaskPromiseBase
+		{
+			Task<T>	get_return_object()		{ return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this)); }
+			void	return_value(T value)	{ Value = std::move(value); }
+
+			T	GetResult()
+			{
+				RethrowIfFailed();
+				return std::move(Value);
+			}
+
+			T	Value;
+		};
+
+		template <>
+		struct TaskPromise<void> : TaskPromiseBase
+		{
+			Task<void>	get_return_object();
+			void		return_void()		{ }
+			void		GetResult()			{ RethrowIfFailed(); }
+		};
+	}
+
+	// Lazily started coroutine. Awaiting a task starts it and the awaiter is resumed straight from its
+	// final suspension point, so a chain of steps costs one frame per coroutine and no allocation per hop.
+	// Where a step runs is chosen with ResumeOnWorker and ResumeOnMainThread.
+	template <class T>
+	class Task
+	{
+	public:
+		typedef Detail::TaskPromise<T>	promise_type;
+
+		explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) { }
+		Task(Task&& other) : m_handle(other.m_handle)	{ other.m_handle = nullptr; }
+		~Task()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+
+		Task&	operator=(Task&& other)
+		{
+			std::swap(m_handle, other.m_handle);
+			return *this;
+		}
+
+		struct Awaiter
+		{
+			bool	await_ready() const noexcept		{ return false; }
+			T		await_resume()						{ return Handle.promise().GetResult(); }
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				Handle.promise().Continuation = awaiting;
+				return Handle;
+			}
+
+			std::coroutine_handle<promise_type>	Handle;
+		};
+
+		Awaiter	operator co_await() const noexcept	{ return Awaiter{ m_handle }; }
+
+		// Starts the task on the calling thread. It frees itself once done, exceptions end the process.
+		void	Detach()
+		{
+			std::coroutine_handle<promise_type> const	handle = m_handle;
+			m_handle = nullptr;
+			handle.promise().Detached = true;
+			handle.resume();
+		}
+
+	private:
+		template <class... Tasks>
+		friend class WhenAllAwaiter;
+
+		Task(Task const&);
+		Task&	operator=(Task const&);
+
+		std::coroutine_handle<promise_type>	m_handle;
+	};
+
+	inline Task<void> Detail::TaskPromise<void>::get_return_object()
+	{
+		return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+	}
+
+	// Starts every task on the calling thread and resumes the awaiter, on the thread finishing last,
+	// with their results. Tasks meant to overlap begin with co_await ResumeOnWorker().
+	template <class... Tasks>
+	class WhenAllAwaiter
+	{
+	public:
+		explicit WhenAllAwaiter(Tasks&&... tasks) : m_tasks(std::move(tasks)...), m_pending(sizeof...(Tasks) + 1) { }
+
+		bool	await_ready() const noexcept	{ return false; }
+
+		bool await_suspend(std::coroutine_handle<> awaiting)
+		{
+			Start(awaiting, std::index_sequence_for<Tasks...>());
+			// The last task may have finished already, the awaiter then goes on without suspending.
+			return m_pending.fetch_sub(1) != 1;
+		}
+
+		std::tuple<decltype(std::declval<Tasks&>().m_handle.promise().GetResult())...> await_resume()
+		{
+			return GetResults(std::index_sequence_for<Tasks...>());
+		}
+
+	private:
+		template <std::size_t... Indices>
+		void Start(std::coroutine_handle<> awaiting, std::index_sequence<Indices...>)
+		{
+			int const	start[] = { (StartTask(std::get<Indices>(m_tasks), awaiting), 0)... };
+			(void)start;
+		}
+
+		template <class TaskType>
+		void StartTask(TaskType& task, std::coroutine_handle<> awaiting)
+		{
+			task.m_handle.promise().Continuation = awaiting;
+			task.m_handle.promise().Pending = &m_pending;
+			task.m_handle.resume();
+		}
+
+		template <std::size_t... Indices>
+		std::tuple<decltype(std::declval<Tasks&>().m_handle.promise().GetResult())...> GetResults(std::index_sequence<Indices...>)
+		{
+			return std::tuple<decltype(std::declval<Tasks&>().m_handle.promise().GetResult())...>(std::get<Indices>(m_tasks).m_handle.promise().GetResult()...);
+		}
+
+		std::tuple<Tasks...>	m_tasks;
+		std::atomic<uint32>		m_pending;
+	};
+
+	template <class... T>
+	WhenAllAwaiter<Task<T>...> WhenAll(Task<T>&&... tasks)
+	{
+		return WhenAllAwaiter<Task<T>...>(std::move(tasks)...);
+	}
+
+	// co_await resumes the coroutine on a worker, or on the main thread from RunMainThreadJobs.
+	class JobAwaiter : public Job
+	{
+	public:
+		JobAwaiter(JobSystem& jobSystem, bool mainThread) : m_jobSystem(jobSystem), m_mainThread(mainThread)
+		{
+			Entry = &Resume;
+			Counter = nullptr;
+		}
+
+		bool	await_ready() const noexcept	{ return m_mainThread && m_jobSystem.IsMainThread(); }
+		void	await_resume() const noexcept	{ }
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			m_handle = handle;
+			if (m_mainThread)
+				m_jobSystem.SubmitToMainThread(*this);
+			else
+				m_jobSystem.SubmitToWorker(*this);
+		}
+
+	private:
+		static void Resume(Job* job)
+		{
+			static_cast<JobAwaiter*>(job)->m_handle.resume();
+		}
+
+		JobSystem&				m_jobSystem;
+		std::coroutine_handle<>	m_handle;
+		bool					m_mainThread;
+	};
+
+	inline JobAwaiter ResumeOnWorker(JobSystem& jobSystem = JobSystem::Get())
+	{
+		return JobAwaiter(jobSystem, false);
+	}
+
+	inline JobAwaiter ResumeOnMainThread(JobSystem& jobSystem = JobSystem::Get())
+	{
+		return JobAwaiter(jobSystem, true);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	bool IsPowerOfTwo(size_t value)
+	{
+		return value && !(value & (value - 1));
+	}
+
+	size_t MipCount(size_t size)
+	{
+		size_t	count = 1;
+		while (size > 1)
+		{
+			size >>= 1;
+			++count;
+		}
+		return count;
+	}
+
+	// Keeps every other bit of a Z-order index, giving back one of its coordinates.
+	size_t CompactBits(uint64 value)
+	{
+		value &= 0x5555555555555555ull;
+		value = (value | (value >> 1)) & 0x3333333333333333ull;
+		value = (value | (value >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		value = (value | (value >> 4)) & 0x00FF00FF00FF00FFull;
+		value = (value | (value >> 8)) & 0x0000FFFF0000FFFFull;
+		value = (value | (value >> 16)) & 0x00000000FFFFFFFFull;
+		return static_cast<size_t>(value);
+	}
+}
+
+bool TextureAtlas::CanPack(TexMetadata const& metadata)
+{
+	if (metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.depth != 1)
+		return false;
+	if (metadata.miscFlags & TEX_MISC_TEXTURECUBE)
+		return false;
+	if (IsCompressed(metadata.format) || !BitsPerPixel(metadata.format) || BitsPerPixel(metadata.format) % 8)
+		return false;
+
+	return IsPowerOfTwo(metadata.width) && IsPowerOfTwo(metadata.height) &&
+		   metadata.width <= MaxTileSize && metadata.height <= MaxTileSize;
+}
+
+TextureAtlas::TextureAtlas() :
+m_memory(MEMORY_TEXTURE, MEMORY_CPU)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+uint32 TextureAtlas::Add(ScratchImage const* image)
+{
+	if (!image || !CanPack(image->GetMetadata()))
+		return InvalidTile;
+
+	TexMetadata const&	metadata = image->GetMetadata();
+
+	Tile	tile;
+	tile.Image = image;
+	tile.Width = metadata.width;
+	tile.Height = metadata.height;
+	tile.CellSize = metadata.width > metadata.height ? metadata.width : metadata.height;
+	tile.X = 0;
+	tile.Y = 0;
+	tile.Page = 0;
+	tile.Packed = false;
+	m_tiles.push_back(tile);
+
+	return static_cast<uint32>(m_tiles.size() - 1);
+}
+
+HRESULT TextureAtlas::Build()
+{
+	m_pages.clear();
+	m_memory.SetBytes(0);
+	m_report = Report();
+	m_report.TextureCount = static_cast<uint32>(m_tiles.size());
+
+	std::vector<uint32>	order(m_tiles.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		m_tiles[i].Packed = false;
+		order[i] = static_cast<uint32>(i);
+	}
+
+	// Group by format, then largest cells first so the Z-order cursor stays aligned to every cell.
+	std::sort(order.begin(), order.end(), [this](uint32 a, uint32 b)
+	{
+		DXGI_FORMAT const	formatA = m_tiles[a].Image->GetMetadata().format;
+		DXGI_FORMAT const	formatB = m_tiles[b].Image->GetMetadata().format;
+		if (formatA != formatB)
+			return formatA < formatB;
+		if (m_tiles[a].CellSize != m_tiles[b].CellSize)
+			return m_tiles[a].CellSize > m_tiles[b].CellSize;
+		return a < b;
+	});
+
+	uint64 const		pageArea = static_cast<uint64>(MaxPageSize) * MaxPageSize;
+	std::vector<uint32>	pageTiles;
+	uint64				cursor = 0;
+	DXGI_FORMAT			format = DXGI_FORMAT_UNKNOWN;
+	for (auto index : order)
+	{
+		Tile&			tile = m_tiles[index];
+		uint64 const	area = static_cast<uint64>(tile.CellSize) * tile.CellSize;
+		DXGI_FORMAT const	tileFormat = tile.Image->GetMetadata().format;
+
+		if (!pageTiles.empty() && (tileFormat != format || cursor + area > pageArea))
+		{
+			HRESULT const	hr = BuildPage(pageTiles, cursor);
+			if (FAILED(hr))
+				return hr;
+			pageTiles.clear();
+			cursor = 0;
+		}
+
+		format = tileFormat;
+		tile.X = CompactBits(cursor);
+		tile.Y = CompactBits(cursor >> 1);
+		pageTiles.push_back(index);
+		cursor += area;
+	}
+
+	if (!pageTiles.empty())
+		return BuildPage(pageTiles, cursor);
+
+	return S_OK;
+}
+
+void TextureAtlas::Clear()
+{
+	m_tiles.clear();
+	m_pages.clear();
+	m_memory.SetBytes(0);
+	m_report = Report();
+}
+
+HRESULT TextureAtlas::BuildPage(std::vector<uint32> const& tiles, uint64 usedArea)
+{
+	// A page holding a single texture saves nothing, leave it as it is.
+	if (tiles.size() < 2)
+		return S_OK;
+
+	size_t	pageSize = 1;
+	while (static_cast<uint64>(pageSize) * pageSize < usedArea)
+		pageSize <<= 1;
+
+	// The chain stops at the level where the smallest tile is down to one texel.
+	size_t	mipLevels = MipCount(pageSize);
+	for (auto index : tiles)
+	{
+		TexMetadata const&	metadata = m_tiles[index].Image->GetMetadata();
+		size_t const		tileLevels = (std::min)(metadata.mipLevels, MipCount((std::min)(metadata.width, metadata.height)));
+		mipLevels = (std::min)(mipLevels, tileLevels);
+	}
+
+	DXGI_FORMAT const	format = m_tiles[tiles.front()].Image->GetMetadata().format;
+	std::unique_ptr<ScratchImage>	page(new ScratchImage());
+	HRESULT	hr = page->Initialize2D(format, pageSize, pageSize, 1, mipLevels);
+	if (FAILED(hr))
+		return hr;
+	memset(page->GetPixels(), 0, page->GetPixelsSize());
+
+	size_t const	bytesPerPixel = BitsPerPixel(format) / 8;
+	uint32 const	pageIndex = static_cast<uint32>(m_pages.size());
+	for (auto index : tiles)
+	{
+		Tile&	tile = m_tiles[index];
+		for (size_t level = 0; level < mipLevels; ++level)
+		{
+			Image const*	source = tile.Image->GetImage(level, 0, 0);
+			Image const*	destination = page->GetImage(level, 0, 0);
+			size_t const	x = tile.X >> level;
+			size_t const	y = tile.Y >> level;
+			for (size_t row = 0; row < source->height; ++row)
+			{
+				memcpy(destination->pixels + (y + row) * destination->rowPitch + x * bytesPerPixel,
+					   source->pixels + row * source->rowPitch,
+					   source->width * bytesPerPixel);
+			}
+		}
+
+		tile.Page = pageIndex;
+		tile.Packed = true;
+		m_report.UsedTexels += static_cast<uint64>(tile.Width) * tile.Height;
+	}
+
+	m_memory.AddBytes(page->GetPixelsSize());
+	m_pages.push_back(std::move(page));
+	m_report.PackedCount += static_cast<uint32>(tiles.size());
+	m_report.PageCount += 1;
+	m_report.PageTexels += static_cast<uint64>(pageSize) * pageSize;
+
+	return S_OK;
+}
+
+bool TextureAtlas::GetRegion(uint32 tile, Region& region) const
+{
+	if (tile >= m_tiles.size() || !m_tiles[tile].Packed)
+		return false;
+
+	Tile const&	packedTile = m_tiles[tile];
+	float const	pageSize = static_cast<float>(m_pages[packedTile.Page]->GetMetadata().width);
+
+	region.Page = packedTile.Page;
+	region.OffsetU = packedTile.X / pageSize;
+	region.OffsetV = packedTile.Y / pageSize;
+	region.ScaleU = packedTile.Width / pageSize;
+	region.ScaleV = packedTile.Height / pageSize;
+	return true;
+}
+
+ScratchImage* TextureAtlas::GetPage(uint32 page) const
+{
+	return m_pages[page].get();
+}
+
+uint32 TextureAtlas::GetPageCount() const
+{
+	return static_cast<uint32>(m_pages.size());
+}
+
+TextureAtlas::Report const& TextureAtlas::GetReport() const
+{
+	return m_report;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+namespace Dive
+{
+	// Packs small power-of-two textures of the same format into shared atlas pages at import time.
+	// Tiles are placed in descending size along a Z-order curve, so every tile sits on a multiple of
+	// its own size and the page mip chain is assembled from the source mips without any refiltering.
+	// Non-square tiles take a square cell of their largest side.
+	class TextureAtlas
+	{
+	public:
+		static size_t const	MaxTileSize = 512;
+		static size_t const	MaxPageSize = 2048;
+		static uint32 const	InvalidTile = uint32(-1);
+
+		// Placement of a tile in its page, in normalized texture coordinates (top-left origin).
+		struct Region
+		{
+			Region() : Page(0), OffsetU(0.0f), OffsetV(0.0f), ScaleU(1.0f), ScaleV(1.0f) { }
+
+			DirectX::XMFLOAT2	Transform(DirectX::XMFLOAT2 const& uv) const	{ return DirectX::XMFLOAT2(OffsetU + uv.x * ScaleU, OffsetV + uv.y * ScaleV); }
+
+			uint32	Page;
+			float	OffsetU;
+			float	OffsetV;
+			float	ScaleU;
+			float	ScaleV;
+		};
+
+		struct Report
+		{
+			Report() : TextureCount(0), PackedCount(0), PageCount(0), UsedTexels(0), PageTexels(0) { }
+
+			float	GetEfficiency() const		{ return PageTexels ? static_cast<float>(UsedTexels) / PageTexels : 0.0f; }
+			// Binds needed to draw every submitted texture once, before and after packing.
+			uint32	GetBindsBefore() const		{ return TextureCount; }
+			uint32	GetBindsAfter() const		{ return TextureCount - PackedCount + PageCount; }
+
+			uint32	TextureCount;
+			uint32	PackedCount;
+			uint32	PageCount;
+			uint64	UsedTexels;
+			uint64	PageTexels;
+		};
+
+		static bool	CanPack(DirectX::TexMetadata const& metadata);
+
+		TextureAtlas();
+		~TextureAtlas();
+
+		// The image must stay alive until Build returns, it can be released afterwards. Returns InvalidTile when the image cannot be packed.
+		uint32	Add(DirectX::ScratchImage const* image);
+		HRESULT	Build();
+		void	Clear();
+
+		bool					GetRegion(uint32 tile, Region& region) const;
+		DirectX::ScratchImage*	GetPage(uint32 page) const;
+		uint32					GetPageCount() const;
+		Report const&			GetReport() const;
+
+	private:
+		struct Tile
+		{
+			DirectX::ScratchImage const*	Image;
+			size_t							Width;
+			size_t							Height;
+			size_t							CellSize;
+			size_t							X;
+			size_t							Y;
+			uint32							Page;
+			bool							Packed;
+		};
+
+		HRESULT	BuildPage(std::vector<uint32> const& tiles, uint64 usedArea);
+
+		std::vector<Tile>									m_tiles;
+		std::vector<std::unique_ptr<DirectX::ScratchImage>>	m_pages;
+		Report												m_report;
+		// Pixels of the pages.
+		MemoryAllocation									m_memory;
+	};
+}
\ No newline at end of file
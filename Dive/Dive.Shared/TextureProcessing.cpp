@@ -0,0 +1,622 @@
+#include "pch.h"
+#include "TextureProcessing.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// DIVE_TEXTURE_SCALAR leaves the vector kernels out, to test them against the scalar ones.
+#if !defined(DIVE_TEXTURE_SCALAR)
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DIVE_TEXTURE_SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DIVE_TEXTURE_AVX2
+#endif
+#elif defined(_M_ARM) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DIVE_TEXTURE_NEON
+#endif
+#endif
+
+using namespace DirectX;
+using namespace Dive;
+
+namespace
+{
+	int const		CHANNEL_COUNT = 4;
+	size_t const	FIXED_RANGE = 4096;
+	DWORD const		FILTER_MODE_MASK = 0xF00000;
+	// Smallest amount of destination pixels worth handing to another thread.
+	size_t const	BAND_PIXEL_COUNT = 16 * 1024;
+
+	// Lookup tables between 8-bit storage and the 12-bit values sRGB images are filtered at.
+	// Built once at startup so the kernels can be used from several threads.
+	struct ConversionTables
+	{
+		ConversionTables()
+		{
+			for (auto i = 0; i < 256; ++i)
+			{
+				float const	value = i / 255.0f;
+				srgbToFixed[i] = static_cast<uint16>(SRGBToLinear(value) * 4095.0f + 0.5f);
+				unormToFixed[i] = static_cast<uint16>(value * 4095.0f + 0.5f);
+				srgbToUnorm[i] = static_cast<uint8>(SRGBToLinear(value) * 255.0f + 0.5f);
+				unormToSrgb[i] = static_cast<uint8>(LinearToSRGB(value) * 255.0f + 0.5f);
+			}
+
+			for (size_t i = 0; i < FIXED_RANGE; ++i)
+			{
+				float const	value = i / 4095.0f;
+				fixedToSrgb[i] = static_cast<uint8>(LinearToSRGB(value) * 255.0f + 0.5f);
+				fixedToUnorm[i] = static_cast<uint8>(value * 255.0f + 0.5f);
+			}
+		}
+
+		static float	SRGBToLinear(float value)
+		{
+			return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		static float	LinearToSRGB(float value)
+		{
+			return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		uint16	srgbToFixed[256];
+		uint16	unormToFixed[256];
+		uint8	srgbToUnorm[256];
+		uint8	unormToSrgb[256];
+		uint8	fixedToSrgb[FIXED_RANGE];
+		uint8	fixedToUnorm[FIXED_RANGE];
+	};
+
+	ConversionTables const	s_tables;
+
+	struct FilterOptions
+	{
+		bool	srgb;
+		bool	triangle;
+		bool	wrapU;
+		bool	wrapV;
+	};
+
+	bool IsFastFormat(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool IsBGRA(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	}
+
+	bool IsPowerOfTwo(size_t value)
+	{
+		return value && !(value & (value - 1));
+	}
+
+	bool IsHalfSize(size_t source, size_t destination)
+	{
+		if (source == 1)
+			return destination == 1;
+		return !(source & 1) && destination == source / 2;
+	}
+
+	bool GetFilterOptions(DXGI_FORMAT format, DWORD filter, FilterOptions& options)
+	{
+		switch (filter & FILTER_MODE_MASK)
+		{
+		case TEX_FILTER_DEFAULT:
+		case TEX_FILTER_BOX:
+			options.triangle = false;
+			break;
+		case TEX_FILTER_TRIANGLE:
+			options.triangle = true;
+			break;
+		default:
+			return false;
+		}
+
+		options.srgb = IsSRGB(format) || (filter & TEX_FILTER_SRGB) != 0;
+		options.wrapU = (filter & TEX_FILTER_WRAP_U) != 0;
+		options.wrapV = (filter & TEX_FILTER_WRAP_V) != 0;
+		return true;
+	}
+
+	size_t SampleIndex(ptrdiff_t index, size_t size, bool wrap)
+	{
+		auto const	count = static_cast<ptrdiff_t>(size);
+		if (wrap)
+			return static_cast<size_t>(((index % count) + count) % count);
+		if (index < 0)
+			return 0;
+		if (index >= count)
+			return size - 1;
+		return static_cast<size_t>(index);
+	}
+
+	// Widens one row of 8-bit pixels to 16-bit lanes. UNORM data keeps its 8-bit scale,
+	// sRGB data is linearized to 12 bits so that filtering happens in linear space.
+	void ExpandRow(uint8 const* src, uint16* dst, size_t width, bool srgb)
+	{
+		size_t	i = 0;
+		size_t const	count = width * CHANNEL_COUNT;
+
+		if (srgb)
+		{
+			for (; i < count; i += CHANNEL_COUNT)
+			{
+				dst[i] = s_tables.srgbToFixed[src[i]];
+				dst[i + 1] = s_tables.srgbToFixed[src[i + 1]];
+				dst[i + 2] = s_tables.srgbToFixed[src[i + 2]];
+				dst[i + 3] = s_tables.unormToFixed[src[i + 3]];
+			}
+			return;
+		}
+
+#if defined(DIVE_TEXTURE_SSE2)
+		__m128i const	zero = _mm_setzero_si128();
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i const	bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(bytes, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; i + 16 <= count; i += 16)
+		{
+			uint8x16_t const	bytes = vld1q_u8(src + i);
+			vst1q_u16(dst + i, vmovl_u8(vget_low_u8(bytes)));
+			vst1q_u16(dst + i + 8, vmovl_u8(vget_high_u8(bytes)));
+		}
+#endif
+		for (; i < count; ++i)
+			dst[i] = src[i];
+	}
+
+	void PackRow(uint16 const* src, uint8* dst, size_t width, bool srgb)
+	{
+		size_t	i = 0;
+		size_t const	count = width * CHANNEL_COUNT;
+
+		if (srgb)
+		{
+			for (; i < count; i += CHANNEL_COUNT)
+			{
+				dst[i] = s_tables.fixedToSrgb[src[i]];
+				dst[i + 1] = s_tables.fixedToSrgb[src[i + 1]];
+				dst[i + 2] = s_tables.fixedToSrgb[src[i + 2]];
+				dst[i + 3] = s_tables.fixedToUnorm[src[i + 3]];
+			}
+			return;
+		}
+
+#if defined(DIVE_TEXTURE_SSE2)
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i const	low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+			__m128i const	high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; i + 16 <= count; i += 16)
+			vst1q_u8(dst + i, vcombine_u8(vmovn_u16(vld1q_u16(src + i)), vmovn_u16(vld1q_u16(src + i + 8))));
+#endif
+		for (; i < count; ++i)
+			dst[i] = static_cast<uint8>(src[i]);
+	}
+
+	// (a + b + 1) >> 1 per lane.
+	void FilterVerticalBox(uint16 const* a, uint16 const* b, uint16* dst, size_t count)
+	{
+		size_t	i = 0;
+#if defined(DIVE_TEXTURE_AVX2)
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i const	va = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+			__m256i const	vb = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_avg_epu16(va, vb));
+		}
+#endif
+#if defined(DIVE_TEXTURE_SSE2)
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i const	va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+			__m128i const	vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu16(va, vb));
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; i + 8 <= count; i += 8)
+			vst1q_u16(dst + i, vrhaddq_u16(vld1q_u16(a + i), vld1q_u16(b + i)));
+#endif
+		for (; i < count; ++i)
+			dst[i] = static_cast<uint16>((a[i] + b[i] + 1) >> 1);
+	}
+
+	// (a + 3b + 3c + d + 4) >> 3 per lane, the 1-3-3-1 tent of a 2:1 triangle filter.
+	void FilterVerticalTriangle(uint16 const* a, uint16 const* b, uint16 const* c, uint16 const* d, uint16* dst, size_t count)
+	{
+		size_t	i = 0;
+#if defined(DIVE_TEXTURE_AVX2)
+		__m256i const	rounding256 = _mm256_set1_epi16(4);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i const	inner = _mm256_add_epi16(
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i)),
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(c + i)));
+			__m256i const	outer = _mm256_add_epi16(
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i)),
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(d + i)));
+			__m256i	sum = _mm256_add_epi16(outer, _mm256_add_epi16(inner, _mm256_slli_epi16(inner, 1)));
+			sum = _mm256_srli_epi16(_mm256_add_epi16(sum, rounding256), 3);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), sum);
+		}
+#endif
+#if defined(DIVE_TEXTURE_SSE2)
+		__m128i const	rounding = _mm_set1_epi16(4);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i const	inner = _mm_add_epi16(
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i)),
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(c + i)));
+			__m128i const	outer = _mm_add_epi16(
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i)),
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(d + i)));
+			__m128i	sum = _mm_add_epi16(outer, _mm_add_epi16(inner, _mm_slli_epi16(inner, 1)));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), sum);
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; i + 8 <= count; i += 8)
+		{
+			uint16x8_t const	inner = vaddq_u16(vld1q_u16(b + i), vld1q_u16(c + i));
+			uint16x8_t const	outer = vaddq_u16(vld1q_u16(a + i), vld1q_u16(d + i));
+			vst1q_u16(dst + i, vrshrq_n_u16(vmlaq_n_u16(outer, inner, 3), 3));
+		}
+#endif
+		for (; i < count; ++i)
+			dst[i] = static_cast<uint16>((a[i] + 3 * (b[i] + c[i]) + d[i] + 4) >> 3);
+	}
+
+	void BoxPixel(uint16 const* src, uint16* dst, size_t i0, size_t i1)
+	{
+		for (auto c = 0; c < CHANNEL_COUNT; ++c)
+			dst[c] = static_cast<uint16>((src[i0 * CHANNEL_COUNT + c] + src[i1 * CHANNEL_COUNT + c] + 1) >> 1);
+	}
+
+	void TrianglePixel(uint16 const* src, uint16* dst, size_t i0, size_t i1, size_t i2, size_t i3)
+	{
+		for (auto c = 0; c < CHANNEL_COUNT; ++c)
+		{
+			dst[c] = static_cast<uint16>((src[i0 * CHANNEL_COUNT + c] +
+										  3 * (src[i1 * CHANNEL_COUNT + c] + src[i2 * CHANNEL_COUNT + c]) +
+										  src[i3 * CHANNEL_COUNT + c] + 4) >> 3);
+		}
+	}
+
+	void FilterHorizontalBox(uint16 const* src, uint16* dst, size_t srcWidth, size_t dstWidth)
+	{
+		size_t	x = 0;
+#if defined(DIVE_TEXTURE_SSE2)
+		// Two destination pixels per iteration: deinterleave even/odd source pixels and average.
+		for (; x + 1 < dstWidth && 2 * x + 3 < srcWidth; x += 2)
+		{
+			__m128i const	v0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 2 * x * CHANNEL_COUNT));
+			__m128i const	v1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + (2 * x + 2) * CHANNEL_COUNT));
+			__m128i const	even = _mm_unpacklo_epi64(v0, v1);
+			__m128i const	odd = _mm_unpackhi_epi64(v0, v1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * CHANNEL_COUNT), _mm_avg_epu16(even, odd));
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; x + 1 < dstWidth && 2 * x + 3 < srcWidth; x += 2)
+		{
+			uint16x8_t const	v0 = vld1q_u16(src + 2 * x * CHANNEL_COUNT);
+			uint16x8_t const	v1 = vld1q_u16(src + (2 * x + 2) * CHANNEL_COUNT);
+			uint16x8_t const	even = vcombine_u16(vget_low_u16(v0), vget_low_u16(v1));
+			uint16x8_t const	odd = vcombine_u16(vget_high_u16(v0), vget_high_u16(v1));
+			vst1q_u16(dst + x * CHANNEL_COUNT, vrhaddq_u16(even, odd));
+		}
+#endif
+		for (; x < dstWidth; ++x)
+			BoxPixel(src, dst + x * CHANNEL_COUNT, SampleIndex(2 * x, srcWidth, false), SampleIndex(2 * x + 1, srcWidth, false));
+	}
+
+	void FilterHorizontalTriangle(uint16 const* src, uint16* dst, size_t srcWidth, size_t dstWidth, bool wrap)
+	{
+		auto const	scalarPixel = [&](size_t x)
+		{
+			auto const	center = static_cast<ptrdiff_t>(2 * x);
+			TrianglePixel(src, dst + x * CHANNEL_COUNT,
+						  SampleIndex(center - 1, srcWidth, wrap),
+						  SampleIndex(center, srcWidth, wrap),
+						  SampleIndex(center + 1, srcWidth, wrap),
+						  SampleIndex(center + 2, srcWidth, wrap));
+		};
+
+		if (!dstWidth)
+			return;
+
+		// The first pixel reads src[-1], the vector loop covers the interior that has
+		// both neighbours in range, the tail goes back to the scalar path.
+		scalarPixel(0);
+		size_t	x = 1;
+#if defined(DIVE_TEXTURE_SSE2)
+		__m128i const	rounding = _mm_set1_epi16(4);
+		for (; x + 1 < dstWidth && 2 * x + 4 < srcWidth; x += 2)
+		{
+			uint16 const*	p = src + (2 * x - 1) * CHANNEL_COUNT;
+			__m128i const	previous = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+			__m128i const	v0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + CHANNEL_COUNT));
+			__m128i const	v1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 3 * CHANNEL_COUNT));
+			__m128i const	next = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p + 5 * CHANNEL_COUNT));
+
+			__m128i const	even = _mm_unpacklo_epi64(v0, v1);
+			__m128i const	odd = _mm_unpackhi_epi64(v0, v1);
+			__m128i const	oddPrevious = _mm_unpacklo_epi64(previous, odd);
+			__m128i const	evenNext = _mm_unpacklo_epi64(_mm_srli_si128(even, 8), next);
+
+			__m128i const	inner = _mm_add_epi16(even, odd);
+			__m128i	sum = _mm_add_epi16(_mm_add_epi16(oddPrevious, evenNext), _mm_add_epi16(inner, _mm_slli_epi16(inner, 1)));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * CHANNEL_COUNT), sum);
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; x + 1 < dstWidth && 2 * x + 4 < srcWidth; x += 2)
+		{
+			uint16 const*	p = src + (2 * x - 1) * CHANNEL_COUNT;
+			uint16x8_t const	previous = vld1q_u16(p);
+			uint16x8_t const	v0 = vld1q_u16(p + CHANNEL_COUNT);
+			uint16x8_t const	v1 = vld1q_u16(p + 3 * CHANNEL_COUNT);
+			uint16x4_t const	next = vld1_u16(p + 5 * CHANNEL_COUNT);
+
+			uint16x8_t const	even = vcombine_u16(vget_low_u16(v0), vget_low_u16(v1));
+			uint16x8_t const	odd = vcombine_u16(vget_high_u16(v0), vget_high_u16(v1));
+			uint16x8_t const	oddPrevious = vcombine_u16(vget_low_u16(previous), vget_high_u16(v0));
+			uint16x8_t const	evenNext = vcombine_u16(vget_low_u16(v1), next);
+
+			uint16x8_t const	outer = vaddq_u16(oddPrevious, evenNext);
+			vst1q_u16(dst + x * CHANNEL_COUNT, vrshrq_n_u16(vmlaq_n_u16(outer, vaddq_u16(even, odd), 3), 3));
+		}
+#endif
+		for (; x < dstWidth; ++x)
+			scalarPixel(x);
+	}
+
+	// Swaps the R and B channels of 8-bit four channel pixels.
+	void SwizzleRow(uint8 const* src, uint8* dst, size_t width)
+	{
+		size_t	i = 0;
+		size_t const	count = width * CHANNEL_COUNT;
+#if defined(DIVE_TEXTURE_SSE2)
+		__m128i const	greenAlpha = _mm_set1_epi32(0xFF00FF00);
+		__m128i const	redBlue = _mm_set1_epi32(0x00FF00FF);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i const	pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+			__m128i const	rb = _mm_and_si128(pixels, redBlue);
+			__m128i const	swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(pixels, greenAlpha), swapped));
+		}
+#elif defined(DIVE_TEXTURE_NEON)
+		for (; i + 64 <= count; i += 64)
+		{
+			uint8x16x4_t	pixels = vld4q_u8(src + i);
+			uint8x16_t const	red = pixels.val[0];
+			pixels.val[0] = pixels.val[2];
+			pixels.val[2] = red;
+			vst4q_u8(dst + i, pixels);
+		}
+#endif
+		for (; i < count; i += CHANNEL_COUNT)
+		{
+			uint8 const	red = src[i];
+			dst[i] = src[i + 2];
+			dst[i + 1] = src[i + 1];
+			dst[i + 2] = red;
+			dst[i + 3] = src[i + 3];
+		}
+	}
+
+	void ConvertRow(uint8 const* src, uint8* dst, size_t width, bool swap, uint8 const* curve)
+	{
+		if (!curve)
+		{
+			if (swap)
+				SwizzleRow(src, dst, width);
+			else if (src != dst)
+				memcpy(dst, src, width * CHANNEL_COUNT);
+			return;
+		}
+
+		size_t const	red = swap ? 2 : 0;
+		size_t const	blue = swap ? 0 : 2;
+		for (size_t i = 0; i < width * CHANNEL_COUNT; i += CHANNEL_COUNT)
+		{
+			uint8 const	r = curve[src[i]];
+			uint8 const	g = curve[src[i + 1]];
+			uint8 const	b = curve[src[i + 2]];
+			dst[i + red] = r;
+			dst[i + 1] = g;
+			dst[i + blue] = b;
+			dst[i + 3] = src[i + 3];
+		}
+	}
+
+	void CopyImage(Image const& src, Image const& dst)
+	{
+		size_t const	rowSize = src.width * CHANNEL_COUNT;
+		for (size_t y = 0; y < src.height; ++y)
+			memcpy(dst.pixels + y * dst.rowPitch, src.pixels + y * src.rowPitch, rowSize);
+	}
+
+	// Downsamples rows [rowBegin, rowEnd) of dst from src, which is twice its size (or 1) in
+	// each dimension. Expanded source rows are kept in a four entry cache indexed by their
+	// position before wrapping or clamping, & 3. The four rows of a filter window then never
+	// evict each other, even when wrapping brings in rows a multiple of 4 apart, and the next
+	// window finds the two rows it shares with this one in place.
+	void DownsampleRows(Image const& src, Image const& dst, size_t rowBegin, size_t rowEnd, FilterOptions const& options)
+	{
+		size_t const	srcCount = src.width * CHANNEL_COUNT;
+		std::vector<uint16>	rows(srcCount * 4);
+		std::vector<uint16>	vertical(srcCount);
+		std::vector<uint16>	horizontal(dst.width * CHANNEL_COUNT);
+		size_t	rowTags[4] = { size_t(-1), size_t(-1), size_t(-1), size_t(-1) };
+
+		auto const	fetchRow = [&](ptrdiff_t index) -> uint16 const*
+		{
+			size_t const	row = SampleIndex(index, src.height, options.wrapV);
+			size_t const	slot = static_cast<size_t>(index) & 3;
+			uint16*	cached = &rows[slot * srcCount];
+			if (rowTags[slot] != row)
+			{
+				ExpandRow(src.pixels + row * src.rowPitch, cached, src.width, options.srgb);
+				rowTags[slot] = row;
+			}
+			return cached;
+		};
+
+		for (size_t y = rowBegin; y < rowEnd; ++y)
+		{
+			auto const	center = static_cast<ptrdiff_t>(2 * y);
+			if (options.triangle)
+			{
+				uint16 const*	r0 = fetchRow(center - 1);
+				uint16 const*	r1 = fetchRow(center);
+				uint16 const*	r2 = fetchRow(center + 1);
+				uint16 const*	r3 = fetchRow(center + 2);
+				FilterVerticalTriangle(r0, r1, r2, r3, vertical.data(), srcCount);
+				FilterHorizontalTriangle(vertical.data(), horizontal.data(), src.width, dst.width, options.wrapU);
+			}
+			else
+			{
+				uint16 const*	r0 = fetchRow(center);
+				uint16 const*	r1 = fetchRow(center + 1);
+				FilterVerticalBox(r0, r1, vertical.data(), srcCount);
+				FilterHorizontalBox(vertical.data(), horizontal.data(), src.width, dst.width);
+			}
+
+			PackRow(horizontal.data(), dst.pixels + y * dst.rowPitch, dst.width, options.srgb);
+		}
+	}
+}
+
+HRESULT Dive::ConvertTexture(Image const& srcImage, DXGI_FORMAT format, DWORD filter, float threshold, ScratchImage& image)
+{
+	if (!IsFastFormat(srcImage.format) || !IsFastFormat(format) ||
+		(filter & (TEX_FILTER_DITHER | TEX_FILTER_DITHER_DIFFUSION)))
+		return Convert(srcImage, format, filter, threshold, image);
+
+	HRESULT	hr = image.Initialize2D(format, srcImage.width, srcImage.height, 1, 1);
+	if (FAILED(hr))
+		return hr;
+
+	bool const	swap = IsBGRA(srcImage.format) != IsBGRA(format);
+	bool const	srgbIn = IsSRGB(srcImage.format) || (filter & TEX_FILTER_SRGB_IN) != 0;
+	bool const	srgbOut = IsSRGB(format) || (filter & TEX_FILTER_SRGB_OUT) != 0;
+	uint8 const*	curve = nullptr;
+	if (srgbIn && !srgbOut)
+		curve = s_tables.srgbToUnorm;
+	else if (!srgbIn && srgbOut)
+		curve = s_tables.unormToSrgb;
+
+	Image const*	dst = image.GetImage(0, 0, 0);
+	for (size_t y = 0; y < srcImage.height; ++y)
+		ConvertRow(srcImage.pixels + y * srcImage.rowPitch, dst->pixels + y * dst->rowPitch, srcImage.width, swap, curve);
+
+	return S_OK;
+}
+
+HRESULT Dive::ResizeTexture(Image const& srcImage, size_t width, size_t height, DWORD filter, ScratchImage& image)
+{
+	FilterOptions	options;
+	if (!IsFastFormat(srcImage.format) || !GetFilterOptions(srcImage.format, filter, options) ||
+		!IsHalfSize(srcImage.width, width) || !IsHalfSize(srcImage.height, height))
+		return Resize(srcImage, width, height, filter, image);
+
+	HRESULT	hr = image.Initialize2D(srcImage.format, width, height, 1, 1);
+	if (FAILED(hr))
+		return hr;
+
+	DownsampleRows(srcImage, *image.GetImage(0, 0, 0), 0, height, options);
+
+	return S_OK;
+}
+
+HRESULT Dive::GenerateTextureMipMaps(Image const* srcImages, size_t nimages, TexMetadata const& metadata, DWORD filter, size_t levels, ScratchImage& mipChain, bool parallel)
+{
+	FilterOptions	options;
+	if (!IsFastFormat(metadata.format) || !GetFilterOptions(metadata.format, filter, options) ||
+		metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.depth != 1 ||
+		!IsPowerOfTwo(metadata.width) || !IsPowerOfTwo(metadata.height) || levels == 1)
+		return GenerateMipMaps(srcImages, nimages, metadata, filter, levels, mipChain);
+
+	size_t	maxLevels = 1;
+	for (auto size = metadata.width > metadata.height ? metadata.width : metadata.height; size > 1; size >>= 1)
+		++maxLevels;
+	if (!levels)
+		levels = maxLevels;
+	else if (levels > maxLevels)
+		return E_INVALIDARG;
+
+	for (size_t item = 0; item < metadata.arraySize; ++item)
+	{
+		if (metadata.ComputeIndex(0, item, 0) >= nimages)
+			return E_FAIL;
+	}
+
+	TexMetadata	mipMetadata = metadata;
+	mipMetadata.mipLevels = levels;
+	HRESULT	hr = mipChain.Initialize(mipMetadata);
+	if (FAILED(hr))
+		return hr;
+
+	// Array slices and cube faces have independent chains. Inside a chain each level depends
+	// on the previous one, so only the rows of a single level are split into bands.
+	auto const	generateChain = [&](size_t item)
+	{
+		CopyImage(srcImages[metadata.ComputeIndex(0, item, 0)], *mipChain.GetImage(0, item, 0));
+
+		for (size_t level = 1; level < levels; ++level)
+		{
+			Image const&	src = *mipChain.GetImage(level - 1, item, 0);
+			Image const&	dst = *mipChain.GetImage(level, item, 0);
+
+			size_t const	bandRows = (BAND_PIXEL_COUNT + dst.width - 1) / dst.width;
+			size_t const	bandCount = (dst.height + bandRows - 1) / bandRows;
+			if (!parallel || bandCount < 2)
+			{
+				DownsampleRows(src, dst, 0, dst.height, options);
+				continue;
+			}
+
+			JobSystem::Get().ParallelFor(0, static_cast<uint32>(bandCount), 1, [&](uint32 band)
+			{
+				size_t const	rowBegin = band * bandRows;
+				size_t const	rowEnd = rowBegin + bandRows < dst.height ? rowBegin + bandRows : dst.height;
+				DownsampleRows(src, dst, rowBegin, rowEnd, options);
+			});
+		}
+	};
+
+	if (parallel && metadata.arraySize > 1)
+		JobSystem::Get().ParallelFor(0, static_cast<uint32>(metadata.arraySize), 1, generateChain);
+	else
+	{
+		for (size_t item = 0; item < metadata.arraySize; ++item)
+			generateChain(item);
+	}
+
+	return S_OK;
+}
\ No newline at end of file
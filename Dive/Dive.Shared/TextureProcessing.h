@@ -0,0 +1,21 @@
+#pragma once
+
+namespace Dive
+{
+	// Fast paths for the DirectXTex operations used by texture cooking.
+	// 8-bit RGBA/BGRA images (UNORM or UNORM_SRGB) are handled by SSE2/NEON kernels,
+	// everything else is forwarded to DirectXTex unchanged.
+	//
+	// The vector and scalar kernels are bit-exact with each other. Against the DirectXTex
+	// float pipeline the results are within 1 LSB per channel: filtering is done on 16-bit
+	// lanes, UNORM data at its 8-bit scale and sRGB data linearized to 12-bit fixed point
+	// through a lookup table, box and triangle mips are separable with a rounding step
+	// between the vertical and horizontal passes.
+	//
+	// With parallel set, GenerateTextureMipMaps builds the chains of array slices and cube
+	// faces concurrently and splits every level into row bands across the thread pool.
+
+	HRESULT	ConvertTexture(DirectX::Image const& srcImage, DXGI_FORMAT format, DWORD filter, float threshold, DirectX::ScratchImage& image);
+	HRESULT	ResizeTexture(DirectX::Image const& srcImage, size_t width, size_t height, DWORD filter, DirectX::ScratchImage& image);
+	HRESULT	GenerateTextureMipMaps(DirectX::Image const* srcImages, size_t nimages, DirectX::TexMetadata const& metadata, DWORD filter, size_t levels, DirectX::ScratchImage& mipChain, bool parallel = false);
+}
\ No newline at end of file
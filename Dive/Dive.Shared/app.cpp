@@ -1,5 +1,9 @@
 #include "pch.h"
 #include "app.h"
+#include "D3D11RenderDevice.h"
+#include "Profiler.h"
+
+#include <fstream>
 
 using namespace Dive;
 
@@ -26,6 +30,28 @@ IFrameworkView^ EngineSource::CreateView()
 	return ref new App();
 }
 
+MainDeviceNotify::MainDeviceNotify(std::shared_ptr<DX::DeviceResources> const& deviceResources, DiveMain& main) :
+m_deviceResources(deviceResources),
+m_main(main)
+{
+	m_deviceResources->RegisterDeviceNotify(this);
+}
+
+MainDeviceNotify::~MainDeviceNotify()
+{
+	m_deviceResources->RegisterDeviceNotify(nullptr);
+}
+
+void MainDeviceNotify::OnDeviceLost()
+{
+	m_main.OnDeviceLost();
+}
+
+void MainDeviceNotify::OnDeviceRestored()
+{
+	m_main.OnDeviceRestored();
+}
+
 App::App() :
 m_windowClosed(false),
 m_windowVisible(true)
@@ -66,7 +92,10 @@ void App::SetWindow(CoreWindow^ window)
 void App::Load(Platform::String^ entryPoint)
 {
 	if (!m_main)
-		m_main = std::unique_ptr<DiveMain>(new DiveMain(m_deviceResources));
+	{
+		m_main = std::unique_ptr<DiveMain>(new DiveMain(std::make_shared<D3D11RenderDevice>(m_deviceResources)));
+		m_deviceNotify = std::unique_ptr<MainDeviceNotify>(new MainDeviceNotify(m_deviceResources, *m_main));
+	}
 }
 
 void App::Run()
@@ -80,7 +109,7 @@ void App::Run()
 			m_main->Update();
 
 			if (m_main->Render())
-				m_deviceResources->Present();
+				m_main->Present();
 		}
 		else
 		{
@@ -106,6 +135,13 @@ void App::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args)
 	{
 		m_deviceResources->Trim();
 
+#if DIVE_PROFILING
+		// The last frames before suspending, for chrome://tracing.
+		std::wstring const	tracePath = std::wstring(Windows::Storage::ApplicationData::Current->LocalFolder->Path->Data()) + L"\\profile.json";
+		std::ofstream		trace(tracePath.c_str());
+		Profiler::Get().ExportChromeTrace(trace);
+#endif
+
 		deferral->Complete();
 	});
 }
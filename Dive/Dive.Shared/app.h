@@ -6,6 +6,24 @@
 
 namespace Dive
 {
+	// Hands device loss and restore from the device resources to the main loop.
+	class MainDeviceNotify : public DX::IDeviceNotify
+	{
+	public:
+		MainDeviceNotify(std::shared_ptr<DX::DeviceResources> const& deviceResources, DiveMain& main);
+		~MainDeviceNotify();
+
+		virtual void	OnDeviceLost() override;
+		virtual void	OnDeviceRestored() override;
+
+	private:
+		MainDeviceNotify(MainDeviceNotify const&);
+		MainDeviceNotify&	operator=(MainDeviceNotify const&);
+
+		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
+		DiveMain&								m_main;
+	};
+
 	ref class App sealed : public Windows::ApplicationModel::Core::IFrameworkView
 	{
 	public:
@@ -37,6 +55,7 @@ namespace Dive
 	private:
 		std::shared_ptr<DX::DeviceResources>	m_deviceResources;
 		std::unique_ptr<DiveMain>		m_main;
+		std::unique_ptr<MainDeviceNotify>	m_deviceNotify;
 		bool	m_windowClosed;
 		bool	m_windowVisible;
 	};
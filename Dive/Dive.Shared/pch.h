@@ -20,4 +20,11 @@
 #include <collection.h>
 #include <ppltasks.h>
 
-#include "DirectXTex.h"
\ No newline at end of file
+#include "DirectXTex.h"
+
+// Visual C++ 2013 only knows the storage class extension.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define DIVE_THREAD_LOCAL __declspec(thread)
+#else
+#define DIVE_THREAD_LOCAL thread_local
+#endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace DirectX;
+using namespace Dive;
+
+// BoundingVolumeHierarchy build, refit, frustum cull and ray casts over a large scene of scattered
+// boxes, next to FrustumCuller testing every box. The tree has to find the same visible boxes as the
+// flat test and the same nearest hit as trying every box, the run fails otherwise. Prints timings, it
+// is not run by ctest.
+
+namespace
+{
+	uint32 const	BOX_COUNT = 200000;
+	float const		SCENE_SIZE = 1000.0f;
+	float const		MAX_EXTENT = 4.0f;
+	uint32 const	REPEAT_COUNT = 5;
+	uint32 const	FRAME_COUNT = 100;
+	uint32 const	RAY_COUNT = 100000;
+	// Rays also checked against every box.
+	uint32 const	CHECKED_RAY_COUNT = 500;
+
+	void Check(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", what);
+			exit(1);
+		}
+	}
+
+	double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	XMVECTOR RandomDirection(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float>	unit(-1.0f, 1.0f);
+		for (;;)
+		{
+			XMVECTOR const	direction = XMVectorSet(unit(random), unit(random), unit(random), 0.0f);
+			float const		lengthSq = XMVectorGetX(XMVector3LengthSq(direction));
+			if (lengthSq > 0.01f && lengthSq <= 1.0f)
+				return XMVector3Normalize(direction);
+		}
+	}
+
+	// Entry distance of the ray into the box, FLT_MAX when it misses. The same slab test as the tree's.
+	float IntersectBox(XMFLOAT3 const& origin, XMFLOAT3 const& direction, BoundingBox const& box)
+	{
+		float const	originComponents[3] = { origin.x, origin.y, origin.z };
+		float const	directionComponents[3] = { direction.x, direction.y, direction.z };
+		float const	centerComponents[3] = { box.Center.x, box.Center.y, box.Center.z };
+		float const	extentComponents[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+		float		entryDistance = 0.0f;
+		float		exitDistance = FLT_MAX;
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			float const	inverse = 1.0f / directionComponents[axis];
+			float		slabNear = (centerComponents[axis] - extentComponents[axis] - originComponents[axis]) * inverse;
+			float		slabFar = (centerComponents[axis] + extentComponents[axis] - originComponents[axis]) * inverse;
+			if (slabNear > slabFar)
+				std::swap(slabNear, slabFar);
+			entryDistance = slabNear > entryDistance ? slabNear : entryDistance;
+			exitDistance = slabFar < exitDistance ? slabFar : exitDistance;
+			if (entryDistance > exitDistance)
+				return FLT_MAX;
+		}
+		return entryDistance;
+	}
+}
+
+int main()
+{
+	JobSystem&		jobSystem = JobSystem::Get();
+	std::mt19937	random(12345);
+
+	std::uniform_real_distribution<float>	position(0.0f, SCENE_SIZE);
+	std::uniform_real_distribution<float>	extent(0.1f, MAX_EXTENT);
+	std::vector<BoundingBox>				boxes(BOX_COUNT);
+	FrustumCuller							flat;
+	for (auto& box : boxes)
+	{
+		box = BoundingBox(XMFLOAT3(position(random), position(random), position(random)), XMFLOAT3(extent(random), extent(random), extent(random)));
+		flat.Add(box, BoundingSphere(box.Center, MAX_EXTENT * 2.0f));
+	}
+
+	BoundingVolumeHierarchy	tree;
+	for (bool parallel : { false, true })
+	{
+		auto const	start = std::chrono::high_resolution_clock::now();
+		for (uint32 repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+			tree.Build(boxes.data(), BOX_COUNT, parallel);
+		printf("%u boxes, %s build on %u workers: %.2f ms, %u nodes\n", BOX_COUNT, parallel ? "parallel" : "serial", jobSystem.GetWorkerCount(),
+			GetMilliseconds(start) / REPEAT_COUNT, tree.GetNodeCount());
+		Check(tree.GetPrimitiveCount() == BOX_COUNT && tree.GetNodeCount() < 2 * BOX_COUNT, "the tree holds every box");
+	}
+
+	// Every box moves a little, the tree keeps its topology.
+	for (uint32 i = 0; i < BOX_COUNT; ++i)
+	{
+		boxes[i].Center.y += 1.0f;
+		tree.UpdateBounds(i, boxes[i]);
+		flat.Update(i, boxes[i], BoundingSphere(boxes[i].Center, MAX_EXTENT * 2.0f));
+	}
+	auto const	refitStart = std::chrono::high_resolution_clock::now();
+	for (uint32 repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+		tree.Refit();
+	printf("refit: %.2f ms\n", GetMilliseconds(refitStart) / REPEAT_COUNT);
+
+	// Cameras inside the scene turning around, each sees a slice of it.
+	XMMATRIX const		projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, SCENE_SIZE * 0.5f);
+	std::vector<uint32>	treeVisible;
+	std::vector<uint32>	flatVisible;
+	double				treeMilliseconds = 0.0;
+	double				flatMilliseconds = 0.0;
+	uint64				visibleCount = 0;
+	for (uint32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		float const		angle = XMConvertToRadians(360.0f) * frame / FRAME_COUNT;
+		XMVECTOR const	eye = XMVectorSet(SCENE_SIZE * 0.5f, SCENE_SIZE * 0.5f, SCENE_SIZE * 0.5f, 0.0f);
+		XMVECTOR const	focus = XMVectorAdd(eye, XMVectorSet(cosf(angle), 0.2f * sinf(2.0f * angle), sinf(angle), 0.0f));
+		XMMATRIX const	viewProjection = XMMatrixMultiply(XMMatrixLookAtLH(eye, focus, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), projection);
+
+		treeVisible.clear();
+		auto	start = std::chrono::high_resolution_clock::now();
+		tree.Cull(viewProjection, treeVisible);
+		treeMilliseconds += GetMilliseconds(start);
+
+		flatVisible.clear();
+		start = std::chrono::high_resolution_clock::now();
+		flat.Cull(viewProjection, flatVisible);
+		flatMilliseconds += GetMilliseconds(start);
+
+		std::sort(treeVisible.begin(), treeVisible.end());
+		Check(treeVisible == flatVisible, "the tree and the flat test see the same boxes");
+		visibleCount += treeVisible.size();
+	}
+	printf("cull: tree %.3f ms, flat %.3f ms, %.0f of %u boxes visible\n", treeMilliseconds / FRAME_COUNT, flatMilliseconds / FRAME_COUNT,
+		static_cast<double>(visibleCount) / FRAME_COUNT, BOX_COUNT);
+
+	// Rays from random points in random directions.
+	std::vector<XMFLOAT3>	origins(RAY_COUNT);
+	std::vector<XMFLOAT3>	directions(RAY_COUNT);
+	for (uint32 ray = 0; ray < RAY_COUNT; ++ray)
+	{
+		origins[ray] = XMFLOAT3(position(random), position(random), position(random));
+		XMStoreFloat3(&directions[ray], RandomDirection(random));
+	}
+
+	uint32	hits = 0;
+	auto const	rayStart = std::chrono::high_resolution_clock::now();
+	for (uint32 ray = 0; ray < RAY_COUNT; ++ray)
+	{
+		float	distance;
+		if (tree.RayCast(XMLoadFloat3(&origins[ray]), XMLoadFloat3(&directions[ray]), distance) != BoundingVolumeHierarchy::InvalidPrimitive)
+			++hits;
+	}
+	double const	rayMilliseconds = GetMilliseconds(rayStart);
+	printf("ray casts: %.0f ns per ray, %u of %u hit\n", rayMilliseconds * 1000000.0 / RAY_COUNT, hits, RAY_COUNT);
+
+	for (uint32 ray = 0; ray < CHECKED_RAY_COUNT; ++ray)
+	{
+		float			nearest = FLT_MAX;
+		for (auto const& box : boxes)
+			nearest = std::min(nearest, IntersectBox(origins[ray], directions[ray], box));
+
+		float			distance;
+		uint32 const	primitive = tree.RayCast(XMLoadFloat3(&origins[ray]), XMLoadFloat3(&directions[ray]), distance);
+		Check((primitive == BoundingVolumeHierarchy::InvalidPrimitive) == (nearest == FLT_MAX), "the tree hits when some box is hit");
+		Check(distance == nearest, "the tree finds the nearest box");
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+//
+// DirectXCollision.h
+// The bounding volumes the portable sources pass around, without their intersection tests.
+//
+
+#pragma once
+
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+	struct BoundingBox
+	{
+		BoundingBox() : Center(0.0f, 0.0f, 0.0f), Extents(1.0f, 1.0f, 1.0f) { }
+		BoundingBox(XMFLOAT3 const& center, XMFLOAT3 const& extents) : Center(center), Extents(extents) { }
+
+		XMFLOAT3	Center;
+		XMFLOAT3	Extents;
+	};
+
+	struct BoundingSphere
+	{
+		BoundingSphere() : Center(0.0f, 0.0f, 0.0f), Radius(1.0f) { }
+		BoundingSphere(XMFLOAT3 const& center, float radius) : Center(center), Radius(radius) { }
+
+		XMFLOAT3	Center;
+		float		Radius;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,304 @@
+//
+// DirectXMath.h
+// The part of DirectXMath the portable sources use, with the same names and row vector conventions.
+// Plain scalar code, vectors and matrices are ordinary structs.
+//
+
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+
+namespace DirectX
+{
+	struct XMFLOAT2
+	{
+		XMFLOAT2() { }
+		XMFLOAT2(float _x, float _y) : x(_x), y(_y) { }
+
+		float	x;
+		float	y;
+	};
+
+	struct XMFLOAT3
+	{
+		XMFLOAT3() { }
+		XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) { }
+
+		float	x;
+		float	y;
+		float	z;
+	};
+
+	struct XMFLOAT4
+	{
+		XMFLOAT4() { }
+		XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) { }
+
+		float	x;
+		float	y;
+		float	z;
+		float	w;
+	};
+
+	struct XMFLOAT4X4
+	{
+		XMFLOAT4X4() { }
+
+		float	operator()(size_t row, size_t column) const	{ return m[row][column]; }
+		float&	operator()(size_t row, size_t column)		{ return m[row][column]; }
+
+		float	m[4][4];
+	};
+
+	struct XMVECTOR
+	{
+		float	v[4];
+	};
+
+	struct XMMATRIX
+	{
+		XMVECTOR	r[4];
+	};
+
+	typedef XMVECTOR const	FXMVECTOR;
+	typedef XMMATRIX const&	CXMMATRIX;
+
+	XMVECTOR const	g_XMFltMax = { { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX } };
+
+	inline float XMConvertToRadians(float degrees)
+	{
+		return degrees * (3.14159265f / 180.0f);
+	}
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		XMVECTOR	result = { { x, y, z, w } };
+		return result;
+	}
+
+	inline XMVECTOR XMVectorReplicate(float value)
+	{
+		return XMVectorSet(value, value, value, value);
+	}
+
+	inline XMVECTOR XMVectorZero()
+	{
+		return XMVectorReplicate(0.0f);
+	}
+
+	inline float XMVectorGetX(FXMVECTOR vector)
+	{
+		return vector.v[0];
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]);
+	}
+
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]);
+	}
+
+	inline XMVECTOR XMVectorScale(FXMVECTOR vector, float scale)
+	{
+		return XMVectorSet(vector.v[0] * scale, vector.v[1] * scale, vector.v[2] * scale, vector.v[3] * scale);
+	}
+
+	inline XMVECTOR XMVectorNegate(FXMVECTOR vector)
+	{
+		return XMVectorScale(vector, -1.0f);
+	}
+
+	// A zero component gives an infinity of its sign, like the real one.
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR vector)
+	{
+		return XMVectorSet(1.0f / vector.v[0], 1.0f / vector.v[1], 1.0f / vector.v[2], 1.0f / vector.v[3]);
+	}
+
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(fminf(a.v[0], b.v[0]), fminf(a.v[1], b.v[1]), fminf(a.v[2], b.v[2]), fminf(a.v[3], b.v[3]));
+	}
+
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(fmaxf(a.v[0], b.v[0]), fmaxf(a.v[1], b.v[1]), fmaxf(a.v[2], b.v[2]), fmaxf(a.v[3], b.v[3]));
+	}
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]);
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR vector)
+	{
+		return XMVector3Dot(vector, vector);
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0], 0.0f);
+	}
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR vector)
+	{
+		float const	length = sqrtf(XMVectorGetX(XMVector3LengthSq(vector)));
+		return length > 0.0f ? XMVectorScale(vector, 1.0f / length) : vector;
+	}
+
+	inline bool XMVector3Equal(FXMVECTOR a, FXMVECTOR b)
+	{
+		return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+	}
+
+	// Divides the plane by the length of its normal.
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane)
+	{
+		float const	length = sqrtf(XMVectorGetX(XMVector3LengthSq(plane)));
+		return length > 0.0f ? XMVectorScale(plane, 1.0f / length) : plane;
+	}
+
+	inline XMVECTOR XMLoadFloat3(XMFLOAT3 const* source)
+	{
+		return XMVectorSet(source->x, source->y, source->z, 0.0f);
+	}
+
+	inline XMVECTOR XMLoadFloat4(XMFLOAT4 const* source)
+	{
+		return XMVectorSet(source->x, source->y, source->z, source->w);
+	}
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR vector)
+	{
+		*destination = XMFLOAT3(vector.v[0], vector.v[1], vector.v[2]);
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR vector)
+	{
+		*destination = XMFLOAT4(vector.v[0], vector.v[1], vector.v[2], vector.v[3]);
+	}
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		XMMATRIX	result = {};
+		for (int i = 0; i < 4; ++i)
+			result.r[i].v[i] = 1.0f;
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		XMMATRIX	result = XMMatrixIdentity();
+		result.r[3] = XMVectorSet(x, y, z, 1.0f);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixMultiply(CXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX	result = {};
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				for (int i = 0; i < 4; ++i)
+					result.r[row].v[column] += a.r[row].v[i] * b.r[i].v[column];
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranspose(CXMMATRIX matrix)
+	{
+		XMMATRIX	result;
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				result.r[row].v[column] = matrix.r[column].v[row];
+		return result;
+	}
+
+	// Gauss-Jordan elimination with partial pivoting. A singular matrix gives a zero determinant and an undefined result.
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, CXMMATRIX matrix)
+	{
+		XMMATRIX	left = matrix;
+		XMMATRIX	result = XMMatrixIdentity();
+		float		product = 1.0f;
+		for (int column = 0; column < 4; ++column)
+		{
+			int	pivot = column;
+			for (int row = column + 1; row < 4; ++row)
+			{
+				if (fabsf(left.r[row].v[column]) > fabsf(left.r[pivot].v[column]))
+					pivot = row;
+			}
+			if (pivot != column)
+			{
+				XMVECTOR const	swapLeft = left.r[pivot];
+				XMVECTOR const	swapResult = result.r[pivot];
+				left.r[pivot] = left.r[column];
+				result.r[pivot] = result.r[column];
+				left.r[column] = swapLeft;
+				result.r[column] = swapResult;
+				product = -product;
+			}
+
+			float const	value = left.r[column].v[column];
+			product *= value;
+			if (value == 0.0f)
+				break;
+			left.r[column] = XMVectorScale(left.r[column], 1.0f / value);
+			result.r[column] = XMVectorScale(result.r[column], 1.0f / value);
+			for (int row = 0; row < 4; ++row)
+			{
+				float const	factor = left.r[row].v[column];
+				if (row == column || factor == 0.0f)
+					continue;
+				left.r[row] = XMVectorSubtract(left.r[row], XMVectorScale(left.r[column], factor));
+				result.r[row] = XMVectorSubtract(result.r[row], XMVectorScale(result.r[column], factor));
+			}
+		}
+		if (determinant)
+			*determinant = XMVectorReplicate(product);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up)
+	{
+		XMVECTOR const	zAxis = XMVector3Normalize(XMVectorSubtract(focus, eye));
+		XMVECTOR const	xAxis = XMVector3Normalize(XMVector3Cross(up, zAxis));
+		XMVECTOR const	yAxis = XMVector3Cross(zAxis, xAxis);
+		XMMATRIX		result;
+		for (int row = 0; row < 3; ++row)
+			result.r[row] = XMVectorSet(xAxis.v[row], yAxis.v[row], zAxis.v[row], 0.0f);
+		result.r[3] = XMVectorSet(-XMVectorGetX(XMVector3Dot(xAxis, eye)), -XMVectorGetX(XMVector3Dot(yAxis, eye)), -XMVectorGetX(XMVector3Dot(zAxis, eye)), 1.0f);
+		return result;
+	}
+
+	// Clip depth in [0, 1].
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float const	height = 1.0f / tanf(fovAngleY * 0.5f);
+		float const	range = farZ / (farZ - nearZ);
+		XMMATRIX	result = {};
+		result.r[0].v[0] = height / aspectRatio;
+		result.r[1].v[1] = height;
+		result.r[2].v[2] = range;
+		result.r[2].v[3] = 1.0f;
+		result.r[3].v[2] = -range * nearZ;
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, CXMMATRIX matrix)
+	{
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				destination->m[row][column] = matrix.r[row].v[column];
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(XMFLOAT4X4 const* source)
+	{
+		XMMATRIX	result;
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				result.r[row].v[column] = source->m[row][column];
+		return result;
+	}
+}
\ No newline at end of file
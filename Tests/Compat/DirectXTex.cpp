@@ -0,0 +1,78 @@
+#include "DirectXTex.h"
+
+using namespace DirectX;
+
+bool DirectX::IsSRGB(DXGI_FORMAT fmt)
+{
+	return fmt == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || fmt == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+}
+
+size_t TexMetadata::ComputeIndex(size_t mip, size_t item, size_t slice) const
+{
+	if (mip >= mipLevels || item >= arraySize || slice > 0)
+		return size_t(-1);
+	return item * mipLevels + mip;
+}
+
+HRESULT ScratchImage::Initialize(TexMetadata const& mdata)
+{
+	if (mdata.dimension != TEX_DIMENSION_TEXTURE2D || mdata.depth != 1 || !mdata.width || !mdata.height ||
+		!mdata.arraySize || !mdata.mipLevels)
+		return E_INVALIDARG;
+	if (mdata.format == DXGI_FORMAT_UNKNOWN || mdata.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+		return E_NOTIMPL;
+
+	m_metadata = mdata;
+	m_images.clear();
+
+	size_t	total = 0;
+	for (size_t item = 0; item < mdata.arraySize; ++item)
+	{
+		size_t	width = mdata.width;
+		size_t	height = mdata.height;
+		for (size_t mip = 0; mip < mdata.mipLevels; ++mip)
+		{
+			Image const	image = { width, height, mdata.format, width * 4, width * 4 * height, nullptr };
+			m_images.push_back(image);
+			total += image.slicePitch;
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+	}
+
+	m_memory.assign(total, 0);
+	uint8_t*	pixels = m_memory.data();
+	for (auto& image : m_images)
+	{
+		image.pixels = pixels;
+		pixels += image.slicePitch;
+	}
+	return S_OK;
+}
+
+HRESULT ScratchImage::Initialize2D(DXGI_FORMAT fmt, size_t width, size_t height, size_t arraySize, size_t mipLevels)
+{
+	TexMetadata const	mdata = { width, height, 1, arraySize, mipLevels, 0, 0, fmt, TEX_DIMENSION_TEXTURE2D };
+	return Initialize(mdata);
+}
+
+Image const* ScratchImage::GetImage(size_t mip, size_t item, size_t slice) const
+{
+	size_t const	index = m_metadata.ComputeIndex(mip, item, slice);
+	return index < m_images.size() ? &m_images[index] : nullptr;
+}
+
+HRESULT DirectX::Resize(Image const&, size_t, size_t, DWORD, ScratchImage&)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT DirectX::Convert(Image const&, DXGI_FORMAT, DWORD, float, ScratchImage&)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT DirectX::GenerateMipMaps(Image const*, size_t, TexMetadata const&, DWORD, size_t, ScratchImage&)
+{
+	return E_NOTIMPL;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+//
+// DirectXTex.h
+// The part of DirectXTex the texture fast paths use, with the same names and values. Images are held in
+// memory only and every operation the fast paths forward to DirectXTex returns E_NOTIMPL.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef int32_t		HRESULT;
+typedef uint32_t	DWORD;
+
+#define S_OK			((HRESULT)0)
+#define E_NOTIMPL		((HRESULT)0x80004001)
+#define E_FAIL			((HRESULT)0x80004005)
+#define E_OUTOFMEMORY	((HRESULT)0x8007000E)
+#define E_INVALIDARG	((HRESULT)0x80070057)
+#define SUCCEEDED(hr)	(((HRESULT)(hr)) >= 0)
+#define FAILED(hr)		(((HRESULT)(hr)) < 0)
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+	DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91
+};
+
+namespace DirectX
+{
+	bool	IsSRGB(DXGI_FORMAT fmt);
+
+	enum TEX_DIMENSION
+	{
+		TEX_DIMENSION_TEXTURE1D = 2,
+		TEX_DIMENSION_TEXTURE2D = 3,
+		TEX_DIMENSION_TEXTURE3D = 4
+	};
+
+	struct TexMetadata
+	{
+		size_t			width;
+		size_t			height;
+		size_t			depth;
+		size_t			arraySize;
+		size_t			mipLevels;
+		uint32_t		miscFlags;
+		uint32_t		miscFlags2;
+		DXGI_FORMAT		format;
+		TEX_DIMENSION	dimension;
+
+		// Returns size_t(-1) to indicate an out-of-range error.
+		size_t	ComputeIndex(size_t mip, size_t item, size_t slice) const;
+	};
+
+	struct Image
+	{
+		size_t		width;
+		size_t		height;
+		DXGI_FORMAT	format;
+		size_t		rowPitch;
+		size_t		slicePitch;
+		uint8_t*	pixels;
+	};
+
+	// 2D textures of 32 bits per pixel only.
+	class ScratchImage
+	{
+	public:
+		HRESULT	Initialize(TexMetadata const& mdata);
+		HRESULT	Initialize2D(DXGI_FORMAT fmt, size_t width, size_t height, size_t arraySize, size_t mipLevels);
+
+		Image const*		GetImage(size_t mip, size_t item, size_t slice) const;
+		Image const*		GetImages() const		{ return m_images.data(); }
+		size_t				GetImageCount() const	{ return m_images.size(); }
+		TexMetadata const&	GetMetadata() const		{ return m_metadata; }
+		size_t				GetPixelsSize() const	{ return m_memory.size(); }
+
+	private:
+		TexMetadata				m_metadata;
+		std::vector<Image>		m_images;
+		std::vector<uint8_t>	m_memory;
+	};
+
+	enum TEX_FILTER_FLAGS
+	{
+		TEX_FILTER_DEFAULT = 0,
+		TEX_FILTER_WRAP_U = 0x1,
+		TEX_FILTER_WRAP_V = 0x2,
+		TEX_FILTER_WRAP_W = 0x4,
+		TEX_FILTER_WRAP = (TEX_FILTER_WRAP_U | TEX_FILTER_WRAP_V | TEX_FILTER_WRAP_W),
+		TEX_FILTER_DITHER = 0x10000,
+		TEX_FILTER_DITHER_DIFFUSION = 0x20000,
+		TEX_FILTER_POINT = 0x100000,
+		TEX_FILTER_LINEAR = 0x200000,
+		TEX_FILTER_CUBIC = 0x300000,
+		TEX_FILTER_BOX = 0x400000,
+		TEX_FILTER_TRIANGLE = 0x500000,
+		TEX_FILTER_SRGB_IN = 0x1000000,
+		TEX_FILTER_SRGB_OUT = 0x2000000,
+		TEX_FILTER_SRGB = (TEX_FILTER_SRGB_IN | TEX_FILTER_SRGB_OUT)
+	};
+
+	HRESULT	Resize(Image const& srcImage, size_t width, size_t height, DWORD filter, ScratchImage& image);
+	HRESULT	Convert(Image const& srcImage, DXGI_FORMAT format, DWORD filter, float threshold, ScratchImage& image);
+	HRESULT	GenerateMipMaps(Image const* srcImages, size_t nimages, TexMetadata const& metadata, DWORD filter, size_t levels, ScratchImage& mipChain);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+//
+// pch.h
+// Stand-in for the application header, for building the portable sources on their own.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// The application gets these from C++/CX.
+typedef uint8_t		uint8;
+typedef uint16_t	uint16;
+typedef uint32_t	uint32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+
+#include "DirectXMath.h"
+#include "DirectXTex.h"
+
+#define DIVE_THREAD_LOCAL thread_local
+
+// Windows SDK helpers. The debug reports go nowhere, like in a release build.
+#define ZeroMemory(destination, length)	memset((destination), 0, (length))
+#define ARRAYSIZE(array)				(sizeof(array) / sizeof((array)[0]))
+#define _RPT0(type, format)
+#define _RPT1(type, format, a1)
+#define _RPT2(type, format, a1, a2)
+#define _RPT3(type, format, a1, a2, a3)
+#define _RPT4(type, format, a1, a2, a3, a4)
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "FramePacer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Dive;
+
+// Replays synthetic 60 Hz traces through the frame pacer. Every frame is presented on the vsync after its
+// slowest stage, the GPU time shrinks with the rendered pixel count and the CPU time does not scale.
+
+namespace
+{
+	double const	VSYNC_MS = 1000.0 / 60.0;
+	uint32 const	TRACE_FRAMES = 3000;
+
+	void Check(bool condition, char const* trace, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s: %s\n", trace, what);
+			exit(1);
+		}
+	}
+
+	struct TraceResult
+	{
+		uint32	LateFrames;
+		uint32	ScaleChanges;
+		uint32	MaxUpscaleDelay;
+		uint32	CpuBoundFrames;
+		float	FinalScale;
+		// Range of the scale over the second half of the trace.
+		float	SettledMin;
+		float	SettledMax;
+	};
+
+	// gpuMs is the GPU time at full resolution.
+	template <class GpuTime>
+	TraceResult Replay(char const* name, bool gpuKnown, GpuTime const& gpuMs, double cpuMs)
+	{
+		FramePacer	pacer;
+		TraceResult	result = { 0, 0, 0, 0, 1.0f, 1.0f, 0.0f };
+
+		for (uint32 frame = 0; frame < TRACE_FRAMES; ++frame)
+		{
+			float const		scale = pacer.GetRenderScale();
+			double const	gpu = gpuMs(frame) * scale * scale;
+			double const	busy = gpu > cpuMs ? gpu : cpuMs;
+			double const	frameMs = ceil(busy / VSYNC_MS - 1e-9) * VSYNC_MS;
+			if (frameMs > VSYNC_MS * 1.01)
+				++result.LateFrames;
+
+			pacer.AddFrame(frameMs, cpuMs, gpuKnown ? gpu : 0.0);
+			if (pacer.GetLastDecision() == PACING_CPU_BOUND)
+				++result.CpuBoundFrames;
+			if (pacer.GetUpscaleDelay() > result.MaxUpscaleDelay)
+				result.MaxUpscaleDelay = pacer.GetUpscaleDelay();
+			if (frame >= TRACE_FRAMES / 2)
+			{
+				result.SettledMin = scale < result.SettledMin ? scale : result.SettledMin;
+				result.SettledMax = scale > result.SettledMax ? scale : result.SettledMax;
+			}
+		}
+
+		result.ScaleChanges = pacer.GetScaleChanges();
+		result.FinalScale = pacer.GetRenderScale();
+		printf("%-22s late %4u/%u, %2u changes, final scale %.2f, settled in [%.2f, %.2f]\n", name, result.LateFrames, TRACE_FRAMES,
+			   result.ScaleChanges, result.FinalScale, result.SettledMin, result.SettledMax);
+		return result;
+	}
+
+	void TestLightLoad()
+	{
+		for (bool gpuKnown : { false, true })
+		{
+			TraceResult const	result = Replay(gpuKnown ? "light, GPU time" : "light, frame time", gpuKnown, [](uint32) { return 10.0; }, 5.0);
+			Check(result.LateFrames == 0 && result.ScaleChanges == 0, "light", "a load with headroom keeps full resolution");
+		}
+	}
+
+	void TestHeavyLoad()
+	{
+		// 25 ms at full resolution needs a scale below sqrt(16.7 / 25) = 0.82.
+		auto const	heavy = [](uint32) { return 25.0; };
+
+		TraceResult const	known = Replay("heavy, GPU time", true, heavy, 5.0);
+		Check(known.SettledMin == known.SettledMax, "heavy with GPU time", "settles on one scale");
+		Check(known.FinalScale >= 0.65f && known.FinalScale < 0.82f, "heavy with GPU time", "settles just below the limit");
+		Check(known.LateFrames <= 20, "heavy with GPU time", "few late frames");
+
+		// By frame time alone the pacer cannot see headroom, it keeps probing a step up with growing waits.
+		TraceResult const	unknown = Replay("heavy, frame time", false, heavy, 5.0);
+		Check(unknown.SettledMax < 0.9f, "heavy by frame time", "stays scaled down");
+		Check(unknown.MaxUpscaleDelay >= 4 * FramePacerSettings().FastFrames, "heavy by frame time", "failed steps up back off");
+		Check(unknown.LateFrames <= 100, "heavy by frame time", "late frames limited by the backoff");
+	}
+
+	void TestSpike()
+	{
+		// A heavy stretch between frames 300 and 900.
+		auto const	spike = [](uint32 frame) { return frame >= 300 && frame < 900 ? 24.0 : 12.0; };
+		for (bool gpuKnown : { false, true })
+		{
+			TraceResult const	result = Replay(gpuKnown ? "spike, GPU time" : "spike, frame time", gpuKnown, spike, 5.0);
+			Check(result.FinalScale == 1.0f, "spike", "returns to full resolution once the load drops");
+		}
+	}
+
+	void TestCpuBound()
+	{
+		for (bool gpuKnown : { false, true })
+		{
+			TraceResult const	result = Replay(gpuKnown ? "CPU bound, GPU time" : "CPU bound, frame time", gpuKnown, [](uint32) { return 10.0; }, 22.0);
+			Check(result.ScaleChanges == 0, "CPU bound", "a lower resolution would not help");
+			Check(result.CpuBoundFrames > 0, "CPU bound", "reported as CPU bound");
+		}
+	}
+
+	void TestHistory()
+	{
+		FramePacer	pacer;
+		uint32 const	frameCount = 500;
+		for (uint32 frame = 0; frame < frameCount; ++frame)
+			pacer.AddFrame(40.0, 5.0, 0.0);
+
+		std::vector<PacingRecord>	history;
+		pacer.GetHistory(history);
+		uint32 const	length = pacer.GetSettings().HistoryLength;
+		Check(history.size() == length, "history", "keeps HistoryLength frames");
+		Check(history.front().Frame == frameCount - length && history.back().Frame == frameCount - 1, "history", "oldest first");
+		Check(pacer.GetRenderScale() == pacer.GetSettings().MinScale, "history", "a hopeless load ends at the lower bound");
+	}
+
+	void TestFixedScale()
+	{
+		FramePacerSettings	settings;
+		settings.MinScale = settings.MaxScale = 1.0f;
+		FramePacer	pacer(settings);
+		for (uint32 frame = 0; frame < 500; ++frame)
+			Check(!pacer.AddFrame(40.0, 5.0, 0.0), "fixed scale", "equal bounds turn the controller off");
+	}
+}
+
+int main()
+{
+	TestLightLoad();
+	TestHeavyLoad();
+	TestSpike();
+	TestCpuBound();
+	TestHistory();
+	TestFixedScale();
+	return 0;
+}
\ No newline at end of file
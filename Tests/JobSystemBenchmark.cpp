@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace Dive;
+
+// Scaling of ParallelFor over worker counts and grain sizes, and the cost of an empty job.
+// Prints timings only, it is not run by ctest.
+
+namespace
+{
+	uint32 const	ELEMENT_COUNT = 1 << 20;
+	uint32 const	REPEAT_COUNT = 5;
+	uint32 const	EMPTY_JOB_COUNT = 100000;
+
+	double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+int main()
+{
+	std::vector<float>	values(ELEMENT_COUNT);
+
+	for (uint32 workerCount : { 1u, 2u, 4u, 8u })
+	{
+		JobSystem	jobSystem(workerCount);
+
+		for (uint32 grainSize : { 1u, 64u, 4096u })
+		{
+			auto const	start = std::chrono::high_resolution_clock::now();
+			for (uint32 repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+			{
+				jobSystem.ParallelFor(0, ELEMENT_COUNT, grainSize, [&](uint32 i)
+				{
+					values[i] = sqrtf(static_cast<float>(i)) * 1.0001f + values[i] * 0.5f;
+				});
+			}
+			printf("%u workers, grain %4u: %.2f ms per loop\n", workerCount, grainSize, GetMilliseconds(start) / REPEAT_COUNT);
+		}
+
+		auto const	start = std::chrono::high_resolution_clock::now();
+		JobCounter	counter;
+		for (uint32 i = 0; i < EMPTY_JOB_COUNT; ++i)
+			jobSystem.Run([] { }, &counter);
+		jobSystem.Wait(counter);
+		printf("%u workers, empty job: %.0f ns\n", workerCount, GetMilliseconds(start) * 1000000.0 / EMPTY_JOB_COUNT);
+	}
+
+	// Keeps the loop from being optimized away.
+	printf("checksum %f\n", values[12345]);
+	return 0;
+}
\ No newline at end of file
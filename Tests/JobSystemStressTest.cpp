@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Dive;
+
+// Runs every scheduling path of the job system many times over, fails on the first wrong result.
+// Meant to be run under ThreadSanitizer and AddressSanitizer as well, see CMakeLists.txt.
+
+namespace
+{
+	uint32 const	ROUND_COUNT = 20;
+
+	void Check(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", what);
+			exit(1);
+		}
+	}
+
+	// Fork-join recursion: every level waits on the job it spawned.
+	uint64 Fibonacci(JobSystem& jobSystem, uint32 n)
+	{
+		if (n < 12)
+		{
+			uint64	a = 0, b = 1;
+			for (uint32 i = 0; i < n; ++i)
+			{
+				uint64 const	next = a + b;
+				a = b;
+				b = next;
+			}
+			return a;
+		}
+
+		uint64		left = 0;
+		JobCounter	counter;
+		jobSystem.Run([&] { left = Fibonacci(jobSystem, n - 1); }, &counter);
+		uint64 const	right = Fibonacci(jobSystem, n - 2);
+		jobSystem.Wait(counter);
+		return left + right;
+	}
+
+	void TestForkJoin(JobSystem& jobSystem)
+	{
+		Check(Fibonacci(jobSystem, 24) == 46368, "nested fork-join");
+	}
+
+	void TestParallelFor(JobSystem& jobSystem)
+	{
+		std::vector<uint32>	values(100000, 0);
+		jobSystem.ParallelFor(0, static_cast<uint32>(values.size()), 37, [&](uint32 i) { values[i] += i; });
+		for (uint32 i = 0; i < values.size(); ++i)
+			Check(values[i] == i, "every index visited once by ParallelFor");
+
+		std::atomic<uint32>	count(0);
+		jobSystem.ParallelFor(0, 64, 1, [&](uint32)
+		{
+			jobSystem.ParallelFor(0, 100, 7, [&](uint32) { count.fetch_add(1); });
+		});
+		Check(count.load() == 6400, "nested ParallelFor");
+	}
+
+	void TestDependencies(JobSystem& jobSystem)
+	{
+		JobCounter			first, second, third;
+		std::atomic<uint32>	firstDone(0);
+		std::atomic<uint32>	stage(0);
+		bool				ordered = true;
+
+		for (uint32 i = 0; i < 50; ++i)
+			jobSystem.Run([&] { std::this_thread::yield(); firstDone.fetch_add(1); }, &first);
+		jobSystem.RunAfter(first, [&]
+		{
+			ordered &= firstDone.load() == 50 && stage.load() == 0;
+			stage.store(1);
+		}, &second);
+		jobSystem.RunAfter(second, [&]
+		{
+			ordered &= stage.load() == 1;
+			stage.store(2);
+		}, &third);
+
+		jobSystem.Wait(third);
+		Check(ordered && stage.load() == 2, "RunAfter chain runs in order");
+	}
+
+	void TestThreadAffinity(JobSystem& jobSystem)
+	{
+		std::thread::id const	mainThread = std::this_thread::get_id();
+		JobCounter				counter;
+		std::atomic<uint32>		onMain(0), offMain(0);
+		std::atomic<uint32>		foreignJobs(0);
+
+		// Main-thread jobs posted from workers only run here, while this thread waits.
+		for (uint32 i = 0; i < 200; ++i)
+		{
+			jobSystem.Run([&]
+			{
+				jobSystem.RunOnMainThread([&]
+				{
+					if (std::this_thread::get_id() == mainThread)
+						onMain.fetch_add(1);
+					else
+						offMain.fetch_add(1);
+				}, &counter);
+			}, &counter);
+		}
+
+		// Threads the job system does not know go through the shared queue.
+		std::vector<std::thread>	foreignThreads;
+		for (uint32 t = 0; t < 3; ++t)
+		{
+			foreignThreads.emplace_back([&]
+			{
+				for (uint32 i = 0; i < 1000; ++i)
+					jobSystem.Run([&] { foreignJobs.fetch_add(1); }, &counter);
+			});
+		}
+		for (auto& thread : foreignThreads)
+			thread.join();
+
+		jobSystem.Wait(counter);
+		Check(onMain.load() == 200 && offMain.load() == 0, "main-thread jobs run on the main thread");
+		Check(foreignJobs.load() == 3000, "jobs from foreign threads");
+	}
+
+	struct WorkerJob : Job
+	{
+		std::atomic<uint32>*	onMain;
+		std::thread::id			mainThread;
+
+		static void	Run(Job* job)
+		{
+			auto const	self = static_cast<WorkerJob*>(job);
+			if (std::this_thread::get_id() == self->mainThread)
+				self->onMain->fetch_add(1);
+		}
+	};
+
+	void TestWorkerJobs(JobSystem& jobSystem)
+	{
+		if (!jobSystem.GetWorkerCount())
+			return;
+
+		JobCounter				counter;
+		std::atomic<uint32>		onMain(0);
+		std::vector<WorkerJob>	jobs(500);
+		for (auto& job : jobs)
+		{
+			job.Entry = &WorkerJob::Run;
+			job.Counter = &counter;
+			job.onMain = &onMain;
+			job.mainThread = std::this_thread::get_id();
+			jobSystem.SubmitToWorker(job);
+		}
+
+		// Busy work in between, so the main thread looks for jobs while it waits.
+		JobCounter	busy;
+		for (uint32 i = 0; i < 500; ++i)
+			jobSystem.Run([] { std::this_thread::yield(); }, &busy);
+		jobSystem.Wait(busy);
+		jobSystem.Wait(counter);
+		Check(onMain.load() == 0, "worker jobs never run on the main thread");
+	}
+
+	void TestOverflow(JobSystem& jobSystem)
+	{
+		// More jobs than a deque holds, the rest spill to the shared queue.
+		JobCounter			counter;
+		std::atomic<uint32>	count(0);
+		for (uint32 i = 0; i < 10000; ++i)
+			jobSystem.Run([&] { count.fetch_add(1); }, &counter);
+		jobSystem.Wait(counter);
+		Check(count.load() == 10000, "jobs past the deque capacity");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32 const	workerCount = argc > 1 ? static_cast<uint32>(atoi(argv[1])) : 4;
+
+	for (uint32 round = 0; round < ROUND_COUNT; ++round)
+	{
+		JobSystem	jobSystem(workerCount);
+		TestForkJoin(jobSystem);
+		TestParallelFor(jobSystem);
+		TestDependencies(jobSystem);
+		TestThreadAffinity(jobSystem);
+		TestWorkerJobs(jobSystem);
+		TestOverflow(jobSystem);
+	}
+
+	printf("%u rounds with %u workers passed\n", ROUND_COUNT, workerCount);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "MeshClusters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DirectX;
+using namespace Dive;
+
+// BuildMeshClusters over a finely tessellated sphere, then ClusterCuller::Cull from cameras orbiting it,
+// one far enough to see it whole and one close enough for the frustum to cut it. The clusters have to
+// cover the mesh and the cones have to face out of it, the run fails otherwise. Prints timings, it is not
+// run by ctest.
+
+namespace
+{
+	uint32 const	RING_COUNT = 256;
+	uint32 const	SEGMENT_COUNT = 512;
+	uint32 const	BUILD_REPEAT_COUNT = 3;
+	uint32 const	FRAME_COUNT = 200;
+
+	void Check(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", what);
+			exit(1);
+		}
+	}
+
+	double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Unit sphere around the origin, one vertex per pole, clockwise seen from outside.
+	void BuildSphere(std::vector<VertexPositionColorNormalUV>& vertices, std::vector<uint32>& indices)
+	{
+		VertexPositionColorNormalUV	vertex = {};
+		vertex.Pos = XMFLOAT3(0.0f, 1.0f, 0.0f);
+		vertices.push_back(vertex);
+		for (uint32 ring = 1; ring < RING_COUNT; ++ring)
+		{
+			float const	theta = XMConvertToRadians(180.0f) * ring / RING_COUNT;
+			for (uint32 segment = 0; segment < SEGMENT_COUNT; ++segment)
+			{
+				float const	phi = XMConvertToRadians(360.0f) * segment / SEGMENT_COUNT;
+				vertex.Pos = XMFLOAT3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				vertices.push_back(vertex);
+			}
+		}
+		vertex.Pos = XMFLOAT3(0.0f, -1.0f, 0.0f);
+		vertices.push_back(vertex);
+
+		uint32 const	bottom = static_cast<uint32>(vertices.size() - 1);
+		auto const		ringVertex = [](uint32 ring, uint32 segment) { return 1 + (ring - 1) * SEGMENT_COUNT + segment % SEGMENT_COUNT; };
+		for (uint32 segment = 0; segment < SEGMENT_COUNT; ++segment)
+		{
+			indices.insert(indices.end(), { 0, ringVertex(1, segment), ringVertex(1, segment + 1) });
+			for (uint32 ring = 1; ring + 1 < RING_COUNT; ++ring)
+			{
+				uint32 const	a = ringVertex(ring, segment);
+				uint32 const	b = ringVertex(ring, segment + 1);
+				uint32 const	c = ringVertex(ring + 1, segment);
+				uint32 const	d = ringVertex(ring + 1, segment + 1);
+				indices.insert(indices.end(), { a, c, b, b, c, d });
+			}
+			indices.insert(indices.end(), { bottom, ringVertex(RING_COUNT - 1, segment + 1), ringVertex(RING_COUNT - 1, segment) });
+		}
+	}
+
+	void CullOrbit(char const* name, float distance, std::vector<MeshCluster> const& clusters, std::vector<uint32> const& clusterIndices)
+	{
+		std::vector<uint32>	destination(clusterIndices.size());
+		ClusterCuller		culler;
+		XMMATRIX const		projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+		uint64				visibleIndices = 0;
+		double				milliseconds = 0.0;
+		for (uint32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			float const		angle = XMConvertToRadians(360.0f) * frame / FRAME_COUNT;
+			XMVECTOR const	eye = XMVectorSet(distance * cosf(angle), 0.3f * distance * sinf(3.0f * angle), distance * sinf(angle), 0.0f);
+			culler.SetView(XMMatrixIdentity(), XMMatrixLookAtLH(eye, XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), projection);
+
+			auto const	start = std::chrono::high_resolution_clock::now();
+			visibleIndices += culler.Cull(clusters.data(), static_cast<uint32>(clusters.size()), clusterIndices.data(), destination.data());
+			milliseconds += GetMilliseconds(start);
+		}
+
+		ClusterCuller::Stats const&	stats = culler.GetStats();
+		Check(stats.Clusters == clusters.size() * FRAME_COUNT, "every cluster is tested every frame");
+		Check(stats.BackfaceCulled > 0, "the far side of the sphere is culled by its cones");
+		Check(visibleIndices < static_cast<uint64>(clusterIndices.size()) * FRAME_COUNT, "some triangles are culled");
+		printf("%s: %.1f ns per cluster, %.1f%% frustum culled, %.1f%% backface culled, %.1f%% of the triangles drawn\n",
+			name, milliseconds * 1000000.0 / stats.Clusters, 100.0 * stats.FrustumCulled / stats.Clusters, 100.0 * stats.BackfaceCulled / stats.Clusters,
+			100.0 * visibleIndices / (static_cast<double>(clusterIndices.size()) * FRAME_COUNT));
+	}
+}
+
+int main()
+{
+	std::vector<VertexPositionColorNormalUV>	vertices;
+	std::vector<uint32>							indices;
+	BuildSphere(vertices, indices);
+
+	std::vector<MeshCluster>	clusters;
+	std::vector<uint32>			clusterIndices;
+	double						milliseconds = 0.0;
+	for (uint32 repeat = 0; repeat < BUILD_REPEAT_COUNT; ++repeat)
+	{
+		clusters.clear();
+		clusterIndices.clear();
+		auto const	start = std::chrono::high_resolution_clock::now();
+		BuildMeshClusters(indices.data(), static_cast<uint32>(indices.size()), vertices.data(), static_cast<uint32>(vertices.size()), clusters, clusterIndices);
+		milliseconds += GetMilliseconds(start);
+	}
+
+	Check(clusterIndices.size() == indices.size(), "every triangle lands in one cluster");
+	uint32	coneCount = 0;
+	for (auto const& cluster : clusters)
+	{
+		Check(cluster.IndexCount && cluster.IndexCount <= MaxClusterTriangles * 3, "clusters hold at most MaxClusterTriangles triangles");
+		if (cluster.ConeCutoff >= 1.0f)
+			continue;
+		++coneCount;
+		Check(cluster.ConeAxis.x * cluster.Center.x + cluster.ConeAxis.y * cluster.Center.y + cluster.ConeAxis.z * cluster.Center.z > 0.0f, "cones face out of the sphere");
+	}
+
+	uint32 const	triangleCount = static_cast<uint32>(indices.size() / 3);
+	printf("%u triangles: %.2f ms to build %u clusters, %.1f triangles per cluster, %u with a cone\n",
+		triangleCount, milliseconds / BUILD_REPEAT_COUNT, static_cast<uint32>(clusters.size()), static_cast<double>(triangleCount) / clusters.size(), coneCount);
+
+	CullOrbit("whole sphere", 4.0f, clusters, clusterIndices);
+	CullOrbit("close up", 1.5f, clusters, clusterIndices);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "ConstantBufferRing.h"
+#include "JobSystem.h"
+#include "RecordingRenderDevice.h"
+#include "RenderQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DirectX;
+using namespace Dive;
+
+// Execute time of the render queue over the number of command lists it records in parallel, on the
+// recording device. Every list count has to reach the device with the draws and constants of a single
+// list, the run fails otherwise. Prints timings, it is not run by ctest.
+
+namespace
+{
+	uint32 const	DRAW_COUNT = 20000;
+	uint32 const	MESH_COUNT = 64;
+	uint32 const	MATERIAL_COUNT = 16;
+	uint32 const	INDEX_COUNT = 36;
+	uint32 const	INSTANCE_CAPACITY = 4096;
+	uint32 const	FRAME_COUNT = 50;
+
+	typedef RecordingRenderDevice	Device;
+
+	// What the device got from one frame, the part that must not depend on how it was recorded.
+	struct FrameCounts
+	{
+		bool	operator==(FrameCounts const& other) const
+		{
+			return DrawCalls == other.DrawCalls && InstancedDrawCalls == other.InstancedDrawCalls && Triangles == other.Triangles &&
+				   ConstantUpdates == other.ConstantUpdates && UploadBytes == other.UploadBytes;
+		}
+
+		uint32	DrawCalls;
+		uint32	InstancedDrawCalls;
+		uint32	Triangles;
+		uint32	ConstantUpdates;
+		uint64	UploadBytes;
+	};
+
+	FrameCounts GetFrameCounts(Device::Stats const& device, RenderStats const& stats)
+	{
+		FrameCounts	counts;
+		counts.DrawCalls = device.Commands[Device::COMMAND_DRAW_INDEXED] + device.Commands[Device::COMMAND_DRAW_INDEXED_INSTANCED];
+		counts.InstancedDrawCalls = device.Commands[Device::COMMAND_DRAW_INDEXED_INSTANCED];
+		counts.Triangles = device.Triangles;
+		counts.ConstantUpdates = device.Commands[Device::COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE] + device.Commands[Device::COMMAND_UPDATE_BUFFER];
+		counts.UploadBytes = device.UploadBytes;
+		if (counts.DrawCalls != stats.DrawCalls || counts.ConstantUpdates != stats.ConstantUpdates)
+		{
+			fprintf(stderr, "FAILED: the device got %u draws and %u constant updates, the queue counted %u and %u\n",
+				counts.DrawCalls, counts.ConstantUpdates, stats.DrawCalls, stats.ConstantUpdates);
+			exit(1);
+		}
+		return counts;
+	}
+}
+
+int main()
+{
+	// The queue records on the global job system.
+	JobSystem&	jobSystem = JobSystem::Get();
+
+	auto const			device = std::make_shared<Device>(1280.0f, 720.0f);
+	ConstantBufferRing	ring(device, DRAW_COUNT * ConstantBufferRing::Alignment);
+	ring.CreateDeviceDependentResources();
+
+	uint8 const		bytecode[16] = {};
+	ShaderProgram	program;
+	program.Id = 0;
+	program.InputLayout = device->CreateInputLayout(nullptr, 0, bytecode, sizeof(bytecode));
+	program.VertexShader = device->CreateVertexShader(bytecode, sizeof(bytecode));
+	program.PixelShader = device->CreatePixelShader(bytecode, sizeof(bytecode));
+	ShaderProgram	instancedProgram = program;
+	instancedProgram.Id = 1;
+	instancedProgram.VertexShader = device->CreateVertexShader(bytecode, sizeof(bytecode));
+
+	std::vector<std::unique_ptr<RenderBuffer>>	vertexBuffers;
+	std::vector<std::unique_ptr<RenderBuffer>>	indexBuffers;
+	for (uint32 mesh = 0; mesh < MESH_COUNT; ++mesh)
+	{
+		vertexBuffers.push_back(device->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_IMMUTABLE, 24 * sizeof(VertexPositionColor), nullptr));
+		indexBuffers.push_back(device->CreateBuffer(BIND_INDEX_BUFFER, USAGE_IMMUTABLE, INDEX_COUNT * sizeof(uint16), nullptr));
+	}
+	auto const	constantBuffer = device->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_DEFAULT, sizeof(ModelViewProjectionConstantBuffer), nullptr);
+	auto const	instanceBuffer = device->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_DYNAMIC, INSTANCE_CAPACITY * sizeof(InstanceData), nullptr);
+
+	ModelViewProjectionConstantBuffer	constants;
+	XMStoreFloat4x4(&constants.Model, XMMatrixIdentity());
+	constants.View = constants.Model;
+	constants.Projection = constants.Model;
+	constants.MaterialIndex = 0.0f;
+
+	// Every fourth draw can be instanced, the others are drawn one by one.
+	RenderQueue	queue;
+	queue.SetConstantRing(&ring);
+	queue.SetInstanceBuffer(instanceBuffer.get(), INSTANCE_CAPACITY);
+	for (uint32 draw = 0; draw < DRAW_COUNT; ++draw)
+	{
+		uint32 const	mesh = draw * 7 % MESH_COUNT;
+		uint32 const	material = draw * 13 % MATERIAL_COUNT;
+		DrawItem		item;
+		item.SortKey = RenderQueue::MakeSortKey(RenderQueue::PASS_OPAQUE, program.Id, material, mesh, (draw % 1000) / 1000.0f);
+		item.Program = &program;
+		item.InstancedProgram = draw % 4 ? nullptr : &instancedProgram;
+		item.Texture = nullptr;
+		item.VertexBuffer = vertexBuffers[mesh].get();
+		item.IndexBuffer = indexBuffers[mesh].get();
+		item.IndexFormat = DXGI_FORMAT_R16_UINT;
+		item.VertexStride = sizeof(VertexPositionColor);
+		item.IndexCount = INDEX_COUNT;
+		item.StartIndex = 0;
+		item.MaterialIndex = material;
+		XMStoreFloat4x4(&item.Model, XMMatrixIdentity());
+		queue.Submit(item);
+	}
+
+	FrameCounts	single = {};
+	for (uint32 threadCount : { 1u, 2u, 4u, 8u })
+	{
+		queue.SetRecordingThreads(threadCount);
+
+		float const	clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		double		milliseconds = 0.0;
+		for (uint32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			device->ResetStats();
+			device->BeginFrame(clearColor);
+			device->SetVertexConstantBuffer(0, constantBuffer.get());
+			ring.BeginFrame();
+			// Starts the frame's stats, the order it sorts into is the same every frame.
+			queue.Sort();
+			auto const	start = std::chrono::high_resolution_clock::now();
+			queue.Execute(*device, constantBuffer.get(), constants);
+			milliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			ring.EndFrame();
+			device->Present();
+
+			FrameCounts const	counts = GetFrameCounts(device->GetStats(), queue.GetStats());
+			if (threadCount == 1)
+				single = counts;
+			else if (!(counts == single))
+			{
+				fprintf(stderr, "FAILED: %u lists issued %u draws and %u constant updates, one list issued %u and %u\n",
+					queue.GetStats().CommandLists, counts.DrawCalls, counts.ConstantUpdates, single.DrawCalls, single.ConstantUpdates);
+				return 1;
+			}
+		}
+
+		RenderStats const&	stats = queue.GetStats();
+		printf("%u workers, %u lists: %.3f ms per Execute, %u draws, %u instanced, %u constant updates, %u state changes\n",
+			jobSystem.GetWorkerCount(), stats.CommandLists, milliseconds / FRAME_COUNT, stats.DrawCalls, stats.InstancedDrawCalls, stats.ConstantUpdates, stats.GetStateChanges());
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include "pch.h"
+#include "ConstantBufferRing.h"
+#include "RecordingRenderDevice.h"
+#include "RenderQueue.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DirectX;
+using namespace Dive;
+
+// Renders frames through the render queue and the constant ring the way Sample3DRenderer does, on the
+// recording device, and checks the commands, draws and uploads that reach the device against the queue's stats.
+
+namespace
+{
+	uint32 const	MESH_COUNT = 8;
+	uint32 const	MATERIAL_COUNT = 4;
+	uint32 const	INDEX_COUNT = 36;
+	uint32 const	VERTEX_COUNT = 24;
+	uint32 const	INSTANCE_CAPACITY = 1024;
+	uint32 const	FRAME_COUNT = 6;
+	uint32 const	RING_SIZE = 1024 * 1024;
+
+	typedef RecordingRenderDevice	Device;
+
+	void Check(bool condition, char const* test, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s: %s\n", test, what);
+			exit(1);
+		}
+	}
+
+	// Programs, meshes and buffers of a small scene, created on the recording device.
+	struct Scene
+	{
+		Scene(uint32 ringSize) :
+		RecordingDevice(std::make_shared<Device>(1280.0f, 720.0f)),
+		Ring(RecordingDevice, ringSize)
+		{
+			uint8 const	bytecode[16] = {};
+			Program.Id = 0;
+			Program.InputLayout = RecordingDevice->CreateInputLayout(nullptr, 0, bytecode, sizeof(bytecode));
+			Program.VertexShader = RecordingDevice->CreateVertexShader(bytecode, sizeof(bytecode));
+			Program.PixelShader = RecordingDevice->CreatePixelShader(bytecode, sizeof(bytecode));
+			InstancedProgram.Id = 1;
+			InstancedProgram.InputLayout = RecordingDevice->CreateInputLayout(nullptr, 0, bytecode, sizeof(bytecode));
+			InstancedProgram.VertexShader = RecordingDevice->CreateVertexShader(bytecode, sizeof(bytecode));
+			InstancedProgram.PixelShader = Program.PixelShader;
+			SecondProgram.Id = 2;
+			SecondProgram.InputLayout = Program.InputLayout;
+			SecondProgram.VertexShader = Program.VertexShader;
+			SecondProgram.PixelShader = RecordingDevice->CreatePixelShader(bytecode, sizeof(bytecode));
+
+			for (uint32 mesh = 0; mesh < MESH_COUNT; ++mesh)
+			{
+				VertexBuffers.push_back(RecordingDevice->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_IMMUTABLE, VERTEX_COUNT * sizeof(VertexPositionColor), nullptr));
+				IndexBuffers.push_back(RecordingDevice->CreateBuffer(BIND_INDEX_BUFFER, USAGE_IMMUTABLE, INDEX_COUNT * sizeof(uint16), nullptr));
+			}
+			ConstantBuffer = RecordingDevice->CreateBuffer(BIND_CONSTANT_BUFFER, USAGE_DEFAULT, sizeof(ModelViewProjectionConstantBuffer), nullptr);
+			InstanceBuffer = RecordingDevice->CreateBuffer(BIND_VERTEX_BUFFER, USAGE_DYNAMIC, INSTANCE_CAPACITY * sizeof(InstanceData), nullptr);
+			Ring.CreateDeviceDependentResources();
+
+			XMStoreFloat4x4(&Constants.Model, XMMatrixIdentity());
+			Constants.View = Constants.Model;
+			Constants.Projection = Constants.Model;
+			Constants.MaterialIndex = 0.0f;
+		}
+
+		DrawItem	MakeDraw(uint32 mesh, uint32 material, float depth, bool instanced) const
+		{
+			DrawItem	item;
+			item.SortKey = RenderQueue::MakeSortKey(RenderQueue::PASS_OPAQUE, Program.Id, material, 0, depth);
+			item.Program = &Program;
+			item.InstancedProgram = instanced ? &InstancedProgram : nullptr;
+			item.Texture = nullptr;
+			item.VertexBuffer = VertexBuffers[mesh].get();
+			item.IndexBuffer = IndexBuffers[mesh].get();
+			item.IndexFormat = DXGI_FORMAT_R16_UINT;
+			item.VertexStride = sizeof(VertexPositionColor);
+			item.IndexCount = INDEX_COUNT;
+			item.StartIndex = 0;
+			item.MaterialIndex = material;
+			XMStoreFloat4x4(&item.Model, XMMatrixIdentity());
+			return item;
+		}
+
+		// One frame of Sample3DRenderer::Render, returns what the device saw.
+		Device::Stats	RenderFrame(RenderQueue& queue)
+		{
+			float const	clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			RecordingDevice->ResetStats();
+			RecordingDevice->BeginFrame(clearColor);
+			RecordingDevice->SetVertexConstantBuffer(0, ConstantBuffer.get());
+			Ring.BeginFrame();
+			queue.Execute(*RecordingDevice, ConstantBuffer.get(), Constants);
+			Ring.EndFrame();
+			RecordingDevice->Present();
+			return RecordingDevice->GetStats();
+		}
+
+		std::shared_ptr<Device>						RecordingDevice;
+		ConstantBufferRing							Ring;
+		ShaderProgram								Program;
+		ShaderProgram								InstancedProgram;
+		ShaderProgram								SecondProgram;
+		std::vector<std::unique_ptr<RenderBuffer>>	VertexBuffers;
+		std::vector<std::unique_ptr<RenderBuffer>>	IndexBuffers;
+		std::unique_ptr<RenderBuffer>				ConstantBuffer;
+		std::unique_ptr<RenderBuffer>				InstanceBuffer;
+		ModelViewProjectionConstantBuffer			Constants;
+	};
+
+	// The device sees exactly the draws and state changes the queue counted.
+	void CheckFrame(char const* test, Device::Stats const& device, RenderStats const& stats)
+	{
+		uint32 const	draws = device.Commands[Device::COMMAND_DRAW_INDEXED] + device.Commands[Device::COMMAND_DRAW_INDEXED_INSTANCED];
+		Check(draws == stats.DrawCalls, test, "every counted draw reaches the device");
+		Check(device.Commands[Device::COMMAND_DRAW_INDEXED_INSTANCED] == stats.InstancedDrawCalls, test, "instanced draws reach the device");
+		Check(device.Triangles == stats.Triangles, test, "triangles match");
+		Check(device.Commands[Device::COMMAND_SET_PIXEL_SHADER] == stats.ShaderChanges, test, "a shader change binds the pixel shader");
+		Check(device.Commands[Device::COMMAND_SET_VERTEX_BUFFER] == stats.GeometryChanges, test, "a geometry change binds the vertex buffer");
+		Check(device.Commands[Device::COMMAND_SET_INDEX_BUFFER] == stats.GeometryChanges, test, "a geometry change binds the index buffer");
+		uint32 const	constantUploads = device.Commands[Device::COMMAND_SET_VERTEX_CONSTANT_BUFFER_RANGE] + device.Commands[Device::COMMAND_UPDATE_BUFFER];
+		Check(constantUploads == stats.ConstantUpdates, test, "every draw's constants are bound from the ring or updated");
+		Check(device.Frames == 1, test, "one frame presented");
+	}
+
+	void TestSeparateDraws()
+	{
+		Scene		scene(RING_SIZE);
+		RenderQueue	queue;
+		queue.SetConstantRing(&scene.Ring);
+		uint32 const	drawCount = 1000;
+		for (uint32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			queue.Clear();
+			for (uint32 draw = 0; draw < drawCount; ++draw)
+				queue.Submit(scene.MakeDraw(draw % MESH_COUNT, draw % MATERIAL_COUNT, (draw % 97) / 97.0f, false));
+			queue.Sort();
+			Device::Stats const	device = scene.RenderFrame(queue);
+			RenderStats const&	stats = queue.GetStats();
+
+			CheckFrame("separate draws", device, stats);
+			Check(stats.DrawCalls == drawCount && stats.InstancedDrawCalls == 0, "separate draws", "one draw per item");
+			Check(device.Commands[Device::COMMAND_UPDATE_BUFFER] == 0, "separate draws", "the ring holds every draw");
+			Check(device.Commands[Device::COMMAND_MAP_BUFFER] == 1, "separate draws", "the ring is uploaded once");
+			Check(device.UploadBytes == drawCount * ConstantBufferRing::Alignment, "separate draws", "only the ring's used range is uploaded");
+			Check(device.Commands[Device::COMMAND_SET_VERTEX_CONSTANT_BUFFER] == 2, "separate draws", "the caller's constant buffer is bound again after the ring");
+		}
+	}
+
+	// Draws of two programs over every mesh and material in both passes, in a scrambled order. Each draw's
+	// StartIndex is its submission index, so the device's draw commands tell which draw came when.
+	std::vector<uint64> SubmitScrambled(Scene const& scene, RenderQueue& queue, uint32 drawCount)
+	{
+		std::vector<uint64>	keys;
+		uint32				seed = 12345;
+		for (uint32 draw = 0; draw < drawCount; ++draw)
+		{
+			seed = seed * 1664525 + 1013904223;
+			uint32 const			mesh = (seed >> 8) % MESH_COUNT;
+			uint32 const			material = (seed >> 16) % MATERIAL_COUNT;
+			float const				depth = ((seed >> 4) % 97) / 97.0f;
+			RenderQueue::Pass const	pass = (seed >> 28) & 1 ? RenderQueue::PASS_DEPTH : RenderQueue::PASS_OPAQUE;
+			ShaderProgram const&	program = (seed >> 24) & 1 ? scene.SecondProgram : scene.Program;
+
+			// The mesh stands in for the texture set, the key field below the material.
+			DrawItem	item = scene.MakeDraw(mesh, material, depth, false);
+			item.SortKey = RenderQueue::MakeSortKey(pass, program.Id, material, mesh, depth);
+			item.Program = &program;
+			item.StartIndex = draw;
+			keys.push_back(item.SortKey);
+			queue.Submit(item);
+		}
+		return keys;
+	}
+
+	// Submission indices of the last frame's draws, in the order the device got them.
+	std::vector<uint32> GetDrawOrder(Device const& device)
+	{
+		std::vector<uint32>	order;
+		for (auto const& command : device.GetLastFrameCommands())
+		{
+			if (command.Type == Device::COMMAND_DRAW_INDEXED)
+				order.push_back(command.Arguments[1]);
+		}
+		return order;
+	}
+
+	void TestSortOrder()
+	{
+		Scene		scene(RING_SIZE);
+		RenderQueue	queue;
+		queue.SetConstantRing(&scene.Ring);
+		// One list, a list boundary binds everything again.
+		queue.SetRecordingThreads(1);
+		uint32 const	drawCount = 2000;
+
+		queue.SetSortEnabled(false);
+		SubmitScrambled(scene, queue, drawCount);
+		queue.Sort();
+		CheckFrame("unsorted", scene.RenderFrame(queue), queue.GetStats());
+		RenderStats const	unsorted = queue.GetStats();
+		Check(unsorted.GetStateChanges() == unsorted.UnsortedStateChanges, "unsorted", "submission order costs the counted state changes");
+		std::vector<uint32>	order = GetDrawOrder(*scene.RecordingDevice);
+		Check(order.size() == drawCount, "unsorted", "every draw is issued");
+		for (uint32 draw = 0; draw < drawCount; ++draw)
+			Check(order[draw] == draw, "unsorted", "draws are issued in submission order");
+
+		queue.SetSortEnabled(true);
+		queue.Clear();
+		std::vector<uint64> const	keys = SubmitScrambled(scene, queue, drawCount);
+		queue.Sort();
+		CheckFrame("sorted", scene.RenderFrame(queue), queue.GetStats());
+		RenderStats const	sorted = queue.GetStats();
+		Check(sorted.UnsortedStateChanges == unsorted.UnsortedStateChanges, "sorted", "the same draws count the same unsorted changes");
+		// 2 passes, 2 programs, 4 materials and 8 meshes are 128 groups of draws.
+		Check(sorted.GetStateChanges() * 8 < unsorted.GetStateChanges(), "sorted", "sorting saves most state changes");
+
+		order = GetDrawOrder(*scene.RecordingDevice);
+		Check(order.size() == drawCount, "sorted", "every draw is issued");
+		std::vector<bool>	issued(drawCount, false);
+		for (uint32 draw = 0; draw < drawCount; ++draw)
+		{
+			Check(order[draw] < drawCount && !issued[order[draw]], "sorted", "every draw is issued once");
+			issued[order[draw]] = true;
+			if (!draw)
+				continue;
+			uint32 const	previous = order[draw - 1];
+			Check(keys[previous] <= keys[order[draw]], "sorted", "draws are issued in key order");
+			Check(keys[previous] != keys[order[draw]] || previous < order[draw], "sorted", "draws with equal keys keep their submission order");
+		}
+	}
+
+	void TestInstancing()
+	{
+		Scene		scene(RING_SIZE);
+		RenderQueue	queue;
+		queue.SetConstantRing(&scene.Ring);
+		queue.SetInstanceBuffer(scene.InstanceBuffer.get(), INSTANCE_CAPACITY);
+		uint32 const	drawCount = 800;
+		for (uint32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			queue.Clear();
+			for (uint32 draw = 0; draw < drawCount; ++draw)
+				queue.Submit(scene.MakeDraw(draw % MESH_COUNT, draw % MATERIAL_COUNT, (draw % 97) / 97.0f, true));
+			queue.Sort();
+			Device::Stats const	device = scene.RenderFrame(queue);
+			RenderStats const&	stats = queue.GetStats();
+
+			CheckFrame("instancing", device, stats);
+			// Draws sharing a mesh and a material, 8 meshes and 4 materials give 8 combinations.
+			Check(stats.InstancedDrawCalls == MESH_COUNT && stats.Instances == drawCount, "instancing", "one instanced draw per mesh and material");
+			Check(device.Commands[Device::COMMAND_MAP_BUFFER] == 2, "instancing", "the ring and the instances are uploaded once each");
+			Check(device.UploadBytes == scene.Ring.GetUsedBytes() + drawCount * sizeof(InstanceData), "instancing", "only the written instances and constants are uploaded");
+		}
+	}
+
+	void TestRingOverflow()
+	{
+		// Room for four draws, the ring doubles until a frame fits.
+		Scene		scene(4 * ConstantBufferRing::Alignment);
+		RenderQueue	queue;
+		queue.SetConstantRing(&scene.Ring);
+		uint32 const	drawCount = 100;
+		uint32		firstFallbacks = 0;
+		uint32		lastFallbacks = 0;
+		for (uint32 frame = 0; frame < 4 * ConstantBufferRing::FrameCount; ++frame)
+		{
+			queue.Clear();
+			for (uint32 draw = 0; draw < drawCount; ++draw)
+				queue.Submit(scene.MakeDraw(draw % MESH_COUNT, draw % MATERIAL_COUNT, 0.5f, false));
+			queue.Sort();
+			Device::Stats const	device = scene.RenderFrame(queue);
+
+			CheckFrame("ring overflow", device, queue.GetStats());
+			if (!frame)
+				firstFallbacks = device.Commands[Device::COMMAND_UPDATE_BUFFER];
+			lastFallbacks = device.Commands[Device::COMMAND_UPDATE_BUFFER];
+		}
+		Check(firstFallbacks == drawCount - 4, "ring overflow", "draws past the ring update the caller's buffer");
+		Check(lastFallbacks == 0, "ring overflow", "the grown ring holds the whole frame");
+	}
+}
+
+int main()
+{
+	TestSeparateDraws();
+	TestSortOrder();
+	TestInstancing();
+	TestRingOverflow();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "Common/StepTimer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DX;
+
+// Drives the step timer with a manual clock, so every frame takes exactly as long as the test says.
+
+namespace
+{
+	double const	FRAME_SECONDS = 1.0 / 60.0;
+
+	void Check(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", what);
+			exit(1);
+		}
+	}
+
+	// Runs frameCount ticks of the given length and returns how many updates they ran.
+	uint32 Run(ManualStepClock& clock, StepTimer& timer, uint32 frameCount, double frameSeconds)
+	{
+		uint32	updates = 0;
+		for (uint32 frame = 0; frame < frameCount; ++frame)
+		{
+			clock.AdvanceSeconds(frameSeconds);
+			timer.Tick([&] { ++updates; });
+		}
+		return updates;
+	}
+
+	void TestVariableStep()
+	{
+		ManualStepClock	clock;
+		StepTimer		timer(clock);
+		uint32 const	updates = Run(clock, timer, 120, FRAME_SECONDS);
+		Check(updates == 120 && timer.GetFrameCount() == 120, "a variable step updates once per tick");
+		Check(timer.GetFramePerSecond() == 60, "120 ticks over two seconds count 60 frames per second");
+	}
+
+	void TestFixedStep()
+	{
+		ManualStepClock	clock;
+		StepTimer		timer(clock);
+		timer.SetFixedTimeStep(true);
+		timer.SetTargetElapsedSeconds(FRAME_SECONDS);
+
+		uint32	updates = Run(clock, timer, 60, FRAME_SECONDS);
+		Check(updates == 60 && timer.GetFramePerSecond() == 60, "frames at the target rate step once each");
+
+		// 50 ms is three fixed steps, all run by the next tick.
+		updates += Run(clock, timer, 1, 0.050);
+		Check(updates == 63 && timer.GetFrameCount() == 63, "60 frames and a 50 ms hitch run 63 updates");
+		Check(timer.GetElapsedTicks() == timer.GetTotalTicks() / 63, "every update is one fixed step");
+	}
+
+	void TestInterpolationAlpha()
+	{
+		ManualStepClock	clock;
+		StepTimer		timer(clock);
+		Run(clock, timer, 10, FRAME_SECONDS);
+		Check(timer.GetInterpolationAlpha() == 1.0, "a variable step does not blend");
+
+		timer.SetFixedTimeStep(true);
+		timer.SetTargetElapsedSeconds(FRAME_SECONDS);
+		Check(Run(clock, timer, 1, FRAME_SECONDS * 1.5) == 1, "a frame and a half runs one step");
+		Check(fabs(timer.GetInterpolationAlpha() - 0.5) < 0.001, "the half step left over is the alpha");
+		Check(Run(clock, timer, 1, FRAME_SECONDS * 0.25) == 0, "a quarter frame runs no step");
+		Check(fabs(timer.GetInterpolationAlpha() - 0.75) < 0.001, "the alpha grows with the time left over");
+	}
+
+	void TestStepCap()
+	{
+		ManualStepClock	clock;
+		StepTimer		timer(clock);
+		timer.SetFixedTimeStep(true);
+		timer.SetTargetElapsedSeconds(FRAME_SECONDS);
+		timer.SetMaxStepsPerTick(4);
+		Run(clock, timer, 60, FRAME_SECONDS);
+		uint64 const	totalBefore = timer.GetTotalTicks();
+
+		// 500 ms: the tick clamps it to 100 ms, runs 4 of those 6 steps and drops the rest.
+		uint32 const	updates = Run(clock, timer, 1, 0.5);
+		Check(updates == 4, "the cap limits the steps of one tick");
+		Check(fabs(timer.GetDroppedSeconds() - 0.5 + 4 * FRAME_SECONDS) < 0.001, "everything the tick did not simulate is dropped");
+
+		uint64 const	accounted = timer.GetTotalTicks() - totalBefore + timer.GetDroppedTicks() + static_cast<uint64>(timer.GetInterpolationAlpha() * StepTimer::SecondsToTicks(FRAME_SECONDS) + 0.5);
+		Check(llabs(static_cast<long long>(accounted - StepTimer::SecondsToTicks(0.5))) <= 2, "simulated, dropped and left over time add up to the hitch");
+
+		// The next frame at the target rate is back to one step.
+		Check(Run(clock, timer, 1, FRAME_SECONDS) == 1, "the frame after a hitch steps once");
+	}
+}
+
+int main()
+{
+	TestVariableStep();
+	TestFixedStep();
+	TestInterpolationAlpha();
+	TestStepCap();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "Task.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace Dive;
+
+// Loads per second of the shader load graph of Sample3DRenderer, written as coroutines and as a chain of
+// continuations. The chain stands in for the PPL tasks of the Windows build: shared state and a function
+// object per step, every continuation scheduled as a job. Prints timings only, it is not run by ctest.
+// Takes the worker count.
+
+namespace
+{
+	uint32 const	LOAD_COUNT = 100000;
+	uint32 const	REPEAT_COUNT = 2;
+
+	// Stands in for reading a shader and creating its objects.
+	uint32 Work(uint32 value)
+	{
+		volatile uint32	sum = value;
+		for (uint32 i = 0; i < 50; ++i)
+			sum = sum + i;
+		return sum;
+	}
+
+	template <class T>
+	class ChainState
+	{
+	public:
+		ChainState() : m_ready(false), m_value() { }
+
+		void	Set(T value)
+		{
+			std::vector<std::function<void()>>	next;
+			{
+				std::lock_guard<std::mutex>	lock(m_mutex);
+				m_value = value;
+				m_ready = true;
+				next.swap(m_next);
+			}
+			for (auto& function : next)
+				function();
+		}
+
+		void	OnReady(std::function<void()> function)
+		{
+			{
+				std::lock_guard<std::mutex>	lock(m_mutex);
+				if (!m_ready)
+				{
+					m_next.push_back(std::move(function));
+					return;
+				}
+			}
+			function();
+		}
+
+		T	GetValue() const	{ return m_value; }
+
+	private:
+		std::mutex							m_mutex;
+		bool								m_ready;
+		T									m_value;
+		std::vector<std::function<void()>>	m_next;
+	};
+
+	typedef std::shared_ptr<ChainState<uint32>>	Chain;
+
+	Chain Start(JobSystem& jobSystem, uint32 value)
+	{
+		Chain const	result = std::make_shared<ChainState<uint32>>();
+		jobSystem.Run([result, value] { result->Set(Work(value)); });
+		return result;
+	}
+
+	Chain Then(JobSystem& jobSystem, Chain const& source)
+	{
+		Chain const	result = std::make_shared<ChainState<uint32>>();
+		source->OnReady([&jobSystem, source, result] { jobSystem.Run([source, result] { result->Set(Work(source->GetValue())); }); });
+		return result;
+	}
+
+	Chain Both(Chain const& first, Chain const& second)
+	{
+		Chain const		result = std::make_shared<ChainState<uint32>>();
+		auto const		pending = std::make_shared<std::atomic<uint32>>(2);
+		auto const		join = [first, second, result, pending]
+		{
+			if (pending->fetch_sub(1) == 1)
+				result->Set(first->GetValue() + second->GetValue());
+		};
+		first->OnReady(join);
+		second->OnReady(join);
+		return result;
+	}
+
+	// Three reads, one create step after each, then the cube and the instance buffer once their shaders exist.
+	void ChainLoad(JobSystem& jobSystem, std::atomic<uint32>& done, uint32 index)
+	{
+		Chain const	vertexShader = Then(jobSystem, Start(jobSystem, index));
+		Chain const	pixelShader = Then(jobSystem, Start(jobSystem, index + 1));
+		Chain const	instancedShader = Then(jobSystem, Start(jobSystem, index + 2));
+		Chain const	cube = Then(jobSystem, Both(pixelShader, vertexShader));
+		Chain const	instances = Then(jobSystem, Both(Both(cube, instancedShader), pixelShader));
+		instances->OnReady([&done] { ++done; });
+	}
+
+	Task<uint32> Read(JobSystem& jobSystem, uint32 value)
+	{
+		co_await ResumeOnWorker(jobSystem);
+		co_return Work(value);
+	}
+
+	Task<void> CoroutineLoad(JobSystem& jobSystem, std::atomic<uint32>& done, uint32 index)
+	{
+		auto const		shaders = co_await WhenAll(Read(jobSystem, index), Read(jobSystem, index + 1), Read(jobSystem, index + 2));
+		uint32 const	vertexShader = Work(std::get<0>(shaders));
+		uint32 const	pixelShader = Work(std::get<1>(shaders));
+		uint32 const	instancedShader = Work(std::get<2>(shaders));
+		uint32 const	cube = Work(pixelShader + vertexShader);
+		Work(cube + instancedShader + pixelShader);
+		++done;
+	}
+
+	template <class Operation>
+	double LoadsPerSecond(std::atomic<uint32>& done, Operation const& operation)
+	{
+		done = 0;
+		auto const	start = std::chrono::high_resolution_clock::now();
+		operation();
+		return LOAD_COUNT / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	JobSystem				jobSystem(argc > 1 ? static_cast<uint32>(atoi(argv[1])) : 0);
+	std::atomic<uint32>		done(0);
+
+	for (uint32 repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+	{
+		double const	chain = LoadsPerSecond(done, [&]
+		{
+			for (uint32 index = 0; index < LOAD_COUNT; ++index)
+				ChainLoad(jobSystem, done, index);
+			while (done.load() < LOAD_COUNT)
+				std::this_thread::yield();
+		});
+		double const	coroutines = LoadsPerSecond(done, [&]
+		{
+			for (uint32 index = 0; index < LOAD_COUNT; ++index)
+				CoroutineLoad(jobSystem, done, index).Detach();
+			while (done.load() < LOAD_COUNT)
+				std::this_thread::yield();
+		});
+		printf("%u workers: continuations %.0f loads/s, coroutines %.0f loads/s\n", jobSystem.GetWorkerCount(), chain, coroutines);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "AsyncFile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace Dive;
+
+// Runs many coroutine loads at once on the job system: nested tasks, WhenAll, thread hops, file reads
+// and exceptions. Takes the path of a file to read.
+
+namespace
+{
+	uint32 const	LOAD_COUNT = 2000;
+
+	void Check(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", what);
+			exit(1);
+		}
+	}
+
+	struct LoadStats
+	{
+		LoadStats() : Done(0), Failed(0), WorkerStepsOnMain(0), MainStepsOffMain(0) { }
+
+		std::atomic<uint32>	Done;
+		std::atomic<uint32>	Failed;
+		std::atomic<uint32>	WorkerStepsOnMain;
+		std::atomic<uint32>	MainStepsOffMain;
+	};
+
+	Task<uint32> Square(LoadStats& stats, uint32 value)
+	{
+		co_await ResumeOnWorker();
+		if (JobSystem::Get().IsMainThread())
+			++stats.WorkerStepsOnMain;
+		co_return value * value;
+	}
+
+	Task<uint32> Fail()
+	{
+		co_await ResumeOnWorker();
+		throw std::runtime_error("failed step");
+	}
+
+	Task<void> Load(LoadStats& stats, std::string filename, size_t fileSize, uint32 index)
+	{
+		bool	ok = co_await Square(stats, index) == index * index;
+
+		auto	results = co_await WhenAll(Square(stats, index + 1), Square(stats, index + 2), ReadFileAsync(filename), ReadFileAsync(filename + ".missing"));
+		ok &= std::get<0>(results) == (index + 1) * (index + 1);
+		ok &= std::get<1>(results) == (index + 2) * (index + 2);
+		ok &= std::get<2>(results).size() == fileSize;
+		ok &= std::get<3>(results).empty();
+
+		co_await ResumeOnMainThread();
+		if (!JobSystem::Get().IsMainThread())
+			++stats.MainStepsOffMain;
+
+		bool	caught = false;
+		try
+		{
+			co_await Fail();
+		}
+		catch (std::runtime_error const&)
+		{
+			caught = true;
+		}
+		ok &= caught;
+
+		if (!ok)
+			++stats.Failed;
+		++stats.Done;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Check(argc > 1, "usage: TaskTest <file to read>");
+	FILE* const	file = fopen(argv[1], "rb");
+	Check(file != nullptr, "the file to read exists");
+	fseek(file, 0, SEEK_END);
+	size_t const	fileSize = static_cast<size_t>(ftell(file));
+	fclose(file);
+
+	JobSystem&	jobSystem = JobSystem::Get();
+	LoadStats	stats;
+	for (uint32 index = 0; index < LOAD_COUNT; ++index)
+		Load(stats, argv[1], fileSize, index).Detach();
+
+	// The loads come back here for their main thread steps.
+	while (stats.Done.load() < LOAD_COUNT)
+	{
+		jobSystem.RunMainThreadJobs();
+		std::this_thread::yield();
+	}
+
+	Check(stats.Failed.load() == 0, "every load gets its results and catches its exception");
+	Check(stats.WorkerStepsOnMain.load() == 0, "ResumeOnWorker never resumes on the main thread");
+	Check(stats.MainStepsOffMain.load() == 0, "ResumeOnMainThread resumes on the main thread");
+	printf("%u loads passed\n", LOAD_COUNT);
+	return 0;
+}
\ No newline at end of file
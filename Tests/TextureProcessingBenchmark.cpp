@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "TextureProcessing.h"
+#include "TextureProcessingScalar.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace DirectX;
+using namespace Dive;
+
+// Throughput of the vector kernels against the scalar ones, in milliseconds per source megapixel.
+// Prints timings only, it is not run by ctest.
+
+namespace
+{
+	size_t const	SIZE = 2048;
+	uint32 const	REPEAT_COUNT = 5;
+
+	template <class Operation>
+	double Measure(Operation const& operation)
+	{
+		auto const	start = std::chrono::high_resolution_clock::now();
+		for (uint32 repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+			operation();
+		double const	milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return milliseconds / REPEAT_COUNT / (SIZE * SIZE / 1000000.0);
+	}
+}
+
+int main()
+{
+	JobSystem::Get();
+
+	std::vector<uint8>	pixels(SIZE * SIZE * 4);
+	uint32	seed = 1;
+	for (auto& value : pixels)
+	{
+		seed = seed * 1664525 + 1013904223;
+		value = static_cast<uint8>(seed >> 24);
+	}
+
+	for (auto format : { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB })
+	{
+		Image const			image = { SIZE, SIZE, format, SIZE * 4, SIZE * SIZE * 4, pixels.data() };
+		TexMetadata const	metadata = { SIZE, SIZE, 1, 1, 1, 0, 0, format, TEX_DIMENSION_TEXTURE2D };
+		char const*			name = format == DXGI_FORMAT_R8G8B8A8_UNORM ? "UNORM" : "sRGB";
+		ScratchImage		result;
+
+		for (auto filter : { TEX_FILTER_BOX, TEX_FILTER_TRIANGLE })
+		{
+			char const*	filterName = filter == TEX_FILTER_BOX ? "box" : "triangle";
+			double const	vector = Measure([&] { GenerateTextureMipMaps(&image, 1, metadata, filter, 0, result); });
+			double const	parallel = Measure([&] { GenerateTextureMipMaps(&image, 1, metadata, filter, 0, result, true); });
+			double const	scalar = Measure([&] { GenerateTextureMipMapsScalar(&image, 1, metadata, filter, 0, result, false); });
+			printf("%-5s %-8s mips:    vector %.2f, parallel %.2f, scalar %.2f ms/MP\n", name, filterName, vector, parallel, scalar);
+		}
+
+		// BGRA in the same color space only swizzles, in the other one it goes through a curve as well.
+		bool const			srgb = IsSRGB(format);
+		DXGI_FORMAT const	sameSpace = srgb ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM;
+		DXGI_FORMAT const	otherSpace = srgb ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+		double const	vector = Measure([&] { ConvertTexture(image, sameSpace, TEX_FILTER_DEFAULT, 0.5f, result); });
+		double const	scalar = Measure([&] { ConvertTextureScalar(image, sameSpace, TEX_FILTER_DEFAULT, 0.5f, result); });
+		double const	curveVector = Measure([&] { ConvertTexture(image, otherSpace, TEX_FILTER_DEFAULT, 0.5f, result); });
+		double const	curveScalar = Measure([&] { ConvertTextureScalar(image, otherSpace, TEX_FILTER_DEFAULT, 0.5f, result); });
+		printf("%-5s to BGRA:         vector %.2f, scalar %.2f ms/MP\n", name, vector, scalar);
+		printf("%-5s to BGRA, curve:  vector %.2f, scalar %.2f ms/MP\n", name, curveVector, curveScalar);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+// The texture fast paths built again without their vector kernels, under other names, so the tests can
+// run both in one program.
+
+#define DIVE_TEXTURE_SCALAR
+#define ConvertTexture			ConvertTextureScalar
+#define ResizeTexture			ResizeTextureScalar
+#define GenerateTextureMipMaps	GenerateTextureMipMapsScalar
+
+#include "TextureProcessing.cpp"
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Dive
+{
+	// TextureProcessing.h entry points built with DIVE_TEXTURE_SCALAR, see TextureProcessingScalar.cpp.
+
+	HRESULT	ConvertTextureScalar(DirectX::Image const& srcImage, DXGI_FORMAT format, DWORD filter, float threshold, DirectX::ScratchImage& image);
+	HRESULT	ResizeTextureScalar(DirectX::Image const& srcImage, size_t width, size_t height, DWORD filter, DirectX::ScratchImage& image);
+	HRESULT	GenerateTextureMipMapsScalar(DirectX::Image const* srcImages, size_t nimages, DirectX::TexMetadata const& metadata, DWORD filter, size_t levels, DirectX::ScratchImage& mipChain, bool parallel);
+}
\ No newline at end of file
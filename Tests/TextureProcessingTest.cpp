@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "TextureProcessing.h"
+#include "TextureProcessingScalar.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+using namespace Dive;
+
+// The vector kernels have to match the scalar ones bit for bit, and both have to stay within 1 LSB of a float
+// filter computed here, for every format, filter and wrap mode and for sizes that leave vector loop tails.
+
+namespace
+{
+	int const	CHANNEL_COUNT = 4;
+	int const	TOLERANCE = 1;
+
+	DXGI_FORMAT const	FORMATS[] =
+	{
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+		DXGI_FORMAT_B8G8R8A8_UNORM,
+		DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+	};
+
+	DWORD const	FILTERS[] =
+	{
+		TEX_FILTER_BOX,
+		TEX_FILTER_TRIANGLE,
+		TEX_FILTER_TRIANGLE | TEX_FILTER_WRAP_U,
+		TEX_FILTER_TRIANGLE | TEX_FILTER_WRAP_V,
+		TEX_FILTER_TRIANGLE | TEX_FILTER_WRAP_U | TEX_FILTER_WRAP_V,
+		TEX_FILTER_BOX | TEX_FILTER_WRAP_V,
+		TEX_FILTER_BOX | TEX_FILTER_SRGB
+	};
+
+	// Heights 2 mod 4 make a wrapping window hold rows a multiple of 4 apart.
+	struct Size { size_t width, height; };
+	Size const	SIZES[] = { { 64, 64 }, { 2, 2 }, { 1, 8 }, { 8, 1 }, { 30, 6 }, { 22, 10 }, { 38, 14 }, { 130, 18 } };
+
+	uint32	s_checks = 0;
+
+	void Check(bool condition, char const* what, size_t width, size_t height, DXGI_FORMAT format, DWORD filter)
+	{
+		++s_checks;
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s, %zux%zu, format %d, filter 0x%x\n", what, width, height, format, filter);
+			exit(1);
+		}
+	}
+
+	// Source images with a padded row pitch and random contents from a fixed seed.
+	struct TestImage
+	{
+		TestImage(size_t width, size_t height, DXGI_FORMAT format, uint32 seed)
+			: memory((width * CHANNEL_COUNT + 12) * height)
+		{
+			image.width = width;
+			image.height = height;
+			image.format = format;
+			image.rowPitch = width * CHANNEL_COUNT + 12;
+			image.slicePitch = image.rowPitch * height;
+			image.pixels = memory.data();
+
+			for (auto& value : memory)
+			{
+				seed = seed * 1664525 + 1013904223;
+				value = static_cast<uint8>(seed >> 24);
+			}
+		}
+
+		std::vector<uint8>	memory;
+		Image				image;
+	};
+
+	float SRGBToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	size_t SampleIndex(ptrdiff_t index, size_t size, bool wrap)
+	{
+		auto const	count = static_cast<ptrdiff_t>(size);
+		if (wrap)
+			return static_cast<size_t>(((index % count) + count) % count);
+		return static_cast<size_t>(index < 0 ? 0 : index >= count ? count - 1 : index);
+	}
+
+	// Channel c of the source pixel at (x, y) in linear space, 0 to 1.
+	float LoadLinear(Image const& src, size_t x, size_t y, int c, bool srgb)
+	{
+		float const	value = src.pixels[y * src.rowPitch + x * CHANNEL_COUNT + c] / 255.0f;
+		return srgb && c != 3 ? SRGBToLinear(value) : value;
+	}
+
+	// One destination pixel of a 2:1 box or 1-3-3-1 triangle filter, without intermediate rounding.
+	// The box filter never wraps horizontally, a box pair never leaves the row.
+	uint8 ReferencePixel(Image const& src, size_t x, size_t y, int c, bool srgb, bool triangle, bool wrapU, bool wrapV)
+	{
+		float const	triangleWeights[] = { 1.0f, 3.0f, 3.0f, 1.0f };
+		float const	boxWeights[] = { 1.0f, 1.0f };
+		float const*	weights = triangle ? triangleWeights : boxWeights;
+		int const		taps = triangle ? 4 : 2;
+		ptrdiff_t const	first = triangle ? -1 : 0;
+
+		float	sum = 0.0f;
+		for (int j = 0; j < taps; ++j)
+		{
+			size_t const	row = SampleIndex(2 * static_cast<ptrdiff_t>(y) + first + j, src.height, wrapV);
+			for (int i = 0; i < taps; ++i)
+			{
+				size_t const	column = SampleIndex(2 * static_cast<ptrdiff_t>(x) + first + i, src.width, triangle && wrapU);
+				sum += weights[i] * weights[j] * LoadLinear(src, column, row, c, srgb);
+			}
+		}
+
+		float	value = sum / (triangle ? 64.0f : 4.0f);
+		if (srgb && c != 3)
+			value = LinearToSRGB(value);
+		return static_cast<uint8>(value * 255.0f + 0.5f);
+	}
+
+	bool IsSame(Image const& a, Image const& b)
+	{
+		if (a.width != b.width || a.height != b.height)
+			return false;
+		for (size_t y = 0; y < a.height; ++y)
+		{
+			if (memcmp(a.pixels + y * a.rowPitch, b.pixels + y * b.rowPitch, a.width * CHANNEL_COUNT))
+				return false;
+		}
+		return true;
+	}
+
+	int GetMaxError(Image const& src, Image const& dst, DWORD filter)
+	{
+		bool const	srgb = IsSRGB(src.format) || (filter & TEX_FILTER_SRGB) != 0;
+		bool const	triangle = (filter & TEX_FILTER_TRIANGLE) == TEX_FILTER_TRIANGLE;
+		bool const	wrapU = (filter & TEX_FILTER_WRAP_U) != 0;
+		bool const	wrapV = (filter & TEX_FILTER_WRAP_V) != 0;
+
+		int	maxError = 0;
+		for (size_t y = 0; y < dst.height; ++y)
+		{
+			for (size_t x = 0; x < dst.width; ++x)
+			{
+				for (int c = 0; c < CHANNEL_COUNT; ++c)
+				{
+					int const	expected = ReferencePixel(src, x, y, c, srgb, triangle, wrapU, wrapV);
+					int const	error = abs(dst.pixels[y * dst.rowPitch + x * CHANNEL_COUNT + c] - expected);
+					maxError = error > maxError ? error : maxError;
+				}
+			}
+		}
+		return maxError;
+	}
+
+	void TestResize()
+	{
+		int	maxError = 0;
+		for (auto const& size : SIZES)
+		{
+			for (auto format : FORMATS)
+			{
+				for (auto filter : FILTERS)
+				{
+					TestImage const	source(size.width, size.height, format, static_cast<uint32>(size.width * 31 + size.height));
+					size_t const	width = size.width > 1 ? size.width / 2 : 1;
+					size_t const	height = size.height > 1 ? size.height / 2 : 1;
+
+					ScratchImage	vector, scalar;
+					Check(SUCCEEDED(ResizeTexture(source.image, width, height, filter, vector)), "resize", size.width, size.height, format, filter);
+					Check(SUCCEEDED(ResizeTextureScalar(source.image, width, height, filter, scalar)), "scalar resize", size.width, size.height, format, filter);
+					Check(IsSame(*vector.GetImage(0, 0, 0), *scalar.GetImage(0, 0, 0)), "vector resize matches scalar", size.width, size.height, format, filter);
+
+					int const	error = GetMaxError(source.image, *vector.GetImage(0, 0, 0), filter);
+					Check(error <= TOLERANCE, "resize within 1 LSB of the float filter", size.width, size.height, format, filter);
+					maxError = error > maxError ? error : maxError;
+				}
+			}
+		}
+		printf("resize: largest error %d LSB\n", maxError);
+	}
+
+	void TestMipMaps()
+	{
+		Size const	sizes[] = { { 256, 64 }, { 32, 256 }, { 1, 16 }, { 512, 512 } };
+		size_t const	arraySize = 3;
+
+		int	maxError = 0;
+		for (auto const& size : sizes)
+		{
+			for (auto format : FORMATS)
+			{
+				for (auto filter : FILTERS)
+				{
+					std::vector<TestImage>	sources;
+					std::vector<Image>		images;
+					for (size_t item = 0; item < arraySize; ++item)
+						sources.emplace_back(size.width, size.height, format, static_cast<uint32>(item * 7 + size.width));
+					for (auto const& source : sources)
+						images.push_back(source.image);
+
+					TexMetadata const	metadata = { size.width, size.height, 1, arraySize, 1, 0, 0, format, TEX_DIMENSION_TEXTURE2D };
+					ScratchImage	vector, parallel, scalar;
+					Check(SUCCEEDED(GenerateTextureMipMaps(images.data(), images.size(), metadata, filter, 0, vector)), "mips", size.width, size.height, format, filter);
+					Check(SUCCEEDED(GenerateTextureMipMaps(images.data(), images.size(), metadata, filter, 0, parallel, true)), "parallel mips", size.width, size.height, format, filter);
+					Check(SUCCEEDED(GenerateTextureMipMapsScalar(images.data(), images.size(), metadata, filter, 0, scalar, false)), "scalar mips", size.width, size.height, format, filter);
+
+					size_t const	levels = vector.GetMetadata().mipLevels;
+					for (size_t item = 0; item < arraySize; ++item)
+					{
+						for (size_t level = 0; level < levels; ++level)
+						{
+							Image const&	image = *vector.GetImage(level, item, 0);
+							Check(IsSame(image, *scalar.GetImage(level, item, 0)), "vector mips match scalar", size.width, size.height, format, filter);
+							Check(IsSame(image, *parallel.GetImage(level, item, 0)), "parallel mips match serial", size.width, size.height, format, filter);
+							if (!level)
+								continue;
+
+							// Each level against the float filter of the level above it, as DirectXTex builds them.
+							int const	error = GetMaxError(*vector.GetImage(level - 1, item, 0), image, filter);
+							Check(error <= TOLERANCE, "mip within 1 LSB of the float filter", size.width, size.height, format, filter);
+							maxError = error > maxError ? error : maxError;
+						}
+					}
+				}
+			}
+		}
+		printf("mips: largest error %d LSB\n", maxError);
+	}
+
+	void TestConvert()
+	{
+		Size const	sizes[] = { { 64, 4 }, { 7, 3 }, { 1, 1 } };
+		for (auto const& size : sizes)
+		{
+			for (auto from : FORMATS)
+			{
+				for (auto to : FORMATS)
+				{
+					TestImage const	source(size.width, size.height, from, static_cast<uint32>(from * 100 + to));
+					ScratchImage	vector, scalar;
+					Check(SUCCEEDED(ConvertTexture(source.image, to, TEX_FILTER_DEFAULT, 0.5f, vector)), "convert", size.width, size.height, from, to);
+					Check(SUCCEEDED(ConvertTextureScalar(source.image, to, TEX_FILTER_DEFAULT, 0.5f, scalar)), "scalar convert", size.width, size.height, from, to);
+
+					Image const&	dst = *vector.GetImage(0, 0, 0);
+					Check(IsSame(dst, *scalar.GetImage(0, 0, 0)), "vector convert matches scalar", size.width, size.height, from, to);
+
+					bool const	swap = (from == DXGI_FORMAT_B8G8R8A8_UNORM || from == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB) !=
+									   (to == DXGI_FORMAT_B8G8R8A8_UNORM || to == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+					bool	exact = true;
+					for (size_t y = 0; y < size.height; ++y)
+					{
+						for (size_t x = 0; x < size.width; ++x)
+						{
+							for (int c = 0; c < CHANNEL_COUNT; ++c)
+							{
+								int const	sourceChannel = swap && c != 1 && c != 3 ? 2 - c : c;
+								float	value = source.image.pixels[y * source.image.rowPitch + x * CHANNEL_COUNT + sourceChannel] / 255.0f;
+								if (c != 3 && IsSRGB(from) && !IsSRGB(to))
+									value = SRGBToLinear(value);
+								else if (c != 3 && !IsSRGB(from) && IsSRGB(to))
+									value = LinearToSRGB(value);
+								exact &= dst.pixels[y * dst.rowPitch + x * CHANNEL_COUNT + c] == static_cast<uint8>(value * 255.0f + 0.5f);
+							}
+						}
+					}
+					Check(exact, "convert matches the rounded float conversion", size.width, size.height, from, to);
+				}
+			}
+		}
+	}
+
+	void TestFallback()
+	{
+		// Anything the fast paths do not cover reaches DirectXTex, which returns E_NOTIMPL here.
+		TestImage const	source(16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 1);
+		ScratchImage	image;
+		Check(ResizeTexture(source.image, 5, 5, TEX_FILTER_BOX, image) == E_NOTIMPL, "odd resize forwarded", 16, 16, source.image.format, TEX_FILTER_BOX);
+		Check(ResizeTexture(source.image, 8, 8, TEX_FILTER_CUBIC, image) == E_NOTIMPL, "cubic resize forwarded", 16, 16, source.image.format, TEX_FILTER_CUBIC);
+		Check(ConvertTexture(source.image, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, 0.5f, image) == E_NOTIMPL,
+			  "float convert forwarded", 16, 16, source.image.format, TEX_FILTER_DEFAULT);
+	}
+}
+
+int main()
+{
+	// The thread using the job system first is its main thread.
+	JobSystem::Get();
+
+	TestResize();
+	TestMipMaps();
+	TestConvert();
+	TestFallback();
+
+	printf("%u checks passed\n", s_checks);
+	return 0;
+}
\ No newline at end of file